@@ -0,0 +1,262 @@
+/*
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Startup cost of a job on one node.  Forks one process per endpoint.  In
+ * lockstep, all of them open their CQs, AV and endpoint, enable the
+ * endpoint, and insert the addresses of all the endpoints into their AV.
+ * Reports the time each step takes, averaged over and at worst across the
+ * processes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include <rdma/fi_cm.h>
+#include <rdma/fi_errno.h>
+
+#include <shared.h>
+
+struct av_insert_shared {
+	pthread_barrier_t barrier;
+	int errors;
+	uint64_t open_ns[];
+	/* followed by enable_ns[ep_cnt], insert_ns[ep_cnt] and
+	 * names[ep_cnt][FT_MAX_CTRL_MSG]
+	 */
+};
+
+#define AV_INSERT_SYNCS 4
+
+static int ep_cnt = 16;
+static int syncs;
+static struct av_insert_shared *shared;
+static uint64_t *enable_ns;
+static uint64_t *insert_ns;
+static char *names;
+
+static int alloc_shared(void)
+{
+	pthread_barrierattr_t attr;
+	size_t size;
+
+	size = sizeof(*shared) + sizeof(uint64_t) * ep_cnt * 3 +
+	       (size_t) FT_MAX_CTRL_MSG * ep_cnt;
+	shared = mmap(NULL, size, PROT_READ | PROT_WRITE,
+		      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (shared == MAP_FAILED)
+		return -errno;
+
+	enable_ns = shared->open_ns + ep_cnt;
+	insert_ns = enable_ns + ep_cnt;
+	names = (char *) (insert_ns + ep_cnt);
+
+	pthread_barrierattr_init(&attr);
+	pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+	return -pthread_barrier_init(&shared->barrier, &attr, ep_cnt);
+}
+
+static void sync_eps(void)
+{
+	pthread_barrier_wait(&shared->barrier);
+	syncs++;
+}
+
+static int insert_all(void)
+{
+	fi_addr_t fi_addr;
+	int i, ret;
+
+	for (i = 0; i < ep_cnt; i++) {
+		ret = fi_av_insert(av, names + (size_t) FT_MAX_CTRL_MSG * i, 1,
+				   &fi_addr, 0, NULL);
+		if (ret != 1) {
+			FT_PRINTERR("fi_av_insert", ret);
+			return ret ? ret : -FI_EINVAL;
+		}
+	}
+	return 0;
+}
+
+static int run_ep(int id)
+{
+	size_t addrlen = FT_MAX_CTRL_MSG;
+	uint64_t start;
+	int ret;
+
+	/* no node or service, so that each endpoint gets its own name */
+	ret = fi_getinfo(FT_FIVERSION, NULL, NULL, 0, hints, &fi);
+	if (ret) {
+		FT_PRINTERR("fi_getinfo", ret);
+		goto out;
+	}
+
+	ret = ft_open_fabric_res();
+	if (ret)
+		goto out;
+
+	sync_eps();
+	start = ft_gettime_ns();
+	ret = ft_alloc_active_res(fi);
+	shared->open_ns[id] = ft_gettime_ns() - start;
+	if (ret)
+		goto out;
+
+	sync_eps();
+	start = ft_gettime_ns();
+	ret = ft_enable_ep(ep, eq, av, txcq, rxcq, txcntr, rxcntr, rma_cntr);
+	enable_ns[id] = ft_gettime_ns() - start;
+	if (ret)
+		goto out;
+
+	ret = fi_getname(&ep->fid, names + (size_t) FT_MAX_CTRL_MSG * id,
+			 &addrlen);
+	if (ret) {
+		FT_PRINTERR("fi_getname", ret);
+		goto out;
+	}
+
+	sync_eps();
+	start = ft_gettime_ns();
+	ret = insert_all();
+	insert_ns[id] = ft_gettime_ns() - start;
+
+out:
+	if (ret)
+		__atomic_fetch_add(&shared->errors, 1, __ATOMIC_RELAXED);
+
+	/* keep every endpoint open until all the inserts are done, and do
+	 * not leave the others waiting if this one failed
+	 */
+	while (syncs < AV_INSERT_SYNCS)
+		sync_eps();
+	ft_free_res();
+	return ret;
+}
+
+static void show_times(const char *name, uint64_t *ns)
+{
+	uint64_t sum = 0, max = 0;
+	int i;
+
+	for (i = 0; i < ep_cnt; i++) {
+		sum += ns[i];
+		max = MAX(max, ns[i]);
+	}
+	printf("%-18s %12.2f %12.2f\n", name, sum / 1000.0 / ep_cnt,
+	       max / 1000.0);
+}
+
+static int run(void)
+{
+	pid_t pid;
+	int i, status, ret;
+
+	ret = alloc_shared();
+	if (ret)
+		return ret;
+
+	for (i = 0; i < ep_cnt; i++) {
+		pid = fork();
+		if (pid < 0)
+			return -errno;
+		if (!pid)
+			exit(run_ep(i) ? EXIT_FAILURE : EXIT_SUCCESS);
+	}
+
+	for (i = 0; i < ep_cnt; i++)
+		wait(&status);
+
+	if (shared->errors) {
+		FT_ERR("%d of %d processes failed", shared->errors, ep_cnt);
+		return -FI_EOTHER;
+	}
+
+	printf("%d endpoints\n", ep_cnt);
+	printf("%-18s %12s %12s\n", "", "avg (usec)", "max (usec)");
+	show_times("open (cq, av, ep)", shared->open_ns);
+	show_times("fi_enable", enable_ns);
+	show_times("fi_av_insert", insert_ns);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	int op, ret;
+
+	opts = INIT_OPTS;
+
+	hints = fi_allocinfo();
+	if (!hints)
+		return EXIT_FAILURE;
+
+	while ((op = getopt_long(argc, argv, "n:h" INFO_OPTS, long_opts,
+				 &lopt_idx)) != -1) {
+		switch (op) {
+		default:
+			if (!ft_parse_long_opts(op, optarg))
+				continue;
+			ft_parseinfo(op, optarg, hints, &opts);
+			break;
+		case 'n':
+			ep_cnt = atoi(optarg);
+			break;
+		case '?':
+		case 'h':
+			ft_usage(argv[0], "Time endpoint enable and AV insert "
+				 "for many endpoints on one node.");
+			FT_PRINT_OPTS_USAGE("-n <endpoints>", "number of "
+				"processes, one endpoint each (default: 16)");
+			ft_longopts_usage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (ep_cnt < 1) {
+		FT_ERR("need at least one endpoint");
+		return EXIT_FAILURE;
+	}
+
+	opts.av_size = ep_cnt;
+	hints->ep_attr->type = FI_EP_RDM;
+	hints->caps = FI_MSG;
+	hints->mode = FI_CONTEXT | FI_CONTEXT2;
+	hints->domain_attr->mr_mode = opts.mr_mode;
+	hints->addr_format = opts.address_format;
+
+	ret = run();
+
+	ft_free_res();
+	return ft_exit_code(ret);
+}
@@ -57,7 +57,9 @@
  * other miscellaneous resources any buffer might need.
  * There is an implicit 1:1 ratio where each thread's fabric resources are only
  * associated with that thread's buffer resources. There are no resources other
- * than fabric that are shared between threads.
+ * than fabric that are shared between threads, unless -u is given, in which
+ * case all threads open their endpoints on one domain. This measures how
+ * the provider's progress scales within a domain.
  * This test comes with a TODO to refactor the common code to support more tests
  * of this type and enable easier development of future tests with more
  * compatible objects instead of global variables.
@@ -76,6 +78,7 @@ static char oob_buffer[BUFFER_SIZE];
 
 static int num_eps = 1;
 static bool bidir = false;
+static bool share_domain = false;
 static ssize_t xfer_size = 1;
 pthread_barrier_t barrier;
 
@@ -123,8 +126,10 @@ static void cleanup_ofi(void)
 			if (ret)
 				printf("fi_close(av[%d]) failed: %d\n", i, ret);
 		}
+	}
 
-		if (targs[i].domain) {
+	for (i = 0; i < num_eps; i++) {
+		if (targs[i].domain && (i == 0 || !share_domain)) {
 			ret = fi_close(&targs[i].domain->fid);
 			if (ret)
 				printf("fi_close(domain[%d]) failed: %d\n", i,
@@ -207,10 +212,14 @@ static int init_ofi(void)
 		memset(&av_attr, 0, sizeof(av_attr));
 		memset(&cntr_attr, 0, sizeof(cntr_attr));
 
-		ret = fi_domain(fabric, fi, &targs[i].domain, NULL);
-		if (ret) {
-			printf("fi_domain failed ep[%d]: %d\n", i, ret);
-			return ret;
+		if (share_domain && i > 0) {
+			targs[i].domain = targs[0].domain;
+		} else {
+			ret = fi_domain(fabric, fi, &targs[i].domain, NULL);
+			if (ret) {
+				printf("fi_domain failed ep[%d]: %d\n", i, ret);
+				return ret;
+			}
 		}
 
 		ret = fi_endpoint(targs[i].domain, fi, &targs[i].ep, NULL);
@@ -363,6 +372,8 @@ static int read_cq(struct fid_cq *cqueue)
 
 	do {
 		ret = fi_cq_read(cqueue, &cq_entry, 1);
+		if (ret == -FI_EAVAIL)
+			return ft_cq_readerr(cqueue);
 		if (ret < 0 && ret != -FI_EAGAIN)
 			return ret;
 		if (ret == 1)
@@ -604,6 +615,8 @@ static void usage(void)
 	FT_PRINT_OPTS_USAGE("-n <num endpoints>",
 			    "number of endpoints (threads) to use");
 	FT_PRINT_OPTS_USAGE("-U", "enable FI_DELIVERY_COMPLETE");
+	FT_PRINT_OPTS_USAGE("-u", "open all endpoints on a single domain, "
+			    "so that they share its progress engine");
 	fprintf(stderr, "Notice to user: Not all fabtests options are supported"
 		" by this test. If something isn't working check if the option"
 		" is supported before reporting a bug.\n");
@@ -620,7 +633,7 @@ int main(int argc, char **argv)
 	if (!hints)
 		return EXIT_FAILURE;
 
-	while ((op = getopt_long(argc, argv, "gn:Uh" CS_OPTS INFO_OPTS API_OPTS
+	while ((op = getopt_long(argc, argv, "gn:Uuh" CS_OPTS INFO_OPTS API_OPTS
 		BENCHMARK_OPTS, long_opts, &lopt_idx)) != -1) {
 		switch (op) {
 		default:
@@ -640,6 +653,9 @@ int main(int argc, char **argv)
 		case 'U':
 			hints->tx_attr->op_flags |= FI_DELIVERY_COMPLETE;
 			break;
+		case 'u':
+			share_domain = true;
+			break;
 		case '?':
 		case 'h':
 			ft_csusage(argv[0], "Multi-Threaded Bandwidth test for "
@@ -656,7 +672,8 @@ int main(int argc, char **argv)
 
 	hints->ep_attr->type = FI_EP_RDM;
 	hints->domain_attr->resource_mgmt = FI_RM_ENABLED;
-	hints->domain_attr->threading = FI_THREAD_DOMAIN;
+	hints->domain_attr->threading = share_domain ?
+					FI_THREAD_SAFE : FI_THREAD_DOMAIN;
 	hints->caps = FI_MSG;
 	hints->mode |= FI_CONTEXT | FI_CONTEXT2;
 	hints->domain_attr->mr_mode = opts.mr_mode;
@@ -0,0 +1,365 @@
+/*
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Connection scaling test.  The client opens one endpoint per simulated
+ * peer (-n) and the server a single endpoint, so the server ends up with
+ * one connection per client endpoint.  In each round, every client
+ * endpoint sends a message to the server, which answers each of them.  The
+ * first round includes setting up the connections and is reported on its
+ * own.  With -q, both sides pause between rounds while still progressing
+ * their CQs, so that a provider may close connections that went idle.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include <sys/resource.h>
+
+#include <rdma/fi_cm.h>
+#include <rdma/fi_errno.h>
+
+#include <shared.h>
+
+static int ep_cnt = 256;
+static int pause_ms;
+static struct fid_ep **eps;
+static fi_addr_t *peer_addrs;
+
+/* Each endpoint, and on the server each connection, takes a descriptor. */
+static void raise_fd_limit(void)
+{
+	struct rlimit rl;
+
+	if (getrlimit(RLIMIT_NOFILE, &rl) || rl.rlim_cur == rl.rlim_max)
+		return;
+
+	rl.rlim_cur = rl.rlim_max;
+	(void) setrlimit(RLIMIT_NOFILE, &rl);
+}
+
+static int post_recv(struct fid_ep *rx_ep)
+{
+	ssize_t ret;
+
+	while ((ret = fi_recv(rx_ep, rx_buf, opts.transfer_size, mr_desc,
+			      FI_ADDR_UNSPEC, &rx_ctx)) == -FI_EAGAIN) {
+		ret = ft_progress(rxcq, rx_seq, &rx_cq_cntr);
+		if (ret)
+			return ret;
+	}
+	if (ret) {
+		FT_PRINTERR("fi_recv", ret);
+		return ret;
+	}
+	rx_seq++;
+	return 0;
+}
+
+static int post_send(struct fid_ep *tx_ep, fi_addr_t addr)
+{
+	ssize_t ret;
+
+	while ((ret = fi_send(tx_ep, tx_buf, opts.transfer_size, mr_desc,
+			      addr, &tx_ctx)) == -FI_EAGAIN) {
+		ret = ft_progress(txcq, tx_seq, &tx_cq_cntr);
+		if (ret)
+			return ret;
+	}
+	if (ret) {
+		FT_PRINTERR("fi_send", ret);
+		return ret;
+	}
+	tx_seq++;
+	return 0;
+}
+
+static int open_client_eps(void)
+{
+	char *names;
+	size_t addrlen;
+	int i, ret;
+
+	eps = calloc(ep_cnt, sizeof(*eps));
+	names = calloc(ep_cnt, FT_MAX_CTRL_MSG);
+	if (!eps || !names) {
+		ret = -FI_ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < ep_cnt; i++) {
+		ret = fi_endpoint(domain, fi, &eps[i], NULL);
+		if (ret) {
+			FT_PRINTERR("fi_endpoint", ret);
+			goto out;
+		}
+
+		ret = ft_enable_ep(eps[i], eq, av, txcq, rxcq, NULL, NULL,
+				   NULL);
+		if (ret)
+			goto out;
+
+		addrlen = FT_MAX_CTRL_MSG;
+		ret = fi_getname(&eps[i]->fid,
+				 names + (size_t) FT_MAX_CTRL_MSG * i, &addrlen);
+		if (ret) {
+			FT_PRINTERR("fi_getname", ret);
+			goto out;
+		}
+	}
+
+	ret = ft_sock_send(oob_sock, names, (size_t) FT_MAX_CTRL_MSG * ep_cnt);
+out:
+	free(names);
+	return ret;
+}
+
+static int insert_client_eps(void)
+{
+	char *names;
+	int i, ret;
+
+	peer_addrs = calloc(ep_cnt, sizeof(*peer_addrs));
+	names = calloc(ep_cnt, FT_MAX_CTRL_MSG);
+	if (!peer_addrs || !names) {
+		ret = -FI_ENOMEM;
+		goto out;
+	}
+
+	ret = ft_sock_recv(oob_sock, names, (size_t) FT_MAX_CTRL_MSG * ep_cnt);
+	if (ret)
+		goto out;
+
+	for (i = 0; i < ep_cnt; i++) {
+		ret = ft_av_insert(av, names + (size_t) FT_MAX_CTRL_MSG * i, 1,
+				   &peer_addrs[i], 0, NULL);
+		if (ret)
+			goto out;
+	}
+out:
+	free(names);
+	return ret;
+}
+
+static int client_round(void)
+{
+	int i, ret;
+
+	for (i = 0; i < ep_cnt; i++) {
+		ret = post_send(eps[i], remote_fi_addr);
+		if (ret)
+			return ret;
+	}
+
+	ret = ft_get_cq_comp(rxcq, &rx_cq_cntr, rx_seq - 1, timeout);
+	if (ret)
+		return ret;
+
+	return ft_get_cq_comp(txcq, &tx_cq_cntr, tx_seq, timeout);
+}
+
+static int server_round(void)
+{
+	int i, ret;
+
+	ret = ft_get_cq_comp(rxcq, &rx_cq_cntr, rx_seq - 1, timeout);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < ep_cnt; i++) {
+		ret = post_send(ep, peer_addrs[i]);
+		if (ret)
+			return ret;
+	}
+
+	return ft_get_cq_comp(txcq, &tx_cq_cntr, tx_seq, timeout);
+}
+
+static void pause_round(void)
+{
+	uint64_t end = ft_gettime_ms() + pause_ms;
+
+	while (ft_gettime_ms() < end) {
+		(void) fi_cq_read(txcq, NULL, 0);
+		(void) fi_cq_read(rxcq, NULL, 0);
+	}
+}
+
+/*
+ * One receive per client endpoint, posted before the peer may send.  The
+ * receive ft_init_fabric() posted on the main endpoint stays outstanding on
+ * both sides for ft_finalize(), so the rounds wait for one completion less
+ * than posted.
+ */
+static int post_round_recvs(void)
+{
+	int i, ret;
+
+	for (i = 0; i < ep_cnt; i++) {
+		ret = post_recv(opts.dst_addr ? eps[i] : ep);
+		if (ret)
+			return ret;
+	}
+	return ft_sync();
+}
+
+static void show_results(uint64_t connect_ns, uint64_t rounds_ns)
+{
+	double msgs = 2.0 * ep_cnt * opts.iterations;
+
+	printf("%-10s %-8s %14s %14s %12s %10s\n", "endpoints", "bytes",
+	       "connect(usec)", "round(usec)", "Mmsgs/sec", "MB/sec");
+	printf("%-10d %-8zu %14.2f %14.2f %12.4f %10.2f\n", ep_cnt,
+	       opts.transfer_size, connect_ns / 1000.0,
+	       rounds_ns / 1000.0 / opts.iterations,
+	       msgs * 1000.0 / rounds_ns,
+	       msgs * opts.transfer_size * 1000.0 / rounds_ns);
+}
+
+static void close_client_eps(void)
+{
+	int i;
+
+	if (!eps)
+		return;
+
+	for (i = 0; i < ep_cnt; i++)
+		FT_CLOSE_FID(eps[i]);
+	free(eps);
+	eps = NULL;
+}
+
+static int run(void)
+{
+	uint64_t start, pause_start, connect_ns = 0;
+	int i, ret;
+
+	ret = ft_init_fabric();
+	if (ret)
+		return ret;
+
+	ret = opts.dst_addr ? open_client_eps() : insert_client_eps();
+	if (ret)
+		goto out;
+
+	start = ft_gettime_ns();
+	for (i = 0; i <= opts.iterations; i++) {
+		ret = post_round_recvs();
+		if (ret)
+			goto out;
+
+		if (i == 1) {
+			connect_ns = ft_gettime_ns() - start;
+			start = ft_gettime_ns();
+		}
+
+		ret = opts.dst_addr ? client_round() : server_round();
+		if (ret)
+			goto out;
+
+		/* Pauses are not counted in the reported times */
+		if (pause_ms && i < opts.iterations) {
+			pause_start = ft_gettime_ns();
+			pause_round();
+			start += ft_gettime_ns() - pause_start;
+		}
+	}
+
+	if (opts.dst_addr)
+		show_results(connect_ns, ft_gettime_ns() - start);
+
+	ret = ft_finalize();
+out:
+	close_client_eps();
+	free(peer_addrs);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	int op, ret;
+
+	opts = INIT_OPTS;
+	opts.options |= FT_OPT_OOB_CTRL;
+	opts.iterations = 10;
+
+	hints = fi_allocinfo();
+	if (!hints)
+		return EXIT_FAILURE;
+
+	while ((op = getopt_long(argc, argv, "n:q:h" CS_OPTS INFO_OPTS,
+				 long_opts, &lopt_idx)) != -1) {
+		switch (op) {
+		default:
+			if (!ft_parse_long_opts(op, optarg))
+				continue;
+			ft_parseinfo(op, optarg, hints, &opts);
+			ft_parsecsopts(op, optarg, &opts);
+			break;
+		case 'n':
+			ep_cnt = atoi(optarg);
+			break;
+		case 'q':
+			pause_ms = atoi(optarg);
+			break;
+		case '?':
+		case 'h':
+			ft_csusage(argv[0], "Connection scaling test for RDM "
+				   "endpoints.");
+			FT_PRINT_OPTS_USAGE("-n <endpoints>", "number of client "
+				"endpoints, one connection each (default: 256)");
+			FT_PRINT_OPTS_USAGE("-q <msec>", "pause between rounds, "
+				"progressing the CQs (default: 0)");
+			ft_longopts_usage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (optind < argc)
+		opts.dst_addr = argv[optind];
+
+	if (ep_cnt < 1 || opts.iterations < 1) {
+		FT_ERR("need at least one endpoint and one iteration");
+		return EXIT_FAILURE;
+	}
+
+	raise_fd_limit();
+	opts.av_size = ep_cnt + 1;
+	hints->ep_attr->type = FI_EP_RDM;
+	hints->caps = FI_MSG;
+	hints->mode = FI_CONTEXT | FI_CONTEXT2;
+	hints->domain_attr->mr_mode = opts.mr_mode;
+	hints->addr_format = opts.address_format;
+
+	ret = run();
+
+	ft_free_res();
+	return ft_exit_code(ret);
+}
@@ -0,0 +1,225 @@
+/*
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Communication/computation overlap test.  In each iteration, both sides
+ * post a send, compute for a while without touching the CQ, and then wait
+ * for the send and the receive to complete.  The compute time is set to the
+ * time an iteration takes without compute, so a provider that progresses
+ * the transfers on its own (e.g. FI_PROGRESS_AUTO) hides them behind the
+ * compute, while one that relies on the application calling into it does
+ * not.  Reports the overlap percentage and the bandwidth with and without
+ * compute for each message size.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+
+#include <rdma/fi_errno.h>
+
+#include <shared.h>
+#include "benchmark_shared.h"
+
+static volatile uint64_t compute_sink;
+static double loops_per_usec;
+
+static void compute(uint64_t loops)
+{
+	uint64_t i, x = compute_sink;
+
+	for (i = 0; i < loops; i++)
+		x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+	compute_sink = x;
+}
+
+/* Run the compute loop for at least 10 ms to find its speed. */
+static void calibrate(void)
+{
+	uint64_t loops, start, nsec;
+
+	for (loops = 1 << 16; ; loops *= 2) {
+		start = ft_gettime_ns();
+		compute(loops);
+		nsec = ft_gettime_ns() - start;
+		if (nsec >= 10000000)
+			break;
+	}
+	loops_per_usec = loops * 1000.0 / nsec;
+}
+
+/* Returns the average time of an iteration in usec. */
+static int exchange(uint64_t loops, double *usec)
+{
+	uint64_t start = 0;
+	int i, ret;
+
+	ret = ft_sync();
+	if (ret)
+		return ret;
+
+	for (i = 0; i < opts.iterations + opts.warmup_iterations; i++) {
+		if (i == opts.warmup_iterations)
+			start = ft_gettime_ns();
+
+		ret = ft_post_tx(ep, remote_fi_addr, opts.transfer_size,
+				 NO_CQ_DATA, &tx_ctx);
+		if (ret)
+			return ret;
+
+		compute(loops);
+
+		ret = ft_get_tx_comp(tx_seq);
+		if (ret)
+			return ret;
+
+		ret = ft_rx(ep, opts.transfer_size);
+		if (ret)
+			return ret;
+	}
+
+	*usec = (ft_gettime_ns() - start) / 1000.0 / opts.iterations;
+	return 0;
+}
+
+static int overlap(void)
+{
+	static int header = 1;
+	double comm, cpu, total, pct;
+	char str[FT_STR_LEN];
+	int ret;
+
+	ret = exchange(0, &comm);
+	if (ret)
+		return ret;
+
+	cpu = comm;
+	ret = exchange((uint64_t) (cpu * loops_per_usec), &total);
+	if (ret)
+		return ret;
+
+	pct = 100.0 * (1.0 - (total - cpu) / comm);
+	pct = MIN(MAX(pct, 0.0), 100.0);
+
+	if (header) {
+		printf("data progress: %s\n",
+		       fi_tostr(&fi->domain_attr->data_progress,
+				FI_TYPE_PROGRESS));
+		printf("%-8s%-8s%12s%12s%12s%10s%12s%12s\n", "bytes", "iters",
+		       "comm usec", "cpu usec", "total usec", "overlap",
+		       "MB/sec", "eff MB/sec");
+		header = 0;
+	}
+
+	printf("%-8s", size_str(str, opts.transfer_size));
+	printf("%-8s", cnt_str(str, opts.iterations));
+	printf("%12.2f%12.2f%12.2f%9.1f%%%12.2f%12.2f\n", comm, cpu, total,
+	       pct, opts.transfer_size / comm, opts.transfer_size / total);
+	return 0;
+}
+
+static int run(void)
+{
+	int i, ret;
+
+	ret = ft_init_fabric();
+	if (ret)
+		return ret;
+
+	calibrate();
+
+	if (!(opts.options & FT_OPT_SIZE)) {
+		for (i = 0; i < TEST_CNT; i++) {
+			if (!ft_use_size(i, opts.sizes_enabled))
+				continue;
+			opts.transfer_size = test_size[i].size;
+			init_test(&opts, test_name, sizeof(test_name));
+			ret = overlap();
+			if (ret)
+				return ret;
+		}
+	} else {
+		init_test(&opts, test_name, sizeof(test_name));
+		ret = overlap();
+		if (ret)
+			return ret;
+	}
+
+	return ft_finalize();
+}
+
+int main(int argc, char **argv)
+{
+	int op, ret;
+
+	opts = INIT_OPTS;
+
+	hints = fi_allocinfo();
+	if (!hints)
+		return EXIT_FAILURE;
+
+	while ((op = getopt_long(argc, argv, "Uh" CS_OPTS INFO_OPTS
+				 BENCHMARK_OPTS, long_opts,
+				 &lopt_idx)) != -1) {
+		switch (op) {
+		default:
+			if (!ft_parse_long_opts(op, optarg))
+				continue;
+			ft_parse_benchmark_opts(op, optarg);
+			ft_parseinfo(op, optarg, hints, &opts);
+			ft_parsecsopts(op, optarg, &opts);
+			break;
+		case 'U':
+			hints->tx_attr->op_flags |= FI_DELIVERY_COMPLETE;
+			break;
+		case '?':
+		case 'h':
+			ft_csusage(argv[0], "Communication/computation overlap "
+				   "test for RDM endpoints.");
+			ft_benchmark_usage();
+			ft_longopts_usage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (optind < argc)
+		opts.dst_addr = argv[optind];
+
+	hints->ep_attr->type = FI_EP_RDM;
+	hints->caps = FI_MSG;
+	hints->mode |= FI_CONTEXT | FI_CONTEXT2;
+	hints->domain_attr->mr_mode = opts.mr_mode;
+	hints->addr_format = opts.address_format;
+
+	ret = run();
+
+	ft_free_res();
+	return ft_exit_code(ret);
+}
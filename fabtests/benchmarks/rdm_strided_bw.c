@@ -0,0 +1,351 @@
+/*
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Bandwidth test for a strided (vector) datatype.  The client sends each
+ * message from blocks spaced out in its buffer, posting one iov per
+ * block with fi_sendv, and the server receives it into a contiguous
+ * buffer.  This measures how well a provider handles many-iov sends.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+
+#include <rdma/fi_errno.h>
+
+#include <shared.h>
+#include "benchmark_shared.h"
+#include "hmem.h"
+
+static size_t block_cnt;
+static size_t stride = 2;
+
+static char *strided_buf;
+static size_t strided_slot;
+static struct fid_mr *strided_mr;
+static void *strided_desc;
+static struct iovec *tx_iov;
+static void **tx_desc;
+static char *pack_buf;
+
+static int alloc_strided(void)
+{
+	size_t max_size;
+	int ret;
+
+	if (!block_cnt || block_cnt > fi->tx_attr->iov_limit)
+		block_cnt = fi->tx_attr->iov_limit;
+
+	max_size = opts.options & FT_OPT_SIZE ?
+		   opts.transfer_size : test_size[TEST_CNT - 1].size;
+	strided_slot = max_size * stride;
+
+	tx_iov = calloc(block_cnt, sizeof(*tx_iov));
+	tx_desc = calloc(block_cnt, sizeof(*tx_desc));
+	pack_buf = malloc(max_size ? max_size : 1);
+	if (!tx_iov || !tx_desc || !pack_buf)
+		return -FI_ENOMEM;
+
+	ret = ft_hmem_alloc(opts.iface, opts.device, (void **) &strided_buf,
+			    strided_slot * opts.window_size);
+	if (ret)
+		return ret;
+
+	if (!ft_need_mr_reg(fi))
+		return 0;
+
+	return ft_reg_mr(fi, strided_buf, strided_slot * opts.window_size,
+			 ft_info_to_mr_access(fi), FT_RX_MR_KEY + 1,
+			 opts.iface, opts.device, &strided_mr, &strided_desc);
+}
+
+static void free_strided(void)
+{
+	if (strided_mr)
+		FT_CLOSE_FID(strided_mr);
+	if (strided_buf)
+		ft_hmem_free(opts.iface, strided_buf);
+	free(tx_iov);
+	free(tx_desc);
+	free(pack_buf);
+}
+
+/* Describe a message of 'size' bytes as up to block_cnt blocks, each
+ * 'stride' block lengths apart, starting at 'slot'.
+ */
+static size_t format_strided(char *slot, size_t size)
+{
+	size_t i, cnt, len;
+
+	cnt = MIN(block_cnt, MAX(size, 1));
+	len = size / cnt;
+	for (i = 0; i < cnt; i++) {
+		tx_iov[i].iov_base = slot + i * len * stride;
+		tx_iov[i].iov_len = len;
+		tx_desc[i] = strided_desc;
+	}
+	tx_iov[cnt - 1].iov_len += size - len * cnt;
+	return cnt;
+}
+
+/* Fill the blocks so that, once packed by the receiver, they read as one
+ * buffer filled by ft_fill_buf().
+ */
+static int fill_strided(size_t cnt)
+{
+	size_t i, off;
+	int ret;
+
+	for (i = 0; i < opts.transfer_size; i++)
+		pack_buf[i] = integ_alphabet[i % integ_alphabet_length];
+
+	for (i = off = 0; i < cnt; i++) {
+		ret = ft_hmem_copy_to(opts.iface, opts.device,
+				      tx_iov[i].iov_base, pack_buf + off,
+				      tx_iov[i].iov_len);
+		if (ret)
+			return ret;
+		off += tx_iov[i].iov_len;
+	}
+	return 0;
+}
+
+static int post_strided(size_t cnt, void *ctx)
+{
+	int ret;
+
+	while (1) {
+		ret = fi_sendv(ep, tx_iov, tx_desc, cnt, remote_fi_addr, ctx);
+		if (ret != -FI_EAGAIN)
+			break;
+
+		ret = ft_progress(txcq, tx_seq, &tx_cq_cntr);
+		if (ret && ret != -FI_EAGAIN)
+			return ret;
+	}
+	if (ret) {
+		FT_PRINTERR("fi_sendv", ret);
+		return ret;
+	}
+	tx_seq++;
+	return 0;
+}
+
+static int strided_tx(void)
+{
+	size_t cnt;
+	int ret, i, j;
+
+	for (i = j = 0; i < opts.iterations + opts.warmup_iterations; i++) {
+		if (i == opts.warmup_iterations)
+			ft_start();
+
+		cnt = format_strided(strided_buf + strided_slot * j,
+				     opts.transfer_size);
+		if (ft_check_opts(FT_OPT_VERIFY_DATA)) {
+			ret = fill_strided(cnt);
+			if (ret)
+				return ret;
+		}
+
+		ret = post_strided(cnt, &tx_ctx_arr[j].context);
+		if (ret)
+			return ret;
+
+		if (++j == opts.window_size || i == opts.iterations +
+		    opts.warmup_iterations - 1) {
+			ret = ft_get_tx_comp(tx_seq);
+			if (ret)
+				return ret;
+			ret = ft_rx(ep, FT_RMA_SYNC_MSG_BYTES);
+			if (ret)
+				return ret;
+			j = 0;
+		}
+	}
+	return 0;
+}
+
+static int strided_rx(void)
+{
+	int ret, i, j, k;
+
+	for (i = j = 0; i < opts.iterations + opts.warmup_iterations; i++) {
+		if (i == opts.warmup_iterations)
+			ft_start();
+
+		ret = ft_post_rx_buf(ep, opts.transfer_size,
+				     &rx_ctx_arr[j].context,
+				     rx_ctx_arr[j].buf, mr_desc, ft_tag);
+		if (ret)
+			return ret;
+
+		if (++j == opts.window_size || i == opts.iterations +
+		    opts.warmup_iterations - 1) {
+			/* rx_seq is always one ahead */
+			ret = ft_get_rx_comp(rx_seq - 1);
+			if (ret)
+				return ret;
+
+			for (k = 0; ft_check_opts(FT_OPT_VERIFY_DATA) &&
+			     k < j; k++) {
+				ret = ft_check_buf(rx_ctx_arr[k].buf,
+						   opts.transfer_size);
+				if (ret)
+					return ret;
+			}
+
+			ret = ft_tx(ep, remote_fi_addr, FT_RMA_SYNC_MSG_BYTES,
+				    &tx_ctx);
+			if (ret)
+				return ret;
+			j = 0;
+		}
+	}
+	return 0;
+}
+
+static int strided_bw(void)
+{
+	int ret;
+
+	ret = ft_sync();
+	if (ret)
+		return ret;
+
+	ret = opts.dst_addr ? strided_tx() : strided_rx();
+	if (ret)
+		return ret;
+	ft_stop();
+
+	show_perf(NULL, opts.transfer_size, opts.iterations, &start, &end, 1);
+	return 0;
+}
+
+static int run(void)
+{
+	int i, ret = 0;
+
+	ret = ft_init_fabric();
+	if (ret)
+		return ret;
+
+	ret = alloc_strided();
+	if (ret)
+		goto out;
+
+	if (!(opts.options & FT_OPT_SIZE)) {
+		for (i = 0; i < TEST_CNT; i++) {
+			if (!ft_use_size(i, opts.sizes_enabled))
+				continue;
+			opts.transfer_size = test_size[i].size;
+			init_test(&opts, test_name, sizeof(test_name));
+			ret = strided_bw();
+			if (ret)
+				goto out;
+		}
+	} else {
+		init_test(&opts, test_name, sizeof(test_name));
+		ret = strided_bw();
+		if (ret)
+			goto out;
+	}
+
+	ft_finalize();
+out:
+	free_strided();
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	int op, ret;
+
+	opts = INIT_OPTS;
+	opts.options |= FT_OPT_BW;
+
+	hints = fi_allocinfo();
+	if (!hints)
+		return EXIT_FAILURE;
+
+	while ((op = getopt_long(argc, argv, "n:x:Uh" CS_OPTS INFO_OPTS
+				 BENCHMARK_OPTS, long_opts,
+				 &lopt_idx)) != -1) {
+		switch (op) {
+		default:
+			if (!ft_parse_long_opts(op, optarg))
+				continue;
+			ft_parse_benchmark_opts(op, optarg);
+			ft_parseinfo(op, optarg, hints, &opts);
+			ft_parsecsopts(op, optarg, &opts);
+			break;
+		case 'U':
+			hints->tx_attr->op_flags |= FI_DELIVERY_COMPLETE;
+			break;
+		case 'n':
+			block_cnt = strtoul(optarg, NULL, 0);
+			break;
+		case 'x':
+			stride = strtoul(optarg, NULL, 0);
+			if (stride < 1)
+				stride = 1;
+			break;
+		case '?':
+		case 'h':
+			ft_csusage(argv[0], "Bandwidth test for RDM endpoints "
+				   "sending a strided datatype.");
+			FT_PRINT_OPTS_USAGE("-n <blocks>", "number of blocks "
+				"(iovs) per message (default: tx iov_limit)");
+			FT_PRINT_OPTS_USAGE("-x <stride>", "distance between "
+				"the starts of blocks, in block lengths "
+				"(default: 2)");
+			ft_benchmark_usage();
+			ft_longopts_usage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (optind < argc)
+		opts.dst_addr = argv[optind];
+
+	hints->ep_attr->type = FI_EP_RDM;
+	hints->domain_attr->resource_mgmt = FI_RM_ENABLED;
+	hints->caps = FI_MSG;
+	hints->mode |= FI_CONTEXT | FI_CONTEXT2;
+	hints->domain_attr->mr_mode = opts.mr_mode;
+	hints->tx_attr->tclass = FI_TC_BULK_DATA;
+	hints->addr_format = opts.address_format;
+
+	ret = run();
+
+	ft_free_res();
+	return ft_exit_code(ret);
+}
@@ -0,0 +1,321 @@
+/*
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Cost of checking the keys of incoming RMA writes against the number of
+ * memory regions registered at the target.  For each region count, the
+ * server registers that many regions and sends their keys to the client,
+ * which then writes to a pseudo-randomly chosen region in each iteration.
+ * Reports the average time per write, so a key lookup that slows down as
+ * regions are added shows up as a rising cost.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+
+#include <rdma/fi_errno.h>
+#include <rdma/fi_rma.h>
+
+#include <shared.h>
+#include <hmem.h>
+#include "benchmark_shared.h"
+
+#define REGION_KEY_BASE 0x100000
+
+/* FI_MR_BASIC, without the deprecation warning */
+#define MR_MODE_BASIC 0x1
+
+static int max_regions = 16384;
+static int prov_keys;
+static char *region_buf;
+static struct fid_mr **regions;
+static struct fi_rma_iov *targets;
+
+static void close_regions(int cnt)
+{
+	int i;
+
+	for (i = 0; i < cnt; i++)
+		FT_CLOSE_FID(regions[i]);
+}
+
+static int reg_regions(int cnt)
+{
+	uint64_t addr;
+	int i, ret;
+
+	addr = (prov_keys || (fi->domain_attr->mr_mode & FI_MR_VIRT_ADDR)) ?
+	       (uintptr_t) region_buf : 0;
+
+	for (i = 0; i < cnt; i++) {
+		ret = ft_reg_mr(fi, region_buf, opts.transfer_size,
+				FI_REMOTE_WRITE, REGION_KEY_BASE + i,
+				FI_HMEM_SYSTEM, 0, &regions[i], NULL);
+		if (ret) {
+			FT_PRINTERR("ft_reg_mr", ret);
+			close_regions(i);
+			return ret;
+		}
+
+		targets[i].addr = addr;
+		targets[i].len = opts.transfer_size;
+		targets[i].key = fi_mr_key(regions[i]);
+	}
+	return 0;
+}
+
+static size_t targets_per_msg(void)
+{
+	return FT_MAX_CTRL_MSG / sizeof(*targets);
+}
+
+static int send_targets(int cnt)
+{
+	size_t n;
+	int i, ret;
+
+	for (i = 0; i < cnt; i += n) {
+		n = MIN(targets_per_msg(), cnt - i);
+		ret = ft_hmem_copy_to(opts.iface, opts.device,
+				      tx_buf + ft_tx_prefix_size(),
+				      &targets[i], n * sizeof(*targets));
+		if (ret)
+			return ret;
+
+		ret = ft_tx(ep, remote_fi_addr,
+			    n * sizeof(*targets) + ft_tx_prefix_size(),
+			    &tx_ctx);
+		if (ret)
+			return ret;
+	}
+	return 0;
+}
+
+static int recv_targets(int cnt)
+{
+	size_t n;
+	int i, ret;
+
+	for (i = 0; i < cnt; i += n) {
+		n = MIN(targets_per_msg(), cnt - i);
+		ret = ft_get_rx_comp(rx_seq);
+		if (ret)
+			return ret;
+
+		ret = ft_hmem_copy_from(opts.iface, opts.device, &targets[i],
+					rx_buf + ft_rx_prefix_size(),
+					n * sizeof(*targets));
+		if (ret)
+			return ret;
+
+		ret = ft_post_rx(ep, rx_size, &rx_ctx);
+		if (ret)
+			return ret;
+	}
+	return 0;
+}
+
+/* Returns the average time of a write in usec. */
+static int write_regions(int cnt, double *usec)
+{
+	uint64_t start = 0, rand = 1;
+	int i, j, ret;
+
+	for (i = j = 0; i < opts.iterations + opts.warmup_iterations; i++) {
+		if (i == opts.warmup_iterations)
+			start = ft_gettime_ns();
+
+		rand = rand * 6364136223846793005ULL + 1442695040888963407ULL;
+		ret = ft_post_rma(FT_RMA_WRITE, tx_buf, opts.transfer_size,
+				  &targets[(rand >> 33) % cnt],
+				  &tx_ctx_arr[j].context);
+		if (ret)
+			return ret;
+
+		if (++j == opts.window_size) {
+			ret = ft_get_tx_comp(tx_seq);
+			if (ret)
+				return ret;
+			j = 0;
+		}
+	}
+
+	ret = ft_get_tx_comp(tx_seq);
+	if (ret)
+		return ret;
+
+	*usec = (ft_gettime_ns() - start) / 1000.0 / opts.iterations;
+	return 0;
+}
+
+static int run_count(int cnt)
+{
+	char str[FT_STR_LEN];
+	double usec;
+	int ret;
+
+	if (!opts.dst_addr) {
+		ret = reg_regions(cnt);
+		if (ret)
+			return ret;
+
+		ret = send_targets(cnt);
+		if (!ret)
+			ret = ft_sync_inband(true);
+		close_regions(cnt);
+		return ret;
+	}
+
+	ret = recv_targets(cnt);
+	if (ret)
+		return ret;
+
+	ret = write_regions(cnt, &usec);
+	if (ret)
+		return ret;
+
+	ret = ft_sync_inband(true);
+	if (ret)
+		return ret;
+
+	printf("%-10d", cnt);
+	printf("%-8s", size_str(str, opts.transfer_size));
+	printf("%-8s", cnt_str(str, opts.iterations));
+	printf("%12.3f%14.3f\n", usec, 1.0 / usec);
+	return 0;
+}
+
+static int run(void)
+{
+	int cnt, ret;
+
+	regions = calloc(max_regions, sizeof(*regions));
+	targets = calloc(max_regions, sizeof(*targets));
+	region_buf = calloc(1, opts.transfer_size);
+	if (!regions || !targets || !region_buf)
+		return -FI_ENOMEM;
+
+	ret = ft_init_fabric();
+	if (ret)
+		return ret;
+
+	if (opts.dst_addr) {
+		printf("keys: %s\n", (fi->domain_attr->mr_mode &
+			(FI_MR_PROV_KEY | MR_MODE_BASIC)) ?
+			"provider" : "application");
+		printf("%-10s%-8s%-8s%12s%14s\n", "regions", "bytes",
+		       "iters", "usec/write", "Mwrites/sec");
+	}
+
+	for (cnt = 1; cnt < max_regions; cnt *= 4) {
+		ret = run_count(cnt);
+		if (ret)
+			return ret;
+	}
+
+	ret = run_count(max_regions);
+	if (ret)
+		return ret;
+
+	return ft_finalize();
+}
+
+int main(int argc, char **argv)
+{
+	int op, ret;
+
+	opts = INIT_OPTS;
+	opts.options |= FT_OPT_SIZE;
+	opts.transfer_size = 64;
+
+	hints = fi_allocinfo();
+	if (!hints)
+		return EXIT_FAILURE;
+
+	while ((op = getopt_long(argc, argv, "n:gUh" CS_OPTS INFO_OPTS
+				 BENCHMARK_OPTS, long_opts,
+				 &lopt_idx)) != -1) {
+		switch (op) {
+		default:
+			if (!ft_parse_long_opts(op, optarg))
+				continue;
+			ft_parse_benchmark_opts(op, optarg);
+			ft_parseinfo(op, optarg, hints, &opts);
+			ft_parsecsopts(op, optarg, &opts);
+			break;
+		case 'n':
+			max_regions = atoi(optarg);
+			break;
+		case 'g':
+			prov_keys = 1;
+			break;
+		case 'U':
+			hints->tx_attr->op_flags |= FI_DELIVERY_COMPLETE;
+			break;
+		case '?':
+		case 'h':
+			ft_csusage(argv[0], "RMA write cost against the number "
+				   "of registered regions at the target.");
+			ft_benchmark_usage();
+			FT_PRINT_OPTS_USAGE("-n <regions>", "largest number of "
+				"regions to register (default: 16384)");
+			FT_PRINT_OPTS_USAGE("-g", "have the provider generate the "
+				"keys (basic registration mode)");
+			ft_longopts_usage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (max_regions < 1) {
+		FT_ERR("need at least one region");
+		return EXIT_FAILURE;
+	}
+
+	if (optind < argc)
+		opts.dst_addr = argv[optind];
+
+	hints->ep_attr->type = FI_EP_RDM;
+	hints->caps = FI_MSG | FI_RMA;
+	hints->mode |= FI_CONTEXT | FI_CONTEXT2;
+	hints->domain_attr->mr_mode = prov_keys ? MR_MODE_BASIC :
+				      opts.mr_mode & ~FI_MR_RAW;
+	hints->addr_format = opts.address_format;
+
+	ret = run();
+
+	if (regions)
+		close_regions(max_regions);
+	free(regions);
+	free(targets);
+	free(region_buf);
+	ft_free_res();
+	return ft_exit_code(ret);
+}
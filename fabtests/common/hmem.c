@@ -34,6 +34,14 @@
 #include <stdbool.h>
 #include "hmem.h"
 
+#ifdef __linux__
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/memfd.h>
+#endif
+
 static bool hmem_initialized = false;
 
 struct ft_hmem_ops {
@@ -219,3 +227,109 @@ int ft_hmem_no_get_dmabuf_fd(void *buf, size_t len,
 {
 	return -FI_ENOSYS;
 }
+
+#ifdef __linux__
+
+/* Host buffers backed by a memfd, so that they can be registered with
+ * the fi_mr_dmabuf API (--memfd).
+ */
+struct ft_memfd_buf {
+	struct ft_memfd_buf *next;
+	void *buf;
+	size_t size;
+	int fd;
+};
+
+static struct ft_memfd_buf *memfd_bufs;
+
+static int ft_memfd_alloc(uint64_t device, void **buf, size_t size)
+{
+	struct ft_memfd_buf *mbuf;
+	int ret;
+
+	mbuf = calloc(1, sizeof(*mbuf));
+	if (!mbuf)
+		return -FI_ENOMEM;
+
+	mbuf->fd = syscall(SYS_memfd_create, "fabtests", MFD_CLOEXEC);
+	if (mbuf->fd < 0) {
+		ret = -errno;
+		goto err1;
+	}
+
+	if (ftruncate(mbuf->fd, size)) {
+		ret = -errno;
+		goto err2;
+	}
+
+	mbuf->buf = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+			 mbuf->fd, 0);
+	if (mbuf->buf == MAP_FAILED) {
+		ret = -errno;
+		goto err2;
+	}
+
+	mbuf->size = size;
+	mbuf->next = memfd_bufs;
+	memfd_bufs = mbuf;
+	*buf = mbuf->buf;
+	return FI_SUCCESS;
+
+err2:
+	close(mbuf->fd);
+err1:
+	free(mbuf);
+	return ret;
+}
+
+static int ft_memfd_free(void *buf)
+{
+	struct ft_memfd_buf **prev, *mbuf;
+
+	for (prev = &memfd_bufs; *prev; prev = &(*prev)->next) {
+		mbuf = *prev;
+		if (mbuf->buf != buf)
+			continue;
+
+		*prev = mbuf->next;
+		munmap(mbuf->buf, mbuf->size);
+		close(mbuf->fd);
+		free(mbuf);
+		return FI_SUCCESS;
+	}
+	return -FI_EINVAL;
+}
+
+static int ft_memfd_get_dmabuf_fd(void *buf, size_t len,
+				  int *fd, uint64_t *offset)
+{
+	struct ft_memfd_buf *mbuf;
+
+	for (mbuf = memfd_bufs; mbuf; mbuf = mbuf->next) {
+		if ((char *) buf < (char *) mbuf->buf ||
+		    (char *) buf + len > (char *) mbuf->buf + mbuf->size)
+			continue;
+
+		*fd = mbuf->fd;
+		*offset = (char *) buf - (char *) mbuf->buf;
+		return FI_SUCCESS;
+	}
+	return -FI_EINVAL;
+}
+
+int ft_hmem_use_memfd(void)
+{
+	hmem_ops[FI_HMEM_SYSTEM].alloc = ft_memfd_alloc;
+	hmem_ops[FI_HMEM_SYSTEM].free = ft_memfd_free;
+	hmem_ops[FI_HMEM_SYSTEM].get_dmabuf_fd = ft_memfd_get_dmabuf_fd;
+	return FI_SUCCESS;
+}
+
+#else
+
+int ft_hmem_use_memfd(void)
+{
+	return -FI_ENOSYS;
+}
+
+#endif /* __linux__ */
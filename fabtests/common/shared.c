@@ -104,6 +104,7 @@ const char *greeting = "Hello from Client!";
 char test_name[50] = "custom";
 int timeout = -1;
 struct timespec start, end;
+struct ft_lat_hist lat_hist;
 
 int listen_sock = -1;
 int sock = -1;
@@ -400,6 +401,7 @@ bool ft_need_mr_reg(struct fi_info *fi)
 {
 	return (fi->caps & (FI_RMA | FI_ATOMIC)) ||
 	       (fi->domain_attr->mr_mode & FI_MR_LOCAL) ||
+	       (opts.options & FT_OPT_MEMFD) ||
 	       ((fi->domain_attr->mr_mode & FI_MR_HMEM) &&
 		(opts.options & FT_OPT_USE_DEVICE));
 }
@@ -902,6 +904,14 @@ int ft_init(void)
 		return ret;
 	}
 
+	if (opts.iface == FI_HMEM_SYSTEM && (opts.options & FT_OPT_MEMFD)) {
+		ret = ft_hmem_use_memfd();
+		if (ret) {
+			FT_PRINTERR("ft_hmem_use_memfd", ret);
+			return ret;
+		}
+	}
+
 	ret = ft_hmem_init(opts.iface);
 	if (ret)
 		FT_PRINTERR("ft_hmem_init", ret);
@@ -3272,6 +3282,145 @@ int64_t get_elapsed(const struct timespec *b, const struct timespec *a,
 	return elapsed / p;
 }
 
+void ft_lat_hist_reset(void)
+{
+	memset(&lat_hist, 0, sizeof(lat_hist));
+	lat_hist.min = UINT64_MAX;
+	lat_hist.last = ft_gettime_ns();
+}
+
+/* Bucket i holds the values v for which (v >> shift) + shift *
+ * FT_LAT_HIST_SUB == i, where shift is the smallest one leaving fewer than
+ * 2 * FT_LAT_HIST_SUB in v >> shift.
+ */
+void ft_lat_hist_add(uint64_t ns)
+{
+	int shift = 0;
+
+	if (ns >= (1ULL << FT_LAT_HIST_MAX_BITS))
+		ns = (1ULL << FT_LAT_HIST_MAX_BITS) - 1;
+
+	while ((ns >> shift) >= 2 * FT_LAT_HIST_SUB)
+		shift++;
+
+	lat_hist.bucket[shift * FT_LAT_HIST_SUB + (ns >> shift)]++;
+	lat_hist.count++;
+	lat_hist.min = MIN(lat_hist.min, ns);
+	lat_hist.max = MAX(lat_hist.max, ns);
+}
+
+/* Returns the middle of the bucket holding the given percentile. */
+uint64_t ft_lat_hist_percentile(double pct)
+{
+	uint64_t target, seen = 0, value;
+	double rank;
+	int i, shift;
+
+	if (!lat_hist.count)
+		return 0;
+
+	rank = pct / 100.0 * lat_hist.count;
+	target = (uint64_t) rank;
+	if (target < rank || !target)
+		target++;
+
+	for (i = 0; i < FT_LAT_HIST_BUCKETS; i++) {
+		seen += lat_hist.bucket[i];
+		if (seen >= target)
+			break;
+	}
+	if (i == FT_LAT_HIST_BUCKETS)
+		return lat_hist.max;
+
+	shift = i < 2 * FT_LAT_HIST_SUB ? 0 : i / FT_LAT_HIST_SUB - 1;
+	value = ((uint64_t) (i - shift * FT_LAT_HIST_SUB) << shift) +
+		((1ULL << shift) >> 1);
+	return MIN(MAX(value, lat_hist.min), lat_hist.max);
+}
+
+#define FT_LAT_CNT 6
+
+static const char *lat_names[FT_LAT_CNT] = {
+	"min", "p50", "p90", "p99", "p99.9", "max"
+};
+
+/* Fills in usec per transfer at each of lat_names, if the test recorded
+ * per-iteration times.
+ */
+static int ft_lat_usec(int xfers_per_iter, double *lat)
+{
+	static const double pcts[] = { 50.0, 90.0, 99.0, 99.9 };
+	double scale = 1000.0 * xfers_per_iter;
+	int i;
+
+	if (!(opts.options & FT_OPT_LAT_HIST) || !lat_hist.count)
+		return 0;
+
+	lat[0] = lat_hist.min / scale;
+	for (i = 0; i < 4; i++)
+		lat[i + 1] = ft_lat_hist_percentile(pcts[i]) / scale;
+	lat[FT_LAT_CNT - 1] = lat_hist.max / scale;
+	return 1;
+}
+
+static const char *ft_perf_name(char *name)
+{
+	const char *base;
+
+	if (name)
+		return name;
+	if (!opts.argv)
+		return test_name;
+
+	base = strrchr(opts.argv[0], '/');
+	return base ? base + 1 : opts.argv[0];
+}
+
+static void show_perf_csv(char *name, size_t tsize, int iters,
+			  long long bytes, int64_t elapsed,
+			  float usec_per_xfer, double *lat)
+{
+	static int header = 1;
+	int i;
+
+	if (header) {
+		printf("name,xfer_size,iterations,total,time,MB/sec,"
+		       "usec/xfer,Mxfers/sec");
+		for (i = 0; i < FT_LAT_CNT; i++)
+			printf(",lat_%s", lat_names[i]);
+		printf("\n");
+		header = 0;
+	}
+
+	printf("%s,%zu,%d,%lld,%f,%f,%f,%f", ft_perf_name(name), tsize, iters,
+	       bytes, elapsed / 1000000.0, bytes / (1.0 * elapsed),
+	       usec_per_xfer, 1.0 / usec_per_xfer);
+	for (i = 0; i < FT_LAT_CNT; i++) {
+		if (lat)
+			printf(",%f", lat[i]);
+		else
+			printf(",");
+	}
+	printf("\n");
+}
+
+/* One JSON object per line, with the keys of show_perf_csv(). */
+static void show_perf_json(char *name, size_t tsize, int iters,
+			   long long bytes, int64_t elapsed,
+			   float usec_per_xfer, double *lat)
+{
+	int i;
+
+	printf("{\"name\": \"%s\", \"xfer_size\": %zu, \"iterations\": %d, "
+	       "\"total\": %lld, \"time\": %f, \"MB/sec\": %f, "
+	       "\"usec/xfer\": %f, \"Mxfers/sec\": %f", ft_perf_name(name),
+	       tsize, iters, bytes, elapsed / 1000000.0,
+	       bytes / (1.0 * elapsed), usec_per_xfer, 1.0 / usec_per_xfer);
+	for (i = 0; lat && i < FT_LAT_CNT; i++)
+		printf(", \"lat_%s\": %f", lat_names[i], lat[i]);
+	printf("}\n");
+}
+
 void show_perf(char *name, size_t tsize, int iters, struct timespec *start,
 		struct timespec *end, int xfers_per_iter)
 {
@@ -3280,37 +3429,48 @@ void show_perf(char *name, size_t tsize, int iters, struct timespec *start,
 	int64_t elapsed = get_elapsed(start, end, MICRO);
 	long long bytes = (long long) iters * tsize * xfers_per_iter;
 	float usec_per_xfer;
+	double lat[FT_LAT_CNT];
+	int has_lat, i;
 
-	if (name) {
-		if (header) {
-			printf("%-50s%-8s%-8s%-8s%8s %10s%13s%13s\n",
-					"name", "bytes", "iters",
-					"total", "time", "MB/sec",
-					"usec/xfer", "Mxfers/sec");
-			header = 0;
-		}
+	usec_per_xfer = ((float)elapsed / iters / xfers_per_iter);
+	has_lat = ft_lat_usec(xfers_per_iter, lat);
 
-		printf("%-50s", name);
-	} else {
-		if (header) {
-			printf("%-8s%-8s%-8s%8s %10s%13s%13s\n",
-					"bytes", "iters", "total",
-					"time", "MB/sec", "usec/xfer",
-					"Mxfers/sec");
-			header = 0;
-		}
+	if (opts.perf_format == FT_PERF_CSV) {
+		show_perf_csv(name, tsize, iters, bytes, elapsed,
+			      usec_per_xfer, has_lat ? lat : NULL);
+		return;
+	} else if (opts.perf_format == FT_PERF_JSON) {
+		show_perf_json(name, tsize, iters, bytes, elapsed,
+			       usec_per_xfer, has_lat ? lat : NULL);
+		return;
 	}
 
+	if (header) {
+		if (name)
+			printf("%-50s", "name");
+		printf("%-8s%-8s%-8s%8s %10s%13s%13s", "bytes", "iters",
+		       "total", "time", "MB/sec", "usec/xfer", "Mxfers/sec");
+		for (i = 0; has_lat && i < FT_LAT_CNT; i++)
+			printf("%9s", lat_names[i]);
+		printf("\n");
+		header = 0;
+	}
+
+	if (name)
+		printf("%-50s", name);
+
 	printf("%-8s", size_str(str, tsize));
 
 	printf("%-8s", cnt_str(str, iters));
 
 	printf("%-8s", size_str(str, bytes));
 
-	usec_per_xfer = ((float)elapsed / iters / xfers_per_iter);
-	printf("%8.2fs%10.2f%11.2f%11.2f\n",
+	printf("%8.2fs%10.2f%11.2f%11.2f",
 		elapsed / 1000000.0, bytes / (1.0 * elapsed),
 		usec_per_xfer, 1.0/usec_per_xfer);
+	for (i = 0; has_lat && i < FT_LAT_CNT; i++)
+		printf("%9.2f", lat[i]);
+	printf("\n");
 }
 
 void show_perf_mr(size_t tsize, int iters, struct timespec *start,
@@ -3321,6 +3481,7 @@ void show_perf_mr(size_t tsize, int iters, struct timespec *start,
 	long long total = (long long) iters * tsize * xfers_per_iter;
 	int i;
 	float usec_per_xfer;
+	double lat[FT_LAT_CNT];
 
 	if (header) {
 		printf("---\n");
@@ -3342,6 +3503,10 @@ void show_perf_mr(size_t tsize, int iters, struct timespec *start,
 	printf("MB/sec: %f, ", (total) / (1.0 * elapsed));
 	printf("usec/xfer: %f, ", usec_per_xfer);
 	printf("Mxfers/sec: %f", 1.0/usec_per_xfer);
+	if (ft_lat_usec(xfers_per_iter, lat)) {
+		for (i = 0; i < FT_LAT_CNT; i++)
+			printf(", lat_%s: %f", lat_names[i], lat[i]);
+	}
 	printf(" }\n");
 }
 
@@ -4480,12 +4645,46 @@ static int ft_parse_pin_core_opt(char *optarg)
 	return 0;
 }
 
+/* Pin to the cpus of a NUMA node, for measuring transfers between
+ * sockets with a server and client pinned to different nodes.  Results
+ * are meaningless unpinned, so failing to pin is fatal.
+ */
+static int ft_parse_pin_node_opt(char *optarg)
+{
+	char path[64], cpus[1024];
+	FILE *file;
+	int ret = -1;
+
+	snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+		 atoi(optarg));
+	file = fopen(path, "r");
+	if (!file) {
+		FT_ERR("Unable to open %s", path);
+		exit(EXIT_FAILURE);
+	}
+
+	if (fgets(cpus, sizeof(cpus), file)) {
+		cpus[strcspn(cpus, "\n")] = '\0';
+		if (cpus[0])
+			ret = ft_pin_core(cpus);
+	}
+	fclose(file);
+	if (ret) {
+		FT_ERR("Pin to node %s failed", optarg);
+		exit(EXIT_FAILURE);
+	}
+	return 0;
+}
+
 void ft_longopts_usage()
 {
 	FT_PRINT_OPTS_USAGE("--pin-core <core_list>",
 		"Specify which cores to pin process to using a\n"
 		"a comma-separated list format, e.g.: 0,2-4.\n"
 		"Disabled by default.");
+	FT_PRINT_OPTS_USAGE("--pin-node <node>",
+		"Pin process to the cores of a NUMA node.\n"
+		"Disabled by default.");
 	FT_PRINT_OPTS_USAGE("--timeout <seconds>",
 		"Overrides default timeout for test specific transfers.");
 	FT_PRINT_OPTS_USAGE("--debug-assert",
@@ -4501,6 +4700,14 @@ void ft_longopts_usage()
 		"Run tests with FI_MORE");
 	FT_PRINT_OPTS_USAGE("--threading",
 		"threading model: safe|completion|domain (default:domain)");
+	FT_PRINT_OPTS_USAGE("--lat-hist",
+		"Time each iteration of latency tests and report\n"
+		"min, p50, p90, p99, p99.9 and max usec/xfer");
+	FT_PRINT_OPTS_USAGE("--perf-format <text|csv|json>",
+		"format of the performance results (default: text)");
+	FT_PRINT_OPTS_USAGE("--memfd",
+		"Allocate host buffers from a memfd and register them\n"
+		"with the fi_mr_dmabuf API");
 }
 
 int debug_assert;
@@ -4515,6 +4722,10 @@ struct option long_opts[] = {
 	{"max-msg-size", required_argument, NULL, LONG_OPT_MAX_MSG_SIZE},
 	{"use-fi-more", no_argument, NULL, LONG_OPT_USE_FI_MORE},
 	{"threading", required_argument, NULL, LONG_OPT_THREADING},
+	{"pin-node", required_argument, NULL, LONG_OPT_PIN_NODE},
+	{"lat-hist", no_argument, NULL, LONG_OPT_LAT_HIST},
+	{"perf-format", required_argument, NULL, LONG_OPT_PERF_FORMAT},
+	{"memfd", no_argument, NULL, LONG_OPT_MEMFD},
 	{NULL, 0, NULL, 0},
 };
 
@@ -4575,6 +4786,24 @@ int ft_parse_long_opts(int op, char *optarg)
 	case LONG_OPT_THREADING:
 		opts.threading = ft_parse_threading_string(optarg);
 		return 0;
+	case LONG_OPT_PIN_NODE:
+		return ft_parse_pin_node_opt(optarg);
+	case LONG_OPT_LAT_HIST:
+		opts.options |= FT_OPT_LAT_HIST;
+		return 0;
+	case LONG_OPT_PERF_FORMAT:
+		if (!strcasecmp("text", optarg))
+			opts.perf_format = FT_PERF_TEXT;
+		else if (!strcasecmp("csv", optarg))
+			opts.perf_format = FT_PERF_CSV;
+		else if (!strcasecmp("json", optarg))
+			opts.perf_format = FT_PERF_JSON;
+		else
+			return EXIT_FAILURE;
+		return 0;
+	case LONG_OPT_MEMFD:
+		opts.options |= FT_OPT_MEMFD | FT_OPT_REG_DMABUF_MR;
+		return 0;
 	default:
 		return EXIT_FAILURE;
 	}
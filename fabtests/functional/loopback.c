@@ -34,6 +34,49 @@
 
 #include <shared.h>
 
+static bool timed;
+
+/* Latency and bandwidth of messages the endpoint sends to itself */
+static int run_size(void)
+{
+	int i, ret;
+
+	init_test(&opts, test_name, sizeof(test_name));
+	for (i = 0; i < opts.iterations + opts.warmup_iterations; i++) {
+		if (i == opts.warmup_iterations)
+			ft_start();
+
+		ret = ft_tx(ep, remote_fi_addr, opts.transfer_size, &tx_ctx);
+		if (ret)
+			return ret;
+
+		ret = ft_rx(ep, opts.transfer_size);
+		if (ret)
+			return ret;
+	}
+	ft_stop();
+
+	show_perf(NULL, opts.transfer_size, opts.iterations, &start, &end, 1);
+	return 0;
+}
+
+static int run_timed(void)
+{
+	int i, ret;
+
+	if (opts.options & FT_OPT_SIZE)
+		return run_size();
+
+	for (i = 0; i < TEST_CNT; i++) {
+		if (!ft_use_size(i, opts.sizes_enabled))
+			continue;
+		opts.transfer_size = test_size[i].size;
+		ret = run_size();
+		if (ret)
+			return ret;
+	}
+	return 0;
+}
 
 static int run(void)
 {
@@ -71,6 +114,8 @@ static int run(void)
 	if (ret)
 		goto out;
 
+	if (timed)
+		ret = run_timed();
 out:
 	fi->dest_addr = NULL;
 	fi->dest_addrlen = 0;
@@ -92,14 +137,24 @@ int main(int argc, char **argv)
 	hints->ep_attr->type = FI_EP_RDM;
 	hints->mode = FI_CONTEXT | FI_CONTEXT2;
 
-	while ((op = getopt(argc, argv, "h" INFO_OPTS)) != -1) {
+	while ((op = getopt(argc, argv, "I:S:h" INFO_OPTS)) != -1) {
 		switch (op) {
 		default:
 			ft_parseinfo(op, optarg, hints, &opts);
 			break;
+		case 'I':
+		case 'S':
+			ft_parsecsopts(op, optarg, &opts);
+			timed = true;
+			break;
 		case '?':
 		case 'h':
 			ft_usage(argv[0], "A loopback communication test.");
+			FT_PRINT_OPTS_USAGE("-I <number>", "number of iterations, "
+					    "times sends to self when given");
+			FT_PRINT_OPTS_USAGE("-S <size>", "specific transfer size "
+					    "or 'all', times sends to self "
+					    "when given");
 			return EXIT_FAILURE;
 		}
 	}
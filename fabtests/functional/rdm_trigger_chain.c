@@ -0,0 +1,197 @@
+/*
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Chains triggered sends on the tx counter: send i is released by the
+ * completion of send i - 1, so the whole chain runs without the
+ * application posting anything after it is queued.  The server chains its
+ * receives on the rx counter the same way.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+
+#include <rdma/fi_errno.h>
+#include <rdma/fi_trigger.h>
+
+#include <shared.h>
+
+static int chain_len = 1000;
+static struct fi_triggered_context2 *trig_ctx;
+
+static int post_chain(struct fid_cntr *cntr, char *base, size_t stride)
+{
+	struct fi_msg msg = {0};
+	struct iovec iov;
+	uint64_t start;
+	ssize_t ret;
+	int i;
+
+	msg.msg_iov = &iov;
+	msg.desc = &mr_desc;
+	msg.iov_count = 1;
+	msg.addr = remote_fi_addr;
+
+	start = fi_cntr_read(cntr);
+	for (i = 0; i < chain_len; i++) {
+		trig_ctx[i].event_type = FI_TRIGGER_THRESHOLD;
+		trig_ctx[i].trigger.threshold.cntr = cntr;
+		trig_ctx[i].trigger.threshold.threshold = start + i;
+
+		iov.iov_base = base + stride * i;
+		iov.iov_len = opts.transfer_size;
+		msg.context = &trig_ctx[i];
+
+		ret = opts.dst_addr ? fi_sendmsg(ep, &msg, FI_TRIGGER) :
+				      fi_recvmsg(ep, &msg, FI_TRIGGER);
+		if (ret) {
+			FT_PRINTERR(opts.dst_addr ? "fi_sendmsg" : "fi_recvmsg",
+				    ret);
+			return (int) ret;
+		}
+	}
+
+	ret = fi_cntr_wait(cntr, start + chain_len, -1);
+	if (ret) {
+		FT_PRINTERR("fi_cntr_wait", ret);
+		return (int) ret;
+	}
+	return 0;
+}
+
+static int run_test(void)
+{
+	int i, ret;
+
+	trig_ctx = calloc(chain_len, sizeof(*trig_ctx));
+	if (!trig_ctx)
+		return -FI_ENOMEM;
+
+	ret = ft_init_fabric();
+	if (ret)
+		goto out;
+
+	if (opts.dst_addr) {
+		for (i = 0; i < chain_len; i++) {
+			ret = ft_fill_buf(tx_buf + tx_size * i,
+					  opts.transfer_size);
+			if (ret)
+				goto out;
+		}
+	}
+
+	ft_start();
+	ret = opts.dst_addr ? post_chain(txcntr, tx_buf, tx_size) :
+			      post_chain(rxcntr, rx_buf, rx_size);
+	ft_stop();
+	if (ret)
+		goto out;
+
+	if (!opts.dst_addr) {
+		for (i = 0; i < chain_len; i++) {
+			ret = ft_check_buf(rx_buf + rx_size * i,
+					   opts.transfer_size);
+			if (ret)
+				goto out;
+		}
+	}
+
+	show_perf(NULL, opts.transfer_size, chain_len, &start, &end, 1);
+
+	/* the chain bypassed the sequence numbers the sync waits on */
+	if (opts.dst_addr)
+		tx_seq += chain_len;
+	else
+		rx_seq += chain_len;
+
+	ret = ft_post_rx(ep, rx_size, &rx_ctx);
+	if (ret)
+		goto out;
+
+	ret = ft_sync_inband(false);
+out:
+	free(trig_ctx);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	int op, ret;
+
+	opts = INIT_OPTS;
+	opts.options = FT_OPT_SIZE | FT_OPT_TX_CNTR | FT_OPT_RX_CNTR |
+			FT_OPT_NO_PRE_POSTED_RX;
+
+	hints = fi_allocinfo();
+	if (!hints)
+		return EXIT_FAILURE;
+
+	while ((op = getopt(argc, argv, "n:h" ADDR_OPTS INFO_OPTS)) != -1) {
+		switch (op) {
+		default:
+			ft_parse_addr_opts(op, optarg, &opts);
+			ft_parseinfo(op, optarg, hints, &opts);
+			break;
+		case 'n':
+			chain_len = atoi(optarg);
+			break;
+		case '?':
+		case 'h':
+			ft_usage(argv[0], "RDM chain of triggered sends, each "
+				 "released by the completion of the last.");
+			FT_PRINT_OPTS_USAGE("-n <count>", "number of triggered "
+					    "sends in the chain (default: 1000)");
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (chain_len < 1) {
+		FT_ERR("need at least one send in the chain");
+		return EXIT_FAILURE;
+	}
+
+	if (optind < argc)
+		opts.dst_addr = argv[optind];
+
+	/* one buffer slot per send, so the chain never reuses one */
+	opts.window_size = chain_len;
+
+	hints->ep_attr->type = FI_EP_RDM;
+	hints->caps = FI_MSG | FI_TRIGGER;
+	hints->mode = FI_CONTEXT | FI_CONTEXT2;
+	hints->domain_attr->mr_mode = opts.mr_mode;
+	hints->addr_format = opts.address_format;
+
+	ret = run_test();
+
+	ft_free_res();
+	return ft_exit_code(ret);
+}
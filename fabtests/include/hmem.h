@@ -228,5 +228,6 @@ int ft_hmem_get_dmabuf_fd(enum fi_hmem_iface iface,
 			  int *fd, uint64_t *offset);
 int ft_hmem_no_get_dmabuf_fd(void *buf, size_t len,
 			     int *fd, uint64_t *offset);
+int ft_hmem_use_memfd(void);
 
 #endif /* _HMEM_H_ */
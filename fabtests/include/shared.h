@@ -149,6 +149,8 @@ enum {
 	FT_OPT_ADDR_IS_OOB		= 1 << 26,
 	FT_OPT_REG_DMABUF_MR		= 1 << 27,
 	FT_OPT_NO_PRE_POSTED_RX		= 1 << 28,
+	FT_OPT_LAT_HIST			= 1 << 29,
+	FT_OPT_MEMFD			= 1 << 30,
 	FT_OPT_OOB_CTRL			= FT_OPT_OOB_SYNC | FT_OPT_OOB_ADDR_EXCH,
 };
 
@@ -177,6 +179,13 @@ enum op_state {
 	OP_PENDING
 };
 
+/* format of the performance results printed by show_perf() */
+enum ft_perf_format {
+	FT_PERF_TEXT,
+	FT_PERF_CSV,
+	FT_PERF_JSON,
+};
+
 struct ft_context {
 	char *buf;
 	void *desc;
@@ -207,6 +216,7 @@ struct ft_opts {
 	int options;
 	enum ft_comp_method comp_method;
 	int machr;
+	enum ft_perf_format perf_format;
 	enum ft_rma_opcodes rma_op;
 	enum ft_cqdata_opcodes cqdata_op;
 	char *oob_port;
@@ -516,8 +526,49 @@ static inline uint64_t ft_gettime_ms(void)
 	return ft_gettime_ns() / 1000000;
 }
 
+/*
+ * Log-linear histogram of per-iteration times, in the style of an HDR
+ * histogram: values are bucketed exactly up to FT_LAT_HIST_SUB ns, and
+ * above that with FT_LAT_HIST_SUB_BITS bits of precision (< 1% error).
+ */
+#define FT_LAT_HIST_SUB_BITS	7
+#define FT_LAT_HIST_SUB		(1 << FT_LAT_HIST_SUB_BITS)
+#define FT_LAT_HIST_MAX_BITS	40
+#define FT_LAT_HIST_BUCKETS	\
+	((FT_LAT_HIST_MAX_BITS - FT_LAT_HIST_SUB_BITS + 1) * FT_LAT_HIST_SUB)
+
+struct ft_lat_hist {
+	uint64_t count;
+	uint64_t min;
+	uint64_t max;
+	uint64_t last;
+	uint64_t bucket[FT_LAT_HIST_BUCKETS];
+};
+
+extern struct ft_lat_hist lat_hist;
+
+void ft_lat_hist_reset(void);
+void ft_lat_hist_add(uint64_t ns);
+uint64_t ft_lat_hist_percentile(double pct);
+
+/* Record the time since the previous mark, or since ft_start(). */
+static inline void ft_lat_mark(void)
+{
+	uint64_t now;
+
+	if ((opts.options & (FT_OPT_LAT_HIST | FT_OPT_ACTIVE)) !=
+	    (FT_OPT_LAT_HIST | FT_OPT_ACTIVE))
+		return;
+
+	now = ft_gettime_ns();
+	ft_lat_hist_add(now - lat_hist.last);
+	lat_hist.last = now;
+}
+
 static inline void ft_start(void)
 {
+	if (opts.options & FT_OPT_LAT_HIST)
+		ft_lat_hist_reset();
 	opts.options |= FT_OPT_ACTIVE;
 	clock_gettime(CLOCK_MONOTONIC, &start);
 }
@@ -673,6 +724,10 @@ enum {
 	LONG_OPT_MAX_MSG_SIZE,
 	LONG_OPT_USE_FI_MORE,
 	LONG_OPT_THREADING,
+	LONG_OPT_PIN_NODE,
+	LONG_OPT_LAT_HIST,
+	LONG_OPT_PERF_FORMAT,
+	LONG_OPT_MEMFD,
 };
 
 extern int debug_assert;
@@ -57,6 +57,8 @@ enum multi_pattern {
 	PATTERN_RING,
 	PATTERN_GATHER,
 	PATTERN_BROADCAST,
+	PATTERN_PAIRS,
+	PATTERN_ALL_TO_ALL,
 };
 
 enum multi_pm_type {
@@ -87,6 +89,7 @@ struct pm_job_info {
 	enum multi_xfer transfer_method;
 	enum multi_pattern pattern;
 	enum multi_pm_type pm;
+	bool		preconnect;
 };
 
 struct multinode_xfer_state {
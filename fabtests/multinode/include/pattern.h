@@ -43,6 +43,9 @@
 /* Number of patterns to test */
 extern const int NUM_TESTS;
 
+/* Patterns run when none is selected, the first entries of patterns[] */
+extern const int NUM_DEFAULT_TESTS;
+
 struct pattern_ops {
 	char *name;
 	int (*next_source)(int *cur);
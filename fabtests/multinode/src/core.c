@@ -94,6 +94,8 @@ static int multi_setup_fabric(int argc, char **argv)
 		hints->caps = FI_MSG;
 	} else if (pm_job.transfer_method == multi_rma) {
 		hints->caps = FI_MSG | FI_RMA;
+		/* rma writes go to a slot of the buffer per rank */
+		opts.window_size = MAX(opts.window_size, pm_job.num_ranks);
 	} else {
 		printf("Not a valid cabability\n");
 		return -FI_ENODATA;
@@ -518,7 +520,7 @@ int multinode_run_tests(int argc, char **argv)
 		fflush(stdout);
 
 	} else {
-		for (i = 0; i < NUM_TESTS && !ret; i++) {
+		for (i = 0; i < NUM_DEFAULT_TESTS && !ret; i++) {
 			PRINTF("starting %s... ", patterns[i].name);
 			pattern = &patterns[i];
 			ret = multi_run_test();
@@ -0,0 +1,283 @@
+/*
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Connection storm: every rank exchanges one message with every other rank
+ * right after address exchange, so all connections are set up at once.
+ * Reports the time to complete the first (cold) exchange and the average
+ * time of the following (warm) exchanges.  With -P, connections are
+ * requested up front through FI_OPT_RXM_PRECONNECT, or FI_OPT_TCP_PRECONNECT
+ * for the tcp provider's own rdm endpoints.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rdma/fi_errno.h>
+#include <rdma/fi_endpoint.h>
+#include <rdma/fi_cm.h>
+#include <rdma/fi_ext.h>
+
+#include <core.h>
+#include <shared.h>
+#include <hmem.h>
+
+static int storm_setup_fabric(void)
+{
+	char my_name[FT_MAX_CTRL_MSG];
+	size_t len;
+	int i, ret;
+
+	hints->ep_attr->type = FI_EP_RDM;
+	hints->caps = FI_MSG;
+	hints->mode = FI_CONTEXT | FI_CONTEXT2;
+	hints->domain_attr->mr_mode = opts.mr_mode;
+
+	ret = ft_hmem_init(opts.iface);
+	if (ret)
+		return ret;
+
+	if (pm_job.my_rank != 0)
+		pm_barrier();
+
+	ret = ft_getinfo(hints, &fi);
+	if (ret)
+		return ret;
+
+	ret = ft_open_fabric_res();
+	if (ret)
+		return ret;
+
+	opts.av_size = pm_job.num_ranks;
+	opts.window_size = pm_job.num_ranks;
+	ret = ft_alloc_active_res(fi);
+	if (ret)
+		return ret;
+
+	ret = ft_enable_ep(ep, eq, av, txcq, rxcq, txcntr, rxcntr, rma_cntr);
+	if (ret)
+		return ret;
+
+	ret = ft_alloc_msgs();
+	if (ret)
+		return ret;
+
+	len = FT_MAX_CTRL_MSG;
+	ret = fi_getname(&ep->fid, (void *) my_name, &len);
+	if (ret) {
+		FT_PRINTERR("error determining local endpoint name\n", ret);
+		return ret;
+	}
+
+	pm_job.name_len = FT_MAX_CTRL_MSG;
+	pm_job.names = malloc(pm_job.name_len * pm_job.num_ranks);
+	if (!pm_job.names) {
+		FT_ERR("error allocating memory for address exchange\n");
+		return -FI_ENOMEM;
+	}
+
+	if (pm_job.my_rank == 0)
+		pm_barrier();
+
+	ret = pm_allgather(my_name, pm_job.names, pm_job.name_len);
+	if (ret) {
+		FT_PRINTERR("error exchanging addresses\n", ret);
+		return ret;
+	}
+
+	pm_job.fi_addrs = calloc(pm_job.num_ranks, sizeof(*pm_job.fi_addrs));
+	if (!pm_job.fi_addrs) {
+		FT_ERR("error allocating memory for av fi addrs\n");
+		return -FI_ENOMEM;
+	}
+
+	for (i = 0; i < pm_job.num_ranks; i++) {
+		ret = fi_av_insert(av, (char *)pm_job.names + i * pm_job.name_len,
+				   1, &pm_job.fi_addrs[i], 0, NULL);
+		if (ret != 1) {
+			FT_ERR("unable to insert all addresses into AV table\n");
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Ask for connections to all peers with a single range covering their
+ * fi_addrs.  Unused entries inside the range are skipped by the provider.
+ */
+static int storm_preconnect(void)
+{
+	struct fi_rxm_preconnect range;
+	fi_addr_t lo = FI_ADDR_NOTAVAIL, hi = 0;
+	size_t i;
+	int ret;
+
+	for (i = 0; i < pm_job.num_ranks; i++) {
+		if (i == pm_job.my_rank)
+			continue;
+		if (lo == FI_ADDR_NOTAVAIL || pm_job.fi_addrs[i] < lo)
+			lo = pm_job.fi_addrs[i];
+		if (pm_job.fi_addrs[i] > hi)
+			hi = pm_job.fi_addrs[i];
+	}
+
+	if (lo == FI_ADDR_NOTAVAIL)
+		return 0;
+
+	range.addr = lo;
+	range.count = hi - lo + 1;
+	ret = fi_setopt(&ep->fid, FI_OPT_ENDPOINT, FI_OPT_RXM_PRECONNECT,
+			&range, sizeof(range));
+	if (ret == -FI_ENOPROTOOPT)
+		ret = fi_setopt(&ep->fid, FI_OPT_ENDPOINT,
+				FI_OPT_TCP_PRECONNECT, &range, sizeof(range));
+	if (ret == -FI_ENOPROTOOPT) {
+		PRINTF("pre-connect not supported by provider, ignoring -P\n");
+		return 0;
+	}
+	if (ret)
+		FT_PRINTERR("fi_setopt(preconnect)", ret);
+
+	return ret;
+}
+
+static int storm_exchange(void)
+{
+	size_t i, peer;
+	int ret;
+
+	for (i = 1; i < pm_job.num_ranks; i++) {
+		peer = (pm_job.my_rank + pm_job.num_ranks - i) %
+		       pm_job.num_ranks;
+		ret = ft_post_rx_buf(ep, opts.transfer_size,
+				     &rx_ctx_arr[peer].context,
+				     rx_ctx_arr[peer].buf,
+				     rx_ctx_arr[peer].desc, 0);
+		if (ret)
+			return ret;
+	}
+
+	for (i = 1; i < pm_job.num_ranks; i++) {
+		peer = (pm_job.my_rank + i) % pm_job.num_ranks;
+		ret = ft_post_tx_buf(ep, pm_job.fi_addrs[peer],
+				     opts.transfer_size, NO_CQ_DATA,
+				     &tx_ctx_arr[peer].context,
+				     tx_ctx_arr[peer].buf,
+				     tx_ctx_arr[peer].desc, 0);
+		if (ret)
+			return ret;
+	}
+
+	ret = ft_get_tx_comp(tx_seq);
+	if (ret)
+		return ret;
+
+	return ft_get_rx_comp(rx_seq);
+}
+
+static void storm_report(const char *name, uint64_t usec)
+{
+	uint64_t *all, max = 0, sum = 0;
+	size_t i;
+	int ret;
+
+	all = calloc(pm_job.num_ranks, sizeof(*all));
+	if (!all)
+		return;
+
+	ret = pm_allgather(&usec, all, sizeof(usec));
+	if (ret)
+		goto out;
+
+	for (i = 0; i < pm_job.num_ranks; i++) {
+		sum += all[i];
+		if (all[i] > max)
+			max = all[i];
+	}
+
+	PRINTF("%-12s ranks %zu  max %" PRIu64 " us  avg %" PRIu64 " us\n",
+	       name, pm_job.num_ranks, max, sum / pm_job.num_ranks);
+out:
+	free(all);
+}
+
+int multinode_run_tests(int argc, char **argv)
+{
+	uint64_t start, cold, warm = 0;
+	int i, ret;
+
+	if (!(opts.options & FT_OPT_ITER))
+		opts.iterations = 10;
+	opts.transfer_size = 64;
+
+	ret = storm_setup_fabric();
+	if (ret)
+		goto out;
+
+	if (pm_job.preconnect) {
+		ret = storm_preconnect();
+		if (ret)
+			goto out;
+	}
+
+	pm_barrier();
+	start = ft_gettime_us();
+	ret = storm_exchange();
+	if (ret)
+		goto out;
+	cold = ft_gettime_us() - start;
+
+	for (i = 0; i < opts.iterations; i++) {
+		pm_barrier();
+		start = ft_gettime_us();
+		ret = storm_exchange();
+		if (ret)
+			goto out;
+		warm += ft_gettime_us() - start;
+	}
+
+	storm_report("cold", cold);
+	if (opts.iterations)
+		storm_report("warm", warm / opts.iterations);
+	pm_barrier();
+out:
+	if (ret)
+		printf("failed\n");
+	else
+		printf("passed\n");
+
+	free(pm_job.names);
+	free(pm_job.fi_addrs);
+	ft_free_res();
+	return ft_exit_code(ret);
+}
@@ -0,0 +1,271 @@
+/*
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Incast: every rank but rank 0 sends a window (-W) of large (-S) tagged
+ * messages to rank 0, then one small message with another tag.  Rank 0
+ * receives the small messages first, so the large ones arrive unexpected and
+ * the small ones queue behind them.  The test fails if the small messages
+ * do not arrive within a few seconds.  Rank 0 then receives the large
+ * messages, and reports how far its peak RSS grew over the run next to the
+ * amount of data that was sent unexpected.  A provider that bounds the
+ * memory used for unexpected messages keeps the first well below the second.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include <rdma/fi_errno.h>
+#include <rdma/fi_endpoint.h>
+#include <rdma/fi_cm.h>
+#include <rdma/fi_tagged.h>
+
+#include <core.h>
+#include <shared.h>
+#include <hmem.h>
+
+#define INCAST_LARGE_TAG	0x1
+#define INCAST_SMALL_TAG	0x2
+#define INCAST_SMALL_SIZE	16
+#define INCAST_STALL_TIMEOUT	10
+
+static int incast_setup_fabric(void)
+{
+	char my_name[FT_MAX_CTRL_MSG];
+	size_t len;
+	int i, ret;
+
+	hints->ep_attr->type = FI_EP_RDM;
+	hints->caps = FI_TAGGED;
+	hints->mode = FI_CONTEXT | FI_CONTEXT2;
+	hints->domain_attr->mr_mode = opts.mr_mode;
+
+	ret = ft_hmem_init(opts.iface);
+	if (ret)
+		return ret;
+
+	if (pm_job.my_rank != 0)
+		pm_barrier();
+
+	ret = ft_getinfo(hints, &fi);
+	if (ret)
+		return ret;
+
+	ret = ft_open_fabric_res();
+	if (ret)
+		return ret;
+
+	opts.av_size = pm_job.num_ranks;
+	ret = ft_alloc_active_res(fi);
+	if (ret)
+		return ret;
+
+	ret = ft_enable_ep(ep, eq, av, txcq, rxcq, txcntr, rxcntr, rma_cntr);
+	if (ret)
+		return ret;
+
+	ret = ft_alloc_msgs();
+	if (ret)
+		return ret;
+
+	len = FT_MAX_CTRL_MSG;
+	ret = fi_getname(&ep->fid, (void *) my_name, &len);
+	if (ret) {
+		FT_PRINTERR("error determining local endpoint name\n", ret);
+		return ret;
+	}
+
+	pm_job.name_len = FT_MAX_CTRL_MSG;
+	pm_job.names = malloc(pm_job.name_len * pm_job.num_ranks);
+	if (!pm_job.names) {
+		FT_ERR("error allocating memory for address exchange\n");
+		return -FI_ENOMEM;
+	}
+
+	if (pm_job.my_rank == 0)
+		pm_barrier();
+
+	ret = pm_allgather(my_name, pm_job.names, pm_job.name_len);
+	if (ret) {
+		FT_PRINTERR("error exchanging addresses\n", ret);
+		return ret;
+	}
+
+	pm_job.fi_addrs = calloc(pm_job.num_ranks, sizeof(*pm_job.fi_addrs));
+	if (!pm_job.fi_addrs) {
+		FT_ERR("error allocating memory for av fi addrs\n");
+		return -FI_ENOMEM;
+	}
+
+	/* rank 0 needs the senders in its AV for their messages to be
+	 * matched before a receive is posted
+	 */
+	for (i = 0; i < pm_job.num_ranks; i++) {
+		ret = fi_av_insert(av, (char *)pm_job.names + i * pm_job.name_len,
+				   1, &pm_job.fi_addrs[i], 0, NULL);
+		if (ret != 1) {
+			FT_ERR("unable to insert all addresses into AV table\n");
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static long incast_maxrss(void)
+{
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage))
+		return 0;
+	return usage.ru_maxrss;
+}
+
+static int incast_send(void)
+{
+	int i, ret;
+
+	for (i = 0; i < opts.window_size; i++) {
+		ret = ft_post_tx_buf(ep, pm_job.fi_addrs[0], opts.transfer_size,
+				     NO_CQ_DATA, &tx_ctx_arr[i].context,
+				     tx_ctx_arr[i].buf, tx_ctx_arr[i].desc,
+				     INCAST_LARGE_TAG);
+		if (ret)
+			return ret;
+	}
+
+	ret = ft_post_tx_buf(ep, pm_job.fi_addrs[0], INCAST_SMALL_SIZE,
+			     NO_CQ_DATA, &tx_ctx, tx_buf, mr_desc,
+			     INCAST_SMALL_TAG);
+	if (ret)
+		return ret;
+
+	return ft_get_tx_comp(tx_seq);
+}
+
+static int incast_recv(uint64_t *small_us)
+{
+	uint64_t start;
+	size_t i, senders = pm_job.num_ranks - 1;
+	int j, ret;
+
+	start = ft_gettime_us();
+	for (i = 0; i < senders; i++) {
+		j = i % opts.window_size;
+		ret = ft_post_rx_buf(ep, INCAST_SMALL_SIZE,
+				     &rx_ctx_arr[j].context, rx_ctx_arr[j].buf,
+				     rx_ctx_arr[j].desc, INCAST_SMALL_TAG);
+		if (ret)
+			return ret;
+	}
+
+	timeout = INCAST_STALL_TIMEOUT;
+	ret = ft_get_rx_comp(rx_seq);
+	timeout = -1;
+	if (ret == -FI_ENODATA) {
+		FT_ERR("small messages stalled behind unexpected large ones\n");
+		return ret;
+	} else if (ret) {
+		return ret;
+	}
+	*small_us = ft_gettime_us() - start;
+
+	for (i = 0; i < senders; i++) {
+		for (j = 0; j < opts.window_size; j++) {
+			ret = ft_post_rx_buf(ep, opts.transfer_size,
+					     &rx_ctx_arr[j].context,
+					     rx_ctx_arr[j].buf,
+					     rx_ctx_arr[j].desc,
+					     INCAST_LARGE_TAG);
+			if (ret)
+				return ret;
+		}
+
+		ret = ft_get_rx_comp(rx_seq);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+int multinode_run_tests(int argc, char **argv)
+{
+	uint64_t small_us = 0, max_small_us = 0;
+	long base_rss;
+	int i, ret;
+
+	if (!(opts.options & FT_OPT_ITER))
+		opts.iterations = 4;
+
+	if (pm_job.num_ranks < 2) {
+		FT_ERR("incast needs at least 2 ranks\n");
+		ret = -FI_EINVAL;
+		goto out;
+	}
+
+	ret = incast_setup_fabric();
+	if (ret)
+		goto out;
+
+	base_rss = incast_maxrss();
+	for (i = 0; i < opts.iterations; i++) {
+		pm_barrier();
+		if (pm_job.my_rank) {
+			ret = incast_send();
+		} else {
+			ret = incast_recv(&small_us);
+			max_small_us = MAX(max_small_us, small_us);
+		}
+		if (ret)
+			goto out;
+	}
+
+	PRINTF("senders %zu, %d x %zu bytes unexpected each\n",
+	       pm_job.num_ranks - 1, opts.window_size, opts.transfer_size);
+	PRINTF("small messages received in at most %" PRIu64 " us\n",
+	       max_small_us);
+	PRINTF("unexpected data %zu KiB, peak RSS growth %ld KiB\n",
+	       (pm_job.num_ranks - 1) * opts.window_size *
+	       opts.transfer_size / 1024, incast_maxrss() - base_rss);
+	pm_barrier();
+out:
+	if (ret)
+		printf("failed\n");
+	else
+		printf("passed\n");
+
+	free(pm_job.names);
+	free(pm_job.fi_addrs);
+	ft_free_res();
+	return ft_exit_code(ret);
+}
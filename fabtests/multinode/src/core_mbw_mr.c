@@ -0,0 +1,391 @@
+/*
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Aggregate message rate with many concurrent senders, in the style of OSU
+ * mbw_mr.  For each of -I windows, every rank posts -W receives for each of
+ * its sources and -W sends to each of its targets, as given by the -z
+ * pattern (default: pairs).  Once a rank has received its window it
+ * acknowledges it to each source, and a rank does not start the next
+ * window before all its targets have acknowledged the last one.  Rank 0
+ * reports the aggregate message rate and bandwidth of the job, and the
+ * rate of the slowest sender.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <rdma/fi_errno.h>
+#include <rdma/fi_endpoint.h>
+#include <rdma/fi_cm.h>
+#include <rdma/fi_tagged.h>
+
+#include <core.h>
+#include <shared.h>
+#include <hmem.h>
+
+#define MBW_DATA_TAG	0x1
+#define MBW_ACK_TAG	0x2
+
+struct mbw_result {
+	uint64_t msgs;
+	uint64_t nsec;
+};
+
+static struct pattern_ops *pattern;
+static int *sources, *targets;
+static int num_sources, num_targets;
+static struct fi_context2 *tx_ctxs, *rx_ctxs;
+
+static int mbw_setup_fabric(void)
+{
+	char my_name[FT_MAX_CTRL_MSG];
+	size_t len;
+	int i, ret;
+
+	hints->ep_attr->type = FI_EP_RDM;
+	hints->caps = FI_MSG | FI_TAGGED;
+	hints->mode = FI_CONTEXT | FI_CONTEXT2;
+	hints->domain_attr->mr_mode = opts.mr_mode;
+
+	ret = ft_hmem_init(opts.iface);
+	if (ret)
+		return ret;
+
+	if (pm_job.my_rank != 0)
+		pm_barrier();
+
+	ret = ft_getinfo(hints, &fi);
+	if (ret)
+		return ret;
+
+	ret = ft_open_fabric_res();
+	if (ret)
+		return ret;
+
+	opts.av_size = pm_job.num_ranks;
+	ret = ft_alloc_active_res(fi);
+	if (ret)
+		return ret;
+
+	ret = ft_enable_ep(ep, eq, av, txcq, rxcq, txcntr, rxcntr, rma_cntr);
+	if (ret)
+		return ret;
+
+	ret = ft_alloc_msgs();
+	if (ret)
+		return ret;
+
+	len = FT_MAX_CTRL_MSG;
+	ret = fi_getname(&ep->fid, (void *) my_name, &len);
+	if (ret) {
+		FT_PRINTERR("error determining local endpoint name\n", ret);
+		return ret;
+	}
+
+	pm_job.name_len = FT_MAX_CTRL_MSG;
+	pm_job.names = malloc(pm_job.name_len * pm_job.num_ranks);
+	if (!pm_job.names) {
+		FT_ERR("error allocating memory for address exchange\n");
+		return -FI_ENOMEM;
+	}
+
+	if (pm_job.my_rank == 0)
+		pm_barrier();
+
+	ret = pm_allgather(my_name, pm_job.names, pm_job.name_len);
+	if (ret) {
+		FT_PRINTERR("error exchanging addresses\n", ret);
+		return ret;
+	}
+
+	pm_job.fi_addrs = calloc(pm_job.num_ranks, sizeof(*pm_job.fi_addrs));
+	if (!pm_job.fi_addrs) {
+		FT_ERR("error allocating memory for av fi addrs\n");
+		return -FI_ENOMEM;
+	}
+
+	for (i = 0; i < pm_job.num_ranks; i++) {
+		ret = fi_av_insert(av, (char *)pm_job.names + i * pm_job.name_len,
+				   1, &pm_job.fi_addrs[i], 0, NULL);
+		if (ret != 1) {
+			FT_ERR("unable to insert all addresses into AV table\n");
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int mbw_get_peers(int (*next)(int *cur), int **peers, int *cnt)
+{
+	int cur = PATTERN_NO_CURRENT;
+
+	*peers = calloc(pm_job.num_ranks, sizeof(**peers));
+	if (!*peers)
+		return -FI_ENOMEM;
+
+	*cnt = 0;
+	while (!next(&cur))
+		(*peers)[(*cnt)++] = cur;
+
+	return 0;
+}
+
+/*
+ * All the receives of a window are posted before any send, so the window
+ * has to fit in the queues, or ranks posting receives to each other would
+ * wait on each other.  All ranks must use the same window.
+ */
+static int mbw_alloc_ctxs(void)
+{
+	int *windows, window = opts.window_size;
+	int i, ret;
+
+	if (num_sources)
+		window = MIN(window, fi->rx_attr->size / num_sources);
+	if (num_targets)
+		window = MIN(window, fi->tx_attr->size / num_targets);
+
+	windows = calloc(pm_job.num_ranks, sizeof(*windows));
+	if (!windows)
+		return -FI_ENOMEM;
+
+	ret = pm_allgather(&window, windows, sizeof(window));
+	for (i = 0; i < pm_job.num_ranks; i++)
+		window = MIN(window, windows[i]);
+	free(windows);
+	if (ret)
+		return ret;
+
+	if (window < 1) {
+		FT_ERR("%d peers do not fit in the tx/rx queues\n",
+		       MAX(num_sources, num_targets));
+		return -FI_EINVAL;
+	}
+	if (window < opts.window_size) {
+		PRINTF("window reduced to %d to fit in the tx/rx queues\n",
+		       window);
+		opts.window_size = window;
+	}
+
+	tx_ctxs = calloc(MAX(window * num_targets, num_sources) + 1,
+			 sizeof(*tx_ctxs));
+	rx_ctxs = calloc(MAX(window * num_sources, num_targets) + 1,
+			 sizeof(*rx_ctxs));
+	if (!tx_ctxs || !rx_ctxs)
+		return -FI_ENOMEM;
+
+	return 0;
+}
+
+static int mbw_ack(void)
+{
+	int i, ret;
+
+	for (i = 0; i < num_targets; i++) {
+		ret = ft_post_rx_buf(ep, 0, &rx_ctxs[i], rx_buf, mr_desc,
+				     MBW_ACK_TAG);
+		if (ret)
+			return ret;
+	}
+
+	for (i = 0; i < num_sources; i++) {
+		ret = ft_post_tx_buf(ep, pm_job.fi_addrs[sources[i]], 0,
+				     NO_CQ_DATA, &tx_ctxs[i], tx_buf, mr_desc,
+				     MBW_ACK_TAG);
+		if (ret)
+			return ret;
+	}
+
+	ret = ft_get_tx_comp(tx_seq);
+	if (ret)
+		return ret;
+
+	return ft_get_rx_comp(rx_seq);
+}
+
+static int mbw_window(void)
+{
+	int i, j, n, ret;
+
+	for (i = 0, n = 0; i < num_sources; i++) {
+		for (j = 0; j < opts.window_size; j++, n++) {
+			ret = ft_post_rx_buf(ep, opts.transfer_size,
+					     &rx_ctxs[n], rx_buf, mr_desc,
+					     MBW_DATA_TAG);
+			if (ret)
+				return ret;
+		}
+	}
+
+	/* round robin over the targets, as concurrent senders would */
+	for (j = 0, n = 0; j < opts.window_size; j++) {
+		for (i = 0; i < num_targets; i++, n++) {
+			ret = ft_post_tx_buf(ep, pm_job.fi_addrs[targets[i]],
+					     opts.transfer_size, NO_CQ_DATA,
+					     &tx_ctxs[n], tx_buf, mr_desc,
+					     MBW_DATA_TAG);
+			if (ret)
+				return ret;
+		}
+	}
+
+	ret = ft_get_tx_comp(tx_seq);
+	if (ret)
+		return ret;
+
+	ret = ft_get_rx_comp(rx_seq);
+	if (ret)
+		return ret;
+
+	return mbw_ack();
+}
+
+static int mbw_run(uint64_t *nsec)
+{
+	uint64_t start;
+	int i, ret;
+
+	for (i = 0; i < opts.warmup_iterations; i++) {
+		ret = mbw_window();
+		if (ret)
+			return ret;
+	}
+
+	pm_barrier();
+	start = ft_gettime_ns();
+	for (i = 0; i < opts.iterations; i++) {
+		ret = mbw_window();
+		if (ret)
+			return ret;
+	}
+	*nsec = ft_gettime_ns() - start;
+
+	return 0;
+}
+
+static int mbw_report(uint64_t nsec)
+{
+	struct mbw_result mine, *all;
+	uint64_t msgs = 0, max_nsec = 0;
+	double rate, min_rate = 0;
+	int i, senders = 0, ret;
+
+	mine.msgs = (uint64_t) opts.iterations * opts.window_size * num_targets;
+	mine.nsec = nsec;
+
+	all = calloc(pm_job.num_ranks, sizeof(*all));
+	if (!all)
+		return -FI_ENOMEM;
+
+	ret = pm_allgather(&mine, all, sizeof(mine));
+	if (ret)
+		goto out;
+
+	for (i = 0; i < pm_job.num_ranks; i++) {
+		max_nsec = MAX(max_nsec, all[i].nsec);
+		if (!all[i].msgs)
+			continue;
+
+		msgs += all[i].msgs;
+		rate = all[i].msgs * 1000.0 / all[i].nsec;
+		if (!senders++ || rate < min_rate)
+			min_rate = rate;
+	}
+
+	if (!senders) {
+		FT_ERR("pattern %s has no senders with %zu ranks\n",
+		       pattern->name, pm_job.num_ranks);
+		ret = -FI_EINVAL;
+		goto out;
+	}
+
+	PRINTF("%-12s%-8s%-8s%-8s%-8s%13s%13s%13s\n", "pattern", "ranks",
+	       "senders", "bytes", "window", "Mmsgs/sec", "MB/sec",
+	       "min Mmsgs/s");
+	PRINTF("%-12s%-8zu%-8d%-8zu%-8d%13.3f%13.2f%13.3f\n", pattern->name,
+	       pm_job.num_ranks, senders, opts.transfer_size,
+	       opts.window_size, msgs * 1000.0 / max_nsec,
+	       msgs * opts.transfer_size * 1000.0 / max_nsec, min_rate);
+out:
+	free(all);
+	return ret;
+}
+
+int multinode_run_tests(int argc, char **argv)
+{
+	uint64_t nsec;
+	int ret;
+
+	if (!(opts.options & FT_OPT_ITER))
+		opts.iterations = 100;
+	pattern = &patterns[(int) pm_job.pattern < 0 ?
+			    PATTERN_PAIRS : pm_job.pattern];
+	remote_fi_addr = FI_ADDR_UNSPEC;
+
+	ret = mbw_setup_fabric();
+	if (ret)
+		goto out;
+
+	ret = mbw_get_peers(pattern->next_source, &sources, &num_sources);
+	if (ret)
+		goto out;
+
+	ret = mbw_get_peers(pattern->next_target, &targets, &num_targets);
+	if (ret)
+		goto out;
+
+	ret = mbw_alloc_ctxs();
+	if (ret)
+		goto out;
+
+	ret = mbw_run(&nsec);
+	if (ret)
+		goto out;
+
+	ret = mbw_report(nsec);
+	pm_barrier();
+out:
+	if (ret)
+		printf("failed\n");
+	else
+		printf("passed\n");
+
+	free(sources);
+	free(targets);
+	free(tx_ctxs);
+	free(rx_ctxs);
+	free(pm_job.names);
+	free(pm_job.fi_addrs);
+	ft_free_res();
+	return ft_exit_code(ret);
+}
@@ -78,6 +78,10 @@ static enum multi_pattern parse_pattern(char *pattern)
 		return PATTERN_GATHER;
 	} else if (strcmp(pattern, "broadcast") == 0) {
 		return PATTERN_BROADCAST;
+	} else if (strcmp(pattern, "pairs") == 0) {
+		return PATTERN_PAIRS;
+	} else if (strcmp(pattern, "all_to_all") == 0) {
+		return PATTERN_ALL_TO_ALL;
 	} else {
 		printf("Warn: Invalid pattern, defaulting to full_mesh\n");
 		return PATTERN_MESH;
@@ -365,7 +369,7 @@ int main(int argc, char **argv)
 	if (!hints)
 		return EXIT_FAILURE;
 
-	while ((c = getopt(argc, argv, "n:x:z:u:Ths:I:" INFO_OPTS)) != -1) {
+	while ((c = getopt(argc, argv, "n:x:z:u:PThs:I:S:W:" INFO_OPTS)) != -1) {
 		switch (c) {
 		default:
 			ft_parse_addr_opts(c, optarg, &opts);
@@ -375,6 +379,12 @@ int main(int argc, char **argv)
 			opts.options |= FT_OPT_ITER;
 			opts.iterations = atoi(optarg);
 			break;
+		case 'S':
+			opts.transfer_size = atol(optarg);
+			break;
+		case 'W':
+			opts.window_size = atoi(optarg);
+			break;
 		case 'n':
 			pm_job.num_ranks = atoi(optarg);
 			break;
@@ -391,6 +401,9 @@ int main(int argc, char **argv)
 			/* setup the process manager type */
 			pm_job.pm = parse_pm(optarg);
 			break;
+		case 'P':
+			pm_job.preconnect = true;
+			break;
 		case '?':
 		case 'h':
 			fprintf(stderr, "Usage:\n");
@@ -408,8 +421,14 @@ int main(int argc, char **argv)
 			FT_PRINT_OPTS_USAGE("-I <iters>", "number of iterations");
 			FT_PRINT_OPTS_USAGE("-T", "pass to enable performance "
 					    "timing mode");
+			FT_PRINT_OPTS_USAGE("-P", "request connections to all "
+					    "peers up front (connstorm)");
+			FT_PRINT_OPTS_USAGE("-S <size>", "message size");
+			FT_PRINT_OPTS_USAGE("-W <window>", "messages in flight "
+					    "to each peer");
 			FT_PRINT_OPTS_USAGE("-z <pattern>", "full_mesh, ring, "
-					    "gather, or broadcast pattern. "
+					    "gather (all to one), broadcast, "
+					    "pairs, or all_to_all pattern. "
 					    "Default: All\n");
 
 			fprintf(stderr, "General Fabtests options: \n\n");
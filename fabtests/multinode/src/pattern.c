@@ -102,6 +102,58 @@ static int mesh_next(int *cur)
 	return 0;
 }
 
+/* The first half of the ranks sends to the second half, pairwise. */
+static int pairs_source(int *cur)
+{
+	int half = pm_job.num_ranks / 2, me = pm_job.my_rank;
+
+	if (*cur != PATTERN_NO_CURRENT || me < half || me >= 2 * half)
+		return -FI_ENODATA;
+
+	*cur = me - half;
+	return 0;
+}
+
+static int pairs_target(int *cur)
+{
+	int half = pm_job.num_ranks / 2, me = pm_job.my_rank;
+
+	if (*cur != PATTERN_NO_CURRENT || me >= half)
+		return -FI_ENODATA;
+
+	*cur = me + half;
+	return 0;
+}
+
+/*
+ * Every rank sends to every other rank, starting with its right neighbor
+ * and shifting by one each step, so that no rank is the target of all the
+ * others at the same time.
+ */
+static int all_to_all_source(int *cur)
+{
+	int n = pm_job.num_ranks, me = pm_job.my_rank, step;
+
+	step = *cur == PATTERN_NO_CURRENT ? 1 : (me - *cur + n) % n + 1;
+	if (step >= n)
+		return -FI_ENODATA;
+
+	*cur = (me - step + n) % n;
+	return 0;
+}
+
+static int all_to_all_target(int *cur)
+{
+	int n = pm_job.num_ranks, me = pm_job.my_rank, step;
+
+	step = *cur == PATTERN_NO_CURRENT ? 1 : (*cur - me + n) % n + 1;
+	if (step >= n)
+		return -FI_ENODATA;
+
+	*cur = (me + step) % n;
+	return 0;
+}
+
 struct pattern_ops patterns[] = {
 	{
 		.name = "full_mesh",
@@ -123,6 +175,18 @@ struct pattern_ops patterns[] = {
 		.next_source = broadcast_gather_current,
 		.next_target = broadcast_gather_next,
 	},
+	/* Only run when selected with -z */
+	{
+		.name = "pairs",
+		.next_source = pairs_source,
+		.next_target = pairs_target,
+	},
+	{
+		.name = "all_to_all",
+		.next_source = all_to_all_source,
+		.next_target = all_to_all_target,
+	},
 };
 
 const int NUM_TESTS = ARRAY_SIZE(patterns);
+const int NUM_DEFAULT_TESTS = PATTERN_PAIRS;
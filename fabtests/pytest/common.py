@@ -15,6 +15,7 @@ import pytest
 
 
 perf_progress_model_cli = "--data-progress manual --control-progress unified"
+perf_executable_pattern = re.compile(r"fi_\w*(pingpong|_bw)\b")
 SERVER_RESTART_DELAY_MS = 10_1000
 CLIENT_RETRY_INTERVAL_MS = 1_000
 
@@ -434,6 +435,10 @@ class ClientServerTest:
         if message_size:
             command += " -S " + str(message_size)
 
+        if self._cmdline_args.perf_log and command_type == "client" \
+                and perf_executable_pattern.match(executable):
+            command += " --perf-format json --lat-hist"
+
         # in communication test, client is sender, server is receiver
         client_memory_type, server_memory_type = memory_type.split("_to_")
         host_memory_type, host_ip = (server_memory_type, self._cmdline_args.server_id) if command_type == "server" else (
@@ -529,11 +534,28 @@ class ClientServerTest:
         print(result.output)
         print(f"client returncode: {result.returncode}")
 
+        if self._cmdline_args.perf_log:
+            self._save_perf_records(result.output)
+
         if client_timed_out:
             raise RuntimeError("Client timed out")
 
         return result
 
+    def _save_perf_records(self, output):
+        test_name = os.environ.get("PYTEST_CURRENT_TEST", "").split(" ")[0]
+        with open(self._cmdline_args.perf_log, "a") as perf_log:
+            for line in output.splitlines():
+                if not line.startswith("{"):
+                    continue
+                try:
+                    record = json.loads(line)
+                except ValueError:
+                    continue
+                record["test"] = test_name
+                record["provider"] = self._cmdline_args.provider
+                perf_log.write(json.dumps(record) + "\n")
+
     @retry(retry_on_exception=is_ssh_connection_error, stop_max_attempt_number=3, wait_fixed=SERVER_RESTART_DELAY_MS)
     def run(self):
         if self._cmdline_args.is_test_excluded(self._server_base_command):
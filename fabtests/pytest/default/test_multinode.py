@@ -24,3 +24,26 @@ def test_multinode_coll(cmdline_args):
     test = MultinodeTest(cmdline_args, server_base_command, client_base_command,
                          client_hostname_list, run_client_asynchronously=True)
     test.run()
+
+@pytest.mark.multinode
+@pytest.mark.parametrize("pattern", ["pairs", "gather", "all_to_all"])
+def test_multinode_mbw_mr(cmdline_args, pattern):
+
+    numproc = 4
+    client_hostname_list = [cmdline_args.client_id, ] * (numproc - 1)
+    client_base_command = f"fi_rdm_mbw_mr -z {pattern} -n {numproc} -I 10"
+    server_base_command = client_base_command
+    test = MultinodeTest(cmdline_args, server_base_command, client_base_command,
+                         client_hostname_list, run_client_asynchronously=True)
+    test.run()
+
+@pytest.mark.multinode
+def test_rdm_incast(cmdline_args):
+
+    numproc = 4
+    client_hostname_list = [cmdline_args.client_id, ] * (numproc - 1)
+    client_base_command = f"fi_rdm_incast -n {numproc} -S 1048576 -W 16 -I 2"
+    server_base_command = client_base_command
+    test = MultinodeTest(cmdline_args, server_base_command, client_base_command,
+                         client_hostname_list, run_client_asynchronously=True)
+    test.run()
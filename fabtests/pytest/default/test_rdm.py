@@ -1,4 +1,5 @@
 import pytest
+import copy
 
 @pytest.mark.unit
 def test_rdm_g00n13s(cmdline_args):
@@ -24,6 +25,12 @@ def test_rdm_rma_trigger(cmdline_args):
     test = ClientServerTest(cmdline_args, "fi_rdm_rma_trigger")
     test.run()
 
+@pytest.mark.functional
+def test_rdm_trigger_chain(cmdline_args):
+    from common import ClientServerTest
+    test = ClientServerTest(cmdline_args, "fi_rdm_trigger_chain")
+    test.run()
+
 @pytest.mark.functional
 def test_rdm_tagged_peek(cmdline_args):
     from common import ClientServerTest
@@ -96,4 +103,58 @@ def test_rdm_bw_mt(cmdline_args, iteration_type, datacheck_type, completion_sema
                             completion_semantic, datacheck_type=datacheck_type)
     test.run()
 
+@pytest.mark.parametrize("iteration_type",
+                         [pytest.param("short", marks=pytest.mark.short),
+                          pytest.param("standard", marks=pytest.mark.standard)])
+def test_rdm_strided_bw(cmdline_args, iteration_type, datacheck_type, completion_semantic):
+    from common import ClientServerTest
+    test = ClientServerTest(cmdline_args, "fi_rdm_strided_bw", iteration_type,
+                            completion_semantic, datacheck_type=datacheck_type)
+    test.run()
+
+
+
+@pytest.mark.parametrize("iteration_type",
+                         [pytest.param("short", marks=pytest.mark.short),
+                          pytest.param("standard", marks=pytest.mark.standard)])
+def test_rdm_overlap(cmdline_args, iteration_type, completion_semantic):
+    from common import ClientServerTest
+    test = ClientServerTest(cmdline_args, "fi_rdm_overlap", iteration_type,
+                            completion_semantic)
+    test.run()
+
+
+@pytest.mark.parametrize("iteration_type",
+                         [pytest.param("short", marks=pytest.mark.short),
+                          pytest.param("standard", marks=pytest.mark.standard)])
+def test_rdm_conn_scale(cmdline_args, iteration_type):
+    from common import ClientServerTest
+    test = ClientServerTest(cmdline_args, "fi_rdm_conn_scale -n 1024",
+                            iteration_type)
+    test.run()
+
+
+# The server keeps fewer connections than there are client endpoints, so rxm
+# has to close idle ones between rounds and reconnect them in the next.
+@pytest.mark.functional
+def test_rdm_conn_scale_evict(cmdline_args):
+    from common import ClientServerTest
+    cmdline_args_copy = copy.copy(cmdline_args)
+    cmdline_args_copy.append_environ("FI_OFI_RXM_MAX_CONNS=8")
+    test = ClientServerTest(cmdline_args_copy,
+                            "fi_rdm_conn_scale -n 32 -q 1500 -I 4")
+    test.run()
+
 
+@pytest.mark.parametrize("key_type", ["application", "provider"])
+@pytest.mark.parametrize("iteration_type",
+                         [pytest.param("short", marks=pytest.mark.short),
+                          pytest.param("standard", marks=pytest.mark.standard)])
+def test_rma_mr_scale(cmdline_args, iteration_type, key_type, completion_semantic):
+    from common import ClientServerTest
+    command = "fi_rma_mr_scale"
+    if key_type == "provider":
+        command += " -g"
+    test = ClientServerTest(cmdline_args, command, iteration_type,
+                            completion_semantic)
+    test.run()
@@ -0,0 +1,33 @@
+import os
+import pytest
+from common import MultinodeTest
+
+
+def numa_node_has_cpus(node):
+    path = "/sys/devices/system/node/node{}/cpulist".format(node)
+    if not os.path.exists(path):
+        return False
+    with open(path) as f:
+        return f.read().strip() != ""
+
+
+# Latency and bandwidth between processes pinned to different NUMA nodes,
+# which exercises the placement of shm regions on the receiver's node.
+@pytest.mark.parametrize("executable", ["fi_rdm_pingpong", "fi_rdm_bw"])
+@pytest.mark.parametrize("iteration_type",
+                         [pytest.param("short", marks=pytest.mark.short),
+                          pytest.param("standard", marks=pytest.mark.standard)])
+def test_numa_cross_node(cmdline_args, executable, iteration_type):
+    # The tests exit with an error when they cannot pin to a node, so both
+    # nodes need cpus for the test to run at all.
+    if not numa_node_has_cpus(0) or not numa_node_has_cpus(1):
+        pytest.skip("This test requires NUMA nodes 0 and 1 with cpus")
+
+    command = executable + " -e rdm"
+    if iteration_type == "short":
+        command += " -I 5"
+    test = MultinodeTest(cmdline_args, command + " --pin-node 0",
+                         command + " --pin-node 1",
+                         [cmdline_args.client_id],
+                         run_client_asynchronously=False)
+    test.run()
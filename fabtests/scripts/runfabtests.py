@@ -309,6 +309,10 @@ def main():
     add_common_arguments(parser, shared_options)
 
     fabtests_args = parser.parse_args()
+    if fabtests_args.perf_log:
+        # pytest runs from its own directory
+        fabtests_args.perf_log = os.path.abspath(fabtests_args.perf_log)
+
     if fabtests_args.provider not in ["efa", "shm"] and fabtests_args.nworkers > 1:
         print("only efa and shm provider support parallelized tests. Setting nworkers to 1 ....")
         fabtests_args.nworkers = 1
@@ -115,6 +115,7 @@ functional_tests=(
 	"fi_rdm -U"
 	"fi_rdm_rma_event"
 	"fi_rdm_rma_trigger"
+	"fi_rdm_trigger_chain"
 	"fi_shared_ctx"
 	"fi_shared_ctx --no-tx-shared-ctx"
 	"fi_shared_ctx --no-rx-shared-ctx"
@@ -214,6 +215,7 @@ standard_tests=(
 	"fi_rdm_atomic -o all -I 1000 -v"
 	"fi_rdm_atomic -o all -I 1000 -U -v"
 	"fi_rdm_cntr_pingpong"
+	"fi_rdm_conn_scale -n 1024"
 	"fi_multi_recv -e rdm"
 	"fi_multi_recv -e msg"
 	"fi_rdm_pingpong"
@@ -232,6 +234,8 @@ standard_tests=(
 	"fi_rdm_tagged_bw -U"
 	"fi_rdm_tagged_bw -v"
 	"fi_rdm_tagged_bw -v -U"
+	"fi_rdm_strided_bw"
+	"fi_rdm_strided_bw -v"
 	"fi_dgram_pingpong"
 	"fi_dgram_pingpong -k"
 )
@@ -260,6 +264,8 @@ multinode_tests=(
 	"fi_multinode -x msg"
 	"fi_multinode -x rma"
 	"fi_multinode_coll"
+	"fi_multinode_connstorm"
+	"fi_rdm_incast -S 1048576 -W 16"
 )
 
 threaded_tests=(
@@ -269,6 +275,7 @@ threaded_tests=(
 	"fi_rdm_bw_mt -n 16 -g"
 	"fi_rdm_bw_mt -n 32"
 	"fi_rdm_bw_mt -n 32 -g"
+	"fi_rdm_bw_mt -n 8 -u"
 )
 
 prov_efa_tests=( \
@@ -2,6 +2,7 @@
 
 import sys
 import csv
+import json
 from optparse import OptionParser
 
 try:
@@ -10,12 +11,33 @@ except ImportError:
 	print ("PyYAML library missing, try: yum install pyyaml")
 	sys.exit(1)
 
+def perf_to_csv(fd):
+	"""Convert the JSON lines printed with --perf-format json, or saved
+	   with runfabtests.py --perf-log, to CSV.
+	"""
+	records = []
+	keys = []
+	for line in fd:
+		if not line.startswith("{"):
+			continue
+		record = json.loads(line)
+		keys += [k for k in record if k not in keys]
+		records.append(record)
+
+	csv_fd = csv.DictWriter(sys.stdout, fieldnames=keys, delimiter=",", quotechar='"', quoting=csv.QUOTE_NONNUMERIC)
+	csv_fd.writeheader()
+	for record in records:
+		csv_fd.writerow(record)
+
+	return 0
+
 def main(argv=None):
 	"""Convert runfabtests.sh yaml output to CSV. If no argument is given
 	   stdin is read, otherwise read from file.
 	"""
 
 	parser = OptionParser(description=main.__doc__, usage="usage: %prog [file]")
+	parser.add_option('-p', action='store_true', default=False, help=perf_to_csv.__doc__)
 	(options, args) = parser.parse_args()
 
 	if len(args) == 0:
@@ -23,6 +45,9 @@ def main(argv=None):
 	else:
 		fd = open(args[0], 'r')
 
+	if options.p:
+		return perf_to_csv(fd)
+
 	yi = yaml.safe_load(fd.read())
 
 	csv_fd = csv.writer(sys.stdout, delimiter=",", quotechar='"', quoting=csv.QUOTE_NONNUMERIC)
@@ -48,6 +48,8 @@
 #include <sys/socket.h>
 
 #include <linux/errqueue.h>
+#include <linux/futex.h>
+#include <linux/mempolicy.h>
 #include <ifaddrs.h>
 #include "unix/osd.h"
 #include "rdma/fi_errno.h"
@@ -140,6 +142,60 @@ static inline int ofi_pidfd_getfd(int pidfd, int targetfd, unsigned int flags)
 	return syscall(__NR_pidfd_getfd, pidfd, targetfd, flags);
 }
 
+/* Shared (not FUTEX_PRIVATE) so that the word may live in memory mapped
+ * by several processes.  A negative timeout waits forever.
+ */
+static inline int ofi_futex_wait(int32_t *addr, int32_t val, int timeout)
+{
+	struct timespec ts;
+
+	if (timeout < 0)
+		return syscall(__NR_futex, addr, FUTEX_WAIT, val, NULL, NULL, 0);
+
+	ts.tv_sec = timeout / 1000;
+	ts.tv_nsec = (timeout % 1000) * 1000000;
+	return syscall(__NR_futex, addr, FUTEX_WAIT, val, &ts, NULL, 0);
+}
+
+static inline int ofi_futex_wake(int32_t *addr, int cnt)
+{
+	return syscall(__NR_futex, addr, FUTEX_WAKE, cnt, NULL, NULL, 0);
+}
+
+static inline int ofi_numa_node(void)
+{
+	unsigned int cpu, node;
+
+	if (syscall(__NR_getcpu, &cpu, &node, NULL))
+		return -1;
+	return node;
+}
+
+/* Prefer 'node' for the pages of [addr, addr + len) that are not yet
+ * allocated, and move those that are.  A memory policy set for the
+ * whole process (by numactl, say) is left to apply instead.
+ */
+static inline int ofi_mbind_preferred(void *addr, size_t len, int node)
+{
+	unsigned long mask[16] = {0};
+	size_t bits = sizeof(unsigned long) * 8;
+	int mode;
+
+	if ((size_t) node >= sizeof(mask) * 8)
+		return -FI_EINVAL;
+
+	if (syscall(__NR_get_mempolicy, &mode, NULL, 0, NULL, 0))
+		return -errno;
+	if (mode != MPOL_DEFAULT)
+		return -FI_EALREADY;
+
+	mask[node / bits] = 1UL << (node % bits);
+	if (syscall(__NR_mbind, addr, len, MPOL_PREFERRED, mask,
+		    sizeof(mask) * 8, MPOL_MF_MOVE))
+		return -errno;
+	return 0;
+}
+
 static inline ssize_t ofi_read_socket(SOCKET fd, void *buf, size_t count)
 {
 	return read(fd, buf, count);
@@ -86,6 +86,8 @@
  *     . if the entry is a no-op it will be released and another entry
  *       will be fetched off the queue.
  *  . Call _release() after reader is done with the entry
+ *  . _isempty() tells whether _head() would find nothing, without
+ *    taking an entry
  */
 
 #ifdef __cplusplus
@@ -219,6 +221,16 @@ again:								\
 	}							\
 	return FI_SUCCESS;					\
 }								\
+static inline bool name ## _isempty(struct name *aq)		\
+{								\
+	int64_t pos, seq;					\
+	pos = ofi_atomic_load_explicit64(&aq->read_pos,		\
+			memory_order_relaxed);			\
+	seq = ofi_atomic_load_explicit64(			\
+			&aq->entry[pos & aq->size_mask].seq,	\
+			memory_order_acquire);			\
+	return seq - (pos + 1) < 0;				\
+}								\
 static inline void name ## _commit(entrytype *buf,		\
 				int64_t pos)			\
 {								\
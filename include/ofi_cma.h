@@ -37,9 +37,17 @@
 #  include <config.h>
 #endif /* HAVE_CONFIG_H */
 
+#include <limits.h>
 #include <ofi.h>
 #include <ofi_iov.h>
 
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+/* process_vm_readv/writev reject more than IOV_MAX entries per side, so
+ * long lists are copied IOV_MAX entries at a time.
+ */
 static inline int cma_copy(struct iovec *local, unsigned long local_cnt,
 			   struct iovec *remote, unsigned long remote_cnt,
 			   size_t total, pid_t pid, bool write,
@@ -49,11 +57,15 @@ static inline int cma_copy(struct iovec *local, unsigned long local_cnt,
 
 	while (1) {
 		if (write)
-			ret = ofi_process_vm_writev(pid, local, local_cnt, remote,
-						    remote_cnt, 0);
+			ret = ofi_process_vm_writev(pid, local,
+						    MIN(local_cnt, IOV_MAX),
+						    remote,
+						    MIN(remote_cnt, IOV_MAX), 0);
 		else
-			ret = ofi_process_vm_readv(pid, local, local_cnt, remote,
-						   remote_cnt, 0);
+			ret = ofi_process_vm_readv(pid, local,
+						   MIN(local_cnt, IOV_MAX),
+						   remote,
+						   MIN(remote_cnt, IOV_MAX), 0);
 		if (ret < 0) {
 			FI_WARN(&core_prov, FI_LOG_CORE,
 				"CMA error %d\n", errno);
@@ -0,0 +1,130 @@
+/*
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _OFI_DOORBELL_H_
+#define _OFI_DOORBELL_H_
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <ofi_atom.h>
+#include <ofi_mb.h>
+#include <ofi_osd.h>
+#include <rdma/fi_errno.h>
+
+/*
+ * Doorbell for a queue in memory shared between processes.  The consumer
+ * arms it, checks the queue once more, and sleeps on it.  Producers ring
+ * it after posting to the queue.  Ringing costs one load unless the
+ * consumer is armed, and only the first producer to see it armed makes
+ * the wake up call.
+ *
+ * consumer:                           producer:
+ *   seq = ofi_doorbell_arm(db);         post to queue
+ *   if (queue empty)                    ofi_doorbell_ring(db);
+ *       ofi_doorbell_wait(db, seq, ms);
+ *   ofi_doorbell_disarm(db);
+ */
+struct ofi_doorbell {
+	ofi_atomic32_t	seq;
+	ofi_atomic32_t	armed;
+};
+
+static inline void ofi_doorbell_init(struct ofi_doorbell *db)
+{
+	ofi_atomic_initialize32(&db->seq, 0);
+	ofi_atomic_initialize32(&db->armed, 0);
+}
+
+static inline int32_t ofi_doorbell_arm(struct ofi_doorbell *db)
+{
+	int32_t seq = ofi_atomic_get32(&db->seq);
+
+	ofi_atomic_set32(&db->armed, 1);
+	/* order the store above with the caller's check of the queue */
+	ofi_mb();
+	return seq;
+}
+
+static inline void ofi_doorbell_disarm(struct ofi_doorbell *db)
+{
+	ofi_atomic_set32(&db->armed, 0);
+}
+
+#ifdef __linux__
+
+static inline void ofi_doorbell_ring(struct ofi_doorbell *db)
+{
+	/* order the caller's post to the queue with the load below */
+	ofi_mb();
+	if (!ofi_atomic_get32(&db->armed) ||
+	    !ofi_atomic_cas_bool32(&db->armed, 1, 0))
+		return;
+
+	ofi_atomic_inc32(&db->seq);
+	(void) ofi_futex_wake((int32_t *) &db->seq.val, INT32_MAX);
+}
+
+/* Returns 0 when woken (or if the doorbell rang since it was armed),
+ * -FI_ETIMEDOUT or -FI_EINTR otherwise.
+ */
+static inline int ofi_doorbell_wait(struct ofi_doorbell *db, int32_t seq,
+				    int timeout)
+{
+	if (!ofi_futex_wait((int32_t *) &db->seq.val, seq, timeout))
+		return 0;
+
+	switch (errno) {
+	case EAGAIN:
+		return 0;
+	case ETIMEDOUT:
+		return -FI_ETIMEDOUT;
+	default:
+		return -FI_EINTR;
+	}
+}
+
+#else
+
+static inline void ofi_doorbell_ring(struct ofi_doorbell *db)
+{
+}
+
+static inline int ofi_doorbell_wait(struct ofi_doorbell *db, int32_t seq,
+				    int timeout)
+{
+	return -FI_ENOSYS;
+}
+
+#endif /* __linux__ */
+
+#endif /* _OFI_DOORBELL_H_ */
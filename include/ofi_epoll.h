@@ -124,6 +124,7 @@ struct ofi_pollfds_ctx *ofi_pollfds_alloc_ctx(struct ofi_pollfds *pfds, int fd);
 #define OFI_EPOLL_IN  EPOLLIN
 #define OFI_EPOLL_OUT EPOLLOUT
 #define OFI_EPOLL_ERR EPOLLERR
+#define OFI_EPOLL_ET  EPOLLET
 
 typedef int ofi_epoll_t;
 #define OFI_EPOLL_INVALID -1
@@ -192,6 +193,8 @@ static inline int ofi_epoll_fd(int ep)
 #define OFI_EPOLL_IN  POLLIN
 #define OFI_EPOLL_OUT POLLOUT
 #define OFI_EPOLL_ERR POLLERR
+/* Edge-triggered events are not emulated, callers check ofi_have_epoll */
+#define OFI_EPOLL_ET  0
 
 typedef struct ofi_pollfds *ofi_epoll_t;
 #define OFI_EPOLL_INVALID NULL
@@ -211,6 +211,12 @@ void ofi_consume_rma_iov(struct fi_rma_iov *rma_iov, size_t *rma_iov_count,
 
 int ofi_truncate_iov(struct iovec *iov, size_t *iov_count, size_t new_size);
 
+/* Copy src to dst, merging segments that are adjacent in memory and
+ * dropping empty ones.  Returns the number of entries written to dst.
+ */
+size_t ofi_coalesce_iov(struct iovec *dst, const struct iovec *src,
+			size_t count);
+
 /* Copy 'len' bytes worth of src iovec to dst */
 int ofi_copy_iov_desc(struct iovec *dst_iov, void **dst_desc, size_t *dst_count,
 		      struct iovec *src_iov, void **src_desc, size_t src_count,
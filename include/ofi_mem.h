@@ -603,6 +603,59 @@ static inline void *ofi_ibuf_alloc_at(struct ofi_bufpool *pool, size_t index)
 	return buf;
 }
 
+/*
+ * Slab allocator
+ *
+ * Serves variable sized buffers from a set of buffer pools, one per size
+ * class.  Classes start at min_size and alternate between powers of two
+ * and the midpoint between them (64, 96, 128, 192, 256, ...), so at most
+ * a third of a buffer is wasted.  Requests above max_size fall back to
+ * malloc.  Pools are created on first use of a class.  Bufpool flags
+ * (OFI_BUFPOOL_HUGEPAGES, NONSHARED, NO_ZERO) are applied to every class.
+ * As with the buffer pool, the caller serializes access.
+ */
+enum {
+	OFI_SLAB_MIN_SIZE	= 64,
+	OFI_SLAB_REGION_SIZE	= 65536,
+	OFI_SLAB_MAX_CLASSES	= 48,
+	OFI_SLAB_LARGE		= OFI_SLAB_MAX_CLASSES,
+};
+
+struct ofi_slab_attr {
+	size_t		min_size;
+	size_t		max_size;
+	size_t		region_size;
+	int		flags;
+};
+
+struct ofi_slab_stats {
+	size_t		alloc_cnt;
+	size_t		large_cnt;
+	size_t		inuse_cnt;
+	size_t		inuse_bytes;
+	size_t		peak_bytes;
+};
+
+struct ofi_slab {
+	struct ofi_bufpool	*pool[OFI_SLAB_MAX_CLASSES];
+	size_t			class_size[OFI_SLAB_MAX_CLASSES];
+	int			class_cnt;
+	uint8_t			min_shift;
+	struct ofi_slab_attr	attr;
+	struct ofi_slab_stats	stats;
+};
+
+struct ofi_slab_hdr {
+	struct ofi_slab		*slab;
+	size_t			size;
+};
+
+int ofi_slab_create(const struct ofi_slab_attr *attr, struct ofi_slab **slab);
+void ofi_slab_destroy(struct ofi_slab *slab);
+void *ofi_slab_alloc(struct ofi_slab *slab, size_t size);
+void ofi_slab_free(void *buf);
+size_t ofi_slab_buf_size(void *buf);
+
 /*
  * Persistent memory support
  */
@@ -50,6 +50,7 @@ struct ofi_mr;
 #include <ofi_lock.h>
 #include <ofi_list.h>
 #include <ofi_tree.h>
+#include <ofi_indexer.h>
 #include <ofi_hmem.h>
 
 #if HAVE_KDREG2_MONITOR
@@ -274,17 +275,29 @@ extern struct ofi_mem_monitor *ze_monitor;
 extern struct ofi_mem_monitor *ze_ipc_monitor;
 extern struct ofi_mem_monitor *import_monitor;
 extern struct ofi_mem_monitor *xpmem_monitor;
+extern struct ofi_mem_monitor *memfd_monitor;
 
 /*
  * Used to store registered memory regions into a lookup map.  This
  * is used by the ofi_mr_xxx calls below, and may be accessed by a
  * provider when processing incoming RMA operations to verify that
  * a region has been registered for the specified operation.
+ *
+ * With FI_MR_PROV_KEY, the low bits of a key are the index of the region
+ * in a dense table, and the high bits a count of the keys handed out, so
+ * looking up a key is an array access and a stale key whose index has been
+ * reused does not match.  Keys requested by the application, provider
+ * keys once the table is full (index 0), and keys copied from another map
+ * are kept in the rbtree.
  */
 
+#define OFI_MR_MAP_IDX_BITS	(OFI_IDX_CHUNK_BITS + OFI_IDX_OFFSET_BITS)
+#define OFI_MR_MAP_IDX_MASK	((1ULL << OFI_MR_MAP_IDX_BITS) - 1)
+
 struct ofi_mr_map {
 	const struct fi_provider *prov;
 	struct ofi_rbmap	*rbtree;
+	struct indexer		idx;
 	uint64_t		key;
 	int			mode;
 };
@@ -297,7 +310,16 @@ int ofi_mr_map_insert(struct ofi_mr_map *map,
 		      const struct fi_mr_attr *attr,
 		      uint64_t *key, void *context,
 		      uint64_t flags);
+int ofi_mr_map_insert_key(struct ofi_mr_map *map,
+			  const struct fi_mr_attr *attr,
+			  uint64_t key, void *context,
+			  uint64_t flags);
 int ofi_mr_map_remove(struct ofi_mr_map *map, uint64_t key);
+
+typedef int (*ofi_mr_map_func)(struct ofi_mr_map *map,
+			       struct fi_mr_attr *attr, void *context);
+int ofi_mr_map_foreach(struct ofi_mr_map *map, ofi_mr_map_func func,
+		       void *context);
 void *ofi_mr_map_get(struct ofi_mr_map *map,  uint64_t key);
 
 int ofi_mr_map_verify(struct ofi_mr_map *map, uintptr_t *io_addr,
@@ -315,6 +337,22 @@ int ofi_mr_map_verify(struct ofi_mr_map *map, uintptr_t *io_addr,
  * a dev_reg data structure, e.g. gdrcopy handle in cuda
  */
 #define OFI_HMEM_DATA_DEV_REG_HANDLE	(1ULL << 60)
+/**
+ * OFI_HMEM_DATA_MEMFD indicates that hmem_data points to an
+ * ofi_memfd_handle describing the file backing a host memory region
+ */
+#define OFI_HMEM_DATA_MEMFD		(1ULL << 61)
+
+/*
+ * Identifies a shareable file (e.g. memfd) mapped into the owner's
+ * address space at base, so that a peer can map the same pages.
+ */
+struct ofi_memfd_handle {
+	int32_t		pid;
+	int32_t		fd;
+	uint64_t	ino;
+	uint64_t	base;
+};
 
 struct ofi_mr {
 	struct fid_mr mr_fid;
@@ -440,6 +478,16 @@ int  ofi_ipc_cache_search(struct ofi_mr_cache *cache, uint64_t peer_id,
 			  struct ipc_info *ipc_info,
 			  struct ofi_mr_entry **mr_entry);
 
+int ofi_memfd_get_handle(const struct fi_mr_dmabuf *dmabuf,
+			 struct ofi_memfd_handle *handle);
+void ofi_memfd_put_handle(struct ofi_memfd_handle *handle);
+int ofi_memfd_cache_open(struct ofi_mr_cache **cache,
+			 struct util_domain *domain);
+void ofi_memfd_cache_destroy(struct ofi_mr_cache *cache);
+int ofi_memfd_cache_search(struct ofi_mr_cache *cache, uint64_t peer_id,
+			   struct iovec *iov, struct ofi_memfd_handle *handle,
+			   struct ofi_mr_entry **mr_entry);
+
 static inline bool ofi_mr_cache_full(struct ofi_mr_cache *cache)
 {
 	return (cache->cached_cnt >= cache->cached_max_cnt) ||
@@ -542,6 +542,8 @@ struct ofi_bsock {
 	uint32_t async_index;
 	uint32_t done_index;
 	bool async_prefetch;
+	/* last recv returned less than asked for, so the socket was empty */
+	bool rx_drained;
 };
 
 static inline void
@@ -557,6 +559,7 @@ ofi_bsock_init(struct ofi_bsock *bsock, struct ofi_sockapi *sockapi,
 	ofi_byteq_init(&bsock->rq, rbuf_size);
 	bsock->zerocopy_size = SIZE_MAX;
 	bsock->async_prefetch = false;
+	bsock->rx_drained = false;
 
 	/* first async op will wrap back to 0 as the starting index */
 	bsock->async_index = UINT32_MAX;
@@ -590,9 +593,13 @@ static inline int ofi_bsock_connect(struct ofi_bsock *bsock,
 static inline int ofi_bsock_recv_unbuffered(struct ofi_bsock *bsock, void *buf,
 					    size_t len)
 {
+	ssize_t ret;
+
 	assert(!ofi_bsock_readable(bsock));
-	return bsock->sockapi->recv(bsock->sockapi, bsock->sock, buf, len,
-				    MSG_NOSIGNAL, &bsock->rx_sockctx);
+	ret = bsock->sockapi->recv(bsock->sockapi, bsock->sock, buf, len,
+				   MSG_NOSIGNAL, &bsock->rx_sockctx);
+	bsock->rx_drained = ret < (ssize_t) len;
+	return (int) ret;
 }
 
 int ofi_bsock_flush(struct ofi_bsock *bsock);
@@ -603,6 +610,11 @@ int ofi_bsock_flush_sync(struct ofi_bsock *bsock);
 int ofi_bsock_send(struct ofi_bsock *bsock, const void *buf, size_t *len);
 int ofi_bsock_sendv(struct ofi_bsock *bsock, const struct iovec *iov,
 		    size_t cnt, size_t *len);
+/* Append to the send staging buffer without a syscall, so that a later
+ * send or flush coalesces it.  Returns -FI_EAGAIN if it does not fit.
+ */
+int ofi_bsock_queuev(struct ofi_bsock *bsock, const struct iovec *iov,
+		     size_t cnt, size_t *len);
 int ofi_bsock_recv(struct ofi_bsock *bsock, void *buf, size_t *len);
 int ofi_bsock_recvv(struct ofi_bsock *bsock, struct iovec *iov,
 		    size_t cnt, size_t *len);
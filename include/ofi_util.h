@@ -215,6 +215,10 @@ struct util_domain {
 	enum fi_threading	threading;
 	enum fi_progress	data_progress;
 	enum fi_progress	control_progress;
+
+	/* counters with triggered ops or deferred work waiting on them */
+	struct dlist_entry	trigger_cntrs;
+	ofi_mutex_t		trigger_lock;
 };
 
 int ofi_domain_init(struct fid_fabric *fabric_fid, const struct fi_info *info,
@@ -437,6 +441,12 @@ struct util_wait_fd {
 };
 
 typedef int (*ofi_wait_try_func)(void *arg);
+/* Put the calling thread to sleep until the fid may have work; 'idle'
+ * counts the rounds of the current wait that found nothing to do.
+ * Returns -FI_EAGAIN if it chose not to sleep.  Called without the wait
+ * set's lock; the fid is not removed from the set until it returns.
+ */
+typedef int (*ofi_wait_block_func)(void *arg, int idle, int timeout);
 
 struct ofi_wait_fd_entry {
 	struct dlist_entry	entry;
@@ -449,10 +459,12 @@ struct ofi_wait_fd_entry {
 struct ofi_wait_fid_entry {
 	struct dlist_entry	entry;
 	ofi_wait_try_func	wait_try;
+	ofi_wait_block_func	block;
 	fid_t			fid;
 	enum fi_wait_obj	wait_obj;
 	uint32_t		events;
 	ofi_atomic32_t		ref;
+	int			blocked; /* threads in block() */
 	struct fi_wait_pollfd	pollfds;
 };
 
@@ -464,6 +476,9 @@ int ofi_wait_del_fd(struct util_wait *wait, int fd);
 int ofi_wait_fdset_del(struct util_wait_fd *wait_fd, int fd);
 int ofi_wait_add_fid(struct util_wait *wat, fid_t fid, uint32_t events,
 		     ofi_wait_try_func wait_try);
+int ofi_wait_add_fid_block(struct util_wait *wait, fid_t fid, uint32_t events,
+			   ofi_wait_try_func wait_try,
+			   ofi_wait_block_func block);
 int ofi_wait_del_fid(struct util_wait *wait, fid_t fid);
 
 
@@ -750,6 +765,10 @@ struct util_cntr {
 
 	struct fid_peer_cntr	*peer_cntr;
 	uint64_t		flags;
+
+	/* struct util_trigger in threshold order, see ofi_trigger_progress */
+	struct dlist_entry	trigger_list;
+	struct dlist_entry	trigger_entry;
 };
 
 #define OFI_TIMEOUT_QUANTUM_MS 50
@@ -767,6 +786,77 @@ int ofi_cntr_set(struct fid_cntr *cntr_fid, uint64_t value);
 int ofi_cntr_seterr(struct fid_cntr *cntr_fid, uint64_t value);
 int ofi_cntr_wait(struct fid_cntr *cntr_fid, uint64_t threshold, int timeout);
 
+/*
+ * Triggered operations (FI_TRIGGER) and deferred work (FI_QUEUE_WORK)
+ *
+ * Queued work waits on its triggering counter in threshold order and is
+ * posted through the target's regular ops once the counter reaches the
+ * threshold.  Nothing is posted from within a counter update, which may
+ * run with provider locks held.  Instead, ofi_cntr_progress() checks the
+ * queues, and providers with their own progress call
+ * ofi_trigger_progress() once their locks are dropped.
+ *
+ * Providers opt in by passing FI_TRIGGER ops from their ep ops to
+ * ofi_trigger_msg/tagged/rma(), and FI_QUEUE_WORK, FI_CANCEL_WORK and
+ * FI_FLUSH_WORK from their domain control to ofi_trigger_control().
+ * Their ep close must call ofi_trigger_flush_ep() before tearing down the
+ * endpoint, as queued work does not hold a reference on it.
+ * Deferred transfers are posted with OFI_TRIGGERED set and a
+ * struct ofi_trigger_ctx as their context, which is only valid for the
+ * duration of the call.  The provider reports the completion with
+ * ofi_trigger_ctx.context, increments ofi_trigger_ctx.cntr instead of the
+ * EP counter, and writes a CQ entry only if the op has FI_COMPLETION.
+ */
+#define OFI_TRIGGERED		(1ULL << 61)
+#define OFI_TRIGGER_IOV_LIMIT	4
+
+struct ofi_trigger_ctx {
+	void			*context;
+	struct util_cntr	*cntr;
+};
+
+struct util_trigger {
+	struct dlist_entry	entry;
+	struct util_cntr	*cntr;
+	uint64_t		threshold;
+	struct fi_deferred_work	*work;
+	struct ofi_trigger_ctx	ctx;
+
+	enum fi_op_type		op_type;
+	struct fid_ep		*ep;
+	uint64_t		flags;
+	union {
+		struct fi_msg		msg;
+		struct fi_msg_tagged	tagged;
+		struct fi_msg_rma	rma;
+		struct fi_op_cntr	cntr;
+	} op;
+	struct iovec		iov[OFI_TRIGGER_IOV_LIMIT];
+	void			*desc[OFI_TRIGGER_IOV_LIMIT];
+	struct fi_rma_iov	rma_iov[OFI_TRIGGER_IOV_LIMIT];
+};
+
+ssize_t ofi_trigger_msg(struct fid_ep *ep, enum fi_op_type op_type,
+			const struct fi_msg *msg, uint64_t flags);
+ssize_t ofi_trigger_tagged(struct fid_ep *ep, enum fi_op_type op_type,
+			   const struct fi_msg_tagged *msg, uint64_t flags);
+ssize_t ofi_trigger_rma(struct fid_ep *ep, enum fi_op_type op_type,
+			const struct fi_msg_rma *msg, uint64_t flags);
+int ofi_trigger_control(struct util_domain *domain, int command, void *arg);
+void ofi_trigger_flush(struct util_domain *domain, struct util_cntr *cntr);
+void ofi_trigger_flush_ep(struct util_domain *domain, struct fid_ep *ep);
+void ofi_trigger_progress_locked(struct util_domain *domain);
+
+static inline void ofi_trigger_progress(struct util_domain *domain)
+{
+	if (dlist_empty(&domain->trigger_cntrs))
+		return;
+
+	ofi_mutex_lock(&domain->trigger_lock);
+	ofi_trigger_progress_locked(domain);
+	ofi_mutex_unlock(&domain->trigger_lock);
+}
+
 static inline void util_cntr_signal(struct util_cntr *cntr)
 {
 	assert(cntr->wait);
@@ -65,6 +65,7 @@ extern "C" {
 
 #define FI_PROV_SPECIFIC_EFA   (0xefa << 16)
 #define FI_PROV_SPECIFIC_TCP   (0x7cb << 16)
+#define FI_PROV_SPECIFIC_RXM   (0x3c3 << 16)
 
 
 /* negative options are provider specific */
@@ -79,6 +80,26 @@ enum {
 	FI_OPT_EFA_HOMOGENEOUS_PEERS,   /* bool */
 };
 
+/* The rxm option values and struct fi_rxm_preconnect are part of the
+ * ABI, see fi_rxm(7).  New options are only ever appended.
+ */
+enum {
+	FI_OPT_RXM_PRECONNECT = -FI_PROV_SPECIFIC_RXM, /* struct fi_rxm_preconnect */
+};
+
+enum {
+	FI_OPT_TCP_PRECONNECT = -FI_PROV_SPECIFIC_TCP, /* struct fi_rxm_preconnect */
+};
+
+/* Start connecting to count consecutive AV entries beginning at addr.
+ * The call returns immediately; connections complete as the endpoint
+ * is progressed.
+ */
+struct fi_rxm_preconnect {
+	fi_addr_t addr;
+	size_t count;
+};
+
 struct fi_fid_export {
 	struct fid **fid;
 	uint64_t flags;
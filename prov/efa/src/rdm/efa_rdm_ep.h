@@ -104,10 +104,8 @@ struct efa_rdm_ep {
 	struct ofi_bufpool *ope_pool;
 	/* data structure to maintain overflow pke linked list entry */
 	struct ofi_bufpool *overflow_pke_pool;
-	/* data structure to maintain pkt rx map */
+	/* overflow entries of the peers' rx entry maps */
 	struct ofi_bufpool *map_entry_pool;
-	/** a map between sender address + msg_id to RX entry */
-	struct efa_rdm_rxe_map rxe_map;
 	/*
 	 * buffer pool for atomic response data, used by
 	 * emulated fetch and compare atomic.
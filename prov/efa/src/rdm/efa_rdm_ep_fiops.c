@@ -226,7 +226,6 @@ int efa_rdm_ep_create_buffer_pools(struct efa_rdm_ep *ep)
 	if (ret)
 		goto err_free;
 
-	efa_rdm_rxe_map_construct(&ep->rxe_map);
 	return 0;
 
 err_free:
@@ -31,6 +31,7 @@ void efa_rdm_peer_construct(struct efa_rdm_peer *peer, struct efa_rdm_ep *ep, st
 	dlist_init(&peer->txe_list);
 	dlist_init(&peer->rxe_list);
 	dlist_init(&peer->overflow_pke_list);
+	efa_rdm_rxe_map_construct(&peer->rxe_map);
 }
 
 /**
@@ -60,6 +61,8 @@ void efa_rdm_peer_destruct(struct efa_rdm_peer *peer, struct efa_rdm_ep *ep)
 	if (peer->robuf.pending)
 		ofi_recvwin_free(&peer->robuf);
 
+	efa_rdm_rxe_map_destruct(&peer->rxe_map);
+
 	if (!ep) {
 		/* ep is NULL means the endpoint has been closed.
 		 * In this case there is no need to proceed because
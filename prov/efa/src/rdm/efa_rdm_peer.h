@@ -63,6 +63,7 @@ struct efa_rdm_peer {
 	struct dlist_entry txe_list; /**< a list of txe related to this peer */
 	struct dlist_entry rxe_list; /**< a list of rxe relased to this peer */
 	struct dlist_entry overflow_pke_list; /**< a list of out-of-order pke that overflow the current recvwin */
+	struct efa_rdm_rxe_map rxe_map; /**< msg_id to rxe of the multi-packet messages being received from the peer */
 
 	/**
 	 * @brief number of bytes that has been sent as part of runting protocols
@@ -6,24 +6,67 @@
 #include "efa_rdm_rxe_map.h"
 #include "efa_rdm_pke_rtm.h"
 
+static inline
+struct efa_rdm_ope **efa_rdm_rxe_map_slot(struct efa_rdm_rxe_map *rxe_map,
+					  uint64_t msg_id)
+{
+	return &rxe_map->ring[msg_id & (EFA_RDM_RXE_MAP_RING_SIZE - 1)];
+}
+
 /**
- * @brief find an RX entry for a received RTM packet entry's sender address and msg_id
+ * @brief release the memory of an RX entry map
+ *
+ * @details
+ * RX entries that are still in the map are detached from it.
  *
- * @param[in]		rxe_map		RX entry map
- * @param[in]		pkt_entry	received packet entry
+ * @param[in,out]	rxe_map		RX entry map
+ */
+void efa_rdm_rxe_map_destruct(struct efa_rdm_rxe_map *rxe_map)
+{
+	struct efa_rdm_rxe_map_entry *entry, *tmp;
+	int i;
+
+	HASH_ITER(hh, rxe_map->overflow, entry, tmp) {
+		HASH_DEL(rxe_map->overflow, entry);
+		entry->rxe->rxe_map = NULL;
+		ofi_buf_free(entry);
+	}
+
+	if (!rxe_map->ring)
+		return;
+
+	for (i = 0; i < EFA_RDM_RXE_MAP_RING_SIZE; i++) {
+		if (rxe_map->ring[i])
+			rxe_map->ring[i]->rxe_map = NULL;
+	}
+	free(rxe_map->ring);
+	rxe_map->ring = NULL;
+}
+
+/**
+ * @brief find the RX entry of a peer's msg_id
+ *
+ * @param[in]		rxe_map		RX entry map of the sender's peer
+ * @param[in]		msg_id		message ID
  * @returns
  * pointer to an RX entry. If such RX entry does not exist, return NULL
 */
 struct efa_rdm_ope *efa_rdm_rxe_map_lookup(struct efa_rdm_rxe_map *rxe_map,
-					   uint64_t msg_id, fi_addr_t addr)
+					   uint64_t msg_id)
 {
 	struct efa_rdm_rxe_map_entry *entry = NULL;
-	struct efa_rdm_rxe_map_key key;
+	struct efa_rdm_ope *rxe;
 
-	memset(&key, 0, sizeof(key));
-	key.msg_id = msg_id;
-	key.addr = addr;
-	HASH_FIND(hh, rxe_map->head, &key, sizeof(struct efa_rdm_rxe_map_key), entry);
+	if (rxe_map->ring) {
+		rxe = *efa_rdm_rxe_map_slot(rxe_map, msg_id);
+		if (OFI_LIKELY(rxe && rxe->msg_id == msg_id))
+			return rxe;
+	}
+
+	if (OFI_LIKELY(!rxe_map->overflow))
+		return NULL;
+
+	HASH_FIND(hh, rxe_map->overflow, &msg_id, sizeof(msg_id), entry);
 	return entry ? entry->rxe : NULL;
 }
 
@@ -31,18 +74,33 @@ struct efa_rdm_ope *efa_rdm_rxe_map_lookup(struct efa_rdm_rxe_map *rxe_map,
  * @brief insert an RX entry into an RX entry map
  *
  * @details
- * the insertion will use the combination of packet entry sender address and msg_id as key.
- * Caller is responsible to make sure the key does not exist in the map.
+ * Caller is responsible to make sure msg_id does not exist in the map.
  *
- * @param[in,out]	rxe_map		RX entry map
- * @param[in]		pkt_entry	received RTM packet
+ * @param[in,out]	rxe_map		RX entry map of the sender's peer
+ * @param[in]		msg_id		message ID
  * @param[in]		rxe		RX entry
 */
 void efa_rdm_rxe_map_insert(struct efa_rdm_rxe_map *rxe_map,
-			    uint64_t msg_id, fi_addr_t addr,
-			    struct efa_rdm_ope *rxe)
+			    uint64_t msg_id, struct efa_rdm_ope *rxe)
 {
 	struct efa_rdm_rxe_map_entry *entry;
+	struct efa_rdm_ope **slot;
+
+	assert(!efa_rdm_rxe_map_lookup(rxe_map, msg_id));
+	assert(rxe->msg_id == msg_id);
+
+	if (OFI_UNLIKELY(!rxe_map->ring))
+		rxe_map->ring = calloc(EFA_RDM_RXE_MAP_RING_SIZE,
+				       sizeof(*rxe_map->ring));
+
+	if (rxe_map->ring) {
+		slot = efa_rdm_rxe_map_slot(rxe_map, msg_id);
+		if (OFI_LIKELY(!*slot)) {
+			*slot = rxe;
+			rxe->rxe_map = rxe_map;
+			return;
+		}
+	}
 
 	entry = ofi_buf_alloc(rxe->ep->map_entry_pool);
 	if (OFI_UNLIKELY(!entry)) {
@@ -52,21 +110,9 @@ void efa_rdm_rxe_map_insert(struct efa_rdm_rxe_map *rxe_map,
 		return;
 	}
 
-	memset(&entry->key, 0, sizeof(entry->key));
-	entry->key.msg_id = msg_id;
-	entry->key.addr = addr;
-
-#if ENABLE_DEBUG
-	{
-		struct efa_rdm_rxe_map_entry *existing_entry = NULL;
-
-		HASH_FIND(hh, rxe_map->head, &entry->key, sizeof(struct efa_rdm_rxe_map_key), existing_entry);
-		assert(!existing_entry);
-	}
-#endif
-
+	entry->msg_id = msg_id;
 	entry->rxe = rxe;
-	HASH_ADD(hh, rxe_map->head, key, sizeof(struct efa_rdm_rxe_map_key), entry);
+	HASH_ADD(hh, rxe_map->overflow, msg_id, sizeof(entry->msg_id), entry);
 	rxe->rxe_map = rxe_map;
 }
 
@@ -74,28 +120,31 @@ void efa_rdm_rxe_map_insert(struct efa_rdm_rxe_map *rxe_map,
  * @brief remove an RX entry from the RX entry map
  *
  * @details
- * the removal will use the combination of packet entry sender address and msg_id as key.
- * Caller is responsible to make sure the key does exist in the map.
+ * Caller is responsible to make sure the RX entry is in the map.
  *
- * @param[in,out]	rxe_map		RX entry map
+ * @param[in,out]	rxe_map		RX entry map of the sender's peer
  * @param[in]		msg_id		message ID
- * @param[in]		addr		peer address
  * @param[in]		rxe		RX entry
  */
 void efa_rdm_rxe_map_remove(struct efa_rdm_rxe_map *rxe_map, uint64_t msg_id,
-			    fi_addr_t addr, struct efa_rdm_ope *rxe)
+			    struct efa_rdm_ope *rxe)
 {
 	struct efa_rdm_rxe_map_entry *entry;
-	struct efa_rdm_rxe_map_key key;
+	struct efa_rdm_ope **slot;
 
-	memset(&key, 0, sizeof(key));
-	key.msg_id = msg_id;
-	key.addr = addr;
+	if (rxe_map->ring) {
+		slot = efa_rdm_rxe_map_slot(rxe_map, msg_id);
+		if (OFI_LIKELY(*slot == rxe)) {
+			*slot = NULL;
+			rxe->rxe_map = NULL;
+			return;
+		}
+	}
 
-	HASH_FIND(hh, rxe_map->head, &key, sizeof(key), entry);
+	HASH_FIND(hh, rxe_map->overflow, &msg_id, sizeof(msg_id), entry);
 	assert(entry && entry->rxe == rxe);
-	HASH_DEL(rxe_map->head, entry);
+	HASH_DEL(rxe_map->overflow, entry);
 	ofi_buf_free(entry);
 	/* Now the rxe is removed from the map, reset it to NULL */
 	rxe->rxe_map = NULL;
-}
\ No newline at end of file
+}
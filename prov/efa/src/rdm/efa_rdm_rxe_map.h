@@ -8,34 +8,43 @@
 #include <rdma/fi_endpoint.h>
 #include "uthash.h"
 
-
-struct efa_rdm_rxe_map_key {
-	uint64_t msg_id;
-	fi_addr_t addr;
-};
-
+/**
+ * @brief number of slots in a peer's RX entry ring, must be a power of 2
+ *
+ * @details
+ * Message IDs from a peer are dense, and only the multi-packet messages
+ * still being received are in the map, so a small ring indexed by msg_id
+ * covers them. The receive window would also do, but costs a lot more
+ * memory per peer.
+ */
+#define EFA_RDM_RXE_MAP_RING_SIZE	(256)
 
 struct efa_rdm_rxe_map_entry;
 
 /**
- * @brief a hashmap between sender address + msg_id to RX entry
+ * @brief a map between a peer's msg_id and RX entry
  *
  * @details
- * This hash map is used on the receiver side to implement
+ * This map is used on the receiver side to implement
  * medium and runting protocols. Such protocol will send
  * multiple RTM packets at the same time. The first RTM
  * will be matched with an RX entry and will be inserted
- * to this map, the later arriving RTM packet will use
- * this hashmap to find the RX entry.
+ * to the map of the sender's peer, the later arriving RTM packet
+ * will use this map to find the RX entry.
+ *
+ * RX entries live in a ring indexed by msg_id. An RX entry whose slot
+ * is taken by an older message that is still being received goes to
+ * the overflow hashmap.
  */
 struct efa_rdm_rxe_map {
-	struct efa_rdm_rxe_map_entry *head;
+	struct efa_rdm_ope **ring;		/**< allocated on first insert */
+	struct efa_rdm_rxe_map_entry *overflow;	/**< hashmap keyed by msg_id */
 };
 
 struct efa_rdm_ope;
 
 struct efa_rdm_rxe_map_entry {
-	struct efa_rdm_rxe_map_key key;
+	uint64_t msg_id;
 	struct efa_rdm_ope *rxe;
 	UT_hash_handle hh;
 };
@@ -43,18 +52,18 @@ struct efa_rdm_rxe_map_entry {
 static inline
 void efa_rdm_rxe_map_construct(struct efa_rdm_rxe_map *rxe_map)
 {
-	rxe_map->head = NULL;
+	rxe_map->ring = NULL;
+	rxe_map->overflow = NULL;
 }
 
-struct efa_rdm_pke;
+void efa_rdm_rxe_map_destruct(struct efa_rdm_rxe_map *rxe_map);
 
 struct efa_rdm_ope *efa_rdm_rxe_map_lookup(struct efa_rdm_rxe_map *rxe_map,
-					   uint64_t msg_id, fi_addr_t addr);
+					   uint64_t msg_id);
 
 void efa_rdm_rxe_map_insert(struct efa_rdm_rxe_map *rxe_map,
-			    uint64_t msg_id, fi_addr_t addr,
-			    struct efa_rdm_ope *rxe);
+			    uint64_t msg_id, struct efa_rdm_ope *rxe);
 
 void efa_rdm_rxe_map_remove(struct efa_rdm_rxe_map *rxe_map, uint64_t msg_id,
-			    fi_addr_t addr, struct efa_rdm_ope *rxe);
-#endif
\ No newline at end of file
+			    struct efa_rdm_ope *rxe);
+#endif
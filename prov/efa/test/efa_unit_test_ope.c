@@ -496,11 +496,9 @@ void test_efa_rdm_rxe_map(struct efa_resource **state)
 	efa_rdm_ep = container_of(resource->ep, struct efa_rdm_ep,
 				  base_ep.util_ep.ep_fid);
 
-	efa_rdm_rxe_map_insert(&efa_rdm_ep->rxe_map, rxe->msg_id, rxe->addr,
-			       rxe);
-	assert_true(rxe->rxe_map == &efa_rdm_ep->rxe_map);
-	assert_true(rxe == efa_rdm_rxe_map_lookup(rxe->rxe_map, rxe->msg_id,
-						  rxe->addr));
+	efa_rdm_rxe_map_insert(&rxe->peer->rxe_map, rxe->msg_id, rxe);
+	assert_true(rxe->rxe_map == &rxe->peer->rxe_map);
+	assert_true(rxe == efa_rdm_rxe_map_lookup(rxe->rxe_map, rxe->msg_id));
 
 	efa_rdm_rxe_release(rxe);
 
@@ -513,6 +511,53 @@ void test_efa_rdm_rxe_map(struct efa_resource **state)
 	efa_rdm_ep->map_entry_pool = NULL;
 }
 
+/**
+ * @brief verify that a msg_id whose ring slot is taken by another message
+ * still being received is found through the overflow map
+ */
+void test_efa_rdm_rxe_map_overflow(struct efa_resource **state)
+{
+	struct efa_resource *resource = *state;
+	struct efa_rdm_ope *rxe1, *rxe2;
+	struct efa_rdm_rxe_map *rxe_map;
+	struct efa_rdm_ep *efa_rdm_ep;
+
+	efa_unit_test_resource_construct(resource, FI_EP_RDM, EFA_FABRIC_NAME);
+
+	rxe1 = efa_unit_test_alloc_rxe(resource, ofi_op_tagged);
+	assert_non_null(rxe1);
+	rxe2 = efa_unit_test_alloc_rxe(resource, ofi_op_tagged);
+	assert_non_null(rxe2);
+	assert_true(rxe1->peer == rxe2->peer);
+
+	/* both msg_ids map to the same ring slot */
+	rxe1->msg_id = 1;
+	rxe2->msg_id = 1 + EFA_RDM_RXE_MAP_RING_SIZE;
+
+	efa_rdm_ep = container_of(resource->ep, struct efa_rdm_ep,
+				  base_ep.util_ep.ep_fid);
+	rxe_map = &rxe1->peer->rxe_map;
+
+	efa_rdm_rxe_map_insert(rxe_map, rxe1->msg_id, rxe1);
+	efa_rdm_rxe_map_insert(rxe_map, rxe2->msg_id, rxe2);
+	assert_non_null(rxe_map->overflow);
+	assert_true(rxe1 == efa_rdm_rxe_map_lookup(rxe_map, rxe1->msg_id));
+	assert_true(rxe2 == efa_rdm_rxe_map_lookup(rxe_map, rxe2->msg_id));
+	assert_null(efa_rdm_rxe_map_lookup(rxe_map, 2));
+
+	efa_rdm_rxe_release(rxe1);
+	assert_null(efa_rdm_rxe_map_lookup(rxe_map, 1));
+	assert_true(rxe2 == efa_rdm_rxe_map_lookup(rxe_map, rxe2->msg_id));
+
+	efa_rdm_rxe_release(rxe2);
+	assert_null(rxe_map->overflow);
+	assert_null(efa_rdm_rxe_map_lookup(rxe_map, 1 + EFA_RDM_RXE_MAP_RING_SIZE));
+
+	/* the overflow entry has been returned to the map_entry_pool */
+	ofi_bufpool_destroy(efa_rdm_ep->map_entry_pool);
+	efa_rdm_ep->map_entry_pool = NULL;
+}
+
 void test_efa_rdm_rxe_list_removal(struct efa_resource **state)
 {
 	struct efa_resource *resource = *state;
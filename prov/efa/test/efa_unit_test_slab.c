@@ -0,0 +1,192 @@
+/* SPDX-License-Identifier: BSD-2-Clause OR GPL-2.0-only */
+/* SPDX-FileCopyrightText: Copyright Amazon.com, Inc. or its affiliates. All rights reserved. */
+
+#include "efa_unit_tests.h"
+#include "ofi_mem.h"
+
+/**
+ * @brief Create a slab with the given limits and check that it succeeded
+ *
+ * @param min_size smallest size class requested
+ * @param max_size largest size class requested
+ * @return the new slab
+ */
+static
+struct ofi_slab *test_ofi_slab_create(size_t min_size, size_t max_size)
+{
+	struct ofi_slab_attr attr = {
+		.min_size = min_size,
+		.max_size = max_size,
+	};
+	struct ofi_slab *slab;
+	int ret;
+
+	ret = ofi_slab_create(&attr, &slab);
+	assert_int_equal(ret, FI_SUCCESS);
+	assert_non_null(slab);
+	return slab;
+}
+
+/**
+ * @brief Allocate a buffer of size bytes and check the size class it came from
+ *
+ * @param slab the slab
+ * @param size requested size
+ * @param expected_size size of the buffer handed out
+ * @return the buffer
+ */
+static
+void *test_ofi_slab_alloc_impl(struct ofi_slab *slab, size_t size,
+			       size_t expected_size)
+{
+	void *buf;
+
+	buf = ofi_slab_alloc(slab, size);
+	assert_non_null(buf);
+	assert_int_equal(ofi_slab_buf_size(buf), expected_size);
+	/* the whole buffer must be usable */
+	memset(buf, 0xa5, expected_size);
+	return buf;
+}
+
+/**
+ * @brief Verify that buffers of each class can be allocated, written and
+ * freed, that freed buffers are reused, and that the slab is empty again
+ * after all of them are freed.
+ */
+void test_ofi_slab_alloc_free(struct efa_resource **state)
+{
+	struct ofi_slab *slab;
+	void *bufs[8], *buf;
+	size_t size;
+	int i;
+
+	slab = test_ofi_slab_create(0, 16384);
+
+	for (i = 0, size = 1; i < 8; i++, size *= 4)
+		bufs[i] = test_ofi_slab_alloc_impl(slab, size,
+						   MAX(size, OFI_SLAB_MIN_SIZE));
+
+	for (i = 0; i < 8; i++)
+		assert_ptr_not_equal(bufs[i], bufs[(i + 1) % 8]);
+	assert_int_equal(slab->stats.inuse_cnt, 8);
+
+	buf = bufs[3];
+	ofi_slab_free(buf);
+	bufs[3] = test_ofi_slab_alloc_impl(slab, 64, 64);
+	assert_ptr_equal(bufs[3], buf);
+
+	for (i = 0; i < 8; i++)
+		ofi_slab_free(bufs[i]);
+	ofi_slab_free(NULL);
+
+	assert_int_equal(slab->stats.inuse_cnt, 0);
+	assert_int_equal(slab->stats.inuse_bytes, 0);
+	ofi_slab_destroy(slab);
+}
+
+/**
+ * @brief Verify that the classes alternate between 2^n and 3 * 2^(n - 2),
+ * and that a request is served from the smallest class that fits it.
+ */
+void test_ofi_slab_size_class_boundary(struct efa_resource **state)
+{
+	struct ofi_slab *slab;
+	void *buf;
+	size_t size;
+	int i;
+
+	slab = test_ofi_slab_create(64, 16384);
+
+	/* 64, 96, 128, 192, ..., 12288, 16384 */
+	assert_int_equal(slab->class_cnt, 17);
+	for (i = 0; i < slab->class_cnt; i++) {
+		size = (i & 1) ? (size_t) 96 << (i / 2) : (size_t) 64 << (i / 2);
+		assert_int_equal(slab->class_size[i], size);
+	}
+
+	for (i = 0; i < slab->class_cnt; i++) {
+		size = slab->class_size[i];
+		buf = test_ofi_slab_alloc_impl(slab, size, size);
+		ofi_slab_free(buf);
+		if (i + 1 < slab->class_cnt) {
+			buf = test_ofi_slab_alloc_impl(slab, size + 1,
+						       slab->class_size[i + 1]);
+			ofi_slab_free(buf);
+		}
+	}
+
+	buf = test_ofi_slab_alloc_impl(slab, 0, 64);
+	ofi_slab_free(buf);
+
+	/* past the largest class, the buffer is sized to the request */
+	buf = test_ofi_slab_alloc_impl(slab, 16385, 16385);
+	assert_int_equal(slab->stats.large_cnt, 1);
+	ofi_slab_free(buf);
+
+	ofi_slab_destroy(slab);
+}
+
+/**
+ * @brief Verify that min_size and max_size are rounded to whole classes
+ */
+void test_ofi_slab_size_class_rounding(struct efa_resource **state)
+{
+	struct ofi_slab *slab;
+	void *buf;
+
+	slab = test_ofi_slab_create(100, 1000);
+	assert_int_equal(slab->class_size[0], 128);
+	assert_int_equal(slab->class_size[slab->class_cnt - 1], 1024);
+
+	buf = test_ofi_slab_alloc_impl(slab, 1, 128);
+	ofi_slab_free(buf);
+	buf = test_ofi_slab_alloc_impl(slab, 1000, 1024);
+	ofi_slab_free(buf);
+	ofi_slab_destroy(slab);
+
+	/* max_size below the smallest class leaves just that class */
+	slab = test_ofi_slab_create(256, 16);
+	assert_int_equal(slab->class_cnt, 1);
+	assert_int_equal(slab->class_size[0], 256);
+	ofi_slab_destroy(slab);
+}
+
+/**
+ * @brief Verify the allocation, in-use and peak counts kept by the slab
+ */
+void test_ofi_slab_stats(struct efa_resource **state)
+{
+	struct ofi_slab *slab;
+	void *buf1, *buf2, *buf3;
+
+	slab = test_ofi_slab_create(64, 1024);
+
+	buf1 = test_ofi_slab_alloc_impl(slab, 100, 128);
+	buf2 = test_ofi_slab_alloc_impl(slab, 500, 512);
+	assert_int_equal(slab->stats.alloc_cnt, 2);
+	assert_int_equal(slab->stats.inuse_cnt, 2);
+	assert_int_equal(slab->stats.inuse_bytes, 640);
+	assert_int_equal(slab->stats.peak_bytes, 640);
+
+	ofi_slab_free(buf2);
+	assert_int_equal(slab->stats.inuse_cnt, 1);
+	assert_int_equal(slab->stats.inuse_bytes, 128);
+	assert_int_equal(slab->stats.peak_bytes, 640);
+
+	buf2 = test_ofi_slab_alloc_impl(slab, 2000, 2000);
+	buf3 = test_ofi_slab_alloc_impl(slab, 64, 64);
+	assert_int_equal(slab->stats.alloc_cnt, 4);
+	assert_int_equal(slab->stats.large_cnt, 1);
+	assert_int_equal(slab->stats.inuse_cnt, 3);
+	assert_int_equal(slab->stats.inuse_bytes, 2192);
+	assert_int_equal(slab->stats.peak_bytes, 2192);
+
+	ofi_slab_free(buf1);
+	ofi_slab_free(buf2);
+	ofi_slab_free(buf3);
+	assert_int_equal(slab->stats.inuse_cnt, 0);
+	assert_int_equal(slab->stats.inuse_bytes, 0);
+	assert_int_equal(slab->stats.peak_bytes, 2192);
+	ofi_slab_destroy(slab);
+}
@@ -231,6 +231,7 @@ void test_efa_rdm_txe_handle_error_not_write_cq();
 void test_efa_rdm_rxe_handle_error_write_cq();
 void test_efa_rdm_rxe_handle_error_not_write_cq();
 void test_efa_rdm_rxe_map();
+void test_efa_rdm_rxe_map_overflow();
 void test_efa_rdm_rxe_list_removal();
 void test_efa_rdm_txe_list_removal();
 void test_efa_rdm_msg_send_to_local_peer_with_null_desc();
@@ -326,6 +327,13 @@ void test_efa_rdm_mr_reg_cuda_memory();
 void test_efa_direct_mr_reg_no_gdrcopy();
 /* end efa_unit_test_mr.c */
 
+/* begin efa_unit_test_slab.c */
+void test_ofi_slab_alloc_free();
+void test_ofi_slab_size_class_boundary();
+void test_ofi_slab_size_class_rounding();
+void test_ofi_slab_stats();
+/* end efa_unit_test_slab.c */
+
 static inline
 int efa_unit_test_get_dlist_length(struct dlist_entry *head)
 {
@@ -47,6 +47,7 @@
 #include <rdma/fi_domain.h>
 #include <rdma/fi_endpoint.h>
 #include <rdma/fi_eq.h>
+#include <rdma/fi_ext.h>
 
 #include <ofi.h>
 #include <ofi_enosys.h>
@@ -85,7 +86,8 @@ union rxm_cm_data {
 		uint8_t op_version;
 		uint16_t port;
 		uint8_t flow_ctrl;
-		uint8_t padding;
+		uint8_t sar_credits : 7;
+		uint8_t close_hs : 1;	/* answers RXM_CREDIT_CLOSE_REQ */
 		uint32_t eager_limit;
 		uint32_t rx_size; /* used? */
 		uint64_t client_conn_id;
@@ -95,7 +97,9 @@ union rxm_cm_data {
 		uint64_t server_conn_id;
 		uint32_t rx_size; /* used? */
 		uint8_t flow_ctrl;
-		uint8_t align_pad[3];
+		uint8_t sar_credits : 7;
+		uint8_t close_hs : 1;	/* answers RXM_CREDIT_CLOSE_REQ */
+		uint8_t align_pad[2];
 	} accept;
 
 	struct _reject {
@@ -127,6 +131,18 @@ extern size_t rxm_packet_size;
 
 #define RXM_IOV_LIMIT 4
 
+/* sar_credits shares its byte of the CM data with close_hs */
+#define RXM_SAR_CREDITS_MAX	127
+
+#define RXM_CONN_MIN_IDLE_MS	1000
+
+/* msg CQ entries read per fi_cq_read, see rxm_adapt_cq_batch() */
+#define RXM_MIN_CQ_BATCH	16
+#define RXM_MAX_CQ_BATCH	128
+
+/* CM polling interval range, as a shift of FI_OFI_RXM_CM_PROGRESS_INTERVAL */
+#define RXM_CM_INTERVAL_SHIFT	3
+
 #define RXM_PEER_XFER_TAG_FLAG	(1ULL << 63)
 
 #define RXM_MR_MODES	(OFI_MR_BASIC_MAP | FI_MR_LOCAL)
@@ -206,6 +222,12 @@ extern int rxm_passthru;
 extern int force_auto_progress;
 extern int rxm_use_write_rndv;
 extern int rxm_detect_hmem_iface;
+extern size_t rxm_sar_credits;
+extern int rxm_sar_tune;
+extern size_t rxm_sar_window;
+extern size_t rxm_conn_idle_timeout;
+extern size_t rxm_max_conns;
+extern size_t rxm_conn_batch;
 extern enum fi_wait_obj def_wait_obj, def_tcp_wait_obj;
 
 struct rxm_ep;
@@ -217,10 +239,37 @@ enum rxm_cm_state {
 	RXM_CM_CONNECTING,
 	RXM_CM_ACCEPTING,
 	RXM_CM_CONNECTED,
+	/* close handshake running, no new transfers are started */
+	RXM_CM_CLOSING,
 };
 
 enum {
 	RXM_CONN_INDEXED = BIT(0),
+	RXM_CONN_CLOSE_HS = BIT(1),	/* peer answers close requests */
+	RXM_CONN_CLOSE_REQ = BIT(2),	/* we asked the peer to close */
+	RXM_CONN_SAR_CREDIT = BIT(3),	/* SAR credit return deferred */
+};
+
+/* Message sizes above the eager limit are grouped into buckets that double
+ * from the eager limit, (eager << b, eager << (b + 1)], to track SAR and
+ * rendezvous performance when tuning the switch-over point.
+ */
+#define RXM_SAR_TUNE_BUCKETS	8
+#define RXM_SAR_TUNE_SAMPLES	4
+#define RXM_SAR_TUNE_MAX_CNT	64
+#define RXM_SAR_TUNE_PROBE	16
+#define RXM_SAR_TUNE_TIMEOUT	1000000000ULL /* ns */
+
+enum {
+	RXM_SAR_TUNE_SAR,
+	RXM_SAR_TUNE_RNDV,
+	RXM_SAR_TUNE_MAX,
+};
+
+struct rxm_proto_stat {
+	uint64_t bytes;
+	uint64_t nsec;
+	uint32_t cnt;
 };
 
 /* Each local rxm ep will have at most 1 connection to a single
@@ -244,11 +293,41 @@ struct rxm_conn {
 	uint8_t flow_ctrl;
 	uint8_t peer_flow_ctrl;
 
+	/* Receiver granted SAR segment credits.  peer_sar_window is 0
+	 * unless both peers advertised a credit window at connect time.
+	 */
+	uint8_t peer_sar_window;
+	uint16_t sar_tx_credits;
+	uint16_t sar_rx_credits;
+
+	/* Largest size bucket sent using SAR, adjusted at runtime */
+	int sar_bucket;
+	uint32_t sar_probe;
+	struct rxm_proto_stat sar_stats[RXM_SAR_TUNE_BUCKETS][RXM_SAR_TUNE_MAX];
+
+	/* The one transfer being timed until the receiver reports that it
+	 * has all of the data: the rendezvous done message, or a SAR ack.
+	 * tune_start is 0 when no transfer is timed.
+	 */
+	uint64_t tune_start;
+	uint64_t tune_msg_id;
+	size_t tune_len;
+	int tune_proto;
+
 	struct dlist_entry deferred_entry;
 	struct dlist_entry deferred_tx_queue;
 	struct dlist_entry deferred_sar_msgs;
 	struct dlist_entry deferred_sar_segments;
 	struct dlist_entry loopback_entry;
+
+	/* Connections with an open msg ep, least recently used first.
+	 * xfer_refs counts held rx buffers, SAR sends with segments still
+	 * to complete, and rendezvous and atomic requests waiting for the
+	 * peer; the connection is not reaped while it is set.
+	 */
+	struct dlist_entry lru_entry;
+	uint64_t last_use;
+	int xfer_refs;
 };
 
 void rxm_freeall_conns(struct rxm_ep *ep);
@@ -413,6 +492,18 @@ enum {
 	rxm_ctrl_rndv_wr_done
 };
 
+/* Type carried in ctrl_hdr.seg_no of rxm_ctrl_credit messages */
+enum {
+	RXM_CREDIT_FLOW_CTRL,
+	RXM_CREDIT_SAR,
+	/* SAR credits, sent once the message in msg_id was received */
+	RXM_CREDIT_SAR_ACK,
+	/* Close handshake, see rxm_conn_handle_close() */
+	RXM_CREDIT_CLOSE_REQ,
+	RXM_CREDIT_CLOSE_ACK,
+	RXM_CREDIT_CLOSE_NAK,
+};
+
 struct rxm_pkt {
 	struct ofi_ctrl_hdr ctrl_hdr;
 	struct ofi_op_hdr hdr;
@@ -428,11 +519,23 @@ enum rxm_sar_seg_type {
 union rxm_sar_ctrl_data {
 	struct {
 		enum rxm_sar_seg_type seg_type : 2;
+		/* first segment: reply with RXM_CREDIT_SAR_ACK */
+		unsigned int ack : 1;
 		uint32_t offset;
 	};
 	uint64_t align;
 };
 
+static inline bool rxm_sar_get_ack(struct ofi_ctrl_hdr *ctrl_hdr)
+{
+	return ((union rxm_sar_ctrl_data *) &(ctrl_hdr->ctrl_data))->ack;
+}
+
+static inline void rxm_sar_set_ack(struct ofi_ctrl_hdr *ctrl_hdr)
+{
+	((union rxm_sar_ctrl_data *) &(ctrl_hdr->ctrl_data))->ack = 1;
+}
+
 static inline enum rxm_sar_seg_type
 rxm_sar_get_seg_type(struct ofi_ctrl_hdr *ctrl_hdr)
 {
@@ -458,8 +561,15 @@ struct rxm_proto_info {
                 struct dlist_entry pkt_list;
                 struct fi_peer_rx_entry *rx_entry;
                 size_t total_recv_len;
+                /* Segments are placed at seg_no * seg_size, so they may
+                 * be processed in any order once the first is seen */
+                size_t seg_size;
+                size_t segs_cnt;
+                size_t segs_recv;
+                size_t segs_queued;
                 struct rxm_conn *conn;
                 uint64_t msg_id;
+                bool ack;
         } sar;
         /* Used for Rendezvous protocol */
         struct {
@@ -492,6 +602,9 @@ struct rxm_rx_buf {
 	uint64_t comp_flags;
 	struct fi_recv_context recv_context;
 	bool repost;
+	bool held;
+	/* holds a SAR credit, returned once a buffer takes its place */
+	bool sar_credit;
 
 	/* Used for large messages */
 	struct dlist_entry rndv_wait_entry;
@@ -513,6 +626,10 @@ struct rxm_tx_buf {
 	void *app_context;
 	uint64_t flags;
 
+	/* Set for rendezvous, SAR and atomic requests, which hold a
+	 * reference in conn->xfer_refs until they finish */
+	struct rxm_conn *conn;
+
 	union {
 		struct {
 			struct fid_mr *mr[RXM_IOV_LIMIT];
@@ -524,13 +641,16 @@ struct rxm_tx_buf {
 	struct {
 		struct iovec iov[RXM_IOV_LIMIT];
 		void *desc[RXM_IOV_LIMIT];
-		struct rxm_conn *conn;
 		size_t rndv_rma_index;
 		size_t rndv_rma_count;
 		struct rxm_tx_buf *done_buf;
 		struct rxm_rndv_hdr remote_hdr;
 	} write_rndv;
 
+	/* SAR segments of this message posted but not yet completed,
+	 * tracked on the first segment */
+	size_t sar_inflight;
+
 	/* Must stay at bottom */
 	struct rxm_pkt pkt;
 };
@@ -560,6 +680,7 @@ enum rxm_deferred_tx_entry_type {
 	RXM_DEFERRED_TX_SAR_SEG,
 	RXM_DEFERRED_TX_ATOMIC_RESP,
 	RXM_DEFERRED_TX_CREDIT_SEND,
+	RXM_DEFERRED_TX_SAR_CREDIT,
 };
 
 struct rxm_deferred_tx_entry {
@@ -643,6 +764,16 @@ struct rxm_ep {
 	int			connecting_cnt;
 	struct index_map	conn_idx_map;
 	struct dlist_entry	loopback_list;
+
+	/* Connection reaping and pre-connect state, see rxm_conn.c */
+	bool			conn_lru;
+	struct dlist_entry	conn_lru_list;
+	struct dlist_entry	conn_close_list;
+	size_t			conn_cnt;
+	size_t			closing_cnt;
+	uint64_t		conn_clock;
+	fi_addr_t		preconnect_next;
+	fi_addr_t		preconnect_end;
 	union ofi_sock_ip	addr;
 
 	pthread_t		cm_thread;
@@ -659,8 +790,13 @@ struct rxm_ep {
 
 	struct fid_cq 		*msg_cq;
 	uint64_t		msg_cq_last_poll;
+	uint64_t		cm_interval;
 	size_t 			comp_per_progress;
 	size_t			cq_eq_fairness;
+	size_t			cq_batch;
+	/* rx buffers freed while handling a msg CQ batch, posted together */
+	struct dlist_entry	repost_list;
+	bool			defer_repost;
 	void			(*handle_comp_error)(struct rxm_ep *ep);
 	ssize_t			(*handle_comp)(struct rxm_ep *ep,
 					       struct fi_cq_data_entry *comp);
@@ -676,6 +812,9 @@ struct rxm_ep {
 
 	size_t			eager_limit;
 	size_t			sar_limit;
+	uint8_t			sar_credit_window;
+	bool			sar_tune;
+	size_t			sar_seg_window;
 	size_t			tx_credit;
 	size_t			min_multi_recv_size;
 
@@ -695,7 +834,7 @@ struct rxm_ep {
 
 int rxm_start_listen(struct rxm_ep *ep);
 void rxm_stop_listen(struct rxm_ep *ep);
-void rxm_conn_progress(struct rxm_ep *ep);
+int rxm_conn_progress(struct rxm_ep *ep);
 
 
 extern struct fi_provider rxm_prov;
@@ -851,6 +990,89 @@ int rxm_msg_mr_reg_internal(struct rxm_domain *rxm_domain, const void *buf,
 
 ssize_t rxm_get_conn(struct rxm_ep *rxm_ep, fi_addr_t addr,
 		     struct rxm_conn **rxm_conn);
+int rxm_preconnect(struct rxm_ep *ep, const struct fi_rxm_preconnect *range);
+
+void rxm_conn_handle_close(struct rxm_conn *conn, uint32_t type);
+
+static inline void rxm_conn_touch(struct rxm_conn *conn)
+{
+	if (!conn->ep->conn_lru || conn->state != RXM_CM_CONNECTED ||
+	    dlist_empty(&conn->lru_entry))
+		return;
+
+	conn->last_use = conn->ep->conn_clock;
+	dlist_remove(&conn->lru_entry);
+	dlist_insert_tail(&conn->lru_entry, &conn->ep->conn_lru_list);
+}
+
+ssize_t rxm_send_credit_msg(struct rxm_conn *rxm_conn, uint32_t type,
+			    uint64_t credits, uint64_t msg_id);
+
+static inline bool rxm_sar_credit_avail(struct rxm_conn *rxm_conn)
+{
+	return !rxm_conn->peer_sar_window || rxm_conn->sar_tx_credits;
+}
+
+static inline void rxm_sar_use_credit(struct rxm_conn *rxm_conn)
+{
+	if (rxm_conn->peer_sar_window) {
+		assert(rxm_conn->sar_tx_credits);
+		rxm_conn->sar_tx_credits--;
+	}
+}
+
+static inline struct rxm_tx_buf *
+rxm_sar_first_tx_buf(struct rxm_ep *rxm_ep, uint64_t msg_id)
+{
+	return ofi_bufpool_get_ibuf(rxm_ep->tx_pool, msg_id);
+}
+
+/* Segments past the window stay on the deferred queue until earlier
+ * segments of the same message complete locally.
+ */
+static inline bool
+rxm_sar_seg_avail(struct rxm_ep *rxm_ep, struct rxm_conn *rxm_conn,
+		  uint64_t msg_id)
+{
+	return rxm_sar_credit_avail(rxm_conn) &&
+	       (!rxm_ep->sar_seg_window ||
+		rxm_sar_first_tx_buf(rxm_ep, msg_id)->sar_inflight <
+		rxm_ep->sar_seg_window);
+}
+
+static inline void
+rxm_sar_seg_sent(struct rxm_ep *rxm_ep, struct rxm_conn *rxm_conn,
+		 uint64_t msg_id)
+{
+	rxm_sar_use_credit(rxm_conn);
+	rxm_sar_first_tx_buf(rxm_ep, msg_id)->sar_inflight++;
+}
+
+/* Only valid for sizes above the eager limit.  ofi_msb() counts from 1,
+ * so (eager, eager << 1] lands in bucket 0.
+ */
+static inline int rxm_sar_bucket(struct rxm_ep *rxm_ep, size_t len)
+{
+	assert(len > rxm_ep->eager_limit);
+	return (int) ofi_msb((len - 1) / rxm_ep->eager_limit) - 1;
+}
+
+/* A timed transfer whose end was never reported is given up on */
+static inline bool rxm_sar_tune_idle(struct rxm_conn *rxm_conn)
+{
+	return !rxm_conn->tune_start ||
+	       ofi_gettime_ns() - rxm_conn->tune_start > RXM_SAR_TUNE_TIMEOUT;
+}
+
+static inline void
+rxm_sar_tune_start(struct rxm_conn *rxm_conn, uint64_t msg_id, size_t len,
+		   int proto)
+{
+	rxm_conn->tune_start = ofi_gettime_ns();
+	rxm_conn->tune_msg_id = msg_id;
+	rxm_conn->tune_len = len;
+	rxm_conn->tune_proto = proto;
+}
 
 static inline void
 rxm_ep_format_tx_buf_pkt(struct rxm_conn *rxm_conn, size_t len, uint8_t op,
@@ -900,9 +1122,17 @@ rxm_free_rx_buf(struct rxm_rx_buf *rx_buf)
 	}
 
 	/* Discard rx buffer if its msg_ep was closed */
-	if (rx_buf->repost && (rx_buf->ep->msg_srx || rx_buf->conn->msg_ep)) {
+	if (rx_buf->repost && rx_buf->ep->defer_repost) {
+		dlist_insert_tail(&rx_buf->repost_entry,
+				  &rx_buf->ep->repost_list);
+	} else if (rx_buf->repost &&
+		   (rx_buf->ep->msg_srx || rx_buf->conn->msg_ep)) {
 		rxm_post_recv(rx_buf);
 	} else {
+		if (rx_buf->held) {
+			rx_buf->conn->xfer_refs--;
+			rx_buf->held = false;
+		}
 		ofi_buf_free(rx_buf);
 	}
 }
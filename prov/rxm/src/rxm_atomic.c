@@ -76,11 +76,13 @@ rxm_ep_send_atomic_req(struct rxm_ep *rxm_ep, struct rxm_conn *rxm_conn,
 	if (ret == -FI_EAGAIN)
 		rxm_ep_do_progress(&rxm_ep->util_ep);
 
-	if (OFI_LIKELY(!ret))
+	if (OFI_LIKELY(!ret)) {
+		tx_buf->conn = rxm_conn;
+		rxm_conn->xfer_refs++;
 		FI_DBG(&rxm_prov, FI_LOG_EP_DATA, "sent atomic request: op: %"
 		       PRIu8 " msg_id: 0x%" PRIx64 "\n", tx_buf->pkt.hdr.op,
 		       tx_buf->pkt.ctrl_hdr.msg_id);
-	else if (OFI_UNLIKELY(ret != -FI_EAGAIN))
+	} else if (OFI_UNLIKELY(ret != -FI_EAGAIN))
 		FI_WARN(&rxm_prov, FI_LOG_EP_DATA, "unable to send atomic "
 			"request: op: %" PRIu8 " msg_id: 0x%" PRIx64 "\n",
 			tx_buf->pkt.hdr.op, tx_buf->pkt.ctrl_hdr.msg_id);
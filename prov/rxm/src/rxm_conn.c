@@ -79,6 +79,11 @@ static void rxm_close_conn(struct rxm_conn *conn)
 		rx_entry = (struct fi_peer_rx_entry*)conn->deferred_sar_msgs.next;
 		rx_entry->srx->owner_ops->free_entry(rx_entry);
 	}
+	if (!dlist_empty(&conn->lru_entry)) {
+		dlist_remove_init(&conn->lru_entry);
+		conn->ep->conn_cnt--;
+	}
+
 	fi_close(&conn->msg_ep->fid);
 	rxm_flush_msg_cq(conn->ep);
 	dlist_remove_init(&conn->loopback_entry);
@@ -87,6 +92,9 @@ static void rxm_close_conn(struct rxm_conn *conn)
 	if (conn->state == RXM_CM_CONNECTING || conn->state == RXM_CM_ACCEPTING)
 		conn->ep->connecting_cnt--;
 	assert(conn->ep->connecting_cnt >= 0);
+	if (conn->state == RXM_CM_CLOSING)
+		conn->ep->closing_cnt--;
+	conn->flags &= ~(RXM_CONN_CLOSE_REQ | RXM_CONN_SAR_CREDIT);
 	conn->state = RXM_CM_IDLE;
 }
 
@@ -219,6 +227,11 @@ static int rxm_open_conn(struct rxm_conn *conn, struct fi_info *msg_info)
 	}
 
 	conn->msg_ep = msg_ep;
+	if (ep->conn_lru)
+		ep->conn_clock = ofi_gettime_ms();
+	conn->last_use = ep->conn_clock;
+	dlist_insert_tail(&conn->lru_entry, &ep->conn_lru_list);
+	ep->conn_cnt++;
 	return 0;
 err:
 	fi_close(&msg_ep->fid);
@@ -245,6 +258,8 @@ static int rxm_init_connect_data(struct rxm_conn *conn,
 	cm_data->connect.flow_ctrl = conn->flow_ctrl ?
 						RXM_CM_FLOW_CTRL_PEER_ON :
 						RXM_CM_FLOW_CTRL_PEER_OFF;
+	cm_data->connect.sar_credits = conn->ep->sar_credit_window;
+	cm_data->connect.close_hs = 1;
 
 	ret = fi_getopt(&conn->ep->msg_pep->fid, FI_OPT_ENDPOINT,
 			FI_OPT_CM_DATA_SIZE, &cm_data_size, &opt_size);
@@ -318,6 +333,7 @@ static int rxm_connect(struct rxm_conn *conn)
 		break;
 	case RXM_CM_CONNECTING:
 	case RXM_CM_ACCEPTING:
+	case RXM_CM_CLOSING:
 		break;
 	case RXM_CM_CONNECTED:
 		return 0;
@@ -399,11 +415,20 @@ rxm_alloc_conn(struct rxm_ep *ep, struct util_peer_addr *peer)
 	conn->state = RXM_CM_IDLE;
 	conn->remote_index = -1;
 	conn->flags = 0;
+	conn->peer_sar_window = 0;
+	conn->sar_bucket = ep->sar_tune ?
+			   rxm_sar_bucket(ep, ep->sar_limit) : -1;
+	conn->sar_probe = 0;
+	memset(conn->sar_stats, 0, sizeof(conn->sar_stats));
+	conn->tune_start = 0;
 	dlist_init(&conn->deferred_entry);
 	dlist_init(&conn->deferred_tx_queue);
 	dlist_init(&conn->deferred_sar_msgs);
 	dlist_init(&conn->deferred_sar_segments);
 	dlist_init(&conn->loopback_entry);
+	dlist_init(&conn->lru_entry);
+	conn->last_use = 0;
+	conn->xfer_refs = 0;
 
 	conn->peer = peer;
 	rxm_ref_peer(peer);
@@ -449,6 +474,7 @@ ssize_t rxm_get_conn(struct rxm_ep *ep, fi_addr_t addr, struct rxm_conn **conn)
 		return -FI_ENOMEM;
 
 	if ((*conn)->state == RXM_CM_CONNECTED) {
+		rxm_conn_touch(*conn);
 		if (!dlist_empty(&(*conn)->deferred_tx_queue)) {
 			rxm_ep_do_progress(&ep->util_ep);
 			if (!dlist_empty(&(*conn)->deferred_tx_queue))
@@ -471,6 +497,200 @@ ssize_t rxm_get_conn(struct rxm_ep *ep, fi_addr_t addr, struct rxm_conn **conn)
 	return ret;
 }
 
+/* Nothing outstanding that still needs the msg ep on this side */
+static bool rxm_conn_quiet(struct rxm_conn *conn)
+{
+	return conn->state == RXM_CM_CONNECTED && !conn->xfer_refs &&
+	       dlist_empty(&conn->deferred_tx_queue) &&
+	       dlist_empty(&conn->deferred_sar_msgs) &&
+	       dlist_empty(&conn->deferred_sar_segments);
+}
+
+/* Closing a connection takes a handshake, so that neither side drops a
+ * message that the other has already sent.  The side that wants to
+ * close sends RXM_CREDIT_CLOSE_REQ and starts no new transfers.  If the
+ * peer has nothing outstanding either, it stops as well and answers
+ * RXM_CREDIT_CLOSE_ACK; otherwise it answers RXM_CREDIT_CLOSE_NAK and
+ * the connection stays up.  The msg ep delivers in order, so once the
+ * ack arrives all data sent by either side has been received.  The
+ * requester then closes its msg ep, and the peer closes its own on the
+ * shutdown that follows.  When both sides ask at once, each acks the
+ * other's request and closes on the ack it gets back.
+ */
+static void rxm_conn_close_req(struct rxm_conn *conn)
+{
+	conn->state = RXM_CM_CLOSING;
+	if (rxm_send_credit_msg(conn, RXM_CREDIT_CLOSE_REQ, 0, 0)) {
+		conn->state = RXM_CM_CONNECTED;
+		return;
+	}
+
+	conn->flags |= RXM_CONN_CLOSE_REQ;
+	conn->ep->closing_cnt++;
+}
+
+/* Called while processing the msg CQ, so the msg ep is closed later
+ * from rxm_reap_conns().
+ */
+void rxm_conn_handle_close(struct rxm_conn *conn, uint32_t type)
+{
+	assert(ofi_genlock_held(&conn->ep->util_ep.lock));
+	switch (type) {
+	case RXM_CREDIT_CLOSE_REQ:
+		if (conn->state == RXM_CM_CLOSING &&
+		    (conn->flags & RXM_CONN_CLOSE_REQ)) {
+			(void) rxm_send_credit_msg(conn, RXM_CREDIT_CLOSE_ACK,
+						   0, 0);
+		} else if (!rxm_conn_quiet(conn)) {
+			(void) rxm_send_credit_msg(conn, RXM_CREDIT_CLOSE_NAK,
+						   0, 0);
+		} else if (!rxm_send_credit_msg(conn, RXM_CREDIT_CLOSE_ACK,
+						0, 0)) {
+			FI_INFO(&rxm_prov, FI_LOG_EP_CTRL,
+				"peer closing conn %p\n", conn);
+			conn->state = RXM_CM_CLOSING;
+			conn->ep->closing_cnt++;
+		}
+		break;
+	case RXM_CREDIT_CLOSE_ACK:
+		if (!(conn->flags & RXM_CONN_CLOSE_REQ))
+			break;
+
+		dlist_remove(&conn->lru_entry);
+		dlist_insert_tail(&conn->lru_entry, &conn->ep->conn_close_list);
+		break;
+	case RXM_CREDIT_CLOSE_NAK:
+		if (!(conn->flags & RXM_CONN_CLOSE_REQ))
+			break;
+
+		FI_INFO(&rxm_prov, FI_LOG_EP_CTRL, "peer keeps conn %p\n",
+			conn);
+		conn->flags &= ~RXM_CONN_CLOSE_REQ;
+		conn->ep->closing_cnt--;
+		conn->state = RXM_CM_CONNECTED;
+		rxm_conn_touch(conn);
+		break;
+	default:
+		assert(0);
+		break;
+	}
+}
+
+/* Close the connections whose close request was acked.  Then walk the
+ * open connections from least to most recently used, asking the peer to
+ * close those that have been idle past the timeout.  If more than
+ * max_cnt connections are open and not already closing, continue past
+ * unexpired entries and ask the oldest idle ones until the count drops.
+ * Either side reconnects on the next transfer.
+ *
+ * Connections used within RXM_CONN_MIN_IDLE_MS, with transfers
+ * outstanding, or to peers that do not answer close requests are never
+ * closed, which makes the connection cap a soft limit.
+ */
+static void rxm_reap_conns(struct rxm_ep *ep, size_t max_cnt)
+{
+	struct rxm_conn *conn;
+	struct dlist_entry *tmp;
+	uint64_t idle;
+	bool expired;
+
+	assert(ofi_genlock_held(&ep->util_ep.lock));
+	while (!dlist_empty(&ep->conn_close_list)) {
+		conn = container_of(ep->conn_close_list.next, struct rxm_conn,
+				    lru_entry);
+		FI_INFO(&rxm_prov, FI_LOG_EP_CTRL, "reaping conn %p\n", conn);
+		rxm_close_conn(conn);
+		rxm_free_conn(conn);
+	}
+
+	dlist_foreach_container_safe(&ep->conn_lru_list, struct rxm_conn,
+				     conn, lru_entry, tmp) {
+		idle = ep->conn_clock - conn->last_use;
+		if (idle < RXM_CONN_MIN_IDLE_MS)
+			break;
+
+		expired = rxm_conn_idle_timeout &&
+			  idle >= rxm_conn_idle_timeout;
+		if (!expired && ep->conn_cnt - ep->closing_cnt <= max_cnt)
+			break;
+
+		if ((conn->flags & (RXM_CONN_INDEXED | RXM_CONN_CLOSE_HS)) !=
+		    (RXM_CONN_INDEXED | RXM_CONN_CLOSE_HS) ||
+		    !rxm_conn_quiet(conn))
+			continue;
+
+		FI_INFO(&rxm_prov, FI_LOG_EP_CTRL,
+			"requesting close of %s conn %p\n",
+			expired ? "idle" : "lru", conn);
+		rxm_conn_close_req(conn);
+	}
+}
+
+static void rxm_preconnect_progress(struct rxm_ep *ep)
+{
+	struct util_peer_addr **peer;
+	struct rxm_conn *conn;
+	fi_addr_t addr;
+	int ret;
+
+	assert(ofi_genlock_held(&ep->util_ep.lock));
+	while (ep->preconnect_next < ep->preconnect_end &&
+	       (size_t) ep->connecting_cnt < rxm_conn_batch) {
+		if (rxm_max_conns && ep->conn_cnt >= rxm_max_conns) {
+			ep->preconnect_next = ep->preconnect_end;
+			break;
+		}
+
+		addr = ep->preconnect_next++;
+		if (!ofi_bufpool_ibuf_is_valid(ep->util_ep.av->av_entry_pool,
+					       addr))
+			continue;
+
+		peer = ofi_av_addr_context(ep->util_ep.av, addr);
+		if (!*peer || (*peer)->firewall_addr)
+			continue;
+
+		conn = rxm_add_conn(ep, *peer);
+		if (!conn)
+			break;
+
+		ret = rxm_connect(conn);
+		if (ret && ret != -FI_EAGAIN)
+			FI_WARN(&rxm_prov, FI_LOG_EP_CTRL,
+				"unable to pre-connect to fi_addr %" PRIu64
+				": %s\n", addr, fi_strerror(-ret));
+	}
+}
+
+int rxm_preconnect(struct rxm_ep *ep, const struct fi_rxm_preconnect *range)
+{
+	if (!ep->util_ep.av || !ep->msg_pep)
+		return -FI_EOPBADSTATE;
+
+	ofi_genlock_lock(&ep->util_ep.lock);
+	ep->preconnect_next = range->addr;
+	ep->preconnect_end = range->addr + range->count;
+	rxm_preconnect_progress(ep);
+	rxm_conn_progress(ep);
+	ofi_genlock_unlock(&ep->util_ep.lock);
+	return 0;
+}
+
+/* Peers that predate SAR credits send 0, which disables them */
+static void rxm_set_peer_sar_window(struct rxm_conn *conn, uint8_t sar_credits)
+{
+	conn->peer_sar_window = conn->ep->sar_credit_window ? sar_credits : 0;
+}
+
+/* Older peers send 0 and are never asked to close */
+static void rxm_set_peer_close_hs(struct rxm_conn *conn, uint8_t close_hs)
+{
+	if (close_hs)
+		conn->flags |= RXM_CONN_CLOSE_HS;
+	else
+		conn->flags &= ~RXM_CONN_CLOSE_HS;
+}
+
 static void rxm_set_peer_flow_ctrl(struct rxm_conn *conn, int cm_flow_ctrl_flag)
 {
 	switch (cm_flow_ctrl_flag) {
@@ -509,8 +729,14 @@ void rxm_process_connect(struct rxm_eq_cm_entry *cm_entry)
 		conn->remote_pid = rxm_peer_pid(cm_entry->data.accept.
 						server_conn_id);
 		rxm_set_peer_flow_ctrl(conn, cm_entry->data.accept.flow_ctrl);
+		rxm_set_peer_sar_window(conn,
+					cm_entry->data.accept.sar_credits);
+		rxm_set_peer_close_hs(conn, cm_entry->data.accept.close_hs);
 	}
 
+	conn->sar_tx_credits = conn->peer_sar_window;
+	conn->sar_rx_credits = 0;
+
 	if (conn->flow_ctrl & conn->peer_flow_ctrl) {
 		domain = container_of(conn->ep->util_ep.domain,
 				      struct rxm_domain, util_domain);
@@ -628,9 +854,10 @@ rxm_accept_connreq(struct rxm_conn *conn, struct rxm_eq_cm_entry *cm_entry)
 	cm_data.accept.rx_size = (uint32_t) cm_entry->info->rx_attr->size;
 	cm_data.accept.flow_ctrl = conn->flow_ctrl ? RXM_CM_FLOW_CTRL_PEER_ON :
 						     RXM_CM_FLOW_CTRL_PEER_OFF;
+	cm_data.accept.sar_credits = conn->ep->sar_credit_window;
+	cm_data.accept.close_hs = 1;
 	cm_data.accept.align_pad[0] = 0;
 	cm_data.accept.align_pad[1] = 0;
-	cm_data.accept.align_pad[2] = 0;
 
 	ret = fi_accept(conn->msg_ep, &cm_data.accept, sizeof(cm_data.accept));
 	if (ret)
@@ -714,6 +941,14 @@ rxm_process_connreq(struct rxm_ep *ep, struct rxm_eq_cm_entry *cm_entry)
 			rxm_close_conn(conn);
 		}
 		break;
+	case RXM_CM_CLOSING:
+		/* The peer closed its side and is reconnecting before we
+		 * saw the shutdown.
+		 */
+		FI_INFO(&rxm_prov, FI_LOG_EP_CTRL,
+			"closing connection exists, replacing %p\n", conn);
+		rxm_close_conn(conn);
+		break;
 	default:
 		assert(0);
 		break;
@@ -726,6 +961,8 @@ rxm_process_connreq(struct rxm_ep *ep, struct rxm_eq_cm_entry *cm_entry)
 		goto free;
 
 	rxm_set_peer_flow_ctrl(conn, cm_entry->data.connect.flow_ctrl);
+	rxm_set_peer_sar_window(conn, cm_entry->data.connect.sar_credits);
+	rxm_set_peer_close_hs(conn, cm_entry->data.connect.close_hs);
 
 	ret = rxm_accept_connreq(conn, cm_entry);
 	if (ret)
@@ -762,6 +999,7 @@ void rxm_process_shutdown(struct rxm_conn *conn)
 	case RXM_CM_CONNECTING:
 	case RXM_CM_ACCEPTING:
 	case RXM_CM_CONNECTED:
+	case RXM_CM_CLOSING:
 		rxm_close_conn(conn);
 		rxm_free_conn(conn);
 		break;
@@ -833,11 +1071,13 @@ rxm_handle_event(struct rxm_ep *ep, uint32_t event,
 	}
 }
 
-void rxm_conn_progress(struct rxm_ep *ep)
+/* Returns the number of CM events handled */
+int rxm_conn_progress(struct rxm_ep *ep)
 {
 	struct rxm_eq_cm_entry cm_entry;
 	uint32_t event;
 	ssize_t ret;
+	int cnt = 0;
 
 	assert(ofi_genlock_held(&ep->util_ep.lock));
 	do {
@@ -845,11 +1085,22 @@ void rxm_conn_progress(struct rxm_ep *ep)
 				 sizeof(cm_entry), 0);
 		if (ret > 0) {
 			rxm_handle_event(ep, event, &cm_entry, ret);
+			cnt++;
 		} else if (ret == -FI_EAVAIL) {
 			rxm_handle_error(ep);
 			ret = 1;
+			cnt++;
 		}
 	} while (ret > 0);
+
+	if (ep->conn_lru) {
+		ep->conn_clock = ofi_gettime_ms();
+		rxm_reap_conns(ep, rxm_max_conns ? rxm_max_conns : SIZE_MAX);
+	}
+
+	if (ep->preconnect_next < ep->preconnect_end)
+		rxm_preconnect_progress(ep);
+	return cnt;
 }
 
 void rxm_stop_listen(struct rxm_ep *ep)
@@ -902,6 +1153,23 @@ static void rxm_flush_msg_cq(struct rxm_ep *ep)
 	} while (ret > 0);
 }
 
+/* The LRU is only walked from rxm_conn_progress(), so the auto-progress
+ * thread must wake up on its own to close idle connections on an
+ * endpoint that has gone quiet.
+ */
+static int rxm_conn_poll_timeout(struct rxm_ep *ep)
+{
+	size_t timeout;
+
+	if (!ep->conn_lru)
+		return -1;
+
+	timeout = rxm_max_conns ? RXM_CONN_MIN_IDLE_MS : SIZE_MAX;
+	if (rxm_conn_idle_timeout)
+		timeout = MIN(timeout, rxm_conn_idle_timeout);
+	return (int) MIN(timeout, INT_MAX);
+}
+
 static void *rxm_cm_data_progress(void *arg)
 {
 	struct rxm_ep *ep = container_of(arg, struct rxm_ep, util_ep);
@@ -914,7 +1182,8 @@ static void *rxm_cm_data_progress(void *arg)
 		{.events = POLLIN},
 		{.events = POLLIN},
 	};
-	int ret;
+	bool cm_ready;
+	int ret, timeout;
 
 	fabric = container_of(ep->util_ep.domain->fabric,
 			      struct rxm_fabric, util_fabric);
@@ -930,21 +1199,31 @@ static void *rxm_cm_data_progress(void *arg)
 		return NULL;
 	}
 
+	timeout = rxm_conn_poll_timeout(ep);
 	FI_INFO(&rxm_prov, FI_LOG_EP_CTRL, "Starting auto-progress thread\n");
 	ofi_genlock_lock(&ep->util_ep.lock);
 	while (ep->do_progress) {
 		ofi_genlock_unlock(&ep->util_ep.lock);
 		ret = fi_trywait(fabric->msg_fabric, fids, 2);
 
+		/* If only the msg CQ woke us, leave the CM to the polling
+		 * interval in the data progress call, unless connections are
+		 * waiting to be closed or preconnected.
+		 */
+		cm_ready = true;
 		if (!ret) {
-			ret = poll(fds, 2, -1);
+			ret = poll(fds, 2, timeout);
 			if (ret == -1) {
 				RXM_WARN_ERR(FI_LOG_EP_CTRL, "poll", -errno);
+			} else if (ret) {
+				cm_ready = fds[0].revents != 0;
 			}
 		}
 		ep->util_ep.progress(&ep->util_ep);
 		ofi_genlock_lock(&ep->util_ep.lock);
-		rxm_conn_progress(ep);
+		if (cm_ready || !dlist_empty(&ep->conn_close_list) ||
+		    ep->preconnect_next < ep->preconnect_end)
+			rxm_conn_progress(ep);
 	}
 	ofi_genlock_unlock(&ep->util_ep.lock);
 
@@ -75,6 +75,8 @@ rxm_rx_buf_alloc(struct rxm_ep *rxm_ep, struct fid_ep *rx_ep)
 	rx_buf->hdr.state = RXM_RX;
 	rx_buf->rx_ep = rx_ep;
 	rx_buf->repost = true;
+	rx_buf->held = false;
+	rx_buf->sar_credit = false;
 
 	if (!rxm_ep->msg_srx)
 		rx_buf->conn = rx_ep->fid.context;
@@ -82,23 +84,100 @@ rxm_rx_buf_alloc(struct rxm_ep *rxm_ep, struct fid_ep *rx_ep)
 	return rx_buf;
 }
 
+/* The credit message could not even be queued.  Retry from progress,
+ * or a sender that has used its whole window would wait forever.
+ */
+static void rxm_sar_defer_credit(struct rxm_conn *conn)
+{
+	struct rxm_deferred_tx_entry *def_tx_entry;
+
+	if (conn->flags & RXM_CONN_SAR_CREDIT)
+		return;
+
+	def_tx_entry = rxm_ep_alloc_deferred_tx_entry(conn->ep, conn,
+						RXM_DEFERRED_TX_SAR_CREDIT);
+	if (!def_tx_entry) {
+		FI_WARN(&rxm_prov, FI_LOG_CQ,
+			"unable to allocate TX entry for deferred SAR credits\n");
+		return;
+	}
+
+	conn->flags |= RXM_CONN_SAR_CREDIT;
+	rxm_queue_deferred_tx(def_tx_entry, OFI_LIST_TAIL);
+}
+
+/* A SAR segment is credited back to the sender once a receive buffer
+ * takes its place: when its own buffer is reposted, or a replacement is
+ * posted while it is held.  Credits are returned in batches of half the
+ * window.
+ */
+static void rxm_sar_return_credit(struct rxm_rx_buf *rx_buf)
+{
+	struct rxm_conn *conn = rx_buf->conn;
+	uint16_t threshold;
+
+	if (!rx_buf->sar_credit)
+		return;
+
+	rx_buf->sar_credit = false;
+	if (!conn || !conn->msg_ep)
+		return;
+
+	threshold = MAX(conn->ep->sar_credit_window / 2, 1);
+	if (++conn->sar_rx_credits < threshold)
+		return;
+
+	if (!rxm_send_credit_msg(conn, RXM_CREDIT_SAR, conn->sar_rx_credits, 0))
+		conn->sar_rx_credits = 0;
+	else
+		rxm_sar_defer_credit(conn);
+}
+
+/* Tell the sender that a SAR message it is timing has been received,
+ * returning the credits collected so far along with it.
+ */
+static void rxm_sar_send_ack(struct rxm_conn *conn, uint64_t msg_id)
+{
+	if (!conn->msg_ep)
+		return;
+
+	if (!rxm_send_credit_msg(conn, RXM_CREDIT_SAR_ACK,
+				 conn->sar_rx_credits, msg_id))
+		conn->sar_rx_credits = 0;
+	else if (conn->sar_rx_credits)
+		rxm_sar_defer_credit(conn);
+}
+
 /* Processing on the current rx buffer is expected to be slow.
  * Post a new buffer to take its place, and mark the current
- * buffer to return to the free pool when finished.
+ * buffer to return to the free pool when finished.  A buffer that
+ * was queued as unexpected has already been replaced.
  */
 static void rxm_replace_rx_buf(struct rxm_rx_buf *rx_buf)
 {
 	struct rxm_rx_buf *new_rx_buf;
 	int ret;
 
+	if (!rx_buf->repost)
+		return;
+
 	new_rx_buf = rxm_rx_buf_alloc(rx_buf->ep, rx_buf->rx_ep);
 	if (!new_rx_buf)
 		return;
 
 	rx_buf->repost = false;
+	if (!rx_buf->conn && rx_buf->ep->msg_srx)
+		rx_buf->conn = ofi_idm_lookup(&rx_buf->ep->conn_idx_map,
+				(int) rx_buf->pkt.ctrl_hdr.conn_id);
+	if (rx_buf->conn) {
+		rx_buf->conn->xfer_refs++;
+		rx_buf->held = true;
+	}
 	ret = rxm_post_recv(new_rx_buf);
 	if (ret)
 		ofi_buf_free(new_rx_buf);
+	else
+		rxm_sar_return_credit(rx_buf);
 }
 
 static void rxm_cq_write_recv_comp(struct rxm_rx_buf *rx_buf, void *context,
@@ -249,6 +328,66 @@ void rxm_finish_eager_send(struct rxm_ep *rxm_ep, struct rxm_tx_buf *tx_buf)
 	ofi_ep_peer_tx_cntr_inc(&rxm_ep->util_ep, ofi_op_msg);
 }
 
+static void rxm_proto_stat_age(struct rxm_proto_stat *stat)
+{
+	stat->bytes >>= 1;
+	stat->nsec >>= 1;
+	stat->cnt >>= 1;
+}
+
+/* Move the SAR limit of a connection by one size bucket if the protocol
+ * on the other side of the limit achieved noticeably higher bandwidth.
+ * Both protocols are timed from the send call until the receiver reports
+ * that it has all of the data.  Older samples are aged out, so that the
+ * limit follows changes in the load of the receiver.
+ */
+static void rxm_sar_tune_update(struct rxm_ep *rxm_ep, struct rxm_conn *conn,
+				uint64_t msg_id, int proto)
+{
+	struct rxm_proto_stat *stat;
+	double sar_bw, rndv_bw;
+	int bucket;
+
+	if (!conn->tune_start || conn->tune_msg_id != msg_id ||
+	    conn->tune_proto != proto)
+		return;
+
+	bucket = rxm_sar_bucket(rxm_ep, conn->tune_len);
+	assert(bucket >= 0 && bucket < RXM_SAR_TUNE_BUCKETS);
+	stat = conn->sar_stats[bucket];
+
+	stat[proto].bytes += conn->tune_len;
+	stat[proto].nsec += ofi_gettime_ns() - conn->tune_start;
+	conn->tune_start = 0;
+	if (++stat[proto].cnt > RXM_SAR_TUNE_MAX_CNT)
+		rxm_proto_stat_age(&stat[proto]);
+
+	if (stat[RXM_SAR_TUNE_SAR].cnt < RXM_SAR_TUNE_SAMPLES ||
+	    stat[RXM_SAR_TUNE_RNDV].cnt < RXM_SAR_TUNE_SAMPLES)
+		return;
+
+	sar_bw = (double) stat[RXM_SAR_TUNE_SAR].bytes /
+		 (stat[RXM_SAR_TUNE_SAR].nsec + 1);
+	rndv_bw = (double) stat[RXM_SAR_TUNE_RNDV].bytes /
+		  (stat[RXM_SAR_TUNE_RNDV].nsec + 1);
+
+	if (bucket == conn->sar_bucket && rndv_bw > sar_bw * 1.125) {
+		conn->sar_bucket--;
+	} else if (bucket == conn->sar_bucket + 1 &&
+		   sar_bw > rndv_bw * 1.125) {
+		conn->sar_bucket++;
+	} else {
+		return;
+	}
+
+	FI_DBG(&rxm_prov, FI_LOG_EP_DATA, "conn %p SAR limit now %zu "
+	       "(SAR %.0f MB/s, rndv %.0f MB/s)\n", conn,
+	       rxm_ep->eager_limit << (conn->sar_bucket + 1),
+	       sar_bw * 1000, rndv_bw * 1000);
+	rxm_proto_stat_age(&stat[RXM_SAR_TUNE_SAR]);
+	rxm_proto_stat_age(&stat[RXM_SAR_TUNE_RNDV]);
+}
+
 static bool rxm_complete_sar(struct rxm_ep *rxm_ep,
 			     struct rxm_tx_buf *tx_buf)
 {
@@ -257,13 +396,18 @@ static bool rxm_complete_sar(struct rxm_ep *rxm_ep,
 	assert(ofi_tx_cq_flags(tx_buf->pkt.hdr.op) & FI_SEND);
 	switch (rxm_sar_get_seg_type(&tx_buf->pkt.ctrl_hdr)) {
 	case RXM_SAR_SEG_FIRST:
+		tx_buf->sar_inflight--;
 		break;
 	case RXM_SAR_SEG_MIDDLE:
+		first_tx_buf = rxm_sar_first_tx_buf(rxm_ep,
+						tx_buf->pkt.ctrl_hdr.msg_id);
+		first_tx_buf->sar_inflight--;
 		rxm_free_tx_buf(rxm_ep, tx_buf);
 		break;
 	case RXM_SAR_SEG_LAST:
 		first_tx_buf = ofi_bufpool_get_ibuf(rxm_ep->tx_pool,
 						tx_buf->pkt.ctrl_hdr.msg_id);
+		first_tx_buf->conn->xfer_refs--;
 		rxm_free_tx_buf(rxm_ep, first_tx_buf);
 		rxm_free_tx_buf(rxm_ep, tx_buf);
 		return true;
@@ -313,6 +457,9 @@ static void rxm_rndv_tx_finish(struct rxm_ep *rxm_ep,
 	assert(ofi_tx_cq_flags(tx_buf->pkt.hdr.op) & FI_SEND);
 
 	RXM_UPDATE_STATE(FI_LOG_CQ, tx_buf, RXM_RNDV_FINISH);
+	rxm_sar_tune_update(rxm_ep, tx_buf->conn,
+			    tx_buf->pkt.ctrl_hdr.msg_id, RXM_SAR_TUNE_RNDV);
+	tx_buf->conn->xfer_refs--;
 	if (!rxm_ep->rdm_mr_local)
 		rxm_msg_mr_closev(tx_buf->rma.mr, tx_buf->rma.count);
 
@@ -418,17 +565,24 @@ static void rxm_init_sar_proto(struct rxm_rx_buf *rx_buf)
 
 	proto_info->sar.conn = rx_buf->conn;
 	proto_info->sar.msg_id = rx_buf->pkt.ctrl_hdr.msg_id;
+	proto_info->sar.ack = rxm_sar_get_ack(&rx_buf->pkt.ctrl_hdr);
 	proto_info->sar.total_recv_len = 0;
 	proto_info->sar.rx_entry = rx_buf->peer_entry;
+	proto_info->sar.seg_size = rx_buf->pkt.ctrl_hdr.seg_size;
+	proto_info->sar.segs_cnt = ofi_div_ceil(rx_buf->pkt.hdr.size,
+						proto_info->sar.seg_size);
+	proto_info->sar.segs_recv = 0;
+	proto_info->sar.segs_queued = 0;
 
 	dlist_insert_tail(&proto_info->sar.entry,
 			  &rx_buf->conn->deferred_sar_msgs);
 
 	dlist_init(&proto_info->sar.pkt_list);
-	if (rx_buf->peer_entry->peer_context)
+	if (rx_buf->peer_entry->peer_context) {
 		dlist_insert_tail(&rx_buf->unexp_entry,
 				  &proto_info->sar.pkt_list);
-
+		proto_info->sar.segs_queued++;
+	}
 
 	rx_buf->proto_info = proto_info;
 }
@@ -447,22 +601,29 @@ int rxm_process_seg_data(struct rxm_rx_buf *rx_buf)
 					       rx_buf->peer_entry->count,
 					       &device);
 
+	/* All but the last segment are full, so the placement of a
+	 * segment does not depend on the ones that arrived before it.
+	 * A truncated receive still waits for every segment, so that
+	 * none is left behind to be mistaken for a new message.
+	 */
 	done_len = ofi_copy_to_hmem_iov(iface, device,
 					rx_buf->peer_entry->iov,
 					rx_buf->peer_entry->count,
-					proto_info->sar.total_recv_len,
+					rx_buf->pkt.ctrl_hdr.seg_no *
+					proto_info->sar.seg_size,
 					rx_buf->pkt.data,
 					rx_buf->pkt.ctrl_hdr.seg_size);
-	assert(done_len == rx_buf->pkt.ctrl_hdr.seg_size);
 
 	proto_info->sar.total_recv_len += done_len;
 
-	if ((rxm_sar_get_seg_type(&rx_buf->pkt.ctrl_hdr) == RXM_SAR_SEG_LAST) ||
-	    (done_len != rx_buf->pkt.ctrl_hdr.seg_size)) {
+	if (++proto_info->sar.segs_recv == proto_info->sar.segs_cnt) {
 		if (!rx_buf->peer_entry->peer_context)
 			dlist_remove(&proto_info->sar.entry);
 		done_len = proto_info->sar.total_recv_len;
 		done = 1;
+		if (proto_info->sar.ack)
+			rxm_sar_send_ack(proto_info->sar.conn,
+					 proto_info->sar.msg_id);
 		ofi_buf_free(rx_buf->proto_info);
 		rxm_finish_recv(rx_buf, done_len);
 	} else {
@@ -489,7 +650,7 @@ static void rxm_handle_seg_data(struct rxm_rx_buf *rx_buf)
 	proto_info = rx_buf->proto_info;
 	dlist_insert_tail(&rx_buf->unexp_entry, &proto_info->sar.pkt_list);
 
-	if ((rxm_sar_get_seg_type(&rx_buf->pkt.ctrl_hdr) == RXM_SAR_SEG_LAST))
+	if (++proto_info->sar.segs_queued == proto_info->sar.segs_cnt)
 		dlist_remove(&proto_info->sar.entry);
 
 	rx_entry = rx_buf->peer_entry;
@@ -625,7 +786,7 @@ static ssize_t rxm_rndv_handle_wr_data(struct rxm_rx_buf *rx_buf)
 	 */
 	RXM_UPDATE_STATE(FI_LOG_CQ, tx_buf, RXM_RNDV_WRITE);
 
-	ret = rxm_rndv_xfer(rx_buf->ep, tx_buf->write_rndv.conn->msg_ep, rx_hdr,
+	ret = rxm_rndv_xfer(rx_buf->ep, tx_buf->conn->msg_ep, rx_hdr,
 			    tx_buf->write_rndv.iov, tx_buf->write_rndv.desc,
 			    tx_buf->rma.count, total_len, tx_buf);
 
@@ -833,24 +994,95 @@ static int rxm_sar_match_msg_id(struct dlist_entry *item, const void *arg)
 	return (msg_id == proto_info->sar.msg_id);
 }
 
+/* A segment can only be matched to its message once the first segment,
+ * which carries the tag, has been seen.  Segments that get ahead of it
+ * are parked on the connection until then.
+ */
+static void rxm_sar_park_segment(struct rxm_rx_buf *rx_buf)
+{
+	FI_DBG(&rxm_prov, FI_LOG_CQ, "parking segment %u of msg_id: 0x%"
+	       PRIx64 "\n", rx_buf->pkt.ctrl_hdr.seg_no,
+	       rx_buf->pkt.ctrl_hdr.msg_id);
+	dlist_insert_tail(&rx_buf->unexp_entry,
+			  &rx_buf->conn->deferred_sar_segments);
+	rxm_replace_rx_buf(rx_buf);
+}
+
+static void rxm_sar_replay_segments(struct rxm_conn *conn, uint64_t msg_id)
+{
+	struct rxm_proto_info *proto_info;
+	struct dlist_entry *sar_entry, *tmp;
+	struct rxm_rx_buf *rx_buf;
+	struct dlist_entry parked;
+
+	dlist_init(&parked);
+	dlist_foreach_container_safe(&conn->deferred_sar_segments,
+				     struct rxm_rx_buf, rx_buf,
+				     unexp_entry, tmp) {
+		if (!rxm_rx_buf_match_msg_id(&rx_buf->unexp_entry, &msg_id))
+			continue;
+		dlist_remove(&rx_buf->unexp_entry);
+		dlist_insert_tail(&rx_buf->unexp_entry, &parked);
+	}
+
+	while (!dlist_empty(&parked)) {
+		dlist_pop_front(&parked, struct rxm_rx_buf, rx_buf,
+				unexp_entry);
+		sar_entry = dlist_find_first_match(&conn->deferred_sar_msgs,
+						   rxm_sar_match_msg_id,
+						   &msg_id);
+		if (!sar_entry) {
+			dlist_insert_tail(&rx_buf->unexp_entry,
+					  &conn->deferred_sar_segments);
+			continue;
+		}
+
+		proto_info = container_of(sar_entry, struct rxm_proto_info,
+					  sar.entry);
+		rx_buf->peer_entry = proto_info->sar.rx_entry;
+		rx_buf->proto_info = proto_info;
+		rxm_handle_seg_data(rx_buf);
+	}
+}
+
 static ssize_t rxm_sar_handle_segment(struct rxm_rx_buf *rx_buf)
 {
 	struct dlist_entry *sar_entry;
 	struct rxm_proto_info *proto_info;
+	struct rxm_conn *conn;
+	uint64_t msg_id;
+	ssize_t ret;
 
 	rx_buf->conn = ofi_idm_at(&rx_buf->ep->conn_idx_map,
 				  (int) rx_buf->pkt.ctrl_hdr.conn_id);
 	if (!rx_buf->conn)
 		return -FI_EOTHER;
 
+	rx_buf->sar_credit = rx_buf->conn->peer_sar_window != 0;
+
 	FI_DBG(&rxm_prov, FI_LOG_CQ,
 	       "Got incoming recv with msg_id: 0x%" PRIx64 " for conn - %p\n",
 	       rx_buf->pkt.ctrl_hdr.msg_id, rx_buf->conn);
 	sar_entry = dlist_find_first_match(&rx_buf->conn->deferred_sar_msgs,
 					   rxm_sar_match_msg_id,
 					   &rx_buf->pkt.ctrl_hdr.msg_id);
-	if (!sar_entry)
-		return rxm_handle_recv_comp(rx_buf);
+	if (!sar_entry) {
+		if (rx_buf->ep->rxm_info->mode & OFI_BUFFERED_RECV)
+			return rxm_handle_recv_comp(rx_buf);
+
+		if (rxm_sar_get_seg_type(&rx_buf->pkt.ctrl_hdr) !=
+		    RXM_SAR_SEG_FIRST) {
+			rxm_sar_park_segment(rx_buf);
+			return 0;
+		}
+
+		conn = rx_buf->conn;
+		msg_id = rx_buf->pkt.ctrl_hdr.msg_id;
+		ret = rxm_handle_recv_comp(rx_buf);
+		if (!ret && !dlist_empty(&conn->deferred_sar_segments))
+			rxm_sar_replay_segments(conn, msg_id);
+		return ret;
+	}
 
 	proto_info = container_of(sar_entry, struct rxm_proto_info, sar.entry);
 	rx_buf->peer_entry = proto_info->sar.rx_entry;
@@ -941,12 +1173,12 @@ rxm_rndv_send_wr_done(struct rxm_ep *rxm_ep, struct rxm_tx_buf *tx_buf)
 	buf->pkt.ctrl_hdr.conn_id = tx_buf->pkt.ctrl_hdr.conn_id;
 	buf->pkt.ctrl_hdr.msg_id = tx_buf->pkt.ctrl_hdr.msg_id;
 
-	ret = fi_send(tx_buf->write_rndv.conn->msg_ep, &buf->pkt,
+	ret = fi_send(tx_buf->conn->msg_ep, &buf->pkt,
 		      sizeof(buf->pkt), buf->hdr.desc, 0, tx_buf);
 	if (ret) {
 		if (ret == -FI_EAGAIN) {
 			def_entry = rxm_ep_alloc_deferred_tx_entry(rxm_ep,
-						tx_buf->write_rndv.conn,
+						tx_buf->conn,
 						RXM_DEFERRED_TX_RNDV_DONE);
 			if (def_entry) {
 				def_entry->rndv_done.tx_buf = tx_buf;
@@ -1342,6 +1574,7 @@ static ssize_t rxm_handle_atomic_resp(struct rxm_ep *rxm_ep,
 
 	ofi_ep_peer_tx_cntr_inc(&rxm_ep->util_ep, tx_buf->pkt.hdr.op);
 free:
+	tx_buf->conn->xfer_refs--;
 	rxm_free_rx_buf(rx_buf);
 	rxm_free_tx_buf(rxm_ep, tx_buf);
 	return ret;
@@ -1355,6 +1588,37 @@ write_err:
 static ssize_t rxm_handle_credit(struct rxm_ep *rxm_ep, struct rxm_rx_buf *rx_buf)
 {
 	struct rxm_domain *domain;
+	struct rxm_conn *conn;
+
+	/* Only peers that negotiated the close handshake send these */
+	if (rx_buf->pkt.ctrl_hdr.seg_no == RXM_CREDIT_CLOSE_REQ ||
+	    rx_buf->pkt.ctrl_hdr.seg_no == RXM_CREDIT_CLOSE_ACK ||
+	    rx_buf->pkt.ctrl_hdr.seg_no == RXM_CREDIT_CLOSE_NAK) {
+		conn = rx_buf->conn;
+		if (!conn)
+			conn = ofi_idm_lookup(&rxm_ep->conn_idx_map,
+					      (int) rx_buf->pkt.ctrl_hdr.conn_id);
+		if (conn)
+			rxm_conn_handle_close(conn, rx_buf->pkt.ctrl_hdr.seg_no);
+		rxm_free_rx_buf(rx_buf);
+		return FI_SUCCESS;
+	}
+
+	/* Only peers that negotiated SAR credits send RXM_CREDIT_SAR(_ACK) */
+	if (rx_buf->pkt.ctrl_hdr.seg_no == RXM_CREDIT_SAR ||
+	    rx_buf->pkt.ctrl_hdr.seg_no == RXM_CREDIT_SAR_ACK) {
+		conn = ofi_idm_at(&rxm_ep->conn_idx_map,
+				  (int) rx_buf->pkt.ctrl_hdr.conn_id);
+		if (conn && conn->peer_sar_window) {
+			conn->sar_tx_credits += rx_buf->pkt.ctrl_hdr.ctrl_data;
+			if (rx_buf->pkt.ctrl_hdr.seg_no == RXM_CREDIT_SAR_ACK)
+				rxm_sar_tune_update(rxm_ep, conn,
+						    rx_buf->pkt.ctrl_hdr.msg_id,
+						    RXM_SAR_TUNE_SAR);
+			rxm_free_rx_buf(rx_buf);
+			return FI_SUCCESS;
+		}
+	}
 
 	assert(rx_buf->rx_ep->fid.fclass == FI_CLASS_EP);
 	domain = container_of(rxm_ep->util_ep.domain, struct rxm_domain,
@@ -1381,6 +1645,20 @@ void rxm_finish_coll_eager_send(struct rxm_ep *rxm_ep,
 	}
 }
 
+/* With a shared receive context, rx_buf->conn is not known until the
+ * header is examined, so look it up from the packet.
+ */
+static void rxm_touch_rx_conn(struct rxm_ep *rxm_ep, struct rxm_rx_buf *rx_buf)
+{
+	struct rxm_conn *conn = rx_buf->conn;
+
+	if (!conn)
+		conn = ofi_idm_lookup(&rxm_ep->conn_idx_map,
+				      (int) rx_buf->pkt.ctrl_hdr.conn_id);
+	if (conn)
+		rxm_conn_touch(conn);
+}
+
 ssize_t rxm_handle_comp(struct rxm_ep *rxm_ep, struct fi_cq_data_entry *comp)
 {
 	struct rxm_rx_buf *rx_buf;
@@ -1417,6 +1695,9 @@ ssize_t rxm_handle_comp(struct rxm_ep *rxm_ep, struct fi_cq_data_entry *comp)
 		assert((rx_buf->pkt.hdr.version == OFI_OP_VERSION) &&
 		       (rx_buf->pkt.ctrl_hdr.version == RXM_CTRL_VERSION));
 
+		if (rxm_ep->conn_lru)
+			rxm_touch_rx_conn(rxm_ep, rx_buf);
+
 		switch (rx_buf->pkt.ctrl_hdr.type) {
 		case rxm_ctrl_eager:
 		case rxm_ctrl_rndv_req:
@@ -1801,11 +2082,14 @@ ssize_t rxm_cq_owner_writeerr(struct fid_peer_cq *peer_cq,
 	return ofi_peer_cq_write_error(&rxm_cq->util_cq, &cqe_err);
 }
 
-int rxm_post_recv(struct rxm_rx_buf *rx_buf)
+static int rxm_post_rx_buf(struct rxm_rx_buf *rx_buf, uint64_t flags)
 {
 	struct rxm_domain *domain;
+	struct iovec iov;
+	struct fi_msg msg;
 	int ret;
 
+	rxm_sar_return_credit(rx_buf);
 	if (rx_buf->ep->msg_srx)
 		rx_buf->conn = NULL;
 	rx_buf->hdr.state = RXM_RX;
@@ -1814,9 +2098,22 @@ int rxm_post_recv(struct rxm_rx_buf *rx_buf)
 
 	domain = container_of(rx_buf->ep->util_ep.domain,
 			      struct rxm_domain, util_domain);
-	ret = (int) fi_recv(rx_buf->rx_ep, &rx_buf->pkt,
-			    domain->rx_post_size, rx_buf->hdr.desc,
-			    FI_ADDR_UNSPEC, rx_buf);
+	if (!flags) {
+		ret = (int) fi_recv(rx_buf->rx_ep, &rx_buf->pkt,
+				    domain->rx_post_size, rx_buf->hdr.desc,
+				    FI_ADDR_UNSPEC, rx_buf);
+	} else {
+		iov.iov_base = &rx_buf->pkt;
+		iov.iov_len = domain->rx_post_size;
+		msg.msg_iov = &iov;
+		msg.desc = &rx_buf->hdr.desc;
+		msg.iov_count = 1;
+		msg.addr = FI_ADDR_UNSPEC;
+		msg.context = rx_buf;
+		msg.data = 0;
+		ret = (int) fi_recvmsg(rx_buf->rx_ep, &msg,
+				       flags | FI_COMPLETION);
+	}
 	if (!ret)
 		return 0;
 
@@ -1827,6 +2124,61 @@ int rxm_post_recv(struct rxm_rx_buf *rx_buf)
 	return ret;
 }
 
+int rxm_post_recv(struct rxm_rx_buf *rx_buf)
+{
+	return rxm_post_rx_buf(rx_buf, 0);
+}
+
+/* Post the buffers freed while handling a batch of completions.  All but
+ * the last are posted with FI_MORE, which lets the msg provider defer its
+ * per-post work, such as resuming a connection stalled on a missing
+ * buffer, to the end of the batch.
+ */
+static void rxm_repost_rx_bufs(struct rxm_ep *ep)
+{
+	struct rxm_rx_buf *rx_buf;
+	uint64_t flags;
+
+	while (!dlist_empty(&ep->repost_list)) {
+		dlist_pop_front(&ep->repost_list, struct rxm_rx_buf, rx_buf,
+				repost_entry);
+		flags = dlist_empty(&ep->repost_list) ? 0 : FI_MORE;
+		rxm_post_rx_buf(rx_buf, flags);
+	}
+}
+
+/* Grow the read size while the msg CQ fills it, to take a backlog in
+ * fewer calls, and shrink it once reads come back mostly empty, which
+ * bounds the work done before the CM and deferred queues get a turn.
+ */
+static void rxm_adapt_cq_batch(struct rxm_ep *ep, ssize_t cnt)
+{
+	if ((size_t) cnt == ep->cq_batch)
+		ep->cq_batch = MIN(ep->cq_batch * 2, RXM_MAX_CQ_BATCH);
+	else if ((size_t) cnt < ep->cq_batch / 4)
+		ep->cq_batch = MAX(ep->cq_batch / 2, RXM_MIN_CQ_BATCH);
+}
+
+/* Poll the CM often while connections come and go, and back off while it
+ * stays quiet.  Only back off past the configured interval while the msg
+ * CQ is busy: a CM poll then delays completions, while polling an idle
+ * CQ costs nothing and keeps accepting new connections quick.
+ */
+static void rxm_adapt_cm_interval(struct rxm_ep *ep, int events, bool busy)
+{
+	uint64_t max;
+
+	if (events) {
+		ep->cm_interval = MAX(rxm_cm_progress_interval >>
+				      RXM_CM_INTERVAL_SHIFT, 1);
+		return;
+	}
+
+	max = busy ? rxm_cm_progress_interval << RXM_CM_INTERVAL_SHIFT :
+		     rxm_cm_progress_interval;
+	ep->cm_interval = MIN(ep->cm_interval * 2, max);
+}
+
 int rxm_prepost_recv(struct rxm_ep *ep, struct fid_ep *rx_ep)
 {
 	struct rxm_rx_buf *rx_buf;
@@ -1850,7 +2202,7 @@ int rxm_prepost_recv(struct rxm_ep *ep, struct fid_ep *rx_ep)
 void rxm_ep_do_progress(struct util_ep *util_ep)
 {
 	struct rxm_ep *rxm_ep = container_of(util_ep, struct rxm_ep, util_ep);
-	struct fi_cq_data_entry comp[32];
+	struct fi_cq_data_entry comp[RXM_MAX_CQ_BATCH];
 	struct dlist_entry *conn_entry_tmp;
 	struct rxm_conn *rxm_conn;
 	size_t comp_read = 0;
@@ -1858,9 +2210,13 @@ void rxm_ep_do_progress(struct util_ep *util_ep)
 	ssize_t ret, i, err;
 
 	do {
-		ret = fi_cq_read(rxm_ep->msg_cq, &comp, 32);
+		ret = fi_cq_read(rxm_ep->msg_cq, &comp, rxm_ep->cq_batch);
 		if (ret > 0) {
 			comp_read += ret;
+			/* With a shared rx context, buffers freed by the
+			 * handlers are reposted together after the batch.
+			 */
+			rxm_ep->defer_repost = rxm_ep->msg_srx != NULL;
 			for (i = 0; i < ret; i++) {
 				err = rxm_ep->handle_comp(rxm_ep, &comp[i]);
 				if (err) {
@@ -1869,6 +2225,9 @@ void rxm_ep_do_progress(struct util_ep *util_ep)
 					rxm_cq_write_error_all(rxm_ep, (int) err);
 				}
 			}
+			rxm_ep->defer_repost = false;
+			rxm_repost_rx_bufs(rxm_ep);
+			rxm_adapt_cq_batch(rxm_ep, ret);
 		} else if (ret < 0 && (ret != -FI_EAGAIN)) {
 			if (ret == -FI_EAVAIL)
 				rxm_ep->handle_comp_error(rxm_ep);
@@ -1883,12 +2242,16 @@ void rxm_ep_do_progress(struct util_ep *util_ep)
 			    rxm_cm_progress_interval) {
 				timestamp = ofi_gettime_us();
 				if (timestamp - rxm_ep->msg_cq_last_poll >
-				    rxm_cm_progress_interval) {
+				    rxm_ep->cm_interval) {
 					rxm_ep->msg_cq_last_poll = timestamp;
-					rxm_conn_progress(rxm_ep);
+					rxm_adapt_cm_interval(rxm_ep,
+						rxm_conn_progress(rxm_ep),
+						ret > 0);
 				}
 			} else {
-				rxm_conn_progress(rxm_ep);
+				rxm_adapt_cm_interval(rxm_ep,
+						      rxm_conn_progress(rxm_ep),
+						      ret > 0);
 			}
 		}
 	} while ((ret > 0) && (comp_read < rxm_ep->comp_per_progress));
@@ -769,9 +769,12 @@ static struct fi_ops_mr rxm_domain_mr_thru_ops = {
 	.regattr = rxm_mr_regattr_thru,
 };
 
-static ssize_t rxm_send_credits(struct fid_ep *ep, uint64_t credits)
+/* msg_id is only used by RXM_CREDIT_SAR_ACK, to name the SAR message.
+ * Control messages still flow while the close handshake runs.
+ */
+ssize_t rxm_send_credit_msg(struct rxm_conn *rxm_conn, uint32_t type,
+			    uint64_t credits, uint64_t msg_id)
 {
-	struct rxm_conn *rxm_conn = ep->fid.context;
 	struct rxm_ep *rxm_ep = rxm_conn->ep;
 	struct rxm_deferred_tx_entry *def_tx_entry;
 	struct rxm_tx_buf *tx_buf;
@@ -790,10 +793,13 @@ static ssize_t rxm_send_credits(struct fid_ep *ep, uint64_t credits)
 	rxm_ep_format_tx_buf_pkt(rxm_conn, 0, rxm_ctrl_credit, 0, 0, FI_SEND,
 				 &tx_buf->pkt);
 	tx_buf->pkt.ctrl_hdr.type = rxm_ctrl_credit;
-	tx_buf->pkt.ctrl_hdr.msg_id = ofi_buf_index(tx_buf);
+	tx_buf->pkt.ctrl_hdr.seg_no = type;
+	tx_buf->pkt.ctrl_hdr.msg_id = (type == RXM_CREDIT_SAR_ACK) ?
+				      msg_id : ofi_buf_index(tx_buf);
 	tx_buf->pkt.ctrl_hdr.ctrl_data = credits;
 
-	if (rxm_conn->state != RXM_CM_CONNECTED)
+	if (rxm_conn->state != RXM_CM_CONNECTED &&
+	    rxm_conn->state != RXM_CM_CLOSING)
 		goto defer;
 
 	iov.iov_base = &tx_buf->pkt;
@@ -803,7 +809,7 @@ static ssize_t rxm_send_credits(struct fid_ep *ep, uint64_t credits)
 	msg.context = tx_buf;
 	msg.desc = &tx_buf->hdr.desc;
 
-	ret = fi_sendmsg(ep, &msg, OFI_PRIORITY);
+	ret = fi_sendmsg(rxm_conn->msg_ep, &msg, OFI_PRIORITY);
 	if (!ret)
 		return FI_SUCCESS;
 
@@ -822,6 +828,12 @@ defer:
 	return FI_SUCCESS;
 }
 
+static ssize_t rxm_send_credits(struct fid_ep *ep, uint64_t credits)
+{
+	return rxm_send_credit_msg(ep->fid.context, RXM_CREDIT_FLOW_CTRL,
+				   credits, 0);
+}
+
 static void rxm_no_add_credits(struct fid_ep *ep_fid, uint64_t credits)
 {
 }
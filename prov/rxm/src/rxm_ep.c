@@ -340,6 +340,11 @@ static int rxm_ep_setopt(fid_t fid, int level, int optname,
 		 */
 		ret = rxm_ep->enable_direct_send ? FI_SUCCESS : -FI_EOPNOTSUPP;
 		break;
+	case FI_OPT_RXM_PRECONNECT:
+		if (optlen != sizeof(struct fi_rxm_preconnect))
+			return -FI_EINVAL;
+		ret = rxm_preconnect(rxm_ep, optval);
+		break;
 
 	default:
 		ret = -FI_ENOPROTOOPT;
@@ -460,6 +465,11 @@ rxm_ep_progress_sar_deferred_segments(struct rxm_deferred_tx_entry *def_tx_entry
 	struct rxm_tx_buf *tx_buf = def_tx_entry->sar_seg.cur_seg_tx_buf;
 
 	if (tx_buf) {
+		if (!rxm_sar_seg_avail(def_tx_entry->rxm_ep,
+				       def_tx_entry->rxm_conn,
+				       def_tx_entry->sar_seg.msg_id))
+			return -FI_EAGAIN;
+
 		ret = fi_send(def_tx_entry->rxm_conn->msg_ep, &tx_buf->pkt,
 			      sizeof(tx_buf->pkt) + tx_buf->pkt.ctrl_hdr.seg_size,
 			      tx_buf->hdr.desc, 0, tx_buf);
@@ -471,6 +481,9 @@ rxm_ep_progress_sar_deferred_segments(struct rxm_deferred_tx_entry *def_tx_entry
 			return ret;
 		}
 
+		rxm_sar_seg_sent(def_tx_entry->rxm_ep, def_tx_entry->rxm_conn,
+				 def_tx_entry->sar_seg.msg_id);
+		def_tx_entry->sar_seg.cur_seg_tx_buf = NULL;
 		def_tx_entry->sar_seg.next_seg_no++;
 		def_tx_entry->sar_seg.remain_len -= rxm_buffer_size;
 
@@ -484,6 +497,11 @@ rxm_ep_progress_sar_deferred_segments(struct rxm_deferred_tx_entry *def_tx_entry
 
 	while (def_tx_entry->sar_seg.next_seg_no !=
 	       def_tx_entry->sar_seg.segs_cnt) {
+		if (!rxm_sar_seg_avail(def_tx_entry->rxm_ep,
+				       def_tx_entry->rxm_conn,
+				       def_tx_entry->sar_seg.msg_id))
+			return -FI_EAGAIN;
+
 		ret = rxm_send_segment(
 				def_tx_entry->rxm_ep, def_tx_entry->rxm_conn,
 				def_tx_entry->sar_seg.app_context,
@@ -510,6 +528,7 @@ rxm_ep_progress_sar_deferred_segments(struct rxm_deferred_tx_entry *def_tx_entry
 
 			return ret;
 		}
+		def_tx_entry->sar_seg.cur_seg_tx_buf = NULL;
 		def_tx_entry->sar_seg.next_seg_no++;
 		def_tx_entry->sar_seg.remain_len -= rxm_buffer_size;
 	}
@@ -526,7 +545,8 @@ void rxm_ep_progress_deferred_queue(struct rxm_ep *rxm_ep,
 	struct fi_msg msg;
 	ssize_t ret = 0;
 
-	if (rxm_conn->state != RXM_CM_CONNECTED)
+	if (rxm_conn->state != RXM_CM_CONNECTED &&
+	    rxm_conn->state != RXM_CM_CLOSING)
 		return;
 
 	while (!dlist_empty(&rxm_conn->deferred_tx_queue) && !ret) {
@@ -650,6 +670,17 @@ void rxm_ep_progress_deferred_queue(struct rxm_ep *rxm_ep,
 				return;
 			}
 			break;
+		case RXM_DEFERRED_TX_SAR_CREDIT:
+			if (rxm_conn->sar_rx_credits) {
+				ret = rxm_send_credit_msg(rxm_conn,
+						RXM_CREDIT_SAR,
+						rxm_conn->sar_rx_credits, 0);
+				if (ret)
+					return;
+				rxm_conn->sar_rx_credits = 0;
+			}
+			rxm_conn->flags &= ~RXM_CONN_SAR_CREDIT;
+			break;
 		}
 
 		rxm_dequeue_deferred_tx(def_tx_entry);
@@ -1090,6 +1121,8 @@ static void rxm_ep_init_proto(struct rxm_ep *ep)
 		return;
 	}
 
+	ep->sar_credit_window = (uint8_t) rxm_sar_credits;
+	ep->sar_seg_window = rxm_sar_window;
 	if (!fi_param_get_size_t(&rxm_prov, "sar_limit", &param)) {
 		if (param <= ep->eager_limit)
 			ep->sar_limit = ep->eager_limit;
@@ -1097,6 +1130,7 @@ static void rxm_ep_init_proto(struct rxm_ep *ep)
 			ep->sar_limit = param;
 	} else {
 		ep->sar_limit = ep->eager_limit * 8;
+		ep->sar_tune = rxm_sar_tune != 0;
 	}
 }
 
@@ -1157,10 +1191,13 @@ static void rxm_ep_settings_init(struct rxm_ep *rxm_ep)
 		"\t\t Completions per progress: MSG - %zu\n"
 	        "\t\t Buffered min: %zu\n"
 	        "\t\t inject size: %zu\n"
-		"\t\t Protocol limits: Eager: %zu, SAR: %zu\n",
+		"\t\t Protocol limits: Eager: %zu, SAR: %zu%s\n"
+		"\t\t SAR credits: %d, segment window: %zu\n",
 		rxm_ep->msg_mr_local, rxm_ep->rdm_mr_local,
 		rxm_ep->comp_per_progress, rxm_ep->buffered_min,
-		rxm_ep->inject_limit, rxm_ep->eager_limit, rxm_ep->sar_limit);
+		rxm_ep->inject_limit, rxm_ep->eager_limit, rxm_ep->sar_limit,
+		rxm_ep->sar_tune ? " (auto tuned)" : "",
+		rxm_ep->sar_credit_window, rxm_ep->sar_seg_window);
 }
 
 static int rxm_ep_txrx_res_open(struct rxm_ep *rxm_ep)
@@ -1612,9 +1649,9 @@ rxm_prepare_deferred_rndv_write(struct rxm_deferred_tx_entry **def_tx_entry,
 {
 	uint8_t i;
 	struct rxm_tx_buf *tx_buf = buf;
-	struct rxm_ep *rxm_ep = tx_buf->write_rndv.conn->ep;
+	struct rxm_ep *rxm_ep = tx_buf->conn->ep;
 
-	*def_tx_entry = rxm_ep_alloc_deferred_tx_entry(rxm_ep, tx_buf->write_rndv.conn,
+	*def_tx_entry = rxm_ep_alloc_deferred_tx_entry(rxm_ep, tx_buf->conn,
 						       RXM_DEFERRED_TX_RNDV_WRITE);
 	if (!*def_tx_entry)
 		return -FI_ENOMEM;
@@ -1773,6 +1810,12 @@ int rxm_endpoint(struct fid_domain *domain, struct fi_info *info,
 		(*ep_fid)->atomic = &rxm_ops_atomic;
 
 	dlist_init(&rxm_ep->loopback_list);
+	dlist_init(&rxm_ep->conn_lru_list);
+	dlist_init(&rxm_ep->conn_close_list);
+	rxm_ep->conn_lru = rxm_conn_idle_timeout || rxm_max_conns;
+	dlist_init(&rxm_ep->repost_list);
+	rxm_ep->cq_batch = RXM_MIN_CQ_BATCH;
+	rxm_ep->cm_interval = rxm_cm_progress_interval;
 
 	return 0;
 err2:
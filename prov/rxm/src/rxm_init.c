@@ -59,6 +59,12 @@ int rxm_passthru = 0; /* disable by default, need to analyze performance */
 int force_auto_progress;
 int rxm_use_write_rndv;
 int rxm_detect_hmem_iface;
+size_t rxm_sar_credits = 64;
+int rxm_sar_tune = 1;
+size_t rxm_sar_window = 32;
+size_t rxm_conn_idle_timeout;
+size_t rxm_max_conns;
+size_t rxm_conn_batch = 64;
 int rxm_rescan = -1;
 enum fi_wait_obj def_wait_obj = FI_WAIT_FD, def_tcp_wait_obj = FI_WAIT_UNSPEC;
 
@@ -643,6 +649,29 @@ RXM_INI
 			"eager_limit to take effect.  (default %zu).",
 			rxm_buffer_size * 8);
 
+	fi_param_define(&rxm_prov, "sar_credits", FI_PARAM_SIZE_T,
+			"Number of SAR segments that a peer may have in flight "
+			"to this endpoint on a single connection.  The receiver "
+			"returns credits as segments are processed, which "
+			"keeps SAR transfers from overrunning the receive "
+			"side.  Credits are only used if both peers enable "
+			"them.  Set to 0 to disable (default: %zu, max: %d).",
+			rxm_sar_credits, RXM_SAR_CREDITS_MAX);
+
+	fi_param_define(&rxm_prov, "sar_auto_tune", FI_PARAM_BOOL,
+			"Adjust the SAR to rendezvous switch-over point for "
+			"each connection at runtime, based on the observed "
+			"bandwidth of both protocols.  Ignored if sar_limit "
+			"is set.  (default: true).");
+
+	fi_param_define(&rxm_prov, "sar_window", FI_PARAM_SIZE_T,
+			"Maximum number of segments of a single SAR message "
+			"that are posted to the msg provider at once.  Further "
+			"segments are posted as earlier ones complete, which "
+			"bounds the transmit buffers and msg provider queue "
+			"entries held by one large message.  Set to 0 for no "
+			"limit (default: %zu).", rxm_sar_window);
+
 	fi_param_define(&rxm_prov, "use_srx", FI_PARAM_BOOL,
 			"Set this environment variable to control the RxM "
 			"receive path. If this variable set to 1 (default: 0), "
@@ -677,6 +706,27 @@ RXM_INI
 			"without checking to see if the CM progress interval has "
 			"been reached. (default: 128).");
 
+	fi_param_define(&rxm_prov, "conn_idle_timeout", FI_PARAM_SIZE_T,
+			"Close connections that have carried no traffic for "
+			"this many seconds.  The connection is re-established "
+			"on the next transfer to the peer.  Set to 0 to keep "
+			"connections open (default: 0).");
+
+	fi_param_define(&rxm_prov, "max_conns", FI_PARAM_SIZE_T,
+			"Maximum number of connections an endpoint keeps open. "
+			"When the limit is exceeded, the least recently used "
+			"idle connections are closed as the endpoint is "
+			"progressed.  Connections with transfers in progress "
+			"on either side or used in the last second are never "
+			"closed, so the limit may be exceeded temporarily. "
+			"Set to 0 for no limit (default: 0).");
+
+	fi_param_define(&rxm_prov, "conn_batch", FI_PARAM_SIZE_T,
+			"Maximum number of connection requests outstanding "
+			"while pre-connecting to a range of peers requested "
+			"through FI_OPT_RXM_PRECONNECT (default: %zu).",
+			rxm_conn_batch);
+
 	fi_param_define(&rxm_prov, "data_auto_progress", FI_PARAM_BOOL,
 			"Force auto-progress for data transfers even if app "
 			"requested manual progress (default: false/no).");
@@ -730,6 +780,18 @@ RXM_INI
 		rxm_cq_eq_fairness = 128;
 	fi_param_get_bool(&rxm_prov, "data_auto_progress", &force_auto_progress);
 	fi_param_get_bool(&rxm_prov, "use_rndv_write", &rxm_use_write_rndv);
+	fi_param_get_size_t(&rxm_prov, "sar_credits", &rxm_sar_credits);
+	if (rxm_sar_credits > RXM_SAR_CREDITS_MAX)
+		rxm_sar_credits = RXM_SAR_CREDITS_MAX;
+	fi_param_get_bool(&rxm_prov, "sar_auto_tune", &rxm_sar_tune);
+	fi_param_get_size_t(&rxm_prov, "sar_window", &rxm_sar_window);
+	fi_param_get_size_t(&rxm_prov, "conn_idle_timeout",
+			    &rxm_conn_idle_timeout);
+	rxm_conn_idle_timeout *= 1000;
+	fi_param_get_size_t(&rxm_prov, "max_conns", &rxm_max_conns);
+	fi_param_get_size_t(&rxm_prov, "conn_batch", &rxm_conn_batch);
+	if (!rxm_conn_batch)
+		rxm_conn_batch = 1;
 
 	rxm_get_def_wait();
 
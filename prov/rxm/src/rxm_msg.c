@@ -105,6 +105,7 @@ rxm_alloc_rndv_buf(struct rxm_ep *rxm_ep, struct rxm_conn *rxm_conn,
 	(*rndv_buf)->app_context = context;
 	(*rndv_buf)->flags = flags;
 	(*rndv_buf)->rma.count = count;
+	(*rndv_buf)->conn = rxm_conn;
 
 	if (!rxm_ep->rdm_mr_local) {
 		ret = rxm_msg_mr_regv(rxm_ep, iov, (*rndv_buf)->rma.count, data_len,
@@ -121,7 +122,6 @@ rxm_alloc_rndv_buf(struct rxm_ep *rxm_ep, struct rxm_conn *rxm_conn,
 	}
 
 	if (rxm_ep->rndv_ops == &rxm_rndv_ops_write) {
-		(*rndv_buf)->write_rndv.conn = rxm_conn;
 		for (i = 0; i < count; i++) {
 			(*rndv_buf)->write_rndv.iov[i] = iov[i];
 			(*rndv_buf)->write_rndv.desc[i] = fi_mr_desc(mr_iov[i]);
@@ -173,6 +173,7 @@ rxm_send_rndv(struct rxm_ep *rxm_ep, struct rxm_conn *rxm_conn,
 	if (ret)
 		goto err;
 
+	rxm_conn->xfer_refs++;
 	return FI_SUCCESS;
 
 err:
@@ -234,7 +235,7 @@ rxm_send_segment(struct rxm_ep *rxm_ep,
 {
 	struct rxm_tx_buf *tx_buf;
 	enum rxm_sar_seg_type seg_type = RXM_SAR_SEG_MIDDLE;
-	ssize_t ret __attribute__((unused));
+	ssize_t ret;
 
 	if (seg_no == (segs_cnt - 1)) {
 		seg_type = RXM_SAR_SEG_LAST;
@@ -258,15 +259,18 @@ rxm_send_segment(struct rxm_ep *rxm_ep,
 
 	*out_tx_buf = tx_buf;
 
-	return fi_send(rxm_conn->msg_ep, &tx_buf->pkt, sizeof(struct rxm_pkt) +
-		       tx_buf->pkt.ctrl_hdr.seg_size, tx_buf->hdr.desc, 0, tx_buf);
+	ret = fi_send(rxm_conn->msg_ep, &tx_buf->pkt, sizeof(struct rxm_pkt) +
+		      tx_buf->pkt.ctrl_hdr.seg_size, tx_buf->hdr.desc, 0, tx_buf);
+	if (!ret)
+		rxm_sar_seg_sent(rxm_ep, rxm_conn, msg_id);
+	return ret;
 }
 
 static ssize_t
 rxm_send_sar(struct rxm_ep *rxm_ep, struct rxm_conn *rxm_conn,
 	     const struct iovec *iov, void **desc, uint8_t count,
 	     void *context, uint64_t data, uint64_t flags, uint64_t tag,
-	     uint8_t op, size_t data_len, size_t segs_cnt)
+	     uint8_t op, size_t data_len, size_t segs_cnt, bool sample)
 {
 	struct rxm_tx_buf *tx_buf, *first_tx_buf;
 	size_t i, iov_offset = 0, remain_len = data_len;
@@ -277,6 +281,11 @@ rxm_send_sar(struct rxm_ep *rxm_ep, struct rxm_conn *rxm_conn,
 	ssize_t ret;
 
 	assert(segs_cnt >= 2);
+	if (!rxm_sar_credit_avail(rxm_conn)) {
+		rxm_ep_do_progress(&rxm_ep->util_ep);
+		return -FI_EAGAIN;
+	}
+
 	iface = rxm_iov_desc_to_hmem_iface_dev(iov, desc, count, &device);
 
 	first_tx_buf = rxm_init_segment(rxm_ep, rxm_conn, context,
@@ -286,6 +295,12 @@ rxm_send_sar(struct rxm_ep *rxm_ep, struct rxm_conn *rxm_conn,
 	if (!first_tx_buf)
 		return -FI_EAGAIN;
 
+	if (sample) {
+		rxm_sar_set_ack(&first_tx_buf->pkt.ctrl_hdr);
+		rxm_sar_tune_start(rxm_conn, msg_id, data_len,
+				   RXM_SAR_TUNE_SAR);
+	}
+
 	ret = ofi_copy_from_hmem_iov(first_tx_buf->pkt.data, rxm_buffer_size,
 				     iface, device, iov, count, iov_offset);
 	assert((size_t) ret == rxm_buffer_size);
@@ -302,9 +317,18 @@ rxm_send_sar(struct rxm_ep *rxm_ep, struct rxm_conn *rxm_conn,
 		return ret;
 	}
 
+	rxm_sar_use_credit(rxm_conn);
+	first_tx_buf->sar_inflight = 1;
+	first_tx_buf->conn = rxm_conn;
+	rxm_conn->xfer_refs++;
 	remain_len -= rxm_buffer_size;
 
 	for (i = 1; i < segs_cnt; i++) {
+		if (!rxm_sar_seg_avail(rxm_ep, rxm_conn, msg_id)) {
+			tx_buf = NULL;
+			goto defer;
+		}
+
 		ret = rxm_send_segment(rxm_ep, rxm_conn, context, data_len,
 				       remain_len, msg_id, rxm_buffer_size, i,
 				       segs_cnt, data, flags, tag, op, iov,
@@ -321,6 +345,7 @@ rxm_send_sar(struct rxm_ep *rxm_ep, struct rxm_conn *rxm_conn,
 	return 0;
 
 free:
+	rxm_conn->xfer_refs--;
 	rxm_free_tx_buf(rxm_ep, first_tx_buf);
 	return ret;
 defer:
@@ -352,6 +377,38 @@ defer:
 	return 0;
 }
 
+/* Every so often, a message in the size buckets on either side of the
+ * current SAR limit is timed, using whichever protocol has fewer samples
+ * for its size, so that rxm_sar_tune_update() can compare the two and
+ * move the limit.  Timing a SAR message relies on the receiver's ack,
+ * so connections without SAR credits keep the static limit.
+ */
+static bool
+rxm_use_sar(struct rxm_ep *rxm_ep, struct rxm_conn *rxm_conn, size_t data_len,
+	    bool *sample)
+{
+	struct rxm_proto_stat *stat;
+	int bucket;
+
+	*sample = false;
+	if (!rxm_ep->sar_tune || !rxm_conn->peer_sar_window)
+		return data_len <= rxm_ep->sar_limit;
+
+	bucket = rxm_sar_bucket(rxm_ep, data_len);
+	if (bucket >= RXM_SAR_TUNE_BUCKETS)
+		return false;
+
+	if ((bucket != rxm_conn->sar_bucket &&
+	     bucket != rxm_conn->sar_bucket + 1) ||
+	    ++rxm_conn->sar_probe % RXM_SAR_TUNE_PROBE ||
+	    !rxm_sar_tune_idle(rxm_conn))
+		return bucket <= rxm_conn->sar_bucket;
+
+	*sample = true;
+	stat = rxm_conn->sar_stats[bucket];
+	return stat[RXM_SAR_TUNE_SAR].cnt <= stat[RXM_SAR_TUNE_RNDV].cnt;
+}
+
 static ssize_t
 rxm_emulate_inject(struct rxm_ep *rxm_ep, struct rxm_conn *rxm_conn,
 		   const void *buf, size_t len, size_t pkt_size,
@@ -498,6 +555,7 @@ rxm_send_common(struct rxm_ep *rxm_ep, struct rxm_conn *rxm_conn,
 	size_t data_len, total_len;
 	enum fi_hmem_iface iface;
 	uint64_t device;
+	bool sample = false;
 	ssize_t ret;
 
 	if (flags & FI_PEER_TRANSFER)
@@ -519,18 +577,24 @@ rxm_send_common(struct rxm_ep *rxm_ep, struct rxm_conn *rxm_conn,
 		ret = rxm_send_eager(rxm_ep, rxm_conn, iov, desc, count,
 				     context, data, flags, tag, op,
 				     data_len, total_len);
-	} else if (data_len <= rxm_ep->sar_limit) {
+	} else if (rxm_use_sar(rxm_ep, rxm_conn, data_len, &sample)) {
 		ret = rxm_send_sar(rxm_ep, rxm_conn, iov, desc, (uint8_t) count,
 				   context, data, flags, tag, op, data_len,
-				   rxm_ep_sar_calc_segs_cnt(rxm_ep, data_len));
+				   rxm_ep_sar_calc_segs_cnt(rxm_ep, data_len),
+				   sample);
 	} else {
 rndv_send:
 		ret = rxm_alloc_rndv_buf(rxm_ep, rxm_conn, context,
 					 (uint8_t) count, iov, desc,
 					 data_len, data, flags, tag, op,
 					 iface, device, &rndv_buf);
-		if (ret >= 0)
+		if (ret >= 0) {
+			if (sample)
+				rxm_sar_tune_start(rxm_conn,
+					rndv_buf->pkt.ctrl_hdr.msg_id,
+					data_len, RXM_SAR_TUNE_RNDV);
 			ret = rxm_send_rndv(rxm_ep, rxm_conn, rndv_buf, ret);
+		}
 	}
 
 	return ret;
@@ -74,10 +74,14 @@
 
 struct smr_env {
 	size_t sar_threshold;
+	size_t mmap_pool_size;
 	int disable_cma;
+	int disable_memfd;
 	int use_dsa_sar;
 	size_t max_gdrcopy_size;
 	int use_xpmem;
+	int wait_spin;
+	int numa_bind;
 };
 
 extern struct smr_env smr_env;
@@ -112,7 +116,12 @@ int smr_av_open(struct fid_domain *domain, struct fi_av_attr *attr,
 int smr_query_atomic(struct fid_domain *domain, enum fi_datatype datatype,
 		enum fi_op op, struct fi_atomic_attr *attr, uint64_t flags);
 
-#define SMR_IOV_LIMIT		4
+/* iovs that do not fit in a command are passed in an inject buffer, so
+ * SMR_IOV_LIMIT must not exceed SMR_INJECT_SIZE / sizeof(struct iovec).
+ * Remote iovs are always carried in the command.
+ */
+#define SMR_IOV_LIMIT		32
+#define SMR_RMA_IOV_LIMIT	4
 
 struct smr_tx_entry {
 	struct smr_cmd	cmd;
@@ -160,6 +169,8 @@ struct smr_domain {
 	int			fast_rma;
 	/* cache for use with hmem ipc */
 	struct ofi_mr_cache	*ipc_cache;
+	/* cache of peer memfd regions mapped by smr_src_memfd */
+	struct ofi_mr_cache	*memfd_cache;
 	struct fid_ep		rx_ep;
 	struct fid_peer_srx	*srx;
 };
@@ -210,11 +221,55 @@ struct smr_sock_info {
 	struct smr_cmap_entry	peers[SMR_MAX_PEERS];
 };
 
+/* Persistent file for the mmap protocol, one per sender/receiver pair.
+ * The sender creates and grows it and carves messages out of it as a
+ * ring (responses complete in order); the receiver maps it on first use
+ * and only remaps when the sender has grown it.
+ */
+struct smr_mmap_pool {
+	struct smr_ep_name	map_name;
+	void			*ptr;
+	size_t			size;
+	size_t			head;
+	size_t			tail;
+	bool			wrapped;
+	int			inflight;
+};
+
 struct smr_unexp_buf {
 	struct slist_entry entry;
 	char buf[SMR_SAR_SIZE];
 };
 
+/* longest a blocking wait sleeps before polling again, in ms */
+#define SMR_WAIT_SLEEP_MAX	10
+
+/* Messages using smr_src_iov that are matched in the same progress call
+ * are copied from each peer with one vectored CMA call.
+ */
+#define SMR_CMA_BATCH_MAX	16
+#define SMR_CMA_BATCH_IOV	256
+
+struct smr_cma_batch_entry {
+	struct smr_msg_hdr	hdr;
+	struct fi_peer_rx_entry	*rx_entry;
+	size_t			local_idx;
+	size_t			local_cnt;
+	size_t			remote_idx;
+	size_t			remote_cnt;
+};
+
+struct smr_cma_batch {
+	int64_t			id;
+	size_t			count;
+	size_t			local_cnt;
+	size_t			remote_cnt;
+	size_t			total_len;
+	struct smr_cma_batch_entry entry[SMR_CMA_BATCH_MAX];
+	struct iovec		local[SMR_CMA_BATCH_IOV];
+	struct iovec		remote[SMR_CMA_BATCH_IOV];
+};
+
 struct smr_ep {
 	struct util_ep		util_ep;
 	size_t			tx_size;
@@ -238,6 +293,9 @@ struct smr_ep {
 	struct smr_sock_info	*sock_info;
 	void			*dsa_context;
 	void 			(*smr_progress_ipc_list)(struct smr_ep *ep);
+	struct smr_mmap_pool	*mmap_tx[SMR_MAX_PEERS];
+	struct smr_mmap_pool	*mmap_rx[SMR_MAX_PEERS];
+	struct smr_cma_batch	cma_batch;
 };
 
 #define smr_ep_rx_flags(smr_ep) ((smr_ep)->util_ep.rx_op_flags)
@@ -247,9 +305,19 @@ static inline int smr_mmap_name(char *shm_name, const char *ep_name,
 				uint64_t msg_id)
 {
 	return snprintf(shm_name, SMR_NAME_MAX - 1, "%s_%ld",
-			ep_name, msg_id);
+			smr_no_prefix(ep_name), msg_id);
+}
+
+static inline int smr_mmap_pool_name(char *shm_name, const char *ep_name,
+				     int64_t pool_id)
+{
+	return snprintf(shm_name, SMR_NAME_MAX - 1, "%s_pool_%ld",
+			smr_no_prefix(ep_name), pool_id);
 }
 
+void smr_mmap_pool_release(struct smr_ep *ep, int64_t id, uint64_t offset,
+			   size_t len);
+
 int smr_endpoint(struct fid_domain *domain, struct fi_info *info,
 		  struct fid_ep **ep, void *context);
 void smr_ep_exchange_fds(struct smr_ep *ep, int64_t id);
@@ -276,8 +344,8 @@ size_t smr_copy_from_sar(struct smr_freestack *sar_pool, struct smr_resp *resp,
 			 const struct iovec *iov, size_t count,
 			 size_t *bytes_done);
 int smr_select_proto(void **desc, size_t iov_count, bool cma_avail,
-		     bool ipc_valid, uint32_t op, uint64_t total_len,
-		     uint64_t op_flags);
+		     bool ipc_valid, bool memfd_avail, uint32_t op,
+		     uint64_t total_len, uint64_t op_flags);
 typedef ssize_t (*smr_proto_func)(struct smr_ep *ep, struct smr_region *peer_smr,
 		int64_t id, int64_t peer_id, uint32_t op, uint64_t tag,
 		uint64_t data, uint64_t op_flags, struct ofi_mr **desc,
@@ -313,6 +381,15 @@ static inline bool smr_vma_enabled(struct smr_ep *ep,
 			peer_smr->xpmem_cap_self == SMR_VMA_CAP_ON);
 }
 
+/* The receiver maps the sender's region, so only its own record of the
+ * sender counts.
+ */
+static inline bool smr_memfd_valid(struct smr_region *peer_smr,
+				   int64_t peer_id)
+{
+	return smr_peer_data(peer_smr)[peer_id].memfd_valid;
+}
+
 static inline void smr_set_ipc_valid(struct smr_region *region, uint64_t id)
 {
 	if (ofi_hmem_is_initialized(FI_HMEM_ZE) &&
@@ -336,6 +413,21 @@ static inline bool smr_ze_ipc_enabled(struct smr_region *smr,
 	       (peer_smr->flags & SMR_FLAG_IPC_SOCK);
 }
 
+/* Wake the owner of 'smr' if it sleeps in a blocking wait.  Called after
+ * posting a command to it and after completing a command it sent.
+ */
+static inline void smr_ring(struct smr_region *smr)
+{
+	ofi_doorbell_ring(&smr->doorbell);
+}
+
+static inline void smr_commit_cmd(struct smr_region *peer_smr,
+				  struct smr_cmd_entry *ce, int64_t pos)
+{
+	smr_cmd_queue_commit(ce, pos);
+	smr_ring(peer_smr);
+}
+
 static inline struct smr_inject_buf *
 smr_get_txbuf(struct smr_region *smr)
 {
@@ -359,6 +451,47 @@ smr_release_txbuf(struct smr_region *smr,
 	pthread_spin_unlock(&smr->lock);
 }
 
+static inline struct iovec *smr_cmd_iov(struct smr_region *smr,
+					struct smr_cmd *cmd)
+{
+	struct smr_inject_buf *tx_buf;
+
+	if (cmd->msg.data.iov_count <= SMR_IOV_INLINE)
+		return cmd->msg.data.iov;
+
+	tx_buf = smr_get_ptr(smr, cmd->msg.data.iov_buf);
+	return (struct iovec *) tx_buf->data;
+}
+
+static inline void smr_release_cmd_iov(struct smr_region *smr,
+				       struct smr_cmd *cmd)
+{
+	if (cmd->msg.data.iov_count > SMR_IOV_INLINE)
+		smr_release_txbuf(smr, smr_get_ptr(smr,
+						   cmd->msg.data.iov_buf));
+}
+
+/* Out-of-line iovs of an unexpected smr_src_iov message are copied into an
+ * unexp buf when it is queued, so the inject buffer can be released early.
+ */
+static inline struct iovec *smr_cmd_ctx_iov(struct smr_cmd_ctx *cmd_ctx)
+{
+	struct smr_unexp_buf *buf;
+
+	if (cmd_ctx->cmd.msg.data.iov_count <= SMR_IOV_INLINE)
+		return cmd_ctx->cmd.msg.data.iov;
+
+	buf = container_of(cmd_ctx->buf_list.head, struct smr_unexp_buf, entry);
+	return (struct iovec *) buf->buf;
+}
+
+static inline void smr_free_cmd_ctx_iov(struct smr_cmd_ctx *cmd_ctx)
+{
+	if (cmd_ctx->cmd.msg.data.iov_count > SMR_IOV_INLINE)
+		ofi_buf_free(container_of(cmd_ctx->buf_list.head,
+					  struct smr_unexp_buf, entry));
+}
+
 int smr_unexp_start(struct fi_peer_rx_entry *rx_entry);
 
 void smr_progress_ipc_list(struct smr_ep *ep);
@@ -192,7 +192,7 @@ static ssize_t smr_generic_atomic(struct smr_ep *ep,
 	assert(count <= SMR_IOV_LIMIT);
 	assert(result_count <= SMR_IOV_LIMIT);
 	assert(compare_count <= SMR_IOV_LIMIT);
-	assert(rma_count <= SMR_IOV_LIMIT);
+	assert(rma_count <= SMR_RMA_IOV_LIMIT);
 
 	id = smr_verify_peer(ep, addr);
 	if (id < 0)
@@ -267,7 +267,7 @@ static ssize_t smr_generic_atomic(struct smr_ep *ep,
 	}
 
 	smr_format_rma_ioc(&ce->rma_cmd, rma_ioc, rma_count);
-	smr_cmd_queue_commit(ce, pos);
+	smr_commit_cmd(peer_smr, ce, pos);
 unlock:
 	ofi_genlock_unlock(&ep->util_ep.lock);
 	return ret;
@@ -387,7 +387,7 @@ static ssize_t smr_atomic_inject(struct fid_ep *ep_fid, const void *buf,
 	}
 
 	smr_format_rma_ioc(&ce->rma_cmd, &rma_ioc, 1);
-	smr_cmd_queue_commit(ce, pos);
+	smr_commit_cmd(peer_smr, ce, pos);
 	ofi_ep_peer_tx_cntr_inc(&ep->util_ep, ofi_op_atomic);
 out:
 	return ret;
@@ -50,7 +50,7 @@ struct fi_tx_attr smr_tx_attr = {
 	.inject_size = SMR_INJECT_SIZE,
 	.size = 1024,
 	.iov_limit = SMR_IOV_LIMIT,
-	.rma_iov_limit = SMR_IOV_LIMIT
+	.rma_iov_limit = SMR_RMA_IOV_LIMIT
 };
 
 struct fi_rx_attr smr_rx_attr = {
@@ -68,7 +68,7 @@ struct fi_tx_attr smr_hmem_tx_attr = {
 	.inject_size = 0,
 	.size = 1024,
 	.iov_limit = SMR_IOV_LIMIT,
-	.rma_iov_limit = SMR_IOV_LIMIT
+	.rma_iov_limit = SMR_RMA_IOV_LIMIT
 };
 
 struct fi_rx_attr smr_hmem_rx_attr = {
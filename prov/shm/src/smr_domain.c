@@ -131,6 +131,9 @@ static int smr_domain_close(fid_t fid)
 	if (domain->ipc_cache)
 		ofi_ipc_cache_destroy(domain->ipc_cache);
 
+	if (domain->memfd_cache)
+		ofi_memfd_cache_destroy(domain->memfd_cache);
+
 	ret = ofi_domain_close(&domain->util_domain);
 	if (ret)
 		return ret;
@@ -147,11 +150,81 @@ static struct fi_ops smr_domain_fi_ops = {
 	.ops_open = fi_no_ops_open,
 };
 
+static int smr_memfd_mr_close(struct fid *fid)
+{
+	struct ofi_mr *mr = container_of(fid, struct ofi_mr, mr_fid.fid);
+	struct ofi_memfd_handle *handle = mr->hmem_data;
+	int ret;
+
+	ret = ofi_mr_close(fid);
+	if (ret)
+		return ret;
+
+	ofi_memfd_put_handle(handle);
+	free(handle);
+	return FI_SUCCESS;
+}
+
+static struct fi_ops smr_memfd_mr_fi_ops = {
+	.size = sizeof(struct fi_ops),
+	.close = smr_memfd_mr_close,
+	.bind = fi_no_bind,
+	.control = fi_no_control,
+	.ops_open = fi_no_ops_open,
+};
+
+/* Host memory registered through FI_MR_DMABUF is backed by a shareable
+ * file (e.g. memfd).  Record the file so that peers can map the region
+ * once and copy from it directly (smr_src_memfd).
+ */
+static int smr_mr_regattr(struct fid *fid, const struct fi_mr_attr *attr,
+			  uint64_t flags, struct fid_mr **mr_fid)
+{
+	struct smr_domain *domain;
+	struct ofi_memfd_handle *handle;
+	struct fi_mr_attr memfd_attr;
+	struct iovec iov;
+	struct ofi_mr *mr;
+	int ret;
+
+	domain = container_of(fid, struct smr_domain,
+			      util_domain.domain_fid.fid);
+	if (!(flags & FI_MR_DMABUF) || attr->iface != FI_HMEM_SYSTEM ||
+	    attr->iov_count != 1 || !domain->memfd_cache)
+		return ofi_mr_regattr(fid, attr, flags, mr_fid);
+
+	handle = calloc(1, sizeof(*handle));
+	if (!handle)
+		return -FI_ENOMEM;
+
+	ret = ofi_memfd_get_handle(attr->dmabuf, handle);
+	if (ret)
+		goto free;
+
+	ofi_mr_get_iov_from_dmabuf(&iov, attr->dmabuf, 1);
+	memfd_attr = *attr;
+	memfd_attr.mr_iov = &iov;
+	ret = ofi_mr_regattr(fid, &memfd_attr, flags & ~FI_MR_DMABUF, mr_fid);
+	if (ret)
+		goto put;
+
+	mr = container_of(*mr_fid, struct ofi_mr, mr_fid);
+	mr->flags |= OFI_HMEM_DATA_MEMFD;
+	mr->hmem_data = handle;
+	mr->mr_fid.fid.ops = &smr_memfd_mr_fi_ops;
+	return FI_SUCCESS;
+put:
+	ofi_memfd_put_handle(handle);
+free:
+	free(handle);
+	return ret;
+}
+
 static struct fi_ops_mr smr_mr_ops = {
 	.size = sizeof(struct fi_ops_mr),
 	.reg = ofi_mr_reg,
 	.regv = ofi_mr_regv,
-	.regattr = ofi_mr_regattr,
+	.regattr = smr_mr_regattr,
 };
 
 int smr_domain_open(struct fid_fabric *fabric, struct fi_info *info,
@@ -188,6 +261,12 @@ int smr_domain_open(struct fid_fabric *fabric, struct fi_info *info,
 		return ret;
 	}
 
+	if (!smr_env.disable_memfd &&
+	    ofi_memfd_cache_open(&smr_domain->memfd_cache,
+				 &smr_domain->util_domain))
+		FI_INFO(&smr_prov, FI_LOG_DOMAIN,
+			"memfd cache unavailable, memfd protocol disabled\n");
+
 	*domain = &smr_domain->util_domain.domain_fid;
 	(*domain)->fid.ops = &smr_domain_fi_ops;
 	(*domain)->ops = &smr_domain_ops;
@@ -204,7 +204,7 @@ static void smr_send_name(struct smr_ep *ep, int64_t id)
 	memcpy(tx_buf->data, ep->name, ce->cmd.msg.hdr.size);
 
 	smr_peer_data(ep->region)[id].name_sent = 1;
-	smr_cmd_queue_commit(ce, pos);
+	smr_commit_cmd(peer_smr, ce, pos);
 }
 
 int64_t smr_verify_peer(struct smr_ep *ep, fi_addr_t fi_addr)
@@ -291,15 +291,45 @@ static void smr_format_inject(struct smr_cmd *cmd, struct ofi_mr **mr,
 						 mr, iov, count, 0);
 }
 
+/* The iovs beyond what fits in the command are written to an inject
+ * buffer of the peer's region, which the peer releases once it has read
+ * them.
+ */
 static void smr_format_iov(struct smr_cmd *cmd, const struct iovec *iov,
 		size_t count, size_t total_len, struct smr_region *smr,
-		struct smr_resp *resp)
+		struct smr_resp *resp, struct smr_region *peer_smr,
+		struct smr_inject_buf *tx_buf)
 {
 	cmd->msg.hdr.op_src = smr_src_iov;
 	cmd->msg.hdr.src_data = smr_get_offset(smr, resp);
 	cmd->msg.data.iov_count = count;
 	cmd->msg.hdr.size = total_len;
-	memcpy(cmd->msg.data.iov, iov, sizeof(*iov) * count);
+	if (tx_buf) {
+		memcpy(tx_buf->data, iov, sizeof(*iov) * count);
+		cmd->msg.data.iov_buf = smr_get_offset(peer_smr, tx_buf);
+	} else {
+		memcpy(cmd->msg.data.iov, iov, sizeof(*iov) * count);
+	}
+}
+
+static void smr_format_memfd(struct smr_cmd *cmd, void *ptr, size_t len,
+			     struct ofi_mr *mr, struct smr_region *smr,
+			     struct smr_resp *resp)
+{
+	struct ofi_memfd_handle *handle = mr->hmem_data;
+	long page_size = ofi_get_page_size();
+	uintptr_t start, end;
+
+	start = (uintptr_t) ofi_get_page_start(ptr, page_size);
+	end = (uintptr_t) ofi_get_page_end((char *) ptr + len - 1, page_size);
+
+	cmd->msg.hdr.op_src = smr_src_memfd;
+	cmd->msg.hdr.src_data = smr_get_offset(smr, resp);
+	cmd->msg.hdr.size = len;
+	cmd->msg.data.memfd.handle = *handle;
+	cmd->msg.data.memfd.base_addr = start;
+	cmd->msg.data.memfd.base_length = end - start + 1;
+	cmd->msg.data.memfd.addr = (uintptr_t) ptr;
 }
 
 static int smr_format_ipc(struct smr_cmd *cmd, void *ptr, size_t len,
@@ -333,7 +363,176 @@ static int smr_format_ipc(struct smr_cmd *cmd, void *ptr, size_t len,
 	return FI_SUCCESS;
 }
 
-static int smr_format_mmap(struct smr_ep *ep, struct smr_cmd *cmd,
+/* The peer copies out of the pool, so place it on the peer's node. */
+static int smr_mmap_pool_grow(struct smr_mmap_pool *pool, size_t size,
+			      int numa_node)
+{
+	void *mapped_ptr;
+	int fd, ret;
+
+	fd = shm_open(pool->map_name.name, O_RDWR | O_CREAT,
+		      S_IRUSR | S_IWUSR);
+	if (fd < 0) {
+		FI_WARN(&smr_prov, FI_LOG_EP_CTRL, "shm_open error\n");
+		return -errno;
+	}
+
+	ret = ftruncate(fd, size);
+	if (ret < 0) {
+		FI_WARN(&smr_prov, FI_LOG_EP_CTRL, "ftruncate error\n");
+		ret = -errno;
+		goto out;
+	}
+
+	mapped_ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+			  fd, 0);
+	if (mapped_ptr == MAP_FAILED) {
+		FI_WARN(&smr_prov, FI_LOG_EP_CTRL, "mmap error\n");
+		ret = -errno;
+		goto out;
+	}
+
+	if (numa_node >= 0)
+		(void) ofi_mbind_preferred(mapped_ptr, size, numa_node);
+
+	if (pool->ptr)
+		munmap(pool->ptr, pool->size);
+	pool->ptr = mapped_ptr;
+	pool->size = size;
+out:
+	close(fd);
+	return ret;
+}
+
+/* Carve total_len bytes out of the persistent file shared with peer id.
+ * Space is handed out as a ring and returned in order as responses
+ * complete.  Returns -FI_EAGAIN if the ring is full; the caller then
+ * falls back to a per-message file.
+ */
+static int smr_mmap_pool_reserve(struct smr_ep *ep, int64_t id,
+				 size_t total_len, uint64_t *offset)
+{
+	struct smr_mmap_pool *pool;
+	size_t len, size;
+	int ret;
+
+	if (total_len > smr_env.mmap_pool_size)
+		return -FI_EMSGSIZE;
+
+	pool = ep->mmap_tx[id];
+	if (!pool) {
+		pool = calloc(1, sizeof(*pool));
+		if (!pool)
+			return -FI_ENOMEM;
+
+		if (smr_mmap_pool_name(pool->map_name.name, ep->name, id) < 0) {
+			free(pool);
+			return -FI_EINVAL;
+		}
+		pthread_mutex_lock(&ep_list_lock);
+		dlist_insert_tail(&pool->map_name.entry, &ep_name_list);
+		pthread_mutex_unlock(&ep_list_lock);
+		ep->mmap_tx[id] = pool;
+	}
+
+	if (!pool->inflight) {
+		pool->head = pool->tail = 0;
+		pool->wrapped = false;
+	}
+
+	len = ofi_get_aligned_size(total_len, 64);
+	if (pool->wrapped) {
+		if (pool->tail + len > pool->head)
+			return -FI_EAGAIN;
+	} else if (pool->tail + len > pool->size) {
+		if (pool->size < smr_env.mmap_pool_size) {
+			size = MIN(roundup_power_of_two(pool->tail + len),
+				   smr_env.mmap_pool_size);
+			ret = smr_mmap_pool_grow(pool, size,
+				smr_peer_region(ep->region, id)->numa_node);
+			if (ret)
+				return ret;
+		}
+		if (pool->tail + len > pool->size) {
+			if (len > pool->head)
+				return -FI_EAGAIN;
+			pool->tail = 0;
+			pool->wrapped = true;
+		}
+	}
+
+	*offset = pool->tail;
+	pool->tail += len;
+	pool->inflight++;
+	return FI_SUCCESS;
+}
+
+void smr_mmap_pool_release(struct smr_ep *ep, int64_t id, uint64_t offset,
+			   size_t len)
+{
+	struct smr_mmap_pool *pool = ep->mmap_tx[id];
+
+	assert(pool && pool->inflight);
+	if (!offset)
+		pool->wrapped = false;
+	pool->head = offset + ofi_get_aligned_size(len, 64);
+	pool->inflight--;
+}
+
+static void smr_mmap_pool_cleanup(struct smr_ep *ep)
+{
+	struct smr_mmap_pool *pool;
+	int i;
+
+	for (i = 0; i < SMR_MAX_PEERS; i++) {
+		pool = ep->mmap_tx[i];
+		if (pool) {
+			if (pool->ptr)
+				munmap(pool->ptr, pool->size);
+			shm_unlink(pool->map_name.name);
+			pthread_mutex_lock(&ep_list_lock);
+			dlist_remove(&pool->map_name.entry);
+			pthread_mutex_unlock(&ep_list_lock);
+			free(pool);
+		}
+
+		pool = ep->mmap_rx[i];
+		if (pool) {
+			if (pool->ptr)
+				munmap(pool->ptr, pool->size);
+			free(pool);
+		}
+	}
+}
+
+static int smr_format_mmap_pool(struct smr_ep *ep, int64_t id,
+				struct smr_cmd *cmd, const struct iovec *iov,
+				size_t count, size_t total_len,
+				struct smr_tx_entry *pend)
+{
+	uint64_t offset;
+	int ret;
+
+	ret = smr_mmap_pool_reserve(ep, id, total_len, &offset);
+	if (ret)
+		return ret;
+
+	if (cmd->msg.hdr.op != ofi_op_read_req &&
+	    ofi_copy_from_iov((char *) ep->mmap_tx[id]->ptr + offset,
+			      total_len, iov, count, 0) != total_len) {
+		FI_WARN(&smr_prov, FI_LOG_EP_CTRL, "copy from iov error\n");
+		smr_mmap_pool_release(ep, id, offset, total_len);
+		return -FI_EIO;
+	}
+
+	cmd->msg.hdr.op_flags |= SMR_MMAP_POOL;
+	cmd->msg.data.mmap.offset = offset;
+	cmd->msg.data.mmap.pool_id = id;
+	pend->map_name = NULL;
+	return 0;
+}
+
+static int smr_format_mmap(struct smr_ep *ep, int64_t id, struct smr_cmd *cmd,
 		const struct iovec *iov, size_t count, size_t total_len,
 		struct smr_tx_entry *pend, struct smr_resp *resp)
 {
@@ -343,6 +542,15 @@ static int smr_format_mmap(struct smr_ep *ep, struct smr_cmd *cmd,
 	struct smr_ep_name *map_name;
 
 	msg_id = ep->msg_id++;
+	if (smr_env.mmap_pool_size &&
+	    !smr_format_mmap_pool(ep, id, cmd, iov, count, total_len, pend)) {
+		cmd->msg.hdr.op_src = smr_src_mmap;
+		cmd->msg.hdr.msg_id = msg_id;
+		cmd->msg.hdr.src_data = smr_get_offset(ep->region, resp);
+		cmd->msg.hdr.size = total_len;
+		return 0;
+	}
+
 	map_name = calloc(1, sizeof(*map_name));
 	if (!map_name) {
 		FI_WARN(&smr_prov, FI_LOG_EP_CTRL, "calloc error\n");
@@ -543,12 +751,12 @@ out:
 }
 
 int smr_select_proto(void **desc, size_t iov_count, bool vma_avail,
-		     bool ipc_valid, uint32_t op, uint64_t total_len,
-		     uint64_t op_flags)
+		     bool ipc_valid, bool memfd_avail, uint32_t op,
+		     uint64_t total_len, uint64_t op_flags)
 {
 	struct ofi_mr *smr_desc;
 	enum fi_hmem_iface iface = FI_HMEM_SYSTEM;
-	bool fastcopy_avail = false, use_ipc = false;
+	bool fastcopy_avail = false, use_ipc = false, use_memfd = false;
 
 	/* Do not inline/inject if IPC is available so device to device
 	 * transfer may occur if possible. */
@@ -565,9 +773,20 @@ int smr_select_proto(void **desc, size_t iov_count, bool vma_avail,
 		}
 	}
 
+	/* The peer maps a memfd-backed region once and then copies directly,
+	 * so prefer it over CMA, which pins the pages on every transfer. */
+	if (iov_count == 1 && desc && desc[0] && memfd_avail) {
+		smr_desc = (struct ofi_mr *) *desc;
+		use_memfd = smr_desc->flags & OFI_HMEM_DATA_MEMFD &&
+			    total_len > SMR_INJECT_SIZE &&
+			    !(op_flags & FI_INJECT);
+	}
+
 	if (op == ofi_op_read_req) {
 		if (use_ipc)
 			return smr_src_ipc;
+		if (use_memfd)
+			return smr_src_memfd;
 		if (vma_avail && FI_HMEM_SYSTEM == iface)
 			return smr_src_iov;
 		return smr_src_sar;
@@ -587,6 +806,9 @@ int smr_select_proto(void **desc, size_t iov_count, bool vma_avail,
 	if (use_ipc)
 		return smr_src_ipc;
 
+	if (use_memfd)
+		return smr_src_memfd;
+
 	if (total_len > SMR_INJECT_SIZE && vma_avail)
 		return smr_src_iov;
 
@@ -641,17 +863,30 @@ static ssize_t smr_do_iov(struct smr_ep *ep, struct smr_region *peer_smr, int64_
 		          const struct iovec *iov, size_t iov_count, size_t total_len,
 		          void *context, struct smr_cmd *cmd)
 {
+	struct iovec cma_iov[SMR_IOV_LIMIT];
+	struct smr_inject_buf *tx_buf = NULL;
 	struct smr_resp *resp;
 	struct smr_tx_entry *pend;
+	size_t cma_count;
 
 	if (ofi_cirque_isfull(smr_resp_queue(ep->region)))
 		return -FI_EAGAIN;
 
+	/* fewer, larger segments mean fewer iovs for the peer to walk */
+	assert(iov_count <= SMR_IOV_LIMIT);
+	cma_count = ofi_coalesce_iov(cma_iov, iov, iov_count);
+	if (cma_count > SMR_IOV_INLINE) {
+		tx_buf = smr_get_txbuf(peer_smr);
+		if (!tx_buf)
+			return -FI_EAGAIN;
+	}
+
 	resp = ofi_cirque_next(smr_resp_queue(ep->region));
 	pend = ofi_freestack_pop(ep->tx_fs);
 
 	smr_generic_format(cmd, peer_id, op, tag, data, op_flags);
-	smr_format_iov(cmd, iov, iov_count, total_len, ep->region, resp);
+	smr_format_iov(cmd, cma_iov, cma_count, total_len, ep->region, resp,
+		       peer_smr, tx_buf);
 	smr_format_pend_resp(pend, cmd, context, desc, iov,
 			     iov_count, op_flags, id, resp);
 	ofi_cirque_commit(smr_resp_queue(ep->region));
@@ -727,6 +962,33 @@ static ssize_t smr_do_ipc(struct smr_ep *ep, struct smr_region *peer_smr, int64_
 	return FI_SUCCESS;
 }
 
+static ssize_t smr_do_memfd(struct smr_ep *ep, struct smr_region *peer_smr,
+			    int64_t id, int64_t peer_id, uint32_t op,
+			    uint64_t tag, uint64_t data, uint64_t op_flags,
+			    struct ofi_mr **desc, const struct iovec *iov,
+			    size_t iov_count, size_t total_len, void *context,
+			    struct smr_cmd *cmd)
+{
+	struct smr_resp *resp;
+	struct smr_tx_entry *pend;
+
+	if (ofi_cirque_isfull(smr_resp_queue(ep->region)))
+		return -FI_EAGAIN;
+
+	resp = ofi_cirque_next(smr_resp_queue(ep->region));
+	pend = ofi_freestack_pop(ep->tx_fs);
+
+	smr_generic_format(cmd, peer_id, op, tag, data, op_flags);
+	assert(iov_count == 1 && desc && desc[0]);
+	smr_format_memfd(cmd, iov[0].iov_base, total_len, desc[0], ep->region,
+			 resp);
+	smr_format_pend_resp(pend, cmd, context, desc, iov,
+			     iov_count, op_flags, id, resp);
+	ofi_cirque_commit(smr_resp_queue(ep->region));
+
+	return FI_SUCCESS;
+}
+
 static ssize_t smr_do_mmap(struct smr_ep *ep, struct smr_region *peer_smr, int64_t id,
 			   int64_t peer_id, uint32_t op, uint64_t tag, uint64_t data,
 			   uint64_t op_flags, struct ofi_mr **desc,
@@ -744,7 +1006,8 @@ static ssize_t smr_do_mmap(struct smr_ep *ep, struct smr_region *peer_smr, int64
 	pend = ofi_freestack_pop(ep->tx_fs);
 
 	smr_generic_format(cmd, peer_id, op, tag, data, op_flags);
-	ret = smr_format_mmap(ep, cmd, iov, iov_count, total_len, pend, resp);
+	ret = smr_format_mmap(ep, id, cmd, iov, iov_count, total_len, pend,
+			      resp);
 	if (ret) {
 		ofi_freestack_push(ep->tx_fs, pend);
 		return ret;
@@ -764,6 +1027,7 @@ smr_proto_func smr_proto_ops[smr_src_max] = {
 	[smr_src_mmap] = &smr_do_mmap,
 	[smr_src_sar] = &smr_do_sar,
 	[smr_src_ipc] = &smr_do_ipc,
+	[smr_src_memfd] = &smr_do_memfd,
 };
 
 static void smr_cleanup_epoll(struct smr_sock_info *sock_info)
@@ -843,6 +1107,7 @@ static int smr_ep_close(struct fid *fid)
 		ofi_bufpool_destroy(ep->pend_buf_pool);
 
 	smr_tx_fs_free(ep->tx_fs);
+	smr_mmap_pool_cleanup(ep);
 
 	free((void *)ep->name);
 	free(ep);
@@ -860,6 +1125,60 @@ static int smr_ep_trywait(void *arg)
 	return FI_SUCCESS;
 }
 
+/* Whether every operation in flight waits on a peer that will ring us
+ * once it makes progress.
+ */
+static bool smr_ep_idle(struct smr_ep *ep)
+{
+	struct smr_tx_entry *pending;
+	struct smr_resp *resp;
+
+	if (smr_env.use_dsa_sar || !dlist_empty(&ep->sar_list) ||
+	    !dlist_empty(&ep->ipc_cpy_pend_list))
+		return false;
+
+	if (!smr_cmd_queue_isempty(smr_cmd_queue(ep->region)))
+		return false;
+
+	if (ofi_cirque_isempty(smr_resp_queue(ep->region)))
+		return true;
+
+	resp = ofi_cirque_head(smr_resp_queue(ep->region));
+	pending = (struct smr_tx_entry *) resp->msg_id;
+	return resp->status == SMR_STATUS_BUSY &&
+	       pending->cmd.msg.hdr.op_src != smr_src_sar;
+}
+
+/* Called by a yield wait set in place of sched_yield().  After spinning
+ * for smr_env.wait_spin rounds, sleep on the region's doorbell.  Work
+ * generated by other threads of this process does not ring it, so
+ * sleeps are capped at SMR_WAIT_SLEEP_MAX.
+ */
+static int smr_ep_block(void *arg, int idle, int timeout)
+{
+	struct smr_ep *ep;
+	int32_t seq;
+
+	if (smr_env.wait_spin < 0 || idle < smr_env.wait_spin)
+		return -FI_EAGAIN;
+
+	ep = container_of(arg, struct smr_ep, util_ep.ep_fid.fid);
+	if (!ep->region)
+		return -FI_EAGAIN;
+
+	seq = ofi_doorbell_arm(&ep->region->doorbell);
+	if (!smr_ep_idle(ep)) {
+		ofi_doorbell_disarm(&ep->region->doorbell);
+		return -FI_EAGAIN;
+	}
+
+	if (timeout < 0 || timeout > SMR_WAIT_SLEEP_MAX)
+		timeout = SMR_WAIT_SLEEP_MAX;
+	(void) ofi_doorbell_wait(&ep->region->doorbell, seq, timeout);
+	ofi_doorbell_disarm(&ep->region->doorbell);
+	return FI_SUCCESS;
+}
+
 static int smr_ep_bind_cq(struct smr_ep *ep, struct util_cq *cq, uint64_t flags)
 {
 	int ret;
@@ -869,8 +1188,9 @@ static int smr_ep_bind_cq(struct smr_ep *ep, struct util_cq *cq, uint64_t flags)
 		return ret;
 
 	if (cq->wait) {
-		ret = ofi_wait_add_fid(cq->wait, &ep->util_ep.ep_fid.fid, 0,
-				       smr_ep_trywait);
+		ret = ofi_wait_add_fid_block(cq->wait,
+					     &ep->util_ep.ep_fid.fid, 0,
+					     smr_ep_trywait, smr_ep_block);
 		if (ret)
 			return ret;
 	}
@@ -887,8 +1207,9 @@ static int smr_ep_bind_cntr(struct smr_ep *ep, struct util_cntr *cntr, uint64_t
 		return ret;
 
 	if (cntr->wait) {
-		ret = ofi_wait_add_fid(cntr->wait, &ep->util_ep.ep_fid.fid, 0,
-				       smr_ep_trywait);
+		ret = ofi_wait_add_fid_block(cntr->wait,
+					     &ep->util_ep.ep_fid.fid, 0,
+					     smr_ep_trywait, smr_ep_block);
 		if (ret)
 			return ret;
 	}
@@ -1058,6 +1379,9 @@ static int smr_discard(struct fi_peer_rx_entry *rx_entry)
 		resp->status = SMR_STATUS_SUCCESS;
 	}
 
+	if (cmd_ctx->cmd.msg.hdr.op_src == smr_src_iov)
+		smr_free_cmd_ctx_iov(cmd_ctx);
+
 	dlist_remove(&cmd_ctx->entry);
 	ofi_buf_free(cmd_ctx);
 
@@ -1141,6 +1465,10 @@ static int smr_ep_ctrl(struct fid *fid, int command, void *arg)
 		attr.tx_count = ep->tx_size;
 		attr.flags = ep->util_ep.caps & FI_HMEM ?
 				SMR_FLAG_HMEM_ENABLED : 0;
+		domain = container_of(ep->util_ep.domain, struct smr_domain,
+				      util_domain);
+		if (domain->memfd_cache)
+			attr.flags |= SMR_FLAG_MEMFD;
 
 		ret = smr_create(&smr_prov, &av->smr_map, &attr, &ep->region);
 		if (ret)
@@ -42,20 +42,29 @@ struct sigaction *old_action = NULL;
 
 struct smr_env smr_env = {
 	.sar_threshold = SIZE_MAX,
+	.mmap_pool_size = 64 * 1024 * 1024,
 	.disable_cma = false,
+	.disable_memfd = false,
 	.use_dsa_sar = false,
 	.max_gdrcopy_size = 3072,
 	.use_xpmem = false,
+	.wait_spin = 1000,
+	.numa_bind = true,
 };
 
 static void smr_init_env(void)
 {
 	fi_param_get_size_t(&smr_prov, "sar_threshold", &smr_env.sar_threshold);
+	fi_param_get_size_t(&smr_prov, "mmap_pool_size",
+			    &smr_env.mmap_pool_size);
 	fi_param_get_size_t(&smr_prov, "tx_size", &smr_info.tx_attr->size);
 	fi_param_get_size_t(&smr_prov, "rx_size", &smr_info.rx_attr->size);
 	fi_param_get_bool(&smr_prov, "disable_cma", &smr_env.disable_cma);
+	fi_param_get_bool(&smr_prov, "disable_memfd", &smr_env.disable_memfd);
 	fi_param_get_bool(&smr_prov, "use_dsa_sar", &smr_env.use_dsa_sar);
 	fi_param_get_bool(&smr_prov, "use_xpmem", &smr_env.use_xpmem);
+	fi_param_get_int(&smr_prov, "wait_spin", &smr_env.wait_spin);
+	fi_param_get_bool(&smr_prov, "numa_bind", &smr_env.numa_bind);
 }
 
 static void smr_resolve_addr(const char *node, const char *service,
@@ -209,6 +218,12 @@ SHM_INI
 			"Max size to use for alternate SAR protocol if CMA \
 			 is not available before switching to mmap protocol \
 			 Default: SIZE_MAX (18446744073709551615)");
+	fi_param_define(&smr_prov, "mmap_pool_size", FI_PARAM_SIZE_T,
+			"Max size of the persistent file kept per peer for \
+			 the mmap protocol. Larger messages, or messages \
+			 that do not fit while others are in flight, use a \
+			 file per message. 0 disables the pool. \
+			 Default: 67108864 (64 MiB)");
 	fi_param_define(&smr_prov, "tx_size", FI_PARAM_SIZE_T,
 			"Max number of outstanding tx operations \
 			 Default: 1024");
@@ -217,11 +232,24 @@ SHM_INI
 			 Default: 1024");
 	fi_param_define(&smr_prov, "disable_cma", FI_PARAM_BOOL,
 			"Manually disables CMA. Default: false");
+	fi_param_define(&smr_prov, "disable_memfd", FI_PARAM_BOOL,
+			"Disable mapping of peers' memfd-backed regions "
+			"registered with FI_MR_DMABUF. Default: false");
 	fi_param_define(&smr_prov, "use_dsa_sar", FI_PARAM_BOOL,
 			"Enable use of DSA in SAR protocol. Default: false");
 	fi_param_define(&smr_prov, "use_xpmem", FI_PARAM_BOOL,
 			"Enable XPMEM over CMA when possible "
 			"(default: false)");
+	fi_param_define(&smr_prov, "wait_spin", FI_PARAM_INT,
+			"Number of idle polls a blocking wait (fi_cq_sread, "
+			"fi_cntr_wait) makes before sleeping until a peer "
+			"posts to the endpoint. -1 never sleeps. "
+			"Default: 1000");
+	fi_param_define(&smr_prov, "numa_bind", FI_PARAM_BOOL,
+			"Place an endpoint's shared region (its command "
+			"queue, inject and SAR buffers) on the NUMA node of "
+			"the CPU that opens the endpoint, unless the process "
+			"has its own memory policy. Default: true");
 
 	smr_init_env();
 
@@ -112,7 +112,8 @@ static ssize_t smr_generic_sendmsg(struct smr_ep *ep, const struct iovec *iov,
 	assert(!(op_flags & FI_INJECT) || total_len <= SMR_INJECT_SIZE);
 
 	proto = smr_select_proto(desc, iov_count, smr_vma_enabled(ep, peer_smr),
-	                         smr_ipc_valid(ep, peer_smr, id, peer_id), op,
+	                         smr_ipc_valid(ep, peer_smr, id, peer_id),
+				 smr_memfd_valid(peer_smr, peer_id), op,
 				 total_len, op_flags);
 
 	ret = smr_proto_ops[proto](ep, peer_smr, id, peer_id, op, tag, data, op_flags,
@@ -122,7 +123,7 @@ static ssize_t smr_generic_sendmsg(struct smr_ep *ep, const struct iovec *iov,
 		smr_cmd_queue_discard(ce, pos);
 		goto unlock;
 	}
-	smr_cmd_queue_commit(ce, pos);
+	smr_commit_cmd(peer_smr, ce, pos);
 
 	if (proto != smr_src_inline && proto != smr_src_inject)
 		goto unlock;
@@ -218,7 +219,7 @@ static ssize_t smr_generic_inject(struct fid_ep *ep_fid, const void *buf,
 		smr_cmd_queue_discard(ce, pos);
 		return -FI_EAGAIN;
 	}
-	smr_cmd_queue_commit(ce, pos);
+	smr_commit_cmd(peer_smr, ce, pos);
 	ofi_ep_peer_tx_cntr_inc(&ep->util_ep, op);
 
 	return FI_SUCCESS;
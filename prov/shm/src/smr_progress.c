@@ -32,6 +32,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <sys/uio.h>
 
 #include "ofi_iov.h"
@@ -96,6 +97,7 @@ static int smr_progress_resp_entry(struct smr_ep *ep, struct smr_resp *resp,
 
 	switch (pending->cmd.msg.hdr.op_src) {
 	case smr_src_iov:
+	case smr_src_memfd:
 		break;
 	case smr_src_ipc:
 		assert(pending->mr[0]);
@@ -130,7 +132,11 @@ static int smr_progress_resp_entry(struct smr_ep *ep, struct smr_resp *resp,
 		resp->status = SMR_STATUS_SUCCESS;
 		break;
 	case smr_src_mmap:
-		if (!pending->map_name)
+		if (pending->cmd.msg.hdr.op_flags & SMR_MMAP_POOL)
+			pending->map_ptr = (char *)
+				ep->mmap_tx[pending->peer_id]->ptr +
+				pending->cmd.msg.data.mmap.offset;
+		else if (!pending->map_name)
 			break;
 		if (pending->cmd.msg.hdr.op == ofi_op_read_req) {
 			if (!*err) {
@@ -153,8 +159,15 @@ static int smr_progress_resp_entry(struct smr_ep *ep, struct smr_resp *resp,
 					pending->bytes_done = (size_t) hmem_copy_ret;
 				}
 			}
-			munmap(pending->map_ptr, pending->cmd.msg.hdr.size);
 		}
+		if (pending->cmd.msg.hdr.op_flags & SMR_MMAP_POOL) {
+			smr_mmap_pool_release(ep, pending->peer_id,
+					      pending->cmd.msg.data.mmap.offset,
+					      pending->cmd.msg.hdr.size);
+			break;
+		}
+		if (pending->cmd.msg.hdr.op == ofi_op_read_req)
+			munmap(pending->map_ptr, pending->cmd.msg.hdr.size);
 		shm_unlink(pending->map_name->name);
 		dlist_remove(&pending->map_name->entry);
 		free(pending->map_name);
@@ -303,9 +316,9 @@ static int smr_progress_inject(struct smr_cmd *cmd, struct ofi_mr **mr,
 	return FI_SUCCESS;
 }
 
-static int smr_progress_iov(struct smr_cmd *cmd, struct iovec *iov,
-			    size_t iov_count, size_t *total_len,
-			    struct smr_ep *ep)
+static int smr_progress_iov(struct smr_cmd *cmd, struct iovec *cmd_iov,
+			    struct iovec *iov, size_t iov_count,
+			    size_t *total_len, struct smr_ep *ep)
 {
 	struct smr_region *peer_smr;
 	struct ofi_xpmem_client *xpmem;
@@ -317,7 +330,7 @@ static int smr_progress_iov(struct smr_cmd *cmd, struct iovec *iov,
 
 	xpmem = &smr_peer_data(ep->region)[cmd->msg.hdr.id].xpmem;
 
-	ret = ofi_shm_p2p_copy(ep->p2p_type, iov, iov_count, cmd->msg.data.iov,
+	ret = ofi_shm_p2p_copy(ep->p2p_type, iov, iov_count, cmd_iov,
 			       cmd->msg.data.iov_count, cmd->msg.hdr.size,
 			       peer_smr->pid, cmd->msg.hdr.op == ofi_op_read_req,
 			       xpmem);
@@ -330,6 +343,162 @@ static int smr_progress_iov(struct smr_cmd *cmd, struct iovec *iov,
 	return ret;
 }
 
+static int smr_progress_memfd(struct smr_cmd *cmd, struct ofi_mr **mr,
+			      struct iovec *iov, size_t iov_count,
+			      size_t *total_len, struct smr_ep *ep)
+{
+	struct smr_domain *domain;
+	struct smr_region *peer_smr;
+	struct ofi_mr_entry *mr_entry;
+	struct smr_resp *resp;
+	struct iovec base;
+	ssize_t hmem_copy_ret;
+	char *mapped_ptr;
+	int ret;
+
+	domain = container_of(ep->util_ep.domain, struct smr_domain,
+			      util_domain);
+	peer_smr = smr_peer_region(ep->region, cmd->msg.hdr.id);
+	resp = smr_get_ptr(peer_smr, cmd->msg.hdr.src_data);
+
+	if (!domain->memfd_cache) {
+		FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
+			"memfd protocol disabled, rejecting peer request\n");
+		ret = -FI_EOPNOTSUPP;
+		goto out;
+	}
+
+	base.iov_base = (void *) (uintptr_t) cmd->msg.data.memfd.base_addr;
+	base.iov_len = cmd->msg.data.memfd.base_length;
+	ret = ofi_memfd_cache_search(domain->memfd_cache, cmd->msg.hdr.id,
+				     &base, &cmd->msg.data.memfd.handle,
+				     &mr_entry);
+	if (ret) {
+		FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
+			"unable to map peer memfd region: %d\n", ret);
+		goto out;
+	}
+
+	mapped_ptr = (char *) mr_entry->info.mapped_addr +
+		     (cmd->msg.data.memfd.addr -
+		      (uintptr_t) mr_entry->info.iov.iov_base);
+
+	if (cmd->msg.hdr.op == ofi_op_read_req)
+		hmem_copy_ret = ofi_copy_from_mr_iov(mapped_ptr,
+					cmd->msg.hdr.size, mr, iov,
+					iov_count, 0);
+	else
+		hmem_copy_ret = ofi_copy_to_mr_iov(mr, iov, iov_count, 0,
+					mapped_ptr, cmd->msg.hdr.size);
+	ofi_mr_cache_delete(domain->memfd_cache, mr_entry);
+
+	if (hmem_copy_ret < 0) {
+		ret = hmem_copy_ret;
+	} else if (hmem_copy_ret != cmd->msg.hdr.size) {
+		ret = -FI_ETRUNC;
+	} else {
+		*total_len = hmem_copy_ret;
+	}
+out:
+	//Status must be set last (signals peer: op done, valid resp entry)
+	resp->status = -ret;
+
+	return ret;
+}
+
+static int smr_mmap_copy(struct smr_cmd *cmd, struct ofi_mr **mr,
+			 struct iovec *iov, size_t iov_count,
+			 void *mapped_ptr, size_t *total_len)
+{
+	ssize_t hmem_copy_ret;
+
+	if (cmd->msg.hdr.op == ofi_op_read_req) {
+		hmem_copy_ret = ofi_copy_from_mr_iov(mapped_ptr,
+					cmd->msg.hdr.size, mr, iov,
+					iov_count, 0);
+	} else {
+		hmem_copy_ret = ofi_copy_to_mr_iov(mr, iov, iov_count, 0,
+					mapped_ptr, cmd->msg.hdr.size);
+	}
+
+	if (hmem_copy_ret < 0) {
+		FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
+			"mmap copy iov failed with code %d\n",
+			(int)(-hmem_copy_ret));
+		return hmem_copy_ret;
+	}
+
+	*total_len = hmem_copy_ret;
+	if (hmem_copy_ret != cmd->msg.hdr.size) {
+		FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
+			"mmap copy iov truncated\n");
+		return -FI_ETRUNC;
+	}
+	return 0;
+}
+
+/* Return the receive side mapping of the peer's persistent mmap file,
+ * remapping only when the peer has grown the file past what we have
+ * mapped (or the slot now belongs to a different peer).
+ */
+static void *smr_mmap_pool_map(struct smr_ep *ep, struct smr_cmd *cmd)
+{
+	struct smr_mmap_pool *pool;
+	char shm_name[SMR_NAME_MAX];
+	struct stat st;
+	void *mapped_ptr;
+	size_t end;
+	int fd;
+
+	if (smr_mmap_pool_name(shm_name,
+			ep->region->map->peers[cmd->msg.hdr.id].peer.name,
+			cmd->msg.data.mmap.pool_id) < 0) {
+		FI_WARN(&smr_prov, FI_LOG_AV, "generating shm file name failed\n");
+		return NULL;
+	}
+
+	pool = ep->mmap_rx[cmd->msg.hdr.id];
+	if (!pool) {
+		pool = calloc(1, sizeof(*pool));
+		if (!pool)
+			return NULL;
+		ep->mmap_rx[cmd->msg.hdr.id] = pool;
+	}
+
+	end = cmd->msg.data.mmap.offset + cmd->msg.hdr.size;
+	if (pool->ptr && end <= pool->size &&
+	    !strncmp(pool->map_name.name, shm_name, SMR_NAME_MAX))
+		goto out;
+
+	fd = shm_open(shm_name, O_RDWR, S_IRUSR | S_IWUSR);
+	if (fd < 0) {
+		FI_WARN(&smr_prov, FI_LOG_AV, "shm_open error\n");
+		return NULL;
+	}
+
+	if (fstat(fd, &st) || st.st_size < end) {
+		FI_WARN(&smr_prov, FI_LOG_AV, "mmap pool size error\n");
+		close(fd);
+		return NULL;
+	}
+
+	mapped_ptr = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE,
+			  MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapped_ptr == MAP_FAILED) {
+		FI_WARN(&smr_prov, FI_LOG_AV, "mmap error %s\n", strerror(errno));
+		return NULL;
+	}
+
+	if (pool->ptr)
+		munmap(pool->ptr, pool->size);
+	pool->ptr = mapped_ptr;
+	pool->size = st.st_size;
+	memcpy(pool->map_name.name, shm_name, SMR_NAME_MAX);
+out:
+	return (char *) pool->ptr + cmd->msg.data.mmap.offset;
+}
+
 static int smr_mmap_peer_copy(struct smr_ep *ep, struct smr_cmd *cmd,
 			      struct ofi_mr **mr, struct iovec *iov,
 			      size_t iov_count, size_t *total_len)
@@ -338,7 +507,14 @@ static int smr_mmap_peer_copy(struct smr_ep *ep, struct smr_cmd *cmd,
 	void *mapped_ptr;
 	int fd, num;
 	int ret = 0;
-	ssize_t hmem_copy_ret;
+
+	if (cmd->msg.hdr.op_flags & SMR_MMAP_POOL) {
+		mapped_ptr = smr_mmap_pool_map(ep, cmd);
+		if (!mapped_ptr)
+			return -FI_EIO;
+		return smr_mmap_copy(cmd, mr, iov, iov_count, mapped_ptr,
+				     total_len);
+	}
 
 	num = smr_mmap_name(shm_name,
 			ep->region->map->peers[cmd->msg.hdr.id].peer.name,
@@ -362,27 +538,7 @@ static int smr_mmap_peer_copy(struct smr_ep *ep, struct smr_cmd *cmd,
 		goto unlink_close;
 	}
 
-	if (cmd->msg.hdr.op == ofi_op_read_req) {
-		hmem_copy_ret = ofi_copy_from_mr_iov(mapped_ptr,
-					cmd->msg.hdr.size, mr, iov,
-					iov_count, 0);
-	} else {
-		hmem_copy_ret = ofi_copy_to_mr_iov(mr, iov, iov_count, 0,
-					mapped_ptr, cmd->msg.hdr.size);
-	}
-
-	if (hmem_copy_ret < 0) {
-		FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
-			"mmap copy iov failed with code %d\n",
-			(int)(-hmem_copy_ret));
-		ret = hmem_copy_ret;
-	} else if (hmem_copy_ret != cmd->msg.hdr.size) {
-		FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
-			"mmap copy iov truncated\n");
-		ret = -FI_ETRUNC;
-	}
-
-	*total_len = hmem_copy_ret;
+	ret = smr_mmap_copy(cmd, mr, iov, iov_count, mapped_ptr, total_len);
 
 	munmap(mapped_ptr, cmd->msg.hdr.size);
 unlink_close:
@@ -711,16 +867,159 @@ out:
 	return err;
 }
 
-static int smr_start_common(struct smr_ep *ep, struct smr_cmd *cmd,
-		struct fi_peer_rx_entry *rx_entry)
+static void smr_ring_peer(struct smr_ep *ep, int64_t id)
+{
+	struct smr_region *peer_smr;
+
+	peer_smr = smr_peer_region(ep->region, id);
+	if (peer_smr)
+		smr_ring(peer_smr);
+}
+
+static void smr_start_complete(struct smr_ep *ep, struct smr_msg_hdr *hdr,
+			       struct fi_peer_rx_entry *rx_entry,
+			       size_t total_len, int err)
 {
-	struct smr_pend_entry *pend = NULL;
-	size_t total_len = 0;
 	uint64_t comp_flags;
 	void *comp_buf;
 	int ret;
+
+	smr_ring_peer(ep, hdr->id);
+	comp_buf = rx_entry->iov[0].iov_base;
+	comp_flags = smr_rx_cq_flags(rx_entry->flags, hdr->op_flags);
+	if (err) {
+		FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
+			"error processing op\n");
+		ret = smr_write_err_comp(ep->util_ep.rx_cq,
+					 rx_entry->context,
+					 comp_flags, rx_entry->tag,
+					 -err);
+	} else {
+		ret = smr_complete_rx(ep, rx_entry->context, hdr->op,
+				      comp_flags, total_len, comp_buf,
+				      hdr->id, hdr->tag, hdr->data);
+	}
+	if (ret) {
+		FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
+			"unable to process rx completion\n");
+	}
+	ep->srx->owner_ops->free_entry(rx_entry);
+}
+
+/* Copy everything gathered in the batch with one call into the peer.  If
+ * that fails, redo each message on its own so that only the failing ones
+ * complete in error.
+ */
+static void smr_cma_batch_flush(struct smr_ep *ep)
+{
+	struct smr_cma_batch *batch = &ep->cma_batch;
+	struct smr_cma_batch_entry *entry;
+	struct smr_region *peer_smr;
+	struct ofi_xpmem_client *xpmem;
+	struct smr_resp *resp;
+	size_t i;
+	int ret, err;
+
+	if (!batch->count)
+		return;
+
+	peer_smr = smr_peer_region(ep->region, batch->id);
+	xpmem = &smr_peer_data(ep->region)[batch->id].xpmem;
+
+	ret = ofi_shm_p2p_copy(ep->p2p_type, batch->local, batch->local_cnt,
+			       batch->remote, batch->remote_cnt,
+			       batch->total_len, peer_smr->pid, false, xpmem);
+
+	for (i = 0; i < batch->count; i++) {
+		entry = &batch->entry[i];
+		err = ret;
+		if (err && batch->count > 1)
+			err = ofi_shm_p2p_copy(ep->p2p_type,
+					&batch->local[entry->local_idx],
+					entry->local_cnt,
+					&batch->remote[entry->remote_idx],
+					entry->remote_cnt, entry->hdr.size,
+					peer_smr->pid, false, xpmem);
+
+		//Status must be set last (signals peer: op done, valid resp entry)
+		resp = smr_get_ptr(peer_smr, entry->hdr.src_data);
+		resp->status = -err;
+
+		smr_start_complete(ep, &entry->hdr, entry->rx_entry,
+				   err ? 0 : entry->hdr.size, err);
+	}
+
+	batch->count = 0;
+	batch->local_cnt = 0;
+	batch->remote_cnt = 0;
+	batch->total_len = 0;
+}
+
+/* Queue a matched smr_src_iov message for smr_cma_batch_flush().  Returns
+ * false if the message has to be copied right away instead.
+ */
+static bool smr_cma_batch_add(struct smr_ep *ep, struct smr_cmd *cmd,
+			      struct iovec *cmd_iov,
+			      struct fi_peer_rx_entry *rx_entry)
+{
+	struct smr_cma_batch *batch = &ep->cma_batch;
+	struct smr_cma_batch_entry *entry;
+	size_t local_cnt = rx_entry->count;
+	size_t remote_cnt = cmd->msg.data.iov_count;
+
+	if (cmd->msg.hdr.op != ofi_op_msg && cmd->msg.hdr.op != ofi_op_tagged)
+		return false;
+
+	if (batch->count && (batch->id != cmd->msg.hdr.id ||
+	    batch->count == SMR_CMA_BATCH_MAX ||
+	    batch->local_cnt + local_cnt > SMR_CMA_BATCH_IOV ||
+	    batch->remote_cnt + remote_cnt > SMR_CMA_BATCH_IOV))
+		smr_cma_batch_flush(ep);
+
+	if (local_cnt > SMR_CMA_BATCH_IOV || remote_cnt > SMR_CMA_BATCH_IOV)
+		return false;
+
+	memcpy(&batch->local[batch->local_cnt], rx_entry->iov,
+	       sizeof(*rx_entry->iov) * local_cnt);
+	if (ofi_truncate_iov(&batch->local[batch->local_cnt], &local_cnt,
+			     cmd->msg.hdr.size))
+		return false;
+
+	memcpy(&batch->remote[batch->remote_cnt], cmd_iov,
+	       sizeof(struct iovec) * remote_cnt);
+
+	entry = &batch->entry[batch->count++];
+	entry->hdr = cmd->msg.hdr;
+	entry->rx_entry = rx_entry;
+	entry->local_idx = batch->local_cnt;
+	entry->local_cnt = local_cnt;
+	entry->remote_idx = batch->remote_cnt;
+	entry->remote_cnt = remote_cnt;
+
+	batch->id = cmd->msg.hdr.id;
+	batch->local_cnt += local_cnt;
+	batch->remote_cnt += remote_cnt;
+	batch->total_len += cmd->msg.hdr.size;
+	return true;
+}
+
+/* cmd_iov holds the remote iovs of a smr_src_iov message */
+static int smr_start_common(struct smr_ep *ep, struct smr_cmd *cmd,
+		struct iovec *cmd_iov, struct fi_peer_rx_entry *rx_entry,
+		bool batch)
+{
+	struct smr_pend_entry *pend = NULL;
+	size_t total_len = 0;
 	int err = 0;
 
+	if (batch && cmd->msg.hdr.op_src == smr_src_iov &&
+	    smr_cma_batch_add(ep, cmd, cmd_iov, rx_entry))
+		return 0;
+
+	/* keep completions in the order the messages arrived */
+	if (batch)
+		smr_cma_batch_flush(ep);
+
 	switch (cmd->msg.hdr.op_src) {
 	case smr_src_inline:
 		err = smr_progress_inline(cmd,
@@ -734,8 +1033,13 @@ static int smr_start_common(struct smr_ep *ep, struct smr_cmd *cmd,
 				ep, 0);
 		break;
 	case smr_src_iov:
-		err = smr_progress_iov(cmd, rx_entry->iov, rx_entry->count,
-				       &total_len, ep);
+		err = smr_progress_iov(cmd, cmd_iov, rx_entry->iov,
+				       rx_entry->count, &total_len, ep);
+		break;
+	case smr_src_memfd:
+		err = smr_progress_memfd(cmd, (struct ofi_mr **) rx_entry->desc,
+					 rx_entry->iov, rx_entry->count,
+					 &total_len, ep);
 		break;
 	case smr_src_mmap:
 		err = smr_progress_mmap(cmd, (struct ofi_mr **) rx_entry->desc,
@@ -760,29 +1064,8 @@ static int smr_start_common(struct smr_ep *ep, struct smr_cmd *cmd,
 		err = -FI_EINVAL;
 	}
 
-	if (!pend) {
-		comp_buf = rx_entry->iov[0].iov_base;
-		comp_flags = smr_rx_cq_flags(rx_entry->flags,
-					     cmd->msg.hdr.op_flags);
-		if (err) {
-			FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
-				"error processing op\n");
-			ret = smr_write_err_comp(ep->util_ep.rx_cq,
-						 rx_entry->context,
-						 comp_flags, rx_entry->tag,
-						 -err);
-		} else {
-			ret = smr_complete_rx(ep, rx_entry->context, cmd->msg.hdr.op,
-					      comp_flags, total_len, comp_buf,
-					      cmd->msg.hdr.id, cmd->msg.hdr.tag,
-					      cmd->msg.hdr.data);
-		}
-		if (ret) {
-			FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
-				"unable to process rx completion\n");
-		}
-		ep->srx->owner_ops->free_entry(rx_entry);
-	}
+	if (!pend)
+		smr_start_complete(ep, &cmd->msg.hdr, rx_entry, total_len, err);
 
 	return 0;
 }
@@ -849,8 +1132,15 @@ int smr_unexp_start(struct fi_peer_rx_entry *rx_entry)
 	if (cmd_ctx->cmd.msg.hdr.op_src == smr_src_sar ||
 	    cmd_ctx->cmd.msg.hdr.op_src == smr_src_inject)
 		ret = smr_copy_saved(cmd_ctx, rx_entry);
-	else
-		ret = smr_start_common(cmd_ctx->ep, &cmd_ctx->cmd, rx_entry);
+	else if (cmd_ctx->cmd.msg.hdr.op_src == smr_src_iov) {
+		ret = smr_start_common(cmd_ctx->ep, &cmd_ctx->cmd,
+				       smr_cmd_ctx_iov(cmd_ctx), rx_entry,
+				       false);
+		smr_free_cmd_ctx_iov(cmd_ctx);
+	} else {
+		ret = smr_start_common(cmd_ctx->ep, &cmd_ctx->cmd, NULL,
+				       rx_entry, false);
+	}
 
 	dlist_remove(&cmd_ctx->entry);
 	ofi_buf_free(cmd_ctx);
@@ -974,6 +1264,22 @@ static int smr_alloc_cmd_ctx(struct smr_ep *ep,
 
 			cmd_ctx->sar_entry = sar_entry;
 		}
+	} else if (cmd->msg.hdr.op_src == smr_src_iov &&
+		   cmd->msg.data.iov_count > SMR_IOV_INLINE) {
+		memcpy(&cmd_ctx->cmd, cmd, sizeof(*cmd));
+		buf = ofi_buf_alloc(ep->unexp_buf_pool);
+		if (!buf) {
+			FI_WARN(&smr_prov, FI_LOG_EP_CTRL,
+				"Error allocating buffer\n");
+			ofi_buf_free(cmd_ctx);
+			return -FI_ENOMEM;
+		}
+		cmd_ctx->sar_entry = NULL;
+		slist_init(&cmd_ctx->buf_list);
+		slist_insert_tail(&buf->entry, &cmd_ctx->buf_list);
+		memcpy(buf->buf, smr_cmd_iov(ep->region, cmd),
+		       sizeof(struct iovec) * cmd->msg.data.iov_count);
+		smr_release_cmd_iov(ep->region, cmd);
 	} else {
 		memcpy(&cmd_ctx->cmd, cmd, sizeof(*cmd));
 	}
@@ -1029,7 +1335,13 @@ static int smr_progress_cmd_msg(struct smr_ep *ep, struct smr_cmd *cmd)
 		FI_WARN(&smr_prov, FI_LOG_EP_CTRL, "Error getting rx_entry\n");
 		return ret;
 	}
-	ret = smr_start_common(ep, cmd, rx_entry);
+	if (cmd->msg.hdr.op_src == smr_src_iov) {
+		ret = smr_start_common(ep, cmd, smr_cmd_iov(ep->region, cmd),
+				       rx_entry, true);
+		smr_release_cmd_iov(ep->region, cmd);
+	} else {
+		ret = smr_start_common(ep, cmd, NULL, rx_entry, true);
+	}
 
 out:
 	return ret < 0 ? ret : 0;
@@ -1083,7 +1395,13 @@ static int smr_progress_cmd_rma(struct smr_ep *ep, struct smr_cmd *cmd,
 		}
 		break;
 	case smr_src_iov:
-		err = smr_progress_iov(cmd, iov, iov_count, &total_len, ep);
+		err = smr_progress_iov(cmd, smr_cmd_iov(ep->region, cmd), iov,
+				       iov_count, &total_len, ep);
+		smr_release_cmd_iov(ep->region, cmd);
+		break;
+	case smr_src_memfd:
+		err = smr_progress_memfd(cmd, mr, iov, iov_count, &total_len,
+					 ep);
 		break;
 	case smr_src_mmap:
 		err = smr_progress_mmap(cmd, mr, iov, iov_count, &total_len,
@@ -1235,6 +1553,9 @@ static void smr_progress_cmd(struct smr_ep *ep)
 		ret = smr_cmd_queue_head(smr_cmd_queue(ep->region), &ce, &pos);
 		if (ret == -FI_ENOENT)
 			break;
+		if (ce->cmd.msg.hdr.op != ofi_op_msg &&
+		    ce->cmd.msg.hdr.op != ofi_op_tagged)
+			smr_cma_batch_flush(ep);
 		switch (ce->cmd.msg.hdr.op) {
 		case ofi_op_msg:
 		case ofi_op_tagged:
@@ -1244,6 +1565,7 @@ static void smr_progress_cmd(struct smr_ep *ep)
 		case ofi_op_read_req:
 			ret = smr_progress_cmd_rma(ep, &ce->cmd,
 				&ce->rma_cmd);
+			smr_ring_peer(ep, ce->cmd.msg.hdr.id);
 			break;
 		case ofi_op_write_async:
 		case ofi_op_read_async:
@@ -1255,6 +1577,7 @@ static void smr_progress_cmd(struct smr_ep *ep)
 		case ofi_op_atomic_compare:
 			ret = smr_progress_cmd_atomic(ep, &ce->cmd,
 				&ce->rma_cmd);
+			smr_ring_peer(ep, ce->cmd.msg.hdr.id);
 			break;
 		case SMR_OP_MAX + ofi_ctrl_connreq:
 			smr_progress_connreq(ep, &ce->cmd);
@@ -1273,6 +1596,7 @@ static void smr_progress_cmd(struct smr_ep *ep)
 			break;
 		}
 	}
+	smr_cma_batch_flush(ep);
 	ofi_genlock_unlock(&ep->util_ep.lock);
 }
 
@@ -1330,6 +1654,7 @@ void smr_progress_ipc_list(struct smr_ep *ep)
 		 * buffer is now free to be reused
 		 */
 		resp->status = SMR_STATUS_SUCCESS;
+		smr_ring(peer_smr);
 
 		ofi_mr_cache_delete(domain->ipc_cache, ipc_entry->ipc_entry);
 		ofi_free_async_copy_event(iface, device,
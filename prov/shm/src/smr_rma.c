@@ -94,7 +94,7 @@ static ssize_t smr_rma_fast(struct smr_ep *ep, struct smr_region *peer_smr,
 	smr_format_rma_resp(&ce->cmd, peer_id, rma_iov, rma_count, total_len,
 			    (op == ofi_op_write) ? ofi_op_write_async :
 			    ofi_op_read_async, op_flags);
-	smr_cmd_queue_commit(ce, pos);
+	smr_commit_cmd(peer_smr, ce, pos);
 	return FI_SUCCESS;
 }
 
@@ -113,7 +113,7 @@ static ssize_t smr_generic_rma(struct smr_ep *ep, const struct iovec *iov,
 	int64_t pos;
 
 	assert(iov_count <= SMR_IOV_LIMIT);
-	assert(rma_count <= SMR_IOV_LIMIT);
+	assert(rma_count <= SMR_RMA_IOV_LIMIT);
 	assert(ofi_total_iov_len(iov, iov_count) ==
 	       ofi_total_rma_iov_len(rma_iov, rma_count));
 
@@ -171,7 +171,8 @@ static ssize_t smr_generic_rma(struct smr_ep *ep, const struct iovec *iov,
 	assert(!(op_flags & FI_INJECT) || total_len <= SMR_INJECT_SIZE);
 
 	proto = smr_select_proto(desc, iov_count, smr_vma_enabled(ep, peer_smr),
-	                         smr_ipc_valid(ep, peer_smr, id, peer_id), op,
+	                         smr_ipc_valid(ep, peer_smr, id, peer_id),
+				 smr_memfd_valid(peer_smr, peer_id), op,
 				 total_len, op_flags);
 
 	ret = smr_proto_ops[proto](ep, peer_smr, id, peer_id, op, 0, data,
@@ -183,7 +184,7 @@ static ssize_t smr_generic_rma(struct smr_ep *ep, const struct iovec *iov,
 	}
 
 	smr_add_rma_cmd(peer_smr, rma_iov, rma_count, ce);
-	smr_cmd_queue_commit(ce, pos);
+	smr_commit_cmd(peer_smr, ce, pos);
 
 	if (proto != smr_src_inline && proto != smr_src_inject)
 		goto unlock;
@@ -362,7 +363,7 @@ static ssize_t smr_generic_rma_inject(struct fid_ep *ep_fid, const void *buf,
 		return -FI_EAGAIN;
 	}
 	smr_add_rma_cmd(peer_smr, &rma_iov, 1, ce);
-	smr_cmd_queue_commit(ce, pos);
+	smr_commit_cmd(peer_smr, ce, pos);
 
 out:
 	if (!ret)
@@ -89,6 +89,40 @@ void smr_cma_check(struct smr_region *smr, struct smr_region *peer_smr)
 	}
 }
 
+/* Whether we may import fds from the peer, either through
+ * pidfd_getfd() (which fails with EBADF for an invalid fd only once the
+ * ptrace attach check has passed) or through /proc/<pid>/fd (which only
+ * needs ptrace read access, like /proc/<pid>/exe).
+ */
+static bool smr_memfd_probe(pid_t pid)
+{
+	char path[64], link[64];
+	int pidfd, ret;
+
+	pidfd = ofi_pidfd_open(pid, 0);
+	if (pidfd >= 0) {
+		ret = ofi_pidfd_getfd(pidfd, -1, 0);
+		close(pidfd);
+		if (ret < 0 && errno == EBADF)
+			return true;
+	}
+
+	snprintf(path, sizeof(path), "/proc/%d/exe", pid);
+	return readlink(path, link, sizeof(link)) >= 0;
+}
+
+/* Record whether this region can map the memfd regions of peer id.
+ * Senders check the entry kept for them in the receiver's region, see
+ * smr_memfd_valid().
+ */
+static void smr_set_memfd_valid(struct smr_region *region,
+				struct smr_region *peer_smr, int64_t id)
+{
+	smr_peer_data(region)[id].memfd_valid =
+		(region->flags & SMR_FLAG_MEMFD) &&
+		(region == peer_smr || smr_memfd_probe(peer_smr->pid));
+}
+
 size_t smr_calculate_size_offsets(size_t tx_count, size_t rx_count,
 				  size_t *cmd_offset, size_t *resp_offset,
 				  size_t *inject_offset, size_t *sar_offset,
@@ -187,6 +221,30 @@ static void smr_lock_init(pthread_spinlock_t *lock)
 	pthread_spin_init(lock, PTHREAD_PROCESS_SHARED);
 }
 
+/* Everything in the region is written by peers and read by its owner,
+ * so place it on the owner's node before any of it is touched.  Returns
+ * the node, or -1 if the region was left to the default policy.
+ */
+static int smr_numa_bind(const struct fi_provider *prov, void *addr,
+			 size_t size)
+{
+	int node, ret;
+
+	node = ofi_numa_node();
+	if (node < 0)
+		return -1;
+
+	ret = ofi_mbind_preferred(addr, size, node);
+	if (ret) {
+		if (ret != -FI_EALREADY)
+			FI_INFO(prov, FI_LOG_EP_CTRL,
+				"unable to bind shm region to node %d: %s\n",
+				node, fi_strerror(-ret));
+		return -1;
+	}
+	return node;
+}
+
 /* TODO: Determine if aligning SMR data helps performance */
 int smr_create(const struct fi_provider *prov, struct smr_map *map,
 	       const struct smr_attr *attr, struct smr_region *volatile *smr)
@@ -195,7 +253,7 @@ int smr_create(const struct fi_provider *prov, struct smr_map *map,
 	size_t total_size, cmd_queue_offset, peer_data_offset;
 	size_t resp_queue_offset, inject_pool_offset, name_offset;
 	size_t sar_pool_offset, sock_name_offset;
-	int fd, ret, i;
+	int fd, ret, i, numa_node;
 	void *mapped_addr;
 	size_t tx_size, rx_size;
 
@@ -254,6 +312,9 @@ int smr_create(const struct fi_provider *prov, struct smr_map *map,
 
 	close(fd);
 
+	numa_node = smr_env.numa_bind ?
+		    smr_numa_bind(prov, mapped_addr, total_size) : -1;
+
 	if (attr->flags & SMR_FLAG_HMEM_ENABLED) {
 		ret = ofi_hmem_host_register(mapped_addr, total_size);
 		if (ret)
@@ -298,6 +359,7 @@ int smr_create(const struct fi_provider *prov, struct smr_map *map,
 	(*smr)->name_offset = name_offset;
 	(*smr)->sock_name_offset = sock_name_offset;
 	(*smr)->max_sar_buf_per_peer = SMR_BUF_BATCH_MAX;
+	(*smr)->numa_node = numa_node;
 
 	smr_cmd_queue_init(smr_cmd_queue(*smr), rx_size);
 	smr_resp_queue_init(smr_resp_queue(*smr), tx_size);
@@ -309,10 +371,12 @@ int smr_create(const struct fi_provider *prov, struct smr_map *map,
 		smr_peer_data(*smr)[i].addr.id = -1;
 		smr_peer_data(*smr)[i].sar_status = 0;
 		smr_peer_data(*smr)[i].name_sent = 0;
+		smr_peer_data(*smr)[i].memfd_valid = 0;
 		smr_peer_data(*smr)[i].xpmem.cap = SMR_VMA_CAP_OFF;
 	}
 
 	strncpy((char *) smr_name(*smr), attr->name, total_size - name_offset);
+	ofi_doorbell_init(&(*smr)->doorbell);
 
 	/* Must be set last to signal full initialization to peers */
 	(*smr)->pid = getpid();
@@ -405,6 +469,14 @@ int smr_map_to_region(const struct fi_provider *prov, struct smr_map *map,
 		goto out;
 	}
 
+	if (peer->version != SMR_VERSION) {
+		FI_WARN(prov, FI_LOG_AV, "peer region version %d, expected %d\n",
+			peer->version, SMR_VERSION);
+		munmap(peer, sizeof(*peer));
+		ret = -FI_ENOENT;
+		goto out;
+	}
+
 	size = peer->total_size;
 	munmap(peer, sizeof(*peer));
 
@@ -473,6 +545,7 @@ void smr_map_to_endpoint(struct smr_region *region, int64_t id)
 	}
 
 	smr_set_ipc_valid(region, id);
+	smr_set_memfd_valid(region, peer_smr, id);
 
 	return;
 }
@@ -540,6 +613,7 @@ void smr_unmap_from_endpoint(struct smr_region *region, int64_t id)
 	peer_peers[peer_id].name_sent = 0;
 
 	local_peers = smr_peer_data(region);
+	local_peers[id].memfd_valid = 0;
 	ofi_xpmem_release(&local_peers[peer_id].xpmem);
 }
 
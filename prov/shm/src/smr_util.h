@@ -47,6 +47,7 @@
 #include <ofi_tree.h>
 #include <ofi_hmem.h>
 #include <ofi_atomic_queue.h>
+#include <ofi_doorbell.h>
 
 #include <rdma/providers/fi_prov.h>
 
@@ -54,12 +55,13 @@
 extern "C" {
 #endif
 
-#define SMR_VERSION	8
+#define SMR_VERSION	9
 
 #define SMR_FLAG_ATOMIC	(1 << 0)
 #define SMR_FLAG_DEBUG	(1 << 1)
 #define SMR_FLAG_IPC_SOCK (1 << 2)
 #define SMR_FLAG_HMEM_ENABLED (1 << 3)
+#define SMR_FLAG_MEMFD	(1 << 4)	/* can map peers' memfd regions */
 
 #define SMR_CMD_SIZE		256	/* align with 64-byte cache line */
 
@@ -71,6 +73,7 @@ enum {
 	smr_src_mmap,	/* mmap-based fallback protocol */
 	smr_src_sar,	/* segmentation fallback protocol */
 	smr_src_ipc,	/* device IPC handle protocol */
+	smr_src_memfd,	/* peer maps sender's memfd-backed region */
 	smr_src_max,
 };
 
@@ -83,8 +86,9 @@ enum {
 #define SMR_TX_COMPLETION	(1 << 2)
 #define SMR_RX_COMPLETION	(1 << 3)
 #define SMR_MULTI_RECV		(1 << 4)
+#define SMR_MMAP_POOL		(1 << 5)
 
-/* CMA/XPMEM capability. Generic acronym used:
+/* CMA/XPMEM/memfd capability. Generic acronym used:
  * VMA: Virtual Memory Address */
 enum {
 	SMR_VMA_CAP_NA,
@@ -122,19 +126,36 @@ struct smr_msg_hdr {
 
 #define SMR_BUF_BATCH_MAX	64
 #define SMR_MSG_DATA_LEN	(SMR_CMD_SIZE - sizeof(struct smr_msg_hdr))
+#define SMR_IOV_INLINE		((SMR_MSG_DATA_LEN - sizeof(size_t)) / \
+				 sizeof(struct iovec))
 
 union smr_cmd_data {
 	uint8_t			msg[SMR_MSG_DATA_LEN];
 	struct {
 		size_t		iov_count;
-		struct iovec	iov[(SMR_MSG_DATA_LEN - sizeof(size_t)) /
-				    sizeof(struct iovec)];
+		union {
+			struct iovec	iov[SMR_IOV_INLINE];
+			/* offset of the inject buffer holding the iovs
+			 * when iov_count > SMR_IOV_INLINE */
+			uint64_t	iov_buf;
+		};
 	};
 	struct {
 		uint32_t	buf_batch_size;
 		int16_t		sar[SMR_BUF_BATCH_MAX];
 	};
 	struct ipc_info		ipc_info;
+	struct {
+		uint64_t	offset;
+		int64_t		pool_id;
+	} mmap;
+	struct {
+		struct ofi_memfd_handle	handle;
+		/* page aligned range of the sender's region to map */
+		uint64_t	base_addr;
+		uint64_t	base_length;
+		uint64_t	addr;
+	} memfd;
 };
 
 struct smr_cmd_msg {
@@ -182,6 +203,7 @@ struct smr_peer_data {
 	uint32_t		sar_status;
 	uint16_t		name_sent;
 	uint16_t		ipc_valid;
+	uint16_t		memfd_valid;
 	struct ofi_xpmem_client xpmem;
 };
 
@@ -234,6 +256,7 @@ struct smr_region {
 	uint8_t		resv2;
 
 	uint32_t	max_sar_buf_per_peer;
+	int		numa_node; /* node the region is placed on, or -1 */
 	struct ofi_xpmem_pinfo	xpmem_self;
 	struct ofi_xpmem_pinfo	xpmem_peer;
 	void		*base_addr;
@@ -241,6 +264,8 @@ struct smr_region {
 				 if both ep->tx_lock and this lock need to
 				 held, then ep->tx_lock needs to be held
 				 first */
+	struct ofi_doorbell	doorbell; /* rung by peers posting to this
+					     region while its owner sleeps */
 
 	struct smr_map	*map;
 
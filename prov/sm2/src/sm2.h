@@ -75,10 +75,16 @@
 #define SM2_IOV_LIMIT		4
 #define SM2_PREFIX		"fi_sm2://"
 #define SM2_PREFIX_NS		"fi_ns://"
-#define SM2_VERSION		1
+#define SM2_VERSION		2
 #define SM2_IOV_LIMIT		4
 #define SM2_INJECT_SIZE		(SM2_XFER_ENTRY_SIZE - sizeof(struct sm2_xfer_hdr))
 
+/* A blocking wait polls sm2_wait_spin times (FI_SM2_WAIT_SPIN) before
+ * sleeping on the region's doorbell, for at most SM2_WAIT_SLEEP_MAX ms
+ * at a time.
+ */
+#define SM2_WAIT_SLEEP_MAX	10
+
 #define SM2_ATOMIC_INJECT_SIZE	    (SM2_INJECT_SIZE - sizeof(struct sm2_atomic_hdr))
 #define SM2_ATOMIC_COMP_INJECT_SIZE (SM2_ATOMIC_INJECT_SIZE / 2)
 
@@ -88,6 +94,7 @@ extern struct util_prov sm2_util_prov;
 extern int sm2_global_ep_idx; // protected by the ep_list_lock
 
 extern pthread_mutex_t sm2_ep_list_lock;
+extern int sm2_wait_spin;
 
 enum {
 	sm2_proto_inject,
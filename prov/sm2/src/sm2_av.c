@@ -82,8 +82,6 @@ static int sm2_av_insert(struct fid_av *av_fid, const void *addr, size_t count,
 	util_av = container_of(av_fid, struct util_av, av_fid);
 	sm2_av = container_of(util_av, struct sm2_av, util_av);
 
-	sm2_file_lock(&sm2_av->mmap);
-
 	for (i = 0; i < count; i++, addr = (char *) addr + strlen(addr) + 1) {
 		ret = sm2_entry_allocate(addr, &sm2_av->mmap, &gid, false);
 		FI_DBG(&sm2_prov, FI_LOG_AV,
@@ -114,8 +112,6 @@ static int sm2_av_insert(struct fid_av *av_fid, const void *addr, size_t count,
 		succ_count++;
 	}
 
-	sm2_file_unlock(&sm2_av->mmap);
-
 	dlist_foreach (&util_av->ep_list, av_entry) {
 		util_ep = container_of(av_entry, struct util_ep, av_entry);
 		sm2_ep = container_of(util_ep, struct sm2_ep, util_ep);
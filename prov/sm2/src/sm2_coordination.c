@@ -34,6 +34,7 @@
 #include "sm2.h"
 #include "sm2_atom.h"
 #include <fcntl.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/mman.h>
@@ -45,10 +46,12 @@
 #define ZOMBIE_ALLOCATION_NAME	 "ZOMBIE"
 #define SM2_COORDINATION_DIR	 "/dev/shm"
 #define SM2_COORDINATION_FILE	 SM2_COORDINATION_DIR "/fi_sm2_mmaps"
-#define SM2_STARTUP_MAX_TRIES	 1000
+/* The file lock is only held to open the file, so retry often */
+#define SM2_STARTUP_RETRY_USEC	 100
+#define SM2_STARTUP_MAX_TRIES	 100000
 
 static void sm2_file_attempt_shrink(struct sm2_mmap *map);
-int sm2_entry_lookup(const char *name, struct sm2_mmap *map);
+static void sm2_entries_init(struct sm2_ep_allocation_entry *entries);
 
 /*
  * Sends signal 0 to the pid, if the call succeeds, it means the pid exists.
@@ -195,7 +198,7 @@ ssize_t sm2_file_open_or_create(struct sm2_mmap *map_shared)
 	char template[template_len];
 	struct sm2_coord_file_header *header, *tmp_header;
 	struct sm2_ep_allocation_entry *entries;
-	int fd, common_fd, err, tries, item;
+	int fd, common_fd, err, tries;
 	bool have_file_lock = false;
 	long int page_size;
 	long int max_file_size;
@@ -249,9 +252,7 @@ ssize_t sm2_file_open_or_create(struct sm2_mmap *map_shared)
 		goto early_exit;
 
 	header = (struct sm2_coord_file_header *) map_ours.base;
-	entries = sm2_mmap_entries(&map_ours);
-	for (item = 0; item < SM2_MAX_UNIVERSE_SIZE; item++)
-		entries[item].pid = 0;
+	sm2_entries_init(sm2_mmap_entries(&map_ours));
 
 	/* Make sure the header is written before we link the file,
 	 * flush file
@@ -299,8 +300,7 @@ ssize_t sm2_file_open_or_create(struct sm2_mmap *map_shared)
 			sm2_mmap_cleanup(map_shared);
 		}
 		/* we could not acquire the lock, sleep and try again. */
-		/* TODO Consider reducing the amount of time we sleep here */
-		usleep(10000);
+		usleep(SM2_STARTUP_RETRY_USEC);
 	} while (tries-- > 0);
 
 	unlink(template);
@@ -334,190 +334,316 @@ early_exit:
 	return -FI_ENOMEM;
 }
 
+static inline int sm2_name_hash(const char *name)
+{
+	uint32_t hash = 2166136261u;
+	int i;
+
+	/* FNV-1a */
+	for (i = 0; i < OFI_NAME_MAX && name[i]; i++)
+		hash = (hash ^ (uint8_t) name[i]) * 16777619u;
+
+	return hash & (SM2_MAX_UNIVERSE_SIZE - 1);
+}
+
+static void sm2_entries_init(struct sm2_ep_allocation_entry *entries)
+{
+	int item;
+
+	for (item = 0; item < SM2_MAX_UNIVERSE_SIZE; item++) {
+		ofi_atomic_initialize32(&entries[item].state, SM2_SLOT_EMPTY);
+		entries[item].pid = 0;
+	}
+}
+
+static void sm2_slot_release(struct sm2_ep_allocation_entry *entry)
+{
+	atomic_wmb();
+	ofi_atomic_set32(&entry->state, SM2_SLOT_READY);
+}
+
+/*
+ * Take a ready slot to update it.  A slot left busy by a process that died
+ * while writing it is taken over, and becomes a zombie since its contents
+ * cannot be trusted.
+ */
+static void sm2_slot_acquire(struct sm2_ep_allocation_entry *entry)
+{
+	int32_t state;
+
+	while (1) {
+		state = ofi_atomic_get32(&entry->state);
+		if (state == SM2_SLOT_READY &&
+		    ofi_atomic_cas_bool32(&entry->state, state, getpid()))
+			break;
+
+		if (state > 0 && !pid_lives(state) &&
+		    ofi_atomic_cas_bool32(&entry->state, state, getpid())) {
+			strncpy(entry->ep_name, ZOMBIE_ALLOCATION_NAME,
+				OFI_NAME_MAX);
+			break;
+		}
+		sched_yield();
+	}
+	atomic_rmb();
+}
+
+/* Wait for a slot to be empty or ready, and return which. */
+static int32_t sm2_slot_wait(struct sm2_ep_allocation_entry *entry)
+{
+	int32_t state;
+
+	while ((state = ofi_atomic_get32(&entry->state)) > 0) {
+		if (!pid_lives(state)) {
+			sm2_slot_acquire(entry);
+			sm2_slot_release(entry);
+		} else {
+			sched_yield();
+		}
+	}
+	atomic_rmb();
+	return state;
+}
+
 /*
- * Insert the name into the ep_allocation array.  Requires the lock.
+ * Find the name in the directory, probing linearly from its hash.  Since
+ * slots are never emptied, reaching an empty slot means the name is not
+ * there, and with insert the slot is claimed for it.  Processes inserting
+ * the same name race for the same empty slot, and the losers find the
+ * winner's entry when they look at it again.
  *
- * Note: that because of speculative av_insert operations, we may need to
- * assign an index for an endpoint claimed by another peer.
- * When self == true, we will "own" the entry (entry.pid = getpid()).
- * When False, we set pid = -getpid(), allowing owner to claim later.
+ * Returns the slot, -FI_ENOENT if the name was not found, or -FI_EAVAIL
+ * if it was not found and every slot is in use.
  */
-ssize_t sm2_entry_allocate(const char *name, struct sm2_mmap *map,
-			   sm2_gid_t *gid, bool self)
+static int sm2_entry_lookup(const char *name, struct sm2_mmap *map,
+			    bool insert)
 {
 	struct sm2_ep_allocation_entry *entries;
-	struct sm2_region *peer_region = NULL;
-	int item, pid = getpid(), peer_pid;
+	int i, item, hash;
 
 	entries = sm2_mmap_entries(map);
+	hash = sm2_name_hash(name);
+	for (i = 0; i < SM2_MAX_UNIVERSE_SIZE; i++) {
+		item = (hash + i) & (SM2_MAX_UNIVERSE_SIZE - 1);
+		if (sm2_slot_wait(&entries[item]) == SM2_SLOT_EMPTY) {
+			if (!insert)
+				return -FI_ENOENT;
+
+			if (ofi_atomic_cas_bool32(&entries[item].state,
+						  SM2_SLOT_EMPTY, getpid())) {
+				/* as if inserted into our AV, so that the slot
+				 * is never unowned until we claim it
+				 */
+				entries[item].pid = -getpid();
+				entries[item].startup_ready = false;
+				strncpy(entries[item].ep_name, name,
+					OFI_NAME_MAX - 1);
+				entries[item].ep_name[OFI_NAME_MAX - 1] = '\0';
+				sm2_slot_release(&entries[item]);
+				FI_DBG(&sm2_prov, FI_LOG_AV,
+				       "Inserted %s in slot %d\n", name, item);
+				return item;
+			}
+			sm2_slot_wait(&entries[item]);
+		}
 
-retry_lookup:
-	item = sm2_entry_lookup(name, map);
-	if (item >= 0) {
-		entries = sm2_mmap_entries(map);
+		if (!strncmp(name, entries[item].ep_name, OFI_NAME_MAX)) {
+			FI_DBG(&sm2_prov, FI_LOG_AV,
+			       "Found existing %s in slot %d\n", name, item);
+			return item;
+		}
+	}
+	return -FI_EAVAIL;
+}
+
+/*
+ * Every slot has been used: give the name the slot of an endpoint that is
+ * gone.  This is the only place a slot changes names (other than to become
+ * a zombie), and it takes the file lock so that processes recycling a slot
+ * for the same name agree on it.
+ */
+static int sm2_entry_recycle(const char *name, struct sm2_mmap *map)
+{
+	struct sm2_ep_allocation_entry *entries;
+	struct sm2_region *peer_region;
+	int item, peer_pid;
+
+	sm2_file_lock(map);
+	item = sm2_entry_lookup(name, map, false);
+	if (item != -FI_EAVAIL)
+		goto out;
 
-		/* Check if it is dirty */
-		if (entries[item].pid && !pid_lives(abs(entries[item].pid))) {
+	entries = sm2_mmap_entries(map);
+	for (item = 0; item < SM2_MAX_UNIVERSE_SIZE; item++) {
+		sm2_slot_acquire(&entries[item]);
+		peer_pid = entries[item].pid;
+		if (peer_pid > 0 && !pid_lives(peer_pid)) {
 			peer_region = sm2_mmap_ep_region(map, item);
-			if (!smr_freestack_isfull(sm2_freestack(peer_region))) {
-				/* Region did not shut down properly, but other
-				 * processes might be using it, make it a zombie
-				 * region - never use this region for as long as
-				 * the file exists */
-				FI_WARN(&sm2_prov, FI_LOG_AV,
-					"Found region at allocation[%d] that "
-					"did not  shut down correctly, marking "
-					"it as a zombie never to be used again "
-					"(until all active processes die, and "
-					"file size is reset)!\n",
-					item);
-				strncpy(entries[item].ep_name,
-					ZOMBIE_ALLOCATION_NAME, OFI_NAME_MAX);
-				goto retry_lookup;
-			}
+			/* we found a slot with a dead PID and the freestack
+			 * is full */
+			if (entries[item].startup_ready &&
+			    smr_freestack_isfull(sm2_freestack(peer_region)))
+				entries[item].pid = peer_pid = 0;
 		}
 
-		if (!self) {
-			if (!pid_lives(abs(entries[item].pid))) {
-				entries[item].pid = 0;
-			}
-			/* Someone else allocated the entry for us */
-			goto found;
+		/* A negative pid means that a third peer might have entered
+		 * this address into their AV, and there is no current way to
+		 * check this... need to keep this entry in the file until we
+		 * clean up
+		 */
+		if (peer_pid == 0 && strcmp(entries[item].ep_name,
+					    ZOMBIE_ALLOCATION_NAME)) {
+			entries[item].pid = -getpid();
+			entries[item].startup_ready = false;
+			strncpy(entries[item].ep_name, name, OFI_NAME_MAX - 1);
+			entries[item].ep_name[OFI_NAME_MAX - 1] = '\0';
+			sm2_slot_release(&entries[item]);
+			goto out;
 		}
+		sm2_slot_release(&entries[item]);
+	}
+	item = -FI_EAVAIL;
+out:
+	sm2_file_unlock(map);
+	return item;
+}
 
-		if (entries[item].pid <= 0) {
-			if (!pid_lives(abs(entries[item].pid))) {
-				FI_WARN(&sm2_prov, FI_LOG_AV,
-					"During sm2 allocation of space for "
-					"endpoint named %s pid %d "
-					"pre-allocated space at allocation "
-					"entry[%d] and then died!\n",
-					name, -entries[item].pid, item);
-			}
-			goto found;
-		}
+/*
+ * Find or insert the name in the directory, and claim its entry.
+ *
+ * Note: that because of speculative av_insert operations, we may need to
+ * assign an index for an endpoint claimed by another peer.
+ * When self == true, we will "own" the entry (entry.pid = getpid()).
+ * When False, we set pid = -getpid(), allowing owner to claim later.
+ */
+ssize_t sm2_entry_allocate(const char *name, struct sm2_mmap *map,
+			   sm2_gid_t *gid, bool self)
+{
+	struct sm2_ep_allocation_entry *entry;
+	struct sm2_region *peer_region = NULL;
+	int item, pid = getpid();
 
+retry_lookup:
+	item = sm2_entry_lookup(name, map, true);
+	if (item == -FI_EAVAIL)
+		item = sm2_entry_recycle(name, map);
+	if (item == -FI_ENOENT)
+		goto retry_lookup;
+	if (item < 0) {
 		FI_WARN(&sm2_prov, FI_LOG_AV,
-			"During sm2 allocation of space for endpoint named %s "
-			"an existing conflicting address was found at "
-			"allocation entry[%d]\n",
-			name, item);
+			"No available entries were found in the coordination "
+			"file, all %d were used\n",
+			SM2_MAX_UNIVERSE_SIZE);
+		return -FI_EAVAIL;
+	}
 
-		if (!pid_lives(entries[item].pid)) {
+	entry = &sm2_mmap_entries(map)[item];
+	sm2_slot_acquire(entry);
+	if (strncmp(name, entry->ep_name, OFI_NAME_MAX)) {
+		/* became a zombie since the lookup */
+		sm2_slot_release(entry);
+		goto retry_lookup;
+	}
+
+	/* Check if it is dirty */
+	if (entry->pid && !pid_lives(abs(entry->pid))) {
+		peer_region = sm2_mmap_ep_region(map, item);
+		if (!smr_freestack_isfull(sm2_freestack(peer_region))) {
+			/* Region did not shut down properly, but other
+			 * processes might be using it, make it a zombie
+			 * region - never use this region for as long as
+			 * the file exists */
 			FI_WARN(&sm2_prov, FI_LOG_AV,
-				"The pid which allocated the conflicting "
-				"allocation entry is "
-				"dead. Reclaiming as our own.\n");
-			/* it is possible that EP's referencing this region are
-			 * still alive... don't know how to check (they likely
-			 * died if PID died) */
-			goto found;
+				"Found region at allocation[%d] that "
+				"did not  shut down correctly, marking "
+				"it as a zombie never to be used again "
+				"(until all active processes die, and "
+				"file size is reset)!\n",
+				item);
+			strncpy(entry->ep_name, ZOMBIE_ALLOCATION_NAME,
+				OFI_NAME_MAX);
+			sm2_slot_release(entry);
+			goto retry_lookup;
 		}
+	}
 
-		FI_WARN(&sm2_prov, FI_LOG_AV,
-			"ERROR: The endpoint (pid: %d) with conflicting "
-			"address %s is still alive.\n",
-			entries[item].pid, name);
-		return -FI_EADDRINUSE;
+	if (!self) {
+		if (!pid_lives(abs(entry->pid))) {
+			entry->pid = 0;
+		}
+		/* Someone else allocated the entry for us */
+		goto found;
 	}
 
-	/* fine, we could not find the entry, so now look for an empty slot */
-	for (item = 0; item < SM2_MAX_UNIVERSE_SIZE; item++) {
-		peer_pid = entries[item].pid;
-		if (peer_pid == 0)
-			goto found;
-		if (peer_pid < 0)
-			/* A third peer might have entered this address into
-			 * their AV, and there is no current way to check
-			 * this... need to keep this entry in the file until we
-			 * clean up */
-			continue;
+	if (entry->pid <= 0) {
+		if (!pid_lives(abs(entry->pid))) {
+			FI_WARN(&sm2_prov, FI_LOG_AV,
+				"During sm2 allocation of space for "
+				"endpoint named %s pid %d "
+				"pre-allocated space at allocation "
+				"entry[%d] and then died!\n",
+				name, -entry->pid, item);
+		}
+		goto found;
+	}
 
-		if (!pid_lives(peer_pid)) {
-			entries = sm2_mmap_entries(map);
-			struct sm2_region *peer_region =
-				sm2_mmap_ep_region(map, item);
+	FI_WARN(&sm2_prov, FI_LOG_AV,
+		"During sm2 allocation of space for endpoint named %s "
+		"an existing conflicting address was found at "
+		"allocation entry[%d]\n",
+		name, item);
 
-			if (entries[item].startup_ready &&
-			    smr_freestack_isfull(sm2_freestack(peer_region))) {
-				/* we found a slot with a dead PID and
-				 * the freestack is full */
-				entries[item].pid = 0;
-				goto found;
-			}
-		}
+	if (!pid_lives(entry->pid)) {
+		FI_WARN(&sm2_prov, FI_LOG_AV,
+			"The pid which allocated the conflicting "
+			"allocation entry is "
+			"dead. Reclaiming as our own.\n");
+		/* it is possible that EP's referencing this region are
+		 * still alive... don't know how to check (they likely
+		 * died if PID died) */
+		goto found;
 	}
 
 	FI_WARN(&sm2_prov, FI_LOG_AV,
-		"No available entries were found in the coordination file, all "
-		"%d were used\n",
-		SM2_MAX_UNIVERSE_SIZE);
-	return -FI_EAVAIL;
+		"ERROR: The endpoint (pid: %d) with conflicting "
+		"address %s is still alive.\n",
+		entry->pid, name);
+	sm2_slot_release(entry);
+	return -FI_EADDRINUSE;
 
 found:
 	if (self) {
-		entries[item].startup_ready = 0;
-		atomic_wmb();
-		entries[item].pid = pid;
+		entry->startup_ready = 0;
+		entry->pid = pid;
 	}
 
-	if (!self && entries[item].pid == 0) {
-		entries[item].startup_ready = 0;
-		atomic_wmb();
-		entries[item].pid = -pid;
+	if (!self && entry->pid == 0) {
+		entry->startup_ready = 0;
+		entry->pid = -pid;
 	}
+	sm2_slot_release(entry);
 
 	FI_INFO(&sm2_prov, FI_LOG_AV,
 		"Using sm2 region at allocation entry[%d] for %s\n", item,
 		name);
 
-	strncpy(entries[item].ep_name, name, OFI_NAME_MAX - 1);
-	entries[item].ep_name[OFI_NAME_MAX - 1] = '\0';
-
 	*gid = item;
 
 	return 0;
 }
 
-int sm2_entry_lookup(const char *name, struct sm2_mmap *map)
-{
-	struct sm2_ep_allocation_entry *entries;
-	int item;
-
-	entries = sm2_mmap_entries(map);
-	/* TODO Optimize this lookup*/
-	for (item = 0; item < SM2_MAX_UNIVERSE_SIZE; item++) {
-		if (0 == strncmp(name, entries[item].ep_name, OFI_NAME_MAX)) {
-			FI_DBG(&sm2_prov, FI_LOG_AV,
-			       "Found existing %s in slot %d\n", name, item);
-			return item;
-		}
-		if (entries[item].ep_name[0] != '\0') {
-			FI_DBG(&sm2_prov, FI_LOG_AV,
-			       "Searching for %s. Not yet found in spot "
-			       "allocation[%d]=%s, PID=%d\n",
-			       name, item, entries[item].ep_name,
-			       entries[item].pid);
-		} else if (!strcmp(entries[item].ep_name,
-				   ZOMBIE_ALLOCATION_NAME)) {
-			FI_DBG(&sm2_prov, FI_LOG_AV,
-			       "Found zombie in spot allocation[%d], PID= %d\n",
-			       item, entries[item].pid);
-		}
-	}
-	return -1;
-}
-
 /*
- * Clear the pid for this entry.  must already hold lock.
+ * Clear the pid for this entry.
  */
 void sm2_entry_free(struct sm2_mmap *map, sm2_gid_t gid)
 {
-	struct sm2_ep_allocation_entry *entries;
+	struct sm2_ep_allocation_entry *entry;
 
-	entries = sm2_mmap_entries(map);
-	assert(entries[gid].pid == getpid());
-	entries[gid].pid = 0;
+	entry = &sm2_mmap_entries(map)[gid];
+	sm2_slot_acquire(entry);
+	assert(entry->pid == getpid());
+	entry->pid = 0;
+	sm2_slot_release(entry);
 }
 
 void sm2_file_lock(struct sm2_mmap *map)
@@ -590,18 +716,50 @@ static void sm2_file_attempt_shrink(struct sm2_mmap *map)
 {
 	struct sm2_coord_file_header *header = (void *) map->base;
 	struct sm2_ep_allocation_entry *entries = sm2_mmap_entries(map);
+	int32_t state[SM2_MAX_UNIVERSE_SIZE];
 	int item;
 
+	/* Inserts do not take the file lock, so claim every slot before
+	 * looking at it.  A live process holding a slot is in the middle
+	 * of updating it.
+	 */
 	for (item = 0; item < SM2_MAX_UNIVERSE_SIZE; item++) {
+		do {
+			state[item] = ofi_atomic_get32(&entries[item].state);
+			if (state[item] > 0 && pid_lives(state[item])) {
+				FI_INFO(&sm2_prov, FI_LOG_AV,
+					"Cannot shrink file b/c PID %d is "
+					"updating it", state[item]);
+				goto release;
+			}
+		} while (!ofi_atomic_cas_bool32(&entries[item].state,
+						state[item], getpid()));
+
 		if (entries[item].pid != 0 &&
 		    pid_lives(abs(entries[item].pid))) {
 			FI_INFO(&sm2_prov, FI_LOG_AV,
 				"Cannot shrink file b/c PID %d still lives",
 				abs(entries[item].pid));
-			return;
+			item++;
+			goto release;
 		}
 	}
 
 	memset(entries, 0, sizeof(*entries) * SM2_MAX_UNIVERSE_SIZE);
+	sm2_entries_init(entries);
 	sm2_mmap_shrink_to_size(map, header->ep_regions_offset);
+	return;
+
+release:
+	while (item-- > 0) {
+		if (state[item] == SM2_SLOT_EMPTY) {
+			ofi_atomic_set32(&entries[item].state, SM2_SLOT_EMPTY);
+			continue;
+		}
+		/* left busy by a dead process, see sm2_slot_acquire() */
+		if (state[item] > 0)
+			strncpy(entries[item].ep_name, ZOMBIE_ALLOCATION_NAME,
+				OFI_NAME_MAX);
+		sm2_slot_release(&entries[item]);
+	}
 }
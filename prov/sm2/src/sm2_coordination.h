@@ -40,6 +40,7 @@
 #include <sys/un.h>
 
 #include <ofi_atom.h>
+#include <ofi_doorbell.h>
 #include <ofi_hmem.h>
 #include <ofi_mem.h>
 #include <ofi_proto.h>
@@ -49,7 +50,8 @@
 #include <rdma/providers/fi_prov.h>
 
 #define SM2_XFER_ENTRY_SIZE   4096
-#define SM2_MAX_UNIVERSE_SIZE 256
+/* Power of 2: also the size of the hashed directory of endpoint names */
+#define SM2_MAX_UNIVERSE_SIZE 1024
 /* TODO: Tune max GDRCopy size for SM2 */
 #define SM2_MAX_GDRCOPY_SIZE 3072
 /* TODO: Make the number of XFER ENTRY's configurable */
@@ -63,7 +65,17 @@ struct sm2_mmap {
 	int fd;
 };
 
+/* Slot states in the directory.  A slot that is being written holds the
+ * pid of the writer instead.  Slots never go back to empty while the
+ * coordination file exists.
+ */
+enum {
+	SM2_SLOT_EMPTY = 0,
+	SM2_SLOT_READY = -1,
+};
+
 struct sm2_ep_allocation_entry {
+	ofi_atomic32_t state;
 	int pid; /* This is for allocation startup */
 	char ep_name[OFI_NAME_MAX];
 	bool startup_ready; /* TODO Do I need to make atomic */
@@ -89,6 +101,9 @@ struct sm2_region {
 	uint8_t resv;
 	uint16_t flags;
 
+	/* rung by peers writing to recv_queue while the owner sleeps */
+	struct ofi_doorbell doorbell;
+
 	/* offsets from start of sm2_region */
 	ptrdiff_t recv_queue_offset;
 	ptrdiff_t freestack_offset;
@@ -363,11 +363,8 @@ static int sm2_ep_close(struct fid *fid)
 	 */
 	/* TODO Do we want to mark our entry as zombie now if we don't have all
 	   our xfer_entry? */
-	if (smr_freestack_isfull(sm2_freestack(ep->self_region))) {
-		sm2_file_lock(ep->mmap);
+	if (smr_freestack_isfull(sm2_freestack(ep->self_region)))
 		sm2_entry_free(ep->mmap, ep->gid);
-		sm2_file_unlock(ep->mmap);
-	}
 
 	if (ep->xfer_ctx_pool)
 		ofi_bufpool_destroy(ep->xfer_ctx_pool);
@@ -388,6 +385,37 @@ static int sm2_ep_trywait(void *arg)
 	return FI_SUCCESS;
 }
 
+/* Called by a yield wait set in place of sched_yield().  Every message,
+ * including the return of our own sends, arrives through the recv
+ * queue, so the endpoint may sleep whenever it is empty.
+ */
+static int sm2_ep_block(void *arg, int idle, int timeout)
+{
+	struct sm2_ep *ep;
+	struct sm2_region *region;
+	int32_t seq;
+
+	if (sm2_wait_spin < 0 || idle < sm2_wait_spin)
+		return -FI_EAGAIN;
+
+	ep = container_of(arg, struct sm2_ep, util_ep.ep_fid.fid);
+	region = ep->self_region;
+	if (!region)
+		return -FI_EAGAIN;
+
+	seq = ofi_doorbell_arm(&region->doorbell);
+	if (sm2_recv_queue(region)->head != SM2_FIFO_FREE) {
+		ofi_doorbell_disarm(&region->doorbell);
+		return -FI_EAGAIN;
+	}
+
+	if (timeout < 0 || timeout > SM2_WAIT_SLEEP_MAX)
+		timeout = SM2_WAIT_SLEEP_MAX;
+	(void) ofi_doorbell_wait(&region->doorbell, seq, timeout);
+	ofi_doorbell_disarm(&region->doorbell);
+	return FI_SUCCESS;
+}
+
 static int sm2_ep_bind_cq(struct sm2_ep *ep, struct util_cq *cq, uint64_t flags)
 {
 	int ret;
@@ -397,8 +425,9 @@ static int sm2_ep_bind_cq(struct sm2_ep *ep, struct util_cq *cq, uint64_t flags)
 		return ret;
 
 	if (cq->wait) {
-		ret = ofi_wait_add_fid(cq->wait, &ep->util_ep.ep_fid.fid, 0,
-				       sm2_ep_trywait);
+		ret = ofi_wait_add_fid_block(cq->wait,
+					     &ep->util_ep.ep_fid.fid, 0,
+					     sm2_ep_trywait, sm2_ep_block);
 		if (ret)
 			return ret;
 	}
@@ -416,8 +445,9 @@ static int sm2_ep_bind_cntr(struct sm2_ep *ep, struct util_cntr *cntr,
 		return ret;
 
 	if (cntr->wait) {
-		ret = ofi_wait_add_fid(cntr->wait, &ep->util_ep.ep_fid.fid, 0,
-				       sm2_ep_trywait);
+		ret = ofi_wait_add_fid_block(cntr->wait,
+					     &ep->util_ep.ep_fid.fid, 0,
+					     sm2_ep_trywait, sm2_ep_block);
 		if (ret)
 			return ret;
 	}
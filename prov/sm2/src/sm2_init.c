@@ -38,6 +38,8 @@
 #include <ofi_hmem.h>
 #include <ofi_prov.h>
 
+int sm2_wait_spin = 1000;
+
 size_t sm2_calculate_size_offsets(ptrdiff_t *rq_offset, ptrdiff_t *fs_offset)
 {
 	size_t total_size;
@@ -61,33 +63,21 @@ int sm2_create(const struct fi_provider *prov, const struct sm2_attr *attr,
 {
 	ptrdiff_t recv_queue_offset, freestack_offset;
 	int ret;
-	void *mapped_addr;
 	struct sm2_region *smr;
 
 	sm2_calculate_size_offsets(&recv_queue_offset, &freestack_offset);
 
 	FI_INFO(prov, FI_LOG_EP_CTRL, "Claiming an entry for (%s)\n",
 		attr->name);
-	sm2_file_lock(sm2_mmap);
 	ret = sm2_entry_allocate(attr->name, sm2_mmap, gid, true);
-
 	if (ret) {
 		FI_WARN(prov, FI_LOG_EP_CTRL,
 			"Failed to allocate an entry in the SHM file for "
 			"ourselves\n");
-		sm2_file_unlock(sm2_mmap);
 		return ret;
 	}
 
-	mapped_addr = sm2_mmap_ep_region(sm2_mmap, *gid);
-
-	if (mapped_addr == MAP_FAILED) {
-		FI_WARN(prov, FI_LOG_EP_CTRL, "mmap error\n");
-		ret = -errno;
-		goto remove;
-	}
-
-	smr = mapped_addr;
+	smr = sm2_mmap_ep_region(sm2_mmap, *gid);
 
 	smr->version = SM2_VERSION;
 	smr->flags = attr->flags;
@@ -95,6 +85,7 @@ int sm2_create(const struct fi_provider *prov, const struct sm2_attr *attr,
 	smr->freestack_offset = freestack_offset;
 
 	sm2_fifo_init(sm2_recv_queue(smr));
+	ofi_doorbell_init(&smr->doorbell);
 	smr_freestack_init(sm2_freestack(smr), SM2_NUM_XFER_ENTRY_PER_PEER,
 			   sizeof(struct sm2_xfer_entry));
 
@@ -103,20 +94,12 @@ int sm2_create(const struct fi_provider *prov, const struct sm2_attr *attr,
 	 * this will unblock other processes trying to send to us
 	 */
 	assert(sm2_mmap_entries(sm2_mmap)[*gid].pid == getpid());
-	sm2_mmap_entries(sm2_mmap)[*gid].startup_ready = true;
 	atomic_wmb();
-
-	/* Need to unlock coordinator so that others can add themselves to
-	 * header */
-	sm2_file_unlock(sm2_mmap);
+	sm2_mmap_entries(sm2_mmap)[*gid].startup_ready = true;
 
 	FI_WARN(&sm2_prov, FI_LOG_EP_CTRL,
 		"Created sm2 endpoint at allocation[%d]\n", *gid);
 	return 0;
-
-remove:
-	sm2_file_unlock(sm2_mmap);
-	return ret;
 }
 
 /*
@@ -253,5 +236,12 @@ struct util_prov sm2_util_prov = {
 
 SM2_INI
 {
+	fi_param_define(&sm2_prov, "wait_spin", FI_PARAM_INT,
+			"Number of idle polls a blocking wait (fi_cq_sread, "
+			"fi_cntr_wait) makes before sleeping until a peer "
+			"posts to the endpoint. -1 never sleeps. "
+			"Default: 1000");
+	fi_param_get_int(&sm2_prov, "wait_spin", &sm2_wait_spin);
+
 	return &sm2_prov;
 }
@@ -88,6 +88,8 @@
 #define SOCK_PE_POLL_TIMEOUT (100000)
 #define SOCK_PE_MAX_ENTRIES (128)
 #define SOCK_PE_WAITTIME (10)
+#define SOCK_PE_MAX_THREADS (64)
+#define SOCK_PE_STEAL_MAX_WAIT (8)
 
 #define SOCK_EQ_DEF_SZ (1<<8)
 #define SOCK_CQ_DEF_SZ (1<<8)
@@ -232,7 +234,11 @@ struct sock_domain {
 
 	enum fi_progress	progress_mode;
 	struct ofi_mr_map	mr_map;
+	/* pe is pe_set[0]; it also serves shared contexts */
 	struct sock_pe		*pe;
+	struct sock_pe		**pe_set;
+	int			pe_cnt;
+	ofi_atomic32_t		pe_next;
 	struct dlist_entry	dom_list_entry;
 	struct fi_domain_attr	attr;
 	struct sock_conn_listener conn_listener;
@@ -543,6 +549,7 @@ struct sock_ep_attr {
 	struct sock_eq *eq;
 	struct sock_av *av;
 	struct sock_domain *domain;
+	struct sock_pe *pe;
 
 	struct sock_rx_ctx *rx_ctx;
 	struct sock_tx_ctx *tx_ctx;
@@ -643,6 +650,7 @@ struct sock_rx_ctx {
 	struct sock_av *av;
 	struct sock_eq *eq;
  	struct sock_domain *domain;
+	struct sock_pe *pe;
 
 	struct dlist_entry pe_entry;
 	struct dlist_entry cq_entry;
@@ -684,6 +692,7 @@ struct sock_tx_ctx {
 	struct sock_av *av;
 	struct sock_eq *eq;
  	struct sock_domain *domain;
+	struct sock_pe *pe;
 
 	struct dlist_entry pe_entry;
 	struct dlist_entry cq_entry;
@@ -850,6 +859,7 @@ struct sock_pe {
 	int wcnt, rcnt;
 	int signal_fds[2];
 	uint64_t waittime;
+	int steal_wait;
 
 	struct ofi_bufpool *pe_rx_pool;
 	struct ofi_bufpool *atomic_rx_pool;
@@ -1136,7 +1146,9 @@ void sock_set_sockopts(int sock, int sock_opts);
 int fd_set_nonblock(int fd);
 int sock_conn_map_init(struct sock_ep *ep, int init_size);
 
-struct sock_pe *sock_pe_init(struct sock_domain *domain);
+int sock_pe_set_init(struct sock_domain *domain);
+void sock_pe_set_finalize(struct sock_domain *domain);
+struct sock_pe *sock_pe_select(struct sock_domain *domain);
 void sock_pe_add_tx_ctx(struct sock_pe *pe, struct sock_tx_ctx *ctx);
 void sock_pe_add_rx_ctx(struct sock_pe *pe, struct sock_rx_ctx *ctx);
 void sock_pe_signal(struct sock_pe *pe);
@@ -1149,7 +1161,6 @@ int sock_pe_progress_rx_ctx(struct sock_pe *pe, struct sock_rx_ctx *rx_ctx);
 int sock_pe_progress_tx_ctx(struct sock_pe *pe, struct sock_tx_ctx *tx_ctx);
 void sock_pe_remove_tx_ctx(struct sock_tx_ctx *tx_ctx);
 void sock_pe_remove_rx_ctx(struct sock_rx_ctx *rx_ctx);
-void sock_pe_finalize(struct sock_pe *pe);
 
 
 struct sock_rx_entry *sock_rx_new_entry(struct sock_rx_ctx *rx_ctx);
@@ -148,7 +148,7 @@ void sock_conn_map_destroy(struct sock_ep_attr *ep_attr)
 	struct sock_conn_map *cmap = &ep_attr->cmap;
 	for (i = 0; i < cmap->used; i++) {
 		if (cmap->table[i].sock_fd != -1) {
-			sock_pe_poll_del(ep_attr->domain->pe, cmap->table[i].sock_fd);
+			sock_pe_poll_del(ep_attr->pe, cmap->table[i].sock_fd);
 			sock_conn_release_entry(cmap, &cmap->table[i]);
 		}
 	}
@@ -216,7 +216,7 @@ static struct sock_conn *sock_conn_map_insert(struct sock_ep_attr *ep_attr,
 		SOCK_LOG_ERROR("failed to add to epoll set: %d\n", conn_fd);
 
 	map->table[index].address_published = addr_published;
-	sock_pe_poll_add(ep_attr->domain->pe, conn_fd);
+	sock_pe_poll_add(ep_attr->pe, conn_fd);
 	return &map->table[index];
 }
 
@@ -389,7 +389,7 @@ static void *sock_conn_listener_thread(void *arg)
 			ofi_mutex_lock(&ep_attr->cmap.lock);
 			sock_conn_map_insert(ep_attr, &remote, conn_fd, 1);
 			ofi_mutex_unlock(&ep_attr->cmap.lock);
-			sock_pe_signal(ep_attr->domain->pe);
+			sock_pe_signal(ep_attr->pe);
 		}
 skip:
 		ofi_mutex_unlock(&conn_listener->signal_lock);
@@ -263,7 +263,7 @@ static int sock_ctx_enable(struct fid_ep *ep)
 	switch (ep->fid.fclass) {
 	case FI_CLASS_RX_CTX:
 		rx_ctx = container_of(ep, struct sock_rx_ctx, ctx.fid);
-		sock_pe_add_rx_ctx(rx_ctx->domain->pe, rx_ctx);
+		sock_pe_add_rx_ctx(rx_ctx->ep_attr->pe, rx_ctx);
 
 		if (!rx_ctx->ep_attr->conn_handle.do_listen &&
 		    sock_conn_listen(rx_ctx->ep_attr)) {
@@ -274,7 +274,7 @@ static int sock_ctx_enable(struct fid_ep *ep)
 
 	case FI_CLASS_TX_CTX:
 		tx_ctx = container_of(ep, struct sock_tx_ctx, fid.ctx.fid);
-		sock_pe_add_tx_ctx(tx_ctx->domain->pe, tx_ctx);
+		sock_pe_add_tx_ctx(tx_ctx->ep_attr->pe, tx_ctx);
 
 		if (!tx_ctx->ep_attr->conn_handle.do_listen &&
 		    sock_conn_listen(tx_ctx->ep_attr)) {
@@ -664,7 +664,7 @@ static int sock_ep_close(struct fid *fid)
 		ofi_mutex_unlock(&sock_ep->attr->av->list_lock);
 	}
 
-	pthread_mutex_lock(&sock_ep->attr->domain->pe->list_lock);
+	pthread_mutex_lock(&sock_ep->attr->pe->list_lock);
 	if (sock_ep->attr->tx_shared) {
 		ofi_mutex_lock(&sock_ep->attr->tx_ctx->lock);
 		dlist_remove(&sock_ep->attr->tx_ctx_entry);
@@ -676,7 +676,7 @@ static int sock_ep_close(struct fid *fid)
 		dlist_remove(&sock_ep->attr->rx_ctx_entry);
 		ofi_mutex_unlock(&sock_ep->attr->rx_ctx->lock);
 	}
-	pthread_mutex_unlock(&sock_ep->attr->domain->pe->list_lock);
+	pthread_mutex_unlock(&sock_ep->attr->pe->list_lock);
 
 	if (sock_ep->attr->conn_handle.do_listen) {
 		ofi_mutex_lock(&sock_ep->attr->domain->conn_listener.signal_lock);
@@ -725,10 +725,10 @@ static int sock_ep_close(struct fid *fid)
 	if (sock_ep->attr->dest_addr)
 		free(sock_ep->attr->dest_addr);
 
-	ofi_mutex_lock(&sock_ep->attr->domain->pe->lock);
+	ofi_mutex_lock(&sock_ep->attr->pe->lock);
 	ofi_idm_reset(&sock_ep->attr->av_idm, NULL);
 	sock_conn_map_destroy(sock_ep->attr);
-	ofi_mutex_unlock(&sock_ep->attr->domain->pe->lock);
+	ofi_mutex_unlock(&sock_ep->attr->pe->lock);
 
 	ofi_atomic_dec32(&sock_ep->attr->domain->ref);
 	ofi_mutex_destroy(&sock_ep->attr->lock);
@@ -884,6 +884,9 @@ static int sock_ep_bind(struct fid *fid, struct fid *bfid, uint64_t flags)
 
 		ep->attr->tx_ctx->use_shared = 1;
 		ep->attr->tx_ctx->stx_ctx = tx_ctx;
+		/* endpoints sharing a context are progressed by its PE */
+		ep->attr->pe = tx_ctx->pe;
+		ep->attr->tx_ctx->pe = tx_ctx->pe;
 		break;
 
 	case FI_CLASS_SRX_CTX:
@@ -894,6 +897,8 @@ static int sock_ep_bind(struct fid *fid, struct fid *bfid, uint64_t flags)
 
 		ep->attr->rx_ctx->use_shared = 1;
 		ep->attr->rx_ctx->srx_ctx = rx_ctx;
+		ep->attr->pe = rx_ctx->pe;
+		ep->attr->rx_ctx->pe = rx_ctx->pe;
 		break;
 
 	default:
@@ -988,11 +993,11 @@ int sock_ep_enable(struct fid_ep *ep)
 			tx_ctx->enabled = 1;
 			if (tx_ctx->use_shared) {
 				if (tx_ctx->stx_ctx) {
-					sock_pe_add_tx_ctx(tx_ctx->domain->pe, tx_ctx->stx_ctx);
+					sock_pe_add_tx_ctx(sock_ep->attr->pe, tx_ctx->stx_ctx);
 					tx_ctx->stx_ctx->enabled = 1;
 				}
 			} else {
-				sock_pe_add_tx_ctx(tx_ctx->domain->pe, tx_ctx);
+				sock_pe_add_tx_ctx(sock_ep->attr->pe, tx_ctx);
 			}
 		}
 	}
@@ -1003,11 +1008,11 @@ int sock_ep_enable(struct fid_ep *ep)
 			rx_ctx->enabled = 1;
 			if (rx_ctx->use_shared) {
 				if (rx_ctx->srx_ctx) {
-					sock_pe_add_rx_ctx(rx_ctx->domain->pe, rx_ctx->srx_ctx);
+					sock_pe_add_rx_ctx(sock_ep->attr->pe, rx_ctx->srx_ctx);
 					rx_ctx->srx_ctx->enabled = 1;
 				}
 			} else {
-				sock_pe_add_rx_ctx(rx_ctx->domain->pe, rx_ctx);
+				sock_pe_add_rx_ctx(sock_ep->attr->pe, rx_ctx);
 			}
 		}
 	}
@@ -1140,6 +1145,7 @@ static int sock_ep_tx_ctx(struct fid_ep *ep, int index, struct fi_tx_attr *attr,
 	tx_ctx->tx_id = (uint16_t) index;
 	tx_ctx->ep_attr = sock_ep->attr;
 	tx_ctx->domain = sock_ep->attr->domain;
+	tx_ctx->pe = sock_ep->attr->pe;
 	if (tx_ctx->rx_ctrl_ctx && tx_ctx->rx_ctrl_ctx->is_ctrl_ctx)
 		tx_ctx->rx_ctrl_ctx->domain = sock_ep->attr->domain;
 	tx_ctx->av = sock_ep->attr->av;
@@ -1186,6 +1192,7 @@ static int sock_ep_rx_ctx(struct fid_ep *ep, int index, struct fi_rx_attr *attr,
 	rx_ctx->rx_id = (uint16_t) index;
 	rx_ctx->ep_attr = sock_ep->attr;
 	rx_ctx->domain = sock_ep->attr->domain;
+	rx_ctx->pe = sock_ep->attr->pe;
 	rx_ctx->av = sock_ep->attr->av;
 	dlist_insert_tail(&sock_ep->attr->rx_ctx_entry, &rx_ctx->ep_list);
 
@@ -1249,6 +1256,7 @@ int sock_stx_ctx(struct fid_domain *domain,
 		return -FI_ENOMEM;
 
 	tx_ctx->domain = dom;
+	tx_ctx->pe = dom->pe;
 	if (tx_ctx->rx_ctrl_ctx && tx_ctx->rx_ctrl_ctx->is_ctrl_ctx)
 		tx_ctx->rx_ctrl_ctx->domain = dom;
 
@@ -1292,6 +1300,7 @@ int sock_srx_ctx(struct fid_domain *domain,
 		return -FI_ENOMEM;
 
 	rx_ctx->domain = dom;
+	rx_ctx->pe = dom->pe;
 	rx_ctx->ctx.fid.fclass = FI_CLASS_SRX_CTX;
 
 	rx_ctx->ctx.fid.ops = &sock_ctx_ops;
@@ -1709,6 +1718,7 @@ int sock_alloc_endpoint(struct fid_domain *domain, struct fi_info *info,
 		goto err2;
 	}
 
+	sock_ep->attr->pe = sock_pe_select(sock_dom);
 	if (sock_ep->attr->fclass != FI_CLASS_SEP) {
 		/* default tx ctx */
 		tx_ctx = sock_tx_ctx_alloc(&sock_ep->tx_attr, context,
@@ -1719,6 +1729,7 @@ int sock_alloc_endpoint(struct fid_domain *domain, struct fi_info *info,
 		}
 		tx_ctx->ep_attr = sock_ep->attr;
 		tx_ctx->domain = sock_dom;
+		tx_ctx->pe = sock_ep->attr->pe;
 		if (tx_ctx->rx_ctrl_ctx && tx_ctx->rx_ctrl_ctx->is_ctrl_ctx)
 			tx_ctx->rx_ctrl_ctx->domain = sock_dom;
 		tx_ctx->tx_id = 0;
@@ -1735,6 +1746,7 @@ int sock_alloc_endpoint(struct fid_domain *domain, struct fi_info *info,
 		}
 		rx_ctx->ep_attr = sock_ep->attr;
 		rx_ctx->domain = sock_dom;
+		rx_ctx->pe = sock_ep->attr->pe;
 		rx_ctx->rx_id = 0;
 		dlist_insert_tail(&sock_ep->attr->rx_ctx_entry, &rx_ctx->ep_list);
 		sock_ep->attr->rx_array[0] = rx_ctx;
@@ -1773,7 +1785,7 @@ void sock_ep_remove_conn(struct sock_ep_attr *attr, struct sock_conn *conn)
 {
 	if (attr->cmap.used <= 0 || conn->sock_fd == -1)
 		return;
-	sock_pe_poll_del(attr->domain->pe, conn->sock_fd);
+	sock_pe_poll_del(attr->pe, conn->sock_fd);
 	sock_conn_release_entry(&attr->cmap, conn);
 }
 
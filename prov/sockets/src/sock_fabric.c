@@ -49,6 +49,7 @@
 #define SOCK_LOG_ERROR(...) _SOCK_LOG_ERROR(FI_LOG_FABRIC, __VA_ARGS__)
 
 int sock_pe_waittime = SOCK_PE_WAITTIME;
+int sock_pe_threads = 1;
 const char sock_fab_name[] = "IP";
 const char sock_dom_name[] = "sockets";
 const char sock_prov_name[] = "sockets";
@@ -233,6 +234,11 @@ static void sock_read_default_params()
 {
 	if (!read_default_params) {
 		fi_param_get_int(&sock_prov, "pe_waittime", &sock_pe_waittime);
+		fi_param_get_int(&sock_prov, "pe_threads", &sock_pe_threads);
+		if (sock_pe_threads < 1)
+			sock_pe_threads = 1;
+		else if (sock_pe_threads > SOCK_PE_MAX_THREADS)
+			sock_pe_threads = SOCK_PE_MAX_THREADS;
 		fi_param_get_int(&sock_prov, "conn_timeout", &sock_conn_timeout);
 		fi_param_get_int(&sock_prov, "max_conn_retry", &sock_conn_retry);
 		fi_param_get_int(&sock_prov, "def_conn_map_sz", &sock_cm_def_map_sz);
@@ -365,6 +371,11 @@ SOCKETS_INI
 	fi_param_define(&sock_prov, "def_eq_sz", FI_PARAM_INT,
 			"Default event queue size");
 
+	fi_param_define(&sock_prov, "pe_threads", FI_PARAM_INT,
+			"Number of progress threads per domain when using auto progress. "
+			"Each endpoint is progressed by one thread; idle threads help "
+			"busy ones (default: 1)");
+
 	fi_param_define(&sock_prov, "pe_affinity", FI_PARAM_STRING,
 			"If specified, bind the progress thread to the indicated range(s) of Linux virtual processor ID(s). "
 			"This option is currently not supported on OS X and Windows. Usage: id_start[-id_end[:stride]][,]");
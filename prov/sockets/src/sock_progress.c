@@ -2335,6 +2335,7 @@ void sock_pe_add_tx_ctx(struct sock_pe *pe, struct sock_tx_ctx *ctx)
 	}
 
 	dlist_insert_tail(&ctx->pe_entry, &pe->tx_list);
+	ctx->pe = pe;
 	sock_pe_signal(pe);
 out:
 	pthread_mutex_unlock(&pe->list_lock);
@@ -2353,6 +2354,7 @@ void sock_pe_add_rx_ctx(struct sock_pe *pe, struct sock_rx_ctx *ctx)
 			goto out;
 	}
 	dlist_insert_tail(&ctx->pe_entry, &pe->rx_list);
+	ctx->pe = pe;
 	sock_pe_signal(pe);
 out:
 	pthread_mutex_unlock(&pe->list_lock);
@@ -2361,16 +2363,16 @@ out:
 
 void sock_pe_remove_tx_ctx(struct sock_tx_ctx *tx_ctx)
 {
-	pthread_mutex_lock(&tx_ctx->domain->pe->list_lock);
+	pthread_mutex_lock(&tx_ctx->pe->list_lock);
 	dlist_remove(&tx_ctx->pe_entry);
-	pthread_mutex_unlock(&tx_ctx->domain->pe->list_lock);
+	pthread_mutex_unlock(&tx_ctx->pe->list_lock);
 }
 
 void sock_pe_remove_rx_ctx(struct sock_rx_ctx *rx_ctx)
 {
-	pthread_mutex_lock(&rx_ctx->domain->pe->list_lock);
+	pthread_mutex_lock(&rx_ctx->pe->list_lock);
 	dlist_remove(&rx_ctx->pe_entry);
-	pthread_mutex_unlock(&rx_ctx->domain->pe->list_lock);
+	pthread_mutex_unlock(&rx_ctx->pe->list_lock);
 }
 
 static int sock_pe_progress_rx_ep(struct sock_pe *pe,
@@ -2564,15 +2566,12 @@ out:
 	return ret;
 }
 
-static int sock_pe_wait_ok(struct sock_pe *pe)
+static int sock_pe_idle(struct sock_pe *pe)
 {
 	struct dlist_entry *entry;
 	struct sock_tx_ctx *tx_ctx;
 	struct sock_rx_ctx *rx_ctx;
 
-	if (pe->waittime && ((ofi_gettime_ms() - pe->waittime) < (uint64_t)sock_pe_waittime))
-		return 0;
-
 	if (dlist_empty(&pe->tx_list) && dlist_empty(&pe->rx_list))
 		return 1;
 
@@ -2603,15 +2602,25 @@ static int sock_pe_wait_ok(struct sock_pe *pe)
 	return 1;
 }
 
-static void sock_pe_wait(struct sock_pe *pe)
+static int sock_pe_wait_ok(struct sock_pe *pe)
+{
+	if (pe->waittime && ((ofi_gettime_ms() - pe->waittime) < (uint64_t)sock_pe_waittime))
+		return 0;
+
+	return sock_pe_idle(pe);
+}
+
+static void sock_pe_wait(struct sock_pe *pe, int timeout)
 {
 	char tmp;
 	int ret;
 	struct ofi_epollfds_event event;
 
-	ret = ofi_epoll_wait(pe->epoll_set, &event, 1, -1);
+	ret = ofi_epoll_wait(pe->epoll_set, &event, 1, timeout);
 	if (ret < 0)
 		SOCK_LOG_ERROR("poll failed : %s\n", strerror(ofi_sockerr()));
+	if (!ret)
+		return;
 
 	ofi_mutex_lock(&pe->signal_lock);
 	if (pe->rcnt != pe->wcnt) {
@@ -2637,12 +2646,69 @@ static void sock_pe_set_affinity(void)
 		SOCK_LOG_ERROR("FI_SOCKETS_PE_AFFINITY is not supported on OS X and Windows\n");
 }
 
-static void *sock_pe_progress_thread(void *data)
+/* Caller holds pe->list_lock */
+static int sock_pe_progress_lists(struct sock_pe *pe)
 {
-	int ret;
 	struct dlist_entry *entry;
 	struct sock_tx_ctx *tx_ctx;
 	struct sock_rx_ctx *rx_ctx;
+	int ret;
+
+	for (entry = pe->tx_list.next; entry != &pe->tx_list;
+	     entry = entry->next) {
+		tx_ctx = container_of(entry, struct sock_tx_ctx, pe_entry);
+		ret = sock_pe_progress_tx_ctx(pe, tx_ctx);
+		if (ret < 0) {
+			SOCK_LOG_ERROR("failed to progress TX\n");
+			return ret;
+		}
+	}
+
+	for (entry = pe->rx_list.next; entry != &pe->rx_list;
+	     entry = entry->next) {
+		rx_ctx = container_of(entry, struct sock_rx_ctx, pe_entry);
+		ret = sock_pe_progress_rx_ctx(pe, rx_ctx);
+		if (ret < 0) {
+			SOCK_LOG_ERROR("failed to progress RX\n");
+			return ret;
+		}
+	}
+	return 0;
+}
+
+/*
+ * An endpoint and all of its contexts are owned by one PE, so the
+ * connections of an endpoint are only progressed under that PE's locks
+ * and per-connection ordering is kept.  A worker with nothing queued on
+ * its own PE helps the others: it takes any PE whose list lock is free
+ * and runs one pass over it.  Returns nonzero if work was found.
+ *
+ * Queued work is often waiting on the peer, so a pass may not move
+ * anything.  The caller backs off between steals, see
+ * sock_pe_progress_thread().
+ */
+static int sock_pe_steal(struct sock_pe *pe)
+{
+	struct sock_domain *domain = pe->domain;
+	struct sock_pe *victim;
+	int i, found = 0;
+
+	for (i = 0; i < domain->pe_cnt; i++) {
+		victim = domain->pe_set[i];
+		if (victim == pe || pthread_mutex_trylock(&victim->list_lock))
+			continue;
+
+		if (!sock_pe_idle(victim)) {
+			(void) sock_pe_progress_lists(victim);
+			found = 1;
+		}
+		pthread_mutex_unlock(&victim->list_lock);
+	}
+	return found;
+}
+
+static void *sock_pe_progress_thread(void *data)
+{
 	struct sock_pe *pe = (struct sock_pe *)data;
 
 	SOCK_LOG_DBG("Progress thread started\n");
@@ -2652,36 +2718,26 @@ static void *sock_pe_progress_thread(void *data)
 		if (pe->domain->progress_mode == FI_PROGRESS_AUTO &&
 		    sock_pe_wait_ok(pe)) {
 			pthread_mutex_unlock(&pe->list_lock);
-			sock_pe_wait(pe);
-			pthread_mutex_lock(&pe->list_lock);
-		}
-
-		if (!dlist_empty(&pe->tx_list)) {
-			for (entry = pe->tx_list.next;
-			     entry != &pe->tx_list; entry = entry->next) {
-				tx_ctx = container_of(entry, struct sock_tx_ctx,
-						      pe_entry);
-				ret = sock_pe_progress_tx_ctx(pe, tx_ctx);
-				if (ret < 0) {
-					SOCK_LOG_ERROR("failed to progress TX\n");
-					pthread_mutex_unlock(&pe->list_lock);
-					return NULL;
-				}
+			if (sock_pe_steal(pe)) {
+				/* Wait on our own fds for up to steal_wait ms
+				 * before the next steal, doubling the wait
+				 * while we stay idle.
+				 */
+				sock_pe_wait(pe, pe->steal_wait);
+				pe->steal_wait = pe->steal_wait ?
+					MIN(pe->steal_wait * 2,
+					    SOCK_PE_STEAL_MAX_WAIT) : 1;
+			} else {
+				sock_pe_wait(pe, -1);
 			}
+			pthread_mutex_lock(&pe->list_lock);
+		} else {
+			pe->steal_wait = 0;
 		}
 
-		if (!dlist_empty(&pe->rx_list)) {
-			for (entry = pe->rx_list.next;
-			     entry != &pe->rx_list; entry = entry->next) {
-				rx_ctx = container_of(entry, struct sock_rx_ctx,
-						      pe_entry);
-				ret = sock_pe_progress_rx_ctx(pe, rx_ctx);
-				if (ret < 0) {
-					SOCK_LOG_ERROR("failed to progress RX\n");
-					pthread_mutex_unlock(&pe->list_lock);
-					return NULL;
-				}
-			}
+		if (sock_pe_progress_lists(pe)) {
+			pthread_mutex_unlock(&pe->list_lock);
+			return NULL;
 		}
 		pthread_mutex_unlock(&pe->list_lock);
 	}
@@ -2712,7 +2768,7 @@ static void sock_pe_init_table(struct sock_pe *pe)
 	SOCK_LOG_DBG("PE table init: OK\n");
 }
 
-struct sock_pe *sock_pe_init(struct sock_domain *domain)
+static struct sock_pe *sock_pe_init(struct sock_domain *domain)
 {
 	struct sock_pe *pe;
 	int ret;
@@ -2801,13 +2857,21 @@ static void sock_pe_free_util_pool(struct sock_pe *pe)
 	ofi_bufpool_destroy(pe->atomic_rx_pool);
 }
 
-void sock_pe_finalize(struct sock_pe *pe)
+static void sock_pe_stop(struct sock_pe *pe)
+{
+	if (pe->domain->progress_mode != FI_PROGRESS_AUTO || !pe->do_progress)
+		return;
+
+	pe->do_progress = 0;
+	sock_pe_signal(pe);
+	pthread_join(pe->progress_thread, NULL);
+}
+
+static void sock_pe_finalize(struct sock_pe *pe)
 {
 	int i;
 	if (pe->domain->progress_mode == FI_PROGRESS_AUTO) {
-		pe->do_progress = 0;
-		sock_pe_signal(pe);
-		pthread_join(pe->progress_thread, NULL);
+		sock_pe_stop(pe);
 		ofi_close_socket(pe->signal_fds[0]);
 		ofi_close_socket(pe->signal_fds[1]);
 	}
@@ -2824,3 +2888,61 @@ void sock_pe_finalize(struct sock_pe *pe)
 	free(pe);
 	SOCK_LOG_DBG("Progress engine finalize: OK\n");
 }
+
+/*
+ * With auto progress, each domain runs sock_pe_threads progress engines,
+ * one thread each.  Manual progress uses a single engine.
+ */
+int sock_pe_set_init(struct sock_domain *domain)
+{
+	int i, cnt;
+
+	cnt = domain->progress_mode == FI_PROGRESS_AUTO ? sock_pe_threads : 1;
+	domain->pe_set = calloc(cnt, sizeof(*domain->pe_set));
+	if (!domain->pe_set)
+		return -FI_ENOMEM;
+
+	for (i = 0; i < cnt; i++) {
+		domain->pe_set[i] = sock_pe_init(domain);
+		if (!domain->pe_set[i])
+			goto err;
+	}
+
+	ofi_atomic_initialize32(&domain->pe_next, 0);
+	domain->pe = domain->pe_set[0];
+	domain->pe_cnt = cnt;
+	return 0;
+
+err:
+	while (i--) {
+		sock_pe_stop(domain->pe_set[i]);
+		sock_pe_finalize(domain->pe_set[i]);
+	}
+	free(domain->pe_set);
+	return -FI_ENOMEM;
+}
+
+/* Workers may be helping any engine, so stop all of them before freeing */
+void sock_pe_set_finalize(struct sock_domain *domain)
+{
+	int i;
+
+	for (i = 0; i < domain->pe_cnt; i++)
+		sock_pe_stop(domain->pe_set[i]);
+
+	for (i = 0; i < domain->pe_cnt; i++)
+		sock_pe_finalize(domain->pe_set[i]);
+
+	free(domain->pe_set);
+	domain->pe_set = NULL;
+	domain->pe = NULL;
+	domain->pe_cnt = 0;
+}
+
+struct sock_pe *sock_pe_select(struct sock_domain *domain)
+{
+	uint32_t idx;
+
+	idx = (uint32_t) ofi_atomic_inc32(&domain->pe_next);
+	return domain->pe_set[idx % domain->pe_cnt];
+}
@@ -48,6 +48,7 @@
 #include <rdma/fi_endpoint.h>
 #include <rdma/fi_eq.h>
 #include <rdma/fi_errno.h>
+#include <rdma/fi_ext.h>
 #include <rdma/fi_rma.h>
 #include <rdma/fi_tagged.h>
 #include <rdma/fi_trigger.h>
@@ -94,7 +95,9 @@ typedef void  xnet_profile_t;
 
 #define XNET_DEF_INJECT		128
 #define XNET_DEF_BUF_SIZE	16384
-#define XNET_MAX_EVENTS		128
+#define XNET_MIN_EVENTS		64
+#define XNET_MAX_EVENTS		1024
+#define XNET_EDGE_RX_BUDGET	16
 #define XNET_MIN_MULTI_RECV	16384
 #define XNET_PORT_MAX_RANGE	(USHRT_MAX)
 
@@ -114,9 +117,15 @@ extern size_t xnet_default_rx_size;
 extern size_t xnet_zerocopy_size;
 extern int xnet_trace_msg;
 extern int xnet_disable_autoprog;
+extern int xnet_self_comm;
+extern int xnet_progress_spin;
+extern int xnet_busy_poll;
+extern int xnet_edge_poll;
+extern size_t xnet_conn_batch;
 extern int xnet_io_uring;
 extern int xnet_max_saved;
 extern size_t xnet_max_saved_size;
+extern size_t xnet_max_saved_mem;
 extern size_t xnet_max_inject;
 extern size_t xnet_buf_size;
 extern int xnet_firewall_addr;
@@ -182,6 +191,7 @@ union xnet_hdrs {
 	struct xnet_tag_hdr	tag_hdr;
 	struct xnet_tag_rts_hdr	tag_rts_hdr;
 	struct xnet_tag_rts_data_hdr tag_rts_data_hdr;
+	struct xnet_rts_size_hdr rts_size_hdr;
 	uint8_t			max_hdr[XNET_MAX_HDR];
 };
 
@@ -213,6 +223,9 @@ struct xnet_srx {
 	struct slist		tag_queue;
 	struct ofi_dyn_arr	src_tag_queues;
 	struct ofi_dyn_arr	saved_msgs;
+	/* untagged messages the rdm ep sent to itself, not yet received */
+	struct slist		self_queue;
+	int			self_cnt;
 
 	struct xnet_xfer_entry	*(*match_tag_rx)(struct xnet_srx *srx,
 						 struct xnet_ep *ep,
@@ -235,6 +248,17 @@ int xnet_srx_context(struct fid_domain *domain, struct fi_rx_attr *attr,
 
 /* xnet_ep::util_ep::flags */
 #define XNET_EP_RENDEZVOUS (1 << 0)
+/* peer accepts rts_size, and we have asked it to lower its rts size */
+#define XNET_EP_RTS_SIZE (1 << 1)
+#define XNET_EP_RTS_LOWERED (1 << 2)
+/* socket registered with XNET_EDGE_EVENTS, see xnet_monitor_edge() */
+#define XNET_EP_EDGE_POLL (1 << 3)
+/* rdm conn: if connecting fails, keep the queued sends for the next
+ * attempt, see xnet_close_conn()
+ */
+#define XNET_EP_KEEP_TX (1 << 4)
+
+#define XNET_EDGE_EVENTS (POLLIN | POLLOUT | OFI_EPOLL_ET)
 
 struct xnet_ep {
 	struct util_ep		util_ep;
@@ -245,6 +269,7 @@ struct xnet_ep {
 	OFI_DBG_VAR(uint8_t, rx_id)
 
 	struct dlist_entry	unexp_entry;
+	struct dlist_entry	ready_entry;
 	struct slist		rx_queue;
 	struct slist		tx_queue;
 	struct slist		priority_queue;
@@ -253,6 +278,8 @@ struct xnet_ep {
 	struct slist		rma_read_queue;
 	struct ofi_byte_idx	rts_queue;
 	struct ofi_byte_idx	cts_queue;
+	/* tagged sends larger than this use rendezvous */
+	uint64_t		rts_size;
 	struct xnet_saved_msg	*saved_msg;
 	int			rx_avail;
 	struct xnet_srx		*srx;
@@ -270,6 +297,13 @@ struct xnet_ep {
 	xnet_profile_t *profile;
 };
 
+/* Sends posted while connecting are queued until the connection is up */
+static inline bool xnet_ep_connecting(struct xnet_ep *ep)
+{
+	return ep->state == XNET_CONNECTING || ep->state == XNET_ACCEPTING ||
+	       ep->state == XNET_REQ_SENT;
+}
+
 /* Must be castable to struct fi_eq_cm_entry */
 struct xnet_cm_entry {
 	fid_t fid;
@@ -288,14 +322,22 @@ enum {
 	XNET_CONN_INDEXED = BIT(0),
 	XNET_CONN_TX_LOOPBACK = BIT(1),
 	XNET_CONN_RX_LOOPBACK = BIT(2),
+	XNET_CONN_SELF = BIT(3),
+	XNET_CONN_PRECONNECT = BIT(4),
 };
 
+#define XNET_CONN_RETRIES 3
+
 struct xnet_conn {
 	struct xnet_ep		*ep;
 	struct xnet_rdm		*rdm;
 	struct util_peer_addr	*peer;
 	uint32_t		remote_pid;
 	int			flags;
+	int			retries;
+	/* sends posted before a failed or replaced connection attempt */
+	struct slist		tx_queue;
+	struct slist		rma_read_queue;
 };
 
 struct xnet_rdm {
@@ -308,6 +350,11 @@ struct xnet_rdm {
 	struct xnet_conn	*rx_loopback;
 	union ofi_sock_ip	addr;
 
+	/* FI_OPT_TCP_PRECONNECT range still to be connected */
+	fi_addr_t		preconnect_next;
+	fi_addr_t		preconnect_end;
+	size_t			preconnect_cnt;
+
 	xnet_profile_t *profile;
 };
 
@@ -317,6 +364,18 @@ ssize_t xnet_get_conn(struct xnet_rdm *rdm, fi_addr_t dest_addr,
 		      struct xnet_conn **conn);
 struct xnet_ep *xnet_get_rx_ep(struct xnet_rdm *rdm, fi_addr_t addr);
 void xnet_freeall_conns(struct xnet_rdm *rdm);
+int xnet_preconnect(struct xnet_rdm *rdm,
+		    const struct fi_rxm_preconnect *range);
+
+ssize_t xnet_self_send(struct xnet_rdm *rdm, uint8_t op,
+		       const struct iovec *iov, size_t count, fi_addr_t addr,
+		       uint64_t tag, uint64_t data, uint64_t flags,
+		       void *context);
+ssize_t xnet_self_rma(struct xnet_rdm *rdm, bool write,
+		      const struct iovec *iov, size_t count,
+		      const struct fi_rma_iov *rma_iov, size_t rma_count,
+		      uint64_t data, uint64_t flags, void *context);
+void xnet_progress_self(struct xnet_srx *srx);
 
 struct xnet_uring {
 	struct fid fid;
@@ -363,10 +422,15 @@ struct xnet_progress {
 	struct dlist_entry	unexp_msg_list;
 	struct dlist_entry	unexp_tag_list;
 	struct dlist_entry	saved_tag_list;
+	/* connected eps with work that no socket event will report */
+	struct dlist_entry	ready_list;
 	struct fd_signal	signal;
 
 	struct slist		event_list;
 	struct ofi_bufpool	*xfer_pool;
+	struct ofi_slab		*rbuf_slab;
+	/* unexpected message data held in rbuf_slab */
+	size_t			saved_mem;
 
 	struct xnet_uring	tx_uring;
 	struct xnet_uring	rx_uring;
@@ -376,9 +440,23 @@ struct xnet_progress {
 
 	struct ofi_dynpoll	epoll_fd;
 	struct ofi_epollfds_event events[XNET_MAX_EVENTS];
+	/* events read per pass, see xnet_adapt_events() */
+	int			max_events;
+	bool			edge_poll;
 
 	bool			auto_progress;
 	pthread_t		thread;
+	/* triggered ops run by the thread, NULL for the EQ's progress */
+	struct util_domain	*domain;
+
+	/* spin-then-block waiting, see xnet_update_spin() */
+	uint64_t		spin_ns;
+	uint64_t		last_event_ns;
+	uint64_t		avg_gap_ns;
+	ofi_atomic64_t		spin_hits;
+	ofi_atomic64_t		spin_misses;
+	ofi_atomic64_t		spin_time_ns;
+	ofi_atomic64_t		blocks;
 };
 
 int xnet_init_progress(struct xnet_progress *progress, struct fi_info *info);
@@ -390,10 +468,29 @@ int xnet_start_recv(struct xnet_ep *ep, struct xnet_xfer_entry *rx_entry);
 void xnet_progress(struct xnet_progress *progress, bool clear_signal);
 void xnet_run_progress(struct xnet_progress *progress, bool clear_signal);
 int xnet_progress_wait(struct xnet_progress *progress, int timeout);
+void xnet_spin_done(struct xnet_progress *progress, uint64_t start, bool hit);
+
+/* How long to poll before blocking for up to timeout ms.  spin_ns is
+ * only updated when events arrive, so once none has for longer than
+ * the maximum window the endpoint is idle and the wait blocks at once.
+ */
+static inline uint64_t
+xnet_spin_window(struct xnet_progress *progress, int timeout)
+{
+	if (!progress->spin_ns ||
+	    ofi_gettime_ns() - progress->last_event_ns >
+	    (uint64_t) xnet_progress_spin * 1000)
+		return 0;
+
+	if (timeout >= 0)
+		return MIN(progress->spin_ns, (uint64_t) timeout * 1000000);
+	return progress->spin_ns;
+}
 void xnet_handle_conn(struct xnet_conn_handle *conn, bool error);
 void xnet_handle_event_list(struct xnet_progress *progress);
 void xnet_progress_unexp(struct xnet_progress *progress,
 			 struct dlist_entry *unexp_list);
+int xnet_monitor_edge(struct xnet_ep *ep, bool add);
 
 int xnet_trywait(struct fid_fabric *fid_fabric, struct fid **fids, int count);
 int xnet_monitor_sock(struct xnet_progress *progress, SOCKET sock,
@@ -437,6 +534,8 @@ static inline void xnet_signal_progress(struct xnet_progress *progress)
 #define XNET_COPY_RECV		BIT(9)
 #define XNET_CLAIM_RECV		BIT(10)
 #define XNET_NEED_CTS		BIT(11)
+#define XNET_MORE		BIT(12)
+#define XNET_SAVED_MEM		BIT(13)
 #define XNET_MULTI_RECV		FI_MULTI_RECV /* BIT(16) */
 
 struct xnet_mrecv {
@@ -470,7 +569,8 @@ struct xnet_xfer_entry {
 	struct xnet_xfer_entry  *resp_entry;
 
 	/* hdr must be second to last, followed by msg_data.  msg_data
-	 * is sized dynamically based on the max_inject size
+	 * is sized dynamically based on the max_inject size.  Saved
+	 * messages are buffered separately in the progress rbuf_slab.
 	 */
 	union xnet_hdrs		hdr;
 	char			msg_data[];
@@ -623,6 +723,8 @@ void xnet_hdr_bswap_trace(struct xnet_ep *ep, struct xnet_base_hdr *hdr);
 
 void xnet_tx_queue_insert(struct xnet_ep *ep,
 			  struct xnet_xfer_entry *tx_entry);
+void xnet_start_tx(struct xnet_ep *ep);
+int xnet_rts_check(struct xnet_ep *ep, struct xnet_xfer_entry *tx_entry);
 
 int xnet_eq_create(struct fid_fabric *fabric_fid, struct fi_eq_attr *attr,
 		   struct fid_eq **eq_fid, void *context);
@@ -639,6 +741,13 @@ xnet_set_ack_flags(struct xnet_xfer_entry *xfer, uint64_t flags)
 	}
 }
 
+static inline void
+xnet_set_more_flag(struct xnet_xfer_entry *xfer, uint64_t flags)
+{
+	if (flags & FI_MORE)
+		xfer->ctrl_flags |= XNET_MORE;
+}
+
 static inline void
 xnet_set_commit_flags(struct xnet_xfer_entry *xfer, uint64_t flags)
 {
@@ -658,6 +767,24 @@ xnet_tx_completion_get_msgflags(struct xnet_ep *ep, uint64_t flags)
 	return (ep->util_ep.tx_msg_flags | flags) & FI_COMPLETION;
 }
 
+/* Deferred work posted by the util trigger engine reports to the work's
+ * context and completion counter, and only writes a CQ entry if asked to.
+ */
+static inline void
+xnet_init_trigger(struct xnet_xfer_entry *xfer, uint64_t flags)
+{
+	struct ofi_trigger_ctx *ctx;
+
+	if (!(flags & OFI_TRIGGERED))
+		return;
+
+	ctx = xfer->context;
+	xfer->context = ctx->context;
+	xfer->cntr = ctx->cntr;
+	xfer->cq_flags = (xfer->cq_flags & ~FI_COMPLETION) |
+			 (flags & FI_COMPLETION);
+}
+
 static inline uint64_t
 xnet_rx_completion_flag(struct xnet_ep *ep)
 {
@@ -695,13 +822,33 @@ xnet_alloc_xfer(struct xnet_progress *progress)
 	return xfer;
 }
 
+/* Saved message data counts against xnet_max_saved_mem until the message
+ * is matched or discarded.
+ */
+static inline void
+xnet_saved_mem_done(struct xnet_progress *progress,
+		    struct xnet_xfer_entry *xfer)
+{
+	size_t len;
+
+	assert(xnet_progress_locked(progress));
+	if (!(xfer->ctrl_flags & XNET_SAVED_MEM))
+		return;
+
+	len = xfer->hdr.base_hdr.size - xfer->hdr.base_hdr.hdr_size;
+	assert(progress->saved_mem >= len);
+	progress->saved_mem -= len;
+	xfer->ctrl_flags &= ~XNET_SAVED_MEM;
+}
+
 static inline void
 xnet_free_xfer(struct xnet_progress *progress, struct xnet_xfer_entry *xfer)
 {
 	assert(xnet_progress_locked(progress));
 
+	xnet_saved_mem_done(progress, xfer);
 	if (xfer->ctrl_flags & XNET_FREE_BUF)
-		free(xfer->user_buf);
+		ofi_slab_free(xfer->user_buf);
 
 	assert(xfer->inuse);
 	OFI_DBG_SET(xfer->inuse, false);
@@ -740,9 +887,11 @@ xnet_alloc_tx(struct xnet_ep *ep)
 }
 
 static inline int
-xnet_alloc_xfer_buf(struct xnet_xfer_entry *xfer, size_t len)
+xnet_alloc_xfer_buf(struct xnet_progress *progress,
+		    struct xnet_xfer_entry *xfer, size_t len)
 {
-	xfer->user_buf = malloc(len);
+	assert(xnet_progress_locked(progress));
+	xfer->user_buf = ofi_slab_alloc(progress->rbuf_slab, len);
 	if (!xfer->user_buf)
 		return -FI_ENOMEM;
 
@@ -770,6 +919,10 @@ void xnet_recv_saved(struct xnet_rdm *rdm,
 		     struct xnet_xfer_entry *rx_entry);
 void xnet_complete_saved(struct xnet_xfer_entry *saved_entry,
 			 void *msg_data);
+int xnet_alter_mrecv(struct xnet_srx *srx, struct xnet_xfer_entry *xfer,
+		     size_t msg_len);
+struct xnet_xfer_entry *
+xnet_srx_match_src(struct xnet_srx *srx, fi_addr_t addr, uint64_t tag);
 
 static inline uint64_t xnet_msg_len(union xnet_hdrs *hdr)
 {
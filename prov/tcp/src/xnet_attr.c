@@ -115,7 +115,7 @@ static struct fi_ep_attr xnet_srx_ep_attr = {
 };
 
 static struct fi_tx_attr xnet_rdm_tx_attr = {
-	.caps = XNET_RDM_EP_CAPS | XNET_TX_CAPS,
+	.caps = XNET_RDM_EP_CAPS | XNET_TX_CAPS | FI_TRIGGER,
 	.op_flags = XNET_TX_OP_FLAGS,
 	.msg_order = XNET_MSG_ORDER,
 	.inject_size = XNET_DEF_INJECT,
@@ -125,7 +125,7 @@ static struct fi_tx_attr xnet_rdm_tx_attr = {
 };
 
 static struct fi_rx_attr xnet_rdm_rx_attr = {
-	.caps = XNET_RDM_EP_CAPS | XNET_SRX_CAPS,
+	.caps = XNET_RDM_EP_CAPS | XNET_SRX_CAPS | FI_TRIGGER,
 	.op_flags = XNET_SRX_OP_FLAGS,
 	.msg_order = XNET_MSG_ORDER,
 	.size = 65536,
@@ -192,7 +192,8 @@ struct fi_fabric_attr xnet_fabric_attr = {
 };
 
 static struct fi_info xnet_rdm_info = {
-	.caps = XNET_DOMAIN_CAPS | XNET_RDM_EP_CAPS | XNET_TX_CAPS | XNET_SRX_CAPS,
+	.caps = XNET_DOMAIN_CAPS | XNET_RDM_EP_CAPS | XNET_TX_CAPS | XNET_SRX_CAPS |
+		FI_TRIGGER,
 	.addr_format = FI_SOCKADDR,
 	.tx_attr = &xnet_rdm_tx_attr,
 	.rx_attr = &xnet_rdm_rx_attr,
@@ -195,6 +195,15 @@ void xnet_req_done(struct xnet_ep *ep)
 	ret = xnet_req_done_internal(ep);
 	if (ret)
 		goto disable;
+
+	if (xnet_ep2_progress(ep)->edge_poll) {
+		ret = xnet_monitor_edge(ep, false);
+		if (ret) {
+			xnet_ep_disable(ep, 0, NULL, 0);
+			return;
+		}
+	}
+	xnet_start_tx(ep);
 	return;
 
 disable:
@@ -238,6 +247,7 @@ void xnet_uring_req_done(struct xnet_ep *ep, int res)
 	ret = xnet_req_done_internal(ep);
 	if (ret)
 		goto disable;
+	xnet_start_tx(ep);
 	return;
 
 disable:
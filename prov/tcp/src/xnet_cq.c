@@ -49,6 +49,7 @@ xnet_cq_readfrom(struct fid_cq *cq_fid, void *buf, size_t count,
 	ofi_genlock_lock(xnet_cq2_progress(cq)->active_lock);
 	ret = ofi_cq_readfrom(cq_fid, buf, count, src_addr);
 	ofi_genlock_unlock(xnet_cq2_progress(cq)->active_lock);
+	ofi_trigger_progress(cq->util_cq.domain);
 	return ret;
 }
 
@@ -66,13 +67,55 @@ xnet_cq_readerr(struct fid_cq *cq_fid, struct fi_cq_err_entry *buf,
 	return ret;
 }
 
+static ssize_t
+xnet_cq_sreadfrom(struct fid_cq *cq_fid, void *buf, size_t count,
+		  fi_addr_t *src_addr, const void *cond, int timeout)
+{
+	struct xnet_progress *progress;
+	struct xnet_cq *cq;
+	uint64_t start, window, spun_ms;
+	ssize_t ret;
+
+	cq = container_of(cq_fid, struct xnet_cq, util_cq.cq_fid);
+	progress = xnet_cq2_progress(cq);
+	window = xnet_spin_window(progress, timeout);
+	if (window) {
+		start = ofi_gettime_ns();
+		do {
+			ret = xnet_cq_readfrom(cq_fid, buf, count, src_addr);
+			if (ret != -FI_EAGAIN) {
+				xnet_spin_done(progress, start, true);
+				return ret;
+			}
+		} while (ofi_gettime_ns() - start < window);
+		xnet_spin_done(progress, start, false);
+
+		/* the window never exceeds the timeout */
+		if (timeout >= 0) {
+			spun_ms = (ofi_gettime_ns() - start + 999999) / 1000000;
+			timeout = (spun_ms < (uint64_t) timeout) ?
+				  timeout - (int) spun_ms : 0;
+		}
+	}
+
+	ofi_atomic_inc64(&progress->blocks);
+	return ofi_cq_sreadfrom(cq_fid, buf, count, src_addr, cond, timeout);
+}
+
+static ssize_t
+xnet_cq_sread(struct fid_cq *cq_fid, void *buf, size_t count,
+	      const void *cond, int timeout)
+{
+	return xnet_cq_sreadfrom(cq_fid, buf, count, NULL, cond, timeout);
+}
+
 static struct fi_ops_cq xnet_cq_ops = {
 	.size = sizeof(struct fi_ops_cq),
 	.read = ofi_cq_read,
 	.readfrom = xnet_cq_readfrom,
 	.readerr = xnet_cq_readerr,
-	.sread = ofi_cq_sread,
-	.sreadfrom = ofi_cq_sreadfrom,
+	.sread = xnet_cq_sread,
+	.sreadfrom = xnet_cq_sreadfrom,
 	.signal = ofi_cq_signal,
 	.strerror = ofi_cq_strerror,
 };
@@ -318,9 +361,16 @@ free_cq:
 }
 
 
+/* Triggered work is posted once the progress lock is dropped */
+static void xnet_cntr_run(struct util_cntr *cntr, bool clear_signal)
+{
+	xnet_progress(xnet_cntr2_progress(cntr), clear_signal);
+	ofi_trigger_progress(cntr->domain);
+}
+
 static void xnet_cntr_progress(struct util_cntr *cntr)
 {
-	xnet_progress(xnet_cntr2_progress(cntr), false);
+	xnet_cntr_run(cntr, false);
 }
 
 void xnet_cntr_incerr(struct xnet_xfer_entry *xfer_entry)
@@ -337,7 +387,7 @@ static uint64_t xnet_cntr_read(struct fid_cntr *cntr_fid)
 	struct util_cntr *cntr;
 
 	cntr = container_of(cntr_fid, struct util_cntr, cntr_fid);
-	xnet_progress(xnet_cntr2_progress(cntr), false);
+	xnet_cntr_run(cntr, false);
 	return ofi_atomic_get64(&cntr->cnt);
 }
 
@@ -346,7 +396,7 @@ static uint64_t xnet_cntr_readerr(struct fid_cntr *cntr_fid)
 	struct util_cntr *cntr;
 
 	cntr = container_of(cntr_fid, struct util_cntr, cntr_fid);
-	xnet_progress(xnet_cntr2_progress(cntr), false);
+	xnet_cntr_run(cntr, false);
 	return ofi_atomic_get64(&cntr->err);
 }
 
@@ -390,17 +440,37 @@ static int xnet_cntr_seterr(struct fid_cntr *cntr_fid, uint64_t value)
 	return FI_SUCCESS;
 }
 
+static bool
+xnet_cntr_done(struct util_cntr *cntr, uint64_t threshold, uint64_t errcnt)
+{
+	return threshold <= (uint64_t) ofi_atomic_get64(&cntr->cnt) ||
+	       errcnt != (uint64_t) ofi_atomic_get64(&cntr->err);
+}
+
 static int
 xnet_cntr_wait(struct fid_cntr *cntr_fid, uint64_t threshold, int timeout)
 {
+	struct xnet_progress *progress;
 	struct util_cntr *cntr;
-	uint64_t endtime, errcnt;
+	uint64_t endtime, errcnt, start, window;
 	int ret;
 
 	cntr = container_of(cntr_fid, struct util_cntr, cntr_fid);
+	progress = xnet_cntr2_progress(cntr);
 	errcnt = xnet_cntr_readerr(cntr_fid);
 	endtime = ofi_timeout_time(timeout);
 
+	window = xnet_spin_window(progress, timeout);
+	if (window && !xnet_cntr_done(cntr, threshold, errcnt)) {
+		start = ofi_gettime_ns();
+		do {
+			xnet_cntr_run(cntr, false);
+		} while (!xnet_cntr_done(cntr, threshold, errcnt) &&
+			 ofi_gettime_ns() - start < window);
+		xnet_spin_done(progress, start,
+			       xnet_cntr_done(cntr, threshold, errcnt));
+	}
+
 	do {
 		if (threshold <= (uint64_t) ofi_atomic_get64(&cntr->cnt))
 			return FI_SUCCESS;
@@ -411,11 +481,12 @@ xnet_cntr_wait(struct fid_cntr *cntr_fid, uint64_t threshold, int timeout)
 		if (ofi_adjust_timeout(endtime, &timeout))
 			return -FI_ETIMEDOUT;
 
-		ret = xnet_progress_wait(xnet_cntr2_progress(cntr), timeout);
+		ofi_atomic_inc64(&progress->blocks);
+		ret = xnet_progress_wait(progress, timeout);
 		if (ret < 0)
 			break;
 
-		xnet_progress(xnet_cntr2_progress(cntr), true);
+		xnet_cntr_run(cntr, true);
 	} while (true);
 
 	return ret;
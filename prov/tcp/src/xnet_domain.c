@@ -176,8 +176,8 @@ xnet_mplex_mr_regattr(struct fid *fid, const struct fi_mr_attr *attr,
 		uint64_t flags, struct fid_mr **mr_fid)
 {
 	struct xnet_domain *domain;
+	struct xnet_domain *subdomain;
 	struct fid_list_entry *item;
-	struct fid_mr *sub_mr_fid;
 	struct ofi_mr *mr;
 	int ret;
 
@@ -193,8 +193,19 @@ xnet_mplex_mr_regattr(struct fid *fid, const struct fi_mr_attr *attr,
 	ofi_genlock_lock(&domain->subdomain_list_lock);
 	dlist_foreach_container(&domain->subdomain_list,
 				struct fid_list_entry, item, entry) {
-		ret = xnet_mr_regattr(item->fid, attr, flags, &sub_mr_fid);
-		if (ret) {
+		/* Subdomains accept the key handed to the application */
+		subdomain = container_of(item->fid, struct xnet_domain,
+					 util_domain.domain_fid.fid);
+		ofi_genlock_lock(&subdomain->util_domain.lock);
+		ret = ofi_mr_map_insert_key(&subdomain->util_domain.mr_map,
+					    attr, mr->key, mr, flags);
+		ofi_genlock_unlock(&subdomain->util_domain.lock);
+		if (!ret) {
+			ofi_atomic_inc32(&subdomain->util_domain.ref);
+		} else if (ret == -FI_ENOKEY) {
+			/* replayed by xnet_rdm_resolve_domains */
+			ret = 0;
+		} else {
 			FI_WARN(&xnet_prov, FI_LOG_MR,
 				"Failed to reg mr (%ld) from subdomain (%p)\n",
 				mr->key, item->fid);
@@ -329,11 +340,20 @@ static struct fi_ops_domain xnet_mplex_domain_ops = {
 	.query_collective = fi_no_query_collective,
 };
 
+static int xnet_domain_ctrl(struct fid *fid, int command, void *arg)
+{
+	struct xnet_domain *domain;
+
+	domain = container_of(fid, struct xnet_domain,
+			      util_domain.domain_fid.fid);
+	return ofi_trigger_control(&domain->util_domain, command, arg);
+}
+
 static struct fi_ops xnet_mplex_domain_fi_ops = {
 	.size = sizeof(struct fi_ops),
 	.close = xnet_mplex_domain_close,
 	.bind = fi_no_bind,
-	.control = fi_no_control,
+	.control = xnet_domain_ctrl,
 	.ops_open = fi_no_ops_open,
 	.tostr = fi_no_tostr,
 	.ops_set = fi_no_ops_set,
@@ -413,7 +433,7 @@ static struct fi_ops xnet_domain_fi_ops = {
 	.size = sizeof(struct fi_ops),
 	.close = xnet_domain_close,
 	.bind = ofi_domain_bind,
-	.control = fi_no_control,
+	.control = xnet_domain_ctrl,
 	.ops_open = fi_no_ops_open,
 	.tostr = fi_no_tostr,
 	.ops_set = fi_no_ops_set,
@@ -453,6 +473,7 @@ int xnet_domain_open(struct fid_fabric *fabric_fid, struct fi_info *info,
 	if (ret)
 		goto close;
 
+	domain->progress.domain = &domain->util_domain;
 	domain->ep_type = info->ep_attr->type;
 	domain->util_domain.domain_fid.fid.ops = &xnet_domain_fi_ops;
 	domain->util_domain.domain_fid.ops = &xnet_domain_ops;
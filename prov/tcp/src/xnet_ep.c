@@ -53,6 +53,7 @@ static const char *const xnet_opstr[] = {
 	[xnet_op_tag_rts] = "tag rts",
 	[xnet_op_cts] = "cts",
 	[xnet_op_data] = "rndv data",
+	[xnet_op_rts_size] = "rts size",
 };
 
 static const char *xnet_op_str(uint8_t op)
@@ -183,6 +184,18 @@ int xnet_setup_socket(SOCKET sock, struct fi_info *info)
 		}
 	}
 
+#ifdef SO_BUSY_POLL
+	if (xnet_busy_poll > 0) {
+		ret = setsockopt(sock, SOL_SOCKET, SO_BUSY_POLL,
+				 (char *) &xnet_busy_poll,
+				 sizeof(xnet_busy_poll));
+		if (ret) {
+			FI_WARN(&xnet_prov, FI_LOG_EP_CTRL,
+				"setsockopt busy_poll failed\n");
+		}
+	}
+#endif
+
 	ret = fi_fd_nonblock(sock);
 	if (ret) {
 		FI_WARN(&xnet_prov, FI_LOG_EP_CTRL,
@@ -201,6 +214,9 @@ static int xnet_monitor_ep(struct xnet_progress *progress, struct xnet_ep *ep)
 					     false, &ep->bsock.pollin_sockctx);
 	}
 
+	if (progress->edge_poll && ep->state == XNET_CONNECTED)
+		return xnet_monitor_edge(ep, true);
+
 	return xnet_monitor_sock(progress, ep->bsock.sock, ep->pollflags,
 				 &ep->util_ep.ep_fid.fid);
 }
@@ -307,6 +323,8 @@ xnet_ep_accept(struct fid_ep *ep_fid, const void *param, size_t paramlen)
 	ofi_genlock_lock(&progress->ep_lock);
 	ep->pollflags = POLLIN;
 	ret = xnet_monitor_ep(progress, ep);
+	if (!ret)
+		xnet_start_tx(ep);
 	ofi_genlock_unlock(&progress->ep_lock);
 	if (ret)
 		return ret;
@@ -429,6 +447,8 @@ void xnet_ep_disable(struct xnet_ep *ep, int cm_err, void* err_data,
 {
 	struct fi_eq_cm_entry cm_entry = {0};
 	struct fi_eq_err_entry err_entry = {0};
+	struct slist tx_queue, rma_read_queue;
+	bool keep_tx;
 	int ret;
 
 	assert(xnet_progress_locked(xnet_ep2_progress(ep)));
@@ -441,8 +461,12 @@ void xnet_ep_disable(struct xnet_ep *ep, int cm_err, void* err_data,
 		return;
 	};
 
+	/* Nothing was sent yet, the rdm conn retries with the same sends */
+	keep_tx = (ep->util_ep.flags & XNET_EP_KEEP_TX) &&
+		  xnet_ep_connecting(ep);
 	ep->state = XNET_DISCONNECTED;
 	dlist_remove_init(&ep->unexp_entry);
+	dlist_remove_init(&ep->ready_entry);
 	if (!xnet_io_uring)
 		xnet_halt_sock(xnet_ep2_progress(ep), ep->bsock.sock);
 
@@ -450,7 +474,16 @@ void xnet_ep_disable(struct xnet_ep *ep, int cm_err, void* err_data,
 	if (ret && ofi_sockerr() != ENOTCONN)
 		FI_WARN(&xnet_prov, FI_LOG_EP_DATA, "shutdown failed\n");
 
+	slist_init(&tx_queue);
+	slist_init(&rma_read_queue);
+	if (keep_tx) {
+		assert(!ep->cur_tx.entry);
+		slist_swap(&tx_queue, &ep->tx_queue);
+		slist_swap(&rma_read_queue, &ep->rma_read_queue);
+	}
 	xnet_ep_flush_all_queues(ep);
+	slist_splice_tail(&ep->tx_queue, &tx_queue);
+	slist_splice_tail(&ep->rma_read_queue, &rma_read_queue);
 
 	if (cm_err) {
 		err_entry.err = cm_err;
@@ -595,6 +628,7 @@ static int xnet_ep_close(struct fid *fid)
 	ofi_genlock_lock(&progress->ep_lock);
 	ep->state = XNET_DISCONNECTED;
 	dlist_remove_init(&ep->unexp_entry);
+	dlist_remove_init(&ep->ready_entry);
 	if (!xnet_io_uring)
 		xnet_halt_sock(progress, ep->bsock.sock);
 	ofi_close_socket(ep->bsock.sock);
@@ -812,12 +846,14 @@ int xnet_endpoint(struct fid_domain *domain, struct fi_info *info,
 	}
 
 	dlist_init(&ep->unexp_entry);
+	dlist_init(&ep->ready_entry);
 	slist_init(&ep->rx_queue);
 	slist_init(&ep->tx_queue);
 	slist_init(&ep->priority_queue);
 	slist_init(&ep->rma_read_queue);
 	slist_init(&ep->need_ack_queue);
 	slist_init(&ep->async_queue);
+	ep->rts_size = xnet_max_saved_size;
 
 	if (info->ep_attr->rx_ctx_cnt != FI_SHARED_CONTEXT)
 		ep->rx_avail = (int) info->rx_attr->size;
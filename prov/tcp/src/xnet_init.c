@@ -66,12 +66,18 @@ size_t xnet_default_rx_size = 256;
 size_t xnet_zerocopy_size = SIZE_MAX;
 int xnet_trace_msg;
 int xnet_disable_autoprog;
+int xnet_self_comm = 1;
+int xnet_progress_spin;
+int xnet_busy_poll;
+int xnet_edge_poll = 1;
 int xnet_io_uring;
 int xnet_max_saved = 64;
 size_t xnet_max_inject = XNET_DEF_INJECT;
 size_t xnet_buf_size = XNET_DEF_BUF_SIZE;
 size_t xnet_max_saved_size = SIZE_MAX;
+size_t xnet_max_saved_mem = 64 * 1024 * 1024;
 int xnet_firewall_addr = 0;
+size_t xnet_conn_batch = 64;
 
 
 static void xnet_init_env(void)
@@ -141,6 +147,14 @@ static void xnet_init_env(void)
 			"overhead to handle unexpected messages, but may be "
 			"required by some applications to prevents hangs.");
 	fi_param_get_size_t(&xnet_prov, "max_saved_size", &xnet_max_saved_size);
+	fi_param_define(&xnet_prov, "max_saved_mem", FI_PARAM_SIZE_T,
+			"amount of unexpected message data that a domain "
+			"buffers.  Past half of it, peers are asked to send "
+			"tagged messages larger than FI_TCP_MAX_RX_SIZE using "
+			"rendezvous.  Smaller messages, and larger ones that "
+			"are already in flight, are still buffered "
+			"(default: %zu)", xnet_max_saved_mem);
+	fi_param_get_size_t(&xnet_prov, "max_saved_mem", &xnet_max_saved_mem);
 
 	fi_param_define(&xnet_prov, "max_rx_size", FI_PARAM_SIZE_T,
 			"maximum size for message buffers. If set lower "
@@ -183,6 +197,33 @@ static void xnet_init_env(void)
 			"prevent auto-progress thread from starting");
 	fi_param_get_bool(&xnet_prov, "disable_auto_progress",
 			&xnet_disable_autoprog);
+	fi_param_define(&xnet_prov, "self_comm", FI_PARAM_BOOL,
+			"handle transfers from an rdm endpoint to its own "
+			"address without a loopback connection (default: %d)",
+			xnet_self_comm);
+	fi_param_get_bool(&xnet_prov, "self_comm", &xnet_self_comm);
+	fi_param_define(&xnet_prov, "conn_batch", FI_PARAM_SIZE_T,
+			"maximum number of connections that an rdm endpoint "
+			"has in progress at once when pre-connecting to a "
+			"range of peers (default: %zu)", xnet_conn_batch);
+	fi_param_get_size_t(&xnet_prov, "conn_batch", &xnet_conn_batch);
+	if (!xnet_conn_batch)
+		xnet_conn_batch = 1;
+	fi_param_define(&xnet_prov, "progress_spin", FI_PARAM_INT,
+			"maximum time in usec that a blocking wait "
+			"polls the sockets before blocking, adjusted to the "
+			"time between events, 0 to always block (default: %d)",
+			xnet_progress_spin);
+	fi_param_get_int(&xnet_prov, "progress_spin", &xnet_progress_spin);
+	fi_param_define(&xnet_prov, "busy_poll", FI_PARAM_INT,
+			"SO_BUSY_POLL value in usec set on data sockets, "
+			"0 to leave unset (default: %d)", xnet_busy_poll);
+	fi_param_get_int(&xnet_prov, "busy_poll", &xnet_busy_poll);
+	fi_param_define(&xnet_prov, "edge_poll", FI_PARAM_BOOL,
+			"register connected sockets edge-triggered for both "
+			"directions, rather than changing POLLOUT as sends "
+			"block and drain (default: %d)", xnet_edge_poll);
+	fi_param_get_bool(&xnet_prov, "edge_poll", &xnet_edge_poll);
 	fi_param_define(&xnet_prov, "io_uring", FI_PARAM_BOOL,
 			"Enable io_uring support if available (default: %d)", xnet_io_uring);
 	fi_param_get_bool(&xnet_prov, "io_uring",
@@ -149,10 +149,10 @@ xnet_init_tx_iov(struct xnet_xfer_entry *tx_entry, size_t hdr_len,
 
 /* If the transfer should use rendezvous protocol
  * (ready-to-send-> + <-clear-to-send + data->),
- * reformat for RTS-CTS flow.
+ * reformat for RTS-CTS flow.  Also used to switch queued sends when the
+ * peer lowers the rts size.
  */
-static int
-xnet_rts_check(struct xnet_ep *ep, struct xnet_xfer_entry *tx_entry)
+int xnet_rts_check(struct xnet_ep *ep, struct xnet_xfer_entry *tx_entry)
 {
 	uint64_t msg_len, hdr_size;
 	uint8_t rts_ctx;
@@ -160,12 +160,13 @@ xnet_rts_check(struct xnet_ep *ep, struct xnet_xfer_entry *tx_entry)
 	assert(xnet_progress_locked(xnet_ep2_progress(ep)));
 	assert(tx_entry->hdr.base_hdr.op == xnet_op_tag);
 
-	if ((tx_entry->hdr.base_hdr.size <= xnet_max_saved_size) ||
-	    !(ep->util_ep.flags & XNET_EP_RENDEZVOUS))
+	/* inject data is copied after the header */
+	if ((tx_entry->hdr.base_hdr.size <= ep->rts_size) ||
+	    !(ep->util_ep.flags & XNET_EP_RENDEZVOUS) ||
+	    (tx_entry->iov_cnt == 1))
 		return 0;
 
 	/* User data is iov[1+] */
-	assert(tx_entry->iov_cnt > 1);
 	assert(tx_entry->iov[0].iov_len == tx_entry->hdr.base_hdr.hdr_size);
 
 	rts_ctx = ofi_byte_idx_insert(&ep->rts_queue, tx_entry);
@@ -343,7 +344,9 @@ xnet_sendmsg(struct fid_ep *ep_fid, const struct fi_msg *msg, uint64_t flags)
 	tx_entry->cq_flags = xnet_tx_completion_get_msgflags(ep, flags) |
 			     FI_MSG | FI_SEND;
 	xnet_set_ack_flags(tx_entry, flags);
+	xnet_set_more_flag(tx_entry, flags);
 	tx_entry->context = msg->context;
+	xnet_init_trigger(tx_entry, flags);
 
 	xnet_tx_queue_insert(ep, tx_entry);
 unlock:
@@ -548,7 +551,9 @@ xnet_tsendmsg(struct fid_ep *fid_ep, const struct fi_msg_tagged *msg,
 	tx_entry->cq_flags = xnet_tx_completion_get_msgflags(ep, flags) |
 			     FI_TAGGED | FI_SEND;
 	xnet_set_ack_flags(tx_entry, flags);
+	xnet_set_more_flag(tx_entry, flags);
 	tx_entry->context = msg->context;
+	xnet_init_trigger(tx_entry, flags);
 
 	ret = xnet_rts_check(ep, tx_entry);
 	if (!ret)
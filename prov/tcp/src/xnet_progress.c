@@ -82,6 +82,76 @@ static void xnet_submit_uring(struct xnet_uring *uring)
 	assert(ready == submitted);
 }
 
+static int xnet_queue_rts_size(struct xnet_ep *ep, uint64_t size)
+{
+	struct xnet_xfer_entry *resp;
+
+	assert(xnet_progress_locked(xnet_ep2_progress(ep)));
+	assert(ep->util_ep.flags & XNET_EP_RTS_SIZE);
+	resp = xnet_alloc_xfer(xnet_ep2_progress(ep));
+	if (!resp)
+		return -FI_ENOMEM;
+
+	resp->iov[0].iov_base = (void *) &resp->hdr;
+	resp->iov[0].iov_len = sizeof(resp->hdr.rts_size_hdr);
+	resp->iov_cnt = 1;
+
+	resp->hdr.base_hdr.version = XNET_HDR_VERSION;
+	resp->hdr.base_hdr.op_data = 0;
+	resp->hdr.base_hdr.op = xnet_op_rts_size;
+	resp->hdr.base_hdr.size = sizeof(resp->hdr.rts_size_hdr);
+	resp->hdr.base_hdr.hdr_size = (uint8_t) sizeof(resp->hdr.rts_size_hdr);
+	resp->hdr.rts_size_hdr.size = size;
+
+	resp->ctrl_flags = XNET_INTERNAL_XFER;
+	resp->context = NULL;
+
+	xnet_tx_queue_insert(ep, resp);
+	return FI_SUCCESS;
+}
+
+static void xnet_lower_rts_size(struct xnet_ep *ep)
+{
+	if ((ep->util_ep.flags & (XNET_EP_RTS_SIZE | XNET_EP_RTS_LOWERED)) !=
+	    XNET_EP_RTS_SIZE)
+		return;
+
+	FI_INFO(&xnet_prov, FI_LOG_EP_DATA, "%zu bytes of unexpected "
+		"messages saved, peer %zu switches to rendezvous\n",
+		xnet_ep2_progress(ep)->saved_mem, ep->peer->fi_addr);
+	if (!xnet_queue_rts_size(ep, xnet_buf_size))
+		ep->util_ep.flags |= XNET_EP_RTS_LOWERED;
+}
+
+static void xnet_restore_rts_size(struct xnet_ep *ep)
+{
+	assert(ep->util_ep.flags & XNET_EP_RTS_LOWERED);
+	if (xnet_ep2_progress(ep)->saved_mem > xnet_max_saved_mem / 4)
+		return;
+
+	if (!xnet_queue_rts_size(ep, xnet_max_saved_size))
+		ep->util_ep.flags &= ~XNET_EP_RTS_LOWERED;
+}
+
+/* Messages that fit an rx buffer are bounded by xnet_max_saved.  Past half
+ * of xnet_max_saved_mem, peers are asked to send larger ones using
+ * rendezvous, which only saves the header.  The messages those peers had
+ * already sent are still saved, while older peers are limited to the full
+ * budget, after which the connection waits for a matching receive.
+ */
+static bool xnet_saved_mem_avail(struct xnet_ep *ep)
+{
+	struct xnet_progress *progress = xnet_ep2_progress(ep);
+	size_t len = ep->cur_rx.data_left;
+
+	if ((len <= xnet_buf_size) ||
+	    (progress->saved_mem + len <= xnet_max_saved_mem / 2) ||
+	    (ep->util_ep.flags & XNET_EP_RTS_SIZE))
+		return true;
+
+	return progress->saved_mem + len <= xnet_max_saved_mem;
+}
+
 static bool xnet_save_and_cont(struct xnet_ep *ep)
 {
 	assert(xnet_progress_locked(xnet_ep2_progress(ep)));
@@ -90,7 +160,8 @@ static bool xnet_save_and_cont(struct xnet_ep *ep)
 	assert(ep->srx);
 
 	if ((ep->cur_rx.data_left > xnet_max_saved_size) ||
-	    (ep->peer->fi_addr == FI_ADDR_NOTAVAIL))
+	    (ep->peer->fi_addr == FI_ADDR_NOTAVAIL) ||
+	    !xnet_saved_mem_avail(ep))
 		return false;
 
 	if (!ep->saved_msg) {
@@ -126,13 +197,19 @@ xnet_get_save_rx(struct xnet_ep *ep, uint64_t tag)
 	rx_entry->ignore = 0;
 	rx_entry->ctrl_flags = XNET_SAVED_XFER;
 
-	if (ep->cur_rx.data_left <= xnet_buf_size) {
-		rx_entry->user_buf = NULL;
-		rx_entry->iov[0].iov_base = &rx_entry->msg_data;
-		rx_entry->iov[0].iov_len = xnet_buf_size;
-		rx_entry->iov_cnt = 1;
-	} else if (xnet_alloc_xfer_buf(rx_entry, ep->cur_rx.data_left)) {
+	if (!ep->cur_rx.data_left) {
+		rx_entry->iov_cnt = 0;
+	} else if (xnet_alloc_xfer_buf(progress, rx_entry,
+				       ep->cur_rx.data_left)) {
 		goto free_xfer;
+	} else {
+		/* sizes the release in xnet_saved_mem_done() */
+		rx_entry->hdr.base_hdr = ep->cur_rx.hdr.base_hdr;
+		rx_entry->ctrl_flags |= XNET_SAVED_MEM;
+		progress->saved_mem += ep->cur_rx.data_left;
+		if ((ep->cur_rx.data_left > xnet_buf_size) &&
+		    (progress->saved_mem > xnet_max_saved_mem / 2))
+			xnet_lower_rts_size(ep);
 	}
 
 	slist_insert_tail(&rx_entry->entry, &ep->saved_msg->queue);
@@ -171,7 +248,8 @@ static int xnet_handle_truncate(struct xnet_ep *ep)
 	ep->cur_rx.claim_ctx = (void *) (uintptr_t) -1;
 	rx_entry->cq_flags = 0;
 	rx_entry->ctrl_flags = XNET_CLAIM_RECV | XNET_INTERNAL_XFER;
-	ret = xnet_alloc_xfer_buf(rx_entry, ep->cur_rx.data_left);
+	ret = xnet_alloc_xfer_buf(xnet_ep2_progress(ep), rx_entry,
+				  ep->cur_rx.data_left);
 	if (ret) {
 		xnet_free_xfer(xnet_ep2_progress(ep), rx_entry);
 		xnet_reset_rx(ep);
@@ -289,6 +367,7 @@ void xnet_recv_saved(struct xnet_rdm *rdm, struct xnet_xfer_entry *saved_entry,
 	FI_DBG(&xnet_prov, FI_LOG_EP_DATA, "recv matched saved msg "
 	       "tag 0x%zx src %zu\n", saved_entry->tag, saved_entry->src_addr);
 
+	xnet_saved_mem_done(progress, saved_entry);
 	if (saved_entry->ctrl_flags & XNET_FREE_BUF) {
 		buf2free = saved_entry->user_buf;
 		msg_data = saved_entry->user_buf;
@@ -323,7 +402,7 @@ void xnet_recv_saved(struct xnet_rdm *rdm, struct xnet_xfer_entry *saved_entry,
 		}
 	} else if (!saved_entry->saving_ep) {
 		xnet_complete_saved(saved_entry, msg_data);
-		free(buf2free);
+		ofi_slab_free(buf2free);
 	/* TODO: io_uring support
 	} else if (async recv posted using io_uring) {
 	 * If we have an async recv posted to the io_uring, we need to
@@ -355,7 +434,7 @@ void xnet_recv_saved(struct xnet_rdm *rdm, struct xnet_xfer_entry *saved_entry,
 			ofi_consume_iov(&saved_entry->iov[0],
 					&saved_entry->iov_cnt, done_len);
 		}
-		free(buf2free);
+		ofi_slab_free(buf2free);
 	}
 
 	xnet_free_xfer(progress, rx_entry);
@@ -377,6 +456,51 @@ int xnet_uring_pollin_add(struct xnet_progress *progress, int fd,
 	return 0;
 }
 
+/* Connected sockets are registered edge-triggered for POLLIN and POLLOUT
+ * together, and the registration stays fixed until the endpoint is
+ * disabled, so that sends do not change POLLOUT each time the socket
+ * fills and drains.  Reads continue until the socket would block.  Work
+ * that no new socket event would report, such as data staged for FI_MORE
+ * or a read cut short by XNET_EDGE_RX_BUDGET, is picked up from the
+ * ready list on the next progress pass.
+ */
+int xnet_monitor_edge(struct xnet_ep *ep, bool add)
+{
+	struct xnet_progress *progress;
+	int ret;
+
+	progress = xnet_ep2_progress(ep);
+	assert(xnet_progress_locked(progress));
+	assert(progress->edge_poll && ep->state == XNET_CONNECTED);
+
+	ep->pollflags = POLLIN | POLLOUT;
+	ep->util_ep.flags |= XNET_EP_EDGE_POLL;
+	if (add)
+		return xnet_monitor_sock(progress, ep->bsock.sock,
+					 XNET_EDGE_EVENTS,
+					 &ep->util_ep.ep_fid.fid);
+
+	ret = ofi_dynpoll_mod(&progress->epoll_fd, ep->bsock.sock,
+			      XNET_EDGE_EVENTS, &ep->util_ep.ep_fid.fid);
+	xnet_signal_progress(progress);
+	return ret;
+}
+
+static void xnet_ready_ep(struct xnet_ep *ep)
+{
+	struct xnet_progress *progress;
+
+	progress = xnet_ep2_progress(ep);
+	assert(xnet_progress_locked(progress));
+	assert(ep->util_ep.flags & XNET_EP_EDGE_POLL);
+	if (!dlist_empty(&ep->ready_entry))
+		return;
+
+	if (dlist_empty(&progress->ready_list))
+		xnet_signal_progress(progress);
+	dlist_insert_tail(&ep->ready_entry, &progress->ready_list);
+}
+
 static int xnet_update_pollflag(struct xnet_ep *ep, short pollflag, bool set)
 {
 	struct xnet_progress *progress;
@@ -384,6 +508,9 @@ static int xnet_update_pollflag(struct xnet_ep *ep, short pollflag, bool set)
 
 	progress = xnet_ep2_progress(ep);
 	assert(xnet_progress_locked(progress));
+	if (ep->util_ep.flags & XNET_EP_EDGE_POLL)
+		return 0;
+
 	if (set) {
 		if (ep->pollflags & pollflag)
 			return 0;
@@ -436,6 +563,21 @@ static int xnet_send_msg(struct xnet_ep *ep)
 	assert(xnet_progress_locked(xnet_ep2_progress(ep)));
 	assert(ep->cur_tx.entry);
 	tx_entry = ep->cur_tx.entry;
+
+	/* If more data follows, either because the app set FI_MORE or
+	 * because sends are already queued behind this one, stage small
+	 * messages so that the last send pushes them out in one syscall.
+	 */
+	if (((tx_entry->ctrl_flags & XNET_MORE) ||
+	     !slist_empty(&ep->priority_queue) ||
+	     !slist_empty(&ep->tx_queue)) &&
+	    !ofi_bsock_queuev(&ep->bsock, tx_entry->iov, tx_entry->iov_cnt,
+			      &len)) {
+		assert(len == ep->cur_tx.data_left);
+		ep->cur_tx.data_left = 0;
+		return FI_SUCCESS;
+	}
+
 	ret = ofi_bsock_sendv(&ep->bsock, tx_entry->iov, tx_entry->iov_cnt,
 			      &len);
 	if (ret < 0 && ret != -OFI_EINPROGRESS_ASYNC)
@@ -513,6 +655,29 @@ static void xnet_need_cts(struct xnet_ep *ep, struct xnet_xfer_entry *tx_entry)
 	       ofi_total_iov_len(tx_entry->iov, tx_entry->iov_cnt));
 }
 
+static bool xnet_next_tx(struct xnet_ep *ep)
+{
+	if (!slist_empty(&ep->priority_queue)) {
+		ep->cur_tx.entry = container_of(slist_remove_head(
+						&ep->priority_queue),
+				     struct xnet_xfer_entry, entry);
+		assert(ep->cur_tx.entry->ctrl_flags & XNET_INTERNAL_XFER);
+	} else if (!slist_empty(&ep->tx_queue)) {
+		ep->cur_tx.entry = container_of(slist_remove_head(
+						&ep->tx_queue),
+				     struct xnet_xfer_entry, entry);
+		assert(!(ep->cur_tx.entry->ctrl_flags & XNET_INTERNAL_XFER));
+	} else {
+		ep->cur_tx.entry = NULL;
+		return false;
+	}
+
+	ep->cur_tx.data_left = ep->cur_tx.entry->hdr.base_hdr.size;
+	OFI_DBG_SET(ep->cur_tx.entry->hdr.base_hdr.id, ep->tx_id++);
+	ep->hdr_bswap(ep, &ep->cur_tx.entry->hdr.base_hdr);
+	return true;
+}
+
 static void xnet_complete_tx(struct xnet_ep *ep, int ret)
 {
 	struct xnet_xfer_entry *tx_entry;
@@ -547,32 +712,17 @@ static void xnet_complete_tx(struct xnet_ep *ep, int ret)
 		xnet_free_xfer(xnet_ep2_progress(ep), tx_entry);
 	}
 
-	if (!slist_empty(&ep->priority_queue)) {
-		ep->cur_tx.entry = container_of(slist_remove_head(
-						&ep->priority_queue),
-				     struct xnet_xfer_entry, entry);
-		assert(ep->cur_tx.entry->ctrl_flags & XNET_INTERNAL_XFER);
-	} else if (!slist_empty(&ep->tx_queue)) {
-		ep->cur_tx.entry = container_of(slist_remove_head(
-						&ep->tx_queue),
-				     struct xnet_xfer_entry, entry);
-		assert(!(ep->cur_tx.entry->ctrl_flags & XNET_INTERNAL_XFER));
-	} else {
-		ep->cur_tx.entry = NULL;
-		return;
-	}
-
-	ep->cur_tx.data_left = ep->cur_tx.entry->hdr.base_hdr.size;
-	OFI_DBG_SET(ep->cur_tx.entry->hdr.base_hdr.id, ep->tx_id++);
-	ep->hdr_bswap(ep, &ep->cur_tx.entry->hdr.base_hdr);
+	xnet_next_tx(ep);
 }
 
 static void xnet_progress_tx(struct xnet_ep *ep)
 {
+	bool more = false;
 	int ret;
 
 	assert(xnet_progress_locked(xnet_ep2_progress(ep)));
 	while (ep->cur_tx.entry) {
+		more = ep->cur_tx.entry->ctrl_flags & XNET_MORE;
 		ret = xnet_send_msg(ep);
 		if (OFI_SOCK_TRY_SND_RCV_AGAIN(-ret)) {
 			ret = xnet_update_pollflag(ep, POLLOUT, true);
@@ -587,6 +737,21 @@ static void xnet_progress_tx(struct xnet_ep *ep)
 		xnet_complete_tx(ep, ret);
 	}
 
+	/* Data staged for FI_MORE is held until the next send without it
+	 * or the next progress pass, which the POLLOUT request triggers.
+	 * io_uring does not support POLLOUT requests, so flush right away.
+	 */
+	if (more && !xnet_io_uring && ofi_bsock_tosend(&ep->bsock)) {
+		if (ep->util_ep.flags & XNET_EP_EDGE_POLL) {
+			xnet_ready_ep(ep);
+			return;
+		}
+		ret = xnet_update_pollflag(ep, POLLOUT, true);
+		if (!ret)
+			return;
+		goto disable_ep;
+	}
+
 	/* Buffered data is sent first by xnet_send_msg, but if we don't
 	 * have other data to send, we need to try flushing any buffered data.
 	 */
@@ -626,15 +791,14 @@ static void xnet_pmem_commit(struct xnet_ep *ep, struct xnet_xfer_entry *rx_entr
 	}
 }
 
-static int xnet_alter_mrecv(struct xnet_ep *ep, struct xnet_xfer_entry *xfer,
-			    size_t msg_len)
+int xnet_alter_mrecv(struct xnet_srx *srx, struct xnet_xfer_entry *xfer,
+		     size_t msg_len)
 {
 	struct xnet_xfer_entry *recv_entry;
 	size_t left;
 	int ret = FI_SUCCESS;
 
-	assert(ep->srx);
-	assert(xnet_progress_locked(xnet_ep2_progress(ep)));
+	assert(xnet_progress_locked(xnet_srx2_progress(srx)));
 
 	if ((msg_len && !xfer->iov_cnt) || (msg_len > xfer->iov[0].iov_len)) {
 		ret = -FI_ETRUNC;
@@ -642,11 +806,11 @@ static int xnet_alter_mrecv(struct xnet_ep *ep, struct xnet_xfer_entry *xfer,
 	}
 
 	left = xfer->iov[0].iov_len - msg_len;
-	if (!xfer->iov_cnt || (left < ep->srx->min_multi_recv_size))
+	if (!xfer->iov_cnt || (left < srx->min_multi_recv_size))
 		goto complete;
 
 	/* If we can't repost the remaining buffer, return it to the user. */
-	recv_entry = xnet_alloc_xfer(xnet_ep2_progress(ep));
+	recv_entry = xnet_alloc_xfer(xnet_srx2_progress(srx));
 	if (!recv_entry)
 		goto complete;
 
@@ -672,7 +836,7 @@ static int xnet_alter_mrecv(struct xnet_ep *ep, struct xnet_xfer_entry *xfer,
 	recv_entry->iov[0].iov_base = recv_entry->user_buf;
 	recv_entry->iov[0].iov_len = left;
 
-	slist_insert_head(&recv_entry->entry, &ep->srx->rx_queue);
+	slist_insert_head(&recv_entry->entry, &srx->rx_queue);
 	return 0;
 
 complete:
@@ -752,7 +916,7 @@ int xnet_start_recv(struct xnet_ep *ep, struct xnet_xfer_entry *rx_entry)
 
 	if (rx_entry->ctrl_flags & XNET_MULTI_RECV) {
 		assert(msg->hdr.base_hdr.op == xnet_op_msg);
-		(void) xnet_alter_mrecv(ep, rx_entry, recv_len);
+		(void) xnet_alter_mrecv(ep->srx, rx_entry, recv_len);
 	}
 
 	ep->cur_rx.entry = rx_entry;
@@ -810,6 +974,9 @@ static int xnet_handle_tag(struct xnet_ep *ep)
 	assert(xnet_progress_locked(xnet_ep2_progress(ep)));
 	assert(ep->srx);
 
+	if (ep->util_ep.flags & XNET_EP_RTS_LOWERED)
+		xnet_restore_rts_size(ep);
+
 	tag = (msg->hdr.base_hdr.flags & XNET_REMOTE_CQ_DATA) ?
 	      msg->hdr.tag_data_hdr.tag : msg->hdr.tag_hdr.tag;
 
@@ -851,6 +1018,37 @@ static int xnet_handle_cts(struct xnet_ep *ep)
 	return 0;
 }
 
+/* The peer is short of memory for unexpected messages.  Tagged sends
+ * that have not started yet follow the new size.
+ */
+static int xnet_handle_rts_size(struct xnet_ep *ep)
+{
+	struct xnet_xfer_entry *tx_entry;
+	struct slist_entry *item, *prev;
+
+	assert(xnet_progress_locked(xnet_ep2_progress(ep)));
+	if ((ep->cur_rx.hdr.base_hdr.hdr_size !=
+	     sizeof(ep->cur_rx.hdr.rts_size_hdr)) || ep->cur_rx.data_left) {
+		FI_WARN(&xnet_prov, FI_LOG_EP_DATA, "Invalid rts size msg\n");
+		return -FI_EIO;
+	}
+
+	ep->rts_size = ep->cur_rx.hdr.rts_size_hdr.size;
+	FI_DBG(&xnet_prov, FI_LOG_EP_DATA, "rts size %" PRIu64 "\n",
+	       ep->rts_size);
+
+	slist_foreach(&ep->tx_queue, item, prev) {
+		tx_entry = container_of(item, struct xnet_xfer_entry, entry);
+		if ((tx_entry->hdr.base_hdr.op == xnet_op_tag) &&
+		    xnet_rts_check(ep, tx_entry))
+			break;
+	}
+	(void) prev; /* suppress compiler warning */
+
+	xnet_reset_rx(ep);
+	return 0;
+}
+
 static int xnet_handle_data(struct xnet_ep *ep)
 {
 	struct xnet_xfer_entry *rx_entry;
@@ -1121,9 +1319,30 @@ cq_error:
 	xnet_ep_disable(ep, 0, NULL, 0);
 }
 
+/* With an edge-triggered socket, keep reading until it would block,
+ * but only for a bounded number of messages per pass.  A short read
+ * already emptied the socket, and any data arriving after it raises a
+ * new edge, so there is no need to wait for -EAGAIN.
+ */
+static bool xnet_rx_more(struct xnet_ep *ep, int *budget)
+{
+	if (ofi_bsock_readable(&ep->bsock))
+		return true;
+
+	if (!(ep->util_ep.flags & XNET_EP_EDGE_POLL) ||
+	    (ep->state != XNET_CONNECTED) || ep->bsock.rx_drained)
+		return false;
+
+	if (--(*budget))
+		return true;
+
+	xnet_ready_ep(ep);
+	return false;
+}
+
 void xnet_progress_rx(struct xnet_ep *ep)
 {
-	int ret;
+	int ret, budget = XNET_EDGE_RX_BUDGET;
 
 	assert(xnet_progress_locked(xnet_ep2_progress(ep)));
 	do {
@@ -1143,7 +1362,7 @@ void xnet_progress_rx(struct xnet_ep *ep)
 		else if (ret)
 			xnet_ep_disable(ep, 0, NULL, 0);
 
-	} while (!ret && ofi_bsock_readable(&ep->bsock));
+	} while (!ret && xnet_rx_more(ep, &budget));
 
 	if (xnet_io_uring) {
 		if (ret == -OFI_EINPROGRESS_URING)
@@ -1423,7 +1642,7 @@ void xnet_tx_queue_insert(struct xnet_ep *ep,
 	progress = xnet_ep2_progress(ep);
 	assert(xnet_progress_locked(progress));
 
-	if (!ep->cur_tx.entry) {
+	if (!ep->cur_tx.entry && !xnet_ep_connecting(ep)) {
 		ep->cur_tx.entry = tx_entry;
 		ep->cur_tx.data_left = tx_entry->hdr.base_hdr.size;
 		OFI_DBG_SET(tx_entry->hdr.base_hdr.id, ep->tx_id++);
@@ -1438,6 +1657,22 @@ void xnet_tx_queue_insert(struct xnet_ep *ep,
 	}
 }
 
+/* Called once the connection is up to send what was queued while
+ * connecting.  The queued sends are written back to back, so small ones
+ * are coalesced.
+ */
+void xnet_start_tx(struct xnet_ep *ep)
+{
+	assert(xnet_progress_locked(xnet_ep2_progress(ep)));
+	assert(ep->state == XNET_CONNECTED);
+	if (ep->cur_tx.entry || !xnet_next_tx(ep))
+		return;
+
+	xnet_progress_tx(ep);
+	if (xnet_io_uring)
+		xnet_submit_uring(&xnet_ep2_progress(ep)->tx_uring);
+}
+
 static int (*xnet_start_op[xnet_op_max])(struct xnet_ep *ep) = {
 	[xnet_op_msg] = xnet_handle_msg,
 	[xnet_op_tag] = xnet_handle_tag,
@@ -1447,6 +1682,7 @@ static int (*xnet_start_op[xnet_op_max])(struct xnet_ep *ep) = {
 	[xnet_op_tag_rts] = xnet_handle_tag,
 	[xnet_op_cts] = xnet_handle_cts,
 	[xnet_op_data] = xnet_handle_data,
+	[xnet_op_rts_size] = xnet_handle_rts_size,
 };
 
 static void xnet_run_ep(struct xnet_ep *ep, bool pin, bool pout, bool perr)
@@ -1454,6 +1690,13 @@ static void xnet_run_ep(struct xnet_ep *ep, bool pin, bool pout, bool perr)
 	assert(xnet_progress_locked(xnet_ep2_progress(ep)));
 	switch (ep->state) {
 	case XNET_CONNECTED:
+		/* A new edge means data arrived after the last short read,
+		 * even if this pass cannot take it because the current
+		 * message is blocked.  Clear the hint so that resuming the
+		 * message later keeps reading.
+		 */
+		if (pin)
+			ep->bsock.rx_drained = false;
 		if (perr)
 			xnet_progress_async(ep);
 		if (pin && ep->state == XNET_CONNECTED)
@@ -1528,6 +1771,40 @@ xnet_handle_events(struct xnet_progress *progress,
 	}
 }
 
+static void xnet_run_ready(struct xnet_progress *progress)
+{
+	struct dlist_entry ready_list;
+	struct xnet_ep *ep;
+
+	assert(ofi_genlock_held(progress->active_lock));
+	if (dlist_empty(&progress->ready_list))
+		return;
+
+	/* endpoints that run out of budget again wait for the next pass */
+	dlist_init(&ready_list);
+	dlist_splice_tail(&ready_list, &progress->ready_list);
+	while (!dlist_empty(&ready_list)) {
+		dlist_pop_front(&ready_list, struct xnet_ep, ep, ready_entry);
+		dlist_init(&ep->ready_entry);
+		xnet_run_ep(ep, true, true, false);
+	}
+}
+
+/* Grow the batch while epoll fills it, so that a backlog across many
+ * sockets takes fewer calls to drain, and shrink it once passes come
+ * back mostly empty, which bounds the time a pass holds the lock.
+ */
+static void xnet_adapt_events(struct xnet_progress *progress, int nfds)
+{
+	if (nfds == progress->max_events) {
+		progress->max_events = MIN(progress->max_events * 2,
+					   XNET_MAX_EVENTS);
+	} else if (nfds < progress->max_events / 4) {
+		progress->max_events = MAX(progress->max_events / 2,
+					   XNET_MIN_EVENTS);
+	}
+}
+
 void xnet_progress_unexp(struct xnet_progress *progress,
 			 struct dlist_entry *unexp_list)
 {
@@ -1545,6 +1822,33 @@ void xnet_progress_unexp(struct xnet_progress *progress,
 	}
 }
 
+/* Threads waiting for completions poll for twice the average time between
+ * socket events, up to the configured maximum, before they block.  That
+ * way a steady stream of messages is picked up without a thread wakeup,
+ * while sparse traffic blocks right away.  Gaps are capped so that the
+ * window opens again quickly after an idle period.
+ */
+static void xnet_update_spin(struct xnet_progress *progress)
+{
+	uint64_t now, gap, max_ns;
+
+	max_ns = (uint64_t) xnet_progress_spin * 1000;
+	now = ofi_gettime_ns();
+	gap = MIN(now - progress->last_event_ns, 2 * max_ns);
+	progress->last_event_ns = now;
+
+	progress->avg_gap_ns = progress->avg_gap_ns ?
+			       (progress->avg_gap_ns * 7 + gap) / 8 : gap;
+	progress->spin_ns = (progress->avg_gap_ns < max_ns) ?
+			    MIN(2 * progress->avg_gap_ns, max_ns) : 0;
+}
+
+void xnet_spin_done(struct xnet_progress *progress, uint64_t start, bool hit)
+{
+	ofi_atomic_add64(&progress->spin_time_ns, ofi_gettime_ns() - start);
+	ofi_atomic_inc64(hit ? &progress->spin_hits : &progress->spin_misses);
+}
+
 void xnet_run_progress(struct xnet_progress *progress, bool clear_signal)
 {
 	int nfds;
@@ -1557,8 +1861,13 @@ void xnet_run_progress(struct xnet_progress *progress, bool clear_signal)
 		xnet_submit_uring(&progress->tx_uring);
 		xnet_submit_uring(&progress->rx_uring);
 	} else {
+		xnet_run_ready(progress);
 		nfds = ofi_dynpoll_wait(&progress->epoll_fd, &progress->events[0],
-					ARRAY_SIZE(progress->events), 0);
+					progress->max_events, 0);
+		if (nfds > 0 && xnet_progress_spin > 0)
+			xnet_update_spin(progress);
+		if (nfds >= 0)
+			xnet_adapt_events(progress, nfds);
 		xnet_handle_events(progress, &progress->events[0], nfds, clear_signal);
 	}
 }
@@ -1626,7 +1935,8 @@ int xnet_trywait(struct fid_fabric *fabric_fid, struct fid **fid, int count)
 			cq = container_of(fid[i], struct xnet_cq,
 					  util_cq.cq_fid.fid);
 			ofi_genlock_lock(xnet_cq2_progress(cq)->active_lock);
-			if (ofi_cirque_isempty(cq->util_cq.cirq))
+			if (ofi_cirque_isempty(cq->util_cq.cirq) &&
+			    dlist_empty(&xnet_cq2_progress(cq)->ready_list))
 				xnet_reset_wait(cq->util_cq.wait);
 			else
 				ret = -FI_EAGAIN;
@@ -1686,12 +1996,37 @@ int xnet_progress_wait(struct xnet_progress *progress, int timeout)
 		assert(ofi_uring_sq_ready(&progress->tx_uring.ring) == 0);
 		assert(ofi_uring_sq_ready(&progress->rx_uring.ring) == 0);
 	}
+
+	/* Read without the lock.  An endpoint added after this check
+	 * signals the progress thread, or is run by the thread adding it.
+	 */
+	if (!dlist_empty(&progress->ready_list))
+		timeout = 0;
+
+	/* An edge-triggered event taken off the epoll set here would not be
+	 * reported again, so only wait for the set to become readable.
+	 */
+	if (progress->edge_poll)
+		return fi_poll_fd(ofi_dynpoll_get_fd(&progress->epoll_fd),
+				  timeout);
 	return ofi_dynpoll_wait(&progress->epoll_fd, &event, 1, timeout);
 }
 
+static uint64_t xnet_thread_cpu_ns(void)
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+	struct timespec ts;
+
+	if (!clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts))
+		return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+	return 0;
+}
+
 static void *xnet_auto_progress(void *arg)
 {
 	struct xnet_progress *progress = arg;
+	uint64_t start, window;
 	int nfds;
 
 	FI_INFO(&xnet_prov, FI_LOG_DOMAIN, "progress thread starting\n");
@@ -1699,13 +2034,36 @@ static void *xnet_auto_progress(void *arg)
 	while (progress->auto_progress) {
 		ofi_genlock_unlock(progress->active_lock);
 
-		nfds = xnet_progress_wait(progress, -1);
+		nfds = 0;
+		window = xnet_spin_window(progress, -1);
+		if (window) {
+			start = ofi_gettime_ns();
+			do {
+				nfds = xnet_progress_wait(progress, 0);
+			} while (!nfds && ofi_gettime_ns() - start < window);
+			xnet_spin_done(progress, start, nfds != 0);
+		}
+		if (!nfds) {
+			ofi_atomic_inc64(&progress->blocks);
+			nfds = xnet_progress_wait(progress, -1);
+		}
 		ofi_genlock_lock(progress->active_lock);
-		if (nfds >= 0)
-			xnet_run_progress(progress, true);
+		if (nfds < 0)
+			continue;
+
+		xnet_run_progress(progress, true);
+		if (progress->domain) {
+			/* Completions just written may meet a trigger threshold,
+			 * and the app may never read the CQ to run it.
+			 */
+			ofi_genlock_unlock(progress->active_lock);
+			ofi_trigger_progress(progress->domain);
+			ofi_genlock_lock(progress->active_lock);
+		}
 	}
 	ofi_genlock_unlock(progress->active_lock);
-	FI_INFO(&xnet_prov, FI_LOG_DOMAIN, "progress thread exiting\n");
+	FI_INFO(&xnet_prov, FI_LOG_DOMAIN, "progress thread exiting, "
+		"%" PRIu64 " usec cpu\n", xnet_thread_cpu_ns() / 1000);
 	return NULL;
 }
 
@@ -1851,14 +2209,33 @@ static void xnet_destroy_uring(struct xnet_uring *uring,
 
 int xnet_init_progress(struct xnet_progress *progress, struct fi_info *info)
 {
+	struct ofi_slab_attr slab_attr = {
+		.max_size = xnet_buf_size,
+	};
 	int ret;
 
 	progress->fid.fclass = XNET_CLASS_PROGRESS;
 	progress->auto_progress = false;
+	progress->domain = NULL;
+	progress->spin_ns = 0;
+	progress->last_event_ns = ofi_gettime_ns();
+	progress->avg_gap_ns = 0;
+	ofi_atomic_initialize64(&progress->spin_hits, 0);
+	ofi_atomic_initialize64(&progress->spin_misses, 0);
+	ofi_atomic_initialize64(&progress->spin_time_ns, 0);
+	ofi_atomic_initialize64(&progress->blocks, 0);
 	dlist_init(&progress->unexp_msg_list);
 	dlist_init(&progress->unexp_tag_list);
 	dlist_init(&progress->saved_tag_list);
+	dlist_init(&progress->ready_list);
 	slist_init(&progress->event_list);
+	progress->max_events = XNET_MIN_EVENTS;
+	/* zero-copy completions are read from the error queue one at a
+	 * time, which relies on level-triggered POLLERR
+	 */
+	progress->edge_poll = xnet_edge_poll && ofi_have_epoll &&
+			      !xnet_io_uring &&
+			      (xnet_zerocopy_size == SIZE_MAX);
 
 	ret = fd_signal_init(&progress->signal);
 	if (ret)
@@ -1875,20 +2252,24 @@ int xnet_init_progress(struct xnet_progress *progress, struct fi_info *info)
 		goto err2;
 
 	ret = ofi_bufpool_create(&progress->xfer_pool,
-			sizeof(struct xnet_xfer_entry) + xnet_buf_size,
+			sizeof(struct xnet_xfer_entry) + xnet_max_inject,
 			16, 0, 1024, 0);
 	if (ret)
 		goto err3;
 
+	ret = ofi_slab_create(&slab_attr, &progress->rbuf_slab);
+	if (ret)
+		goto err4;
+
 	ret = ofi_dynpoll_add(&progress->epoll_fd, progress->signal.fd[FI_READ_FD],
 			      POLLIN, &progress->fid);
 	if (ret)
-		goto err4;
+		goto err5;
 
 	if (xnet_io_uring) {
 		progress->cqes = calloc(XNET_MAX_EVENTS, sizeof(*progress->cqes));
 		if (!progress->cqes)
-			goto err5;
+			goto err6;
 
 		progress->sockapi = xnet_sockapi_uring;
 
@@ -1898,7 +2279,7 @@ int xnet_init_progress(struct xnet_progress *progress, struct fi_info *info)
 				      &progress->sockapi.tx_uring,
 				      &progress->epoll_fd);
 		if (ret)
-			goto err6;
+			goto err7;
 
 		ret = xnet_init_uring(&progress->rx_uring,
 				      info ? info->rx_attr->size :
@@ -1906,18 +2287,20 @@ int xnet_init_progress(struct xnet_progress *progress, struct fi_info *info)
 				      &progress->sockapi.rx_uring,
 				      &progress->epoll_fd);
 		if (ret)
-			goto err7;
+			goto err8;
 	} else {
 		progress->sockapi = xnet_sockapi_socket;
 	}
 
 	return 0;
-err7:
+err8:
 	xnet_destroy_uring(&progress->tx_uring, &progress->epoll_fd);
-err6:
+err7:
 	ofi_dynpoll_del(&progress->epoll_fd, progress->signal.fd[FI_READ_FD]);
-err5:
+err6:
 	free(progress->cqes);
+err5:
+	ofi_slab_destroy(progress->rbuf_slab);
 err4:
 	ofi_bufpool_destroy(progress->xfer_pool);
 err3:
@@ -1937,12 +2320,22 @@ void xnet_close_progress(struct xnet_progress *progress)
 	assert(dlist_empty(&progress->saved_tag_list));
 	assert(slist_empty(&progress->event_list));
 	xnet_stop_progress(progress);
+	if (xnet_progress_spin > 0) {
+		FI_INFO(&xnet_prov, FI_LOG_DOMAIN, "spin waits: %" PRIi64
+			" hits, %" PRIi64 " misses, %" PRIi64 " usec, "
+			"%" PRIi64 " blocking waits\n",
+			ofi_atomic_get64(&progress->spin_hits),
+			ofi_atomic_get64(&progress->spin_misses),
+			ofi_atomic_get64(&progress->spin_time_ns) / 1000,
+			ofi_atomic_get64(&progress->blocks));
+	}
 	if (xnet_io_uring) {
 		free(progress->cqes);
 		xnet_destroy_uring(&progress->rx_uring, &progress->epoll_fd);
 		xnet_destroy_uring(&progress->tx_uring, &progress->epoll_fd);
 	}
 	ofi_dynpoll_close(&progress->epoll_fd);
+	ofi_slab_destroy(progress->rbuf_slab);
 	ofi_bufpool_destroy(progress->xfer_pool);
 	ofi_genlock_destroy(&progress->ep_lock);
 	ofi_genlock_destroy(&progress->rdm_lock);
@@ -57,15 +57,19 @@ enum {
 	xnet_op_tag_rts,
 	xnet_op_cts,
 	xnet_op_data,
+	xnet_op_rts_size,
 	xnet_op_max
 };
 
 /* Version 1 adds support for tagged rendezvous transfers.
  * ops: tag_rts, cts, data
+ * Version 2 lets a receiver set the size above which the peer sends
+ * tagged messages using rendezvous.
+ * ops: rts_size
  * VERSION_FLAG set in a response indicates the peer checks the version
  */
 #define XNET_RDM_VERSION_FLAG	(1 << 7)
-#define XNET_RDM_VERSION	1
+#define XNET_RDM_VERSION	2
 
 #define XNET_CTRL_HDR_VERSION	3
 
@@ -146,6 +150,12 @@ struct xnet_tag_rts_data_hdr {
 	uint64_t		size;
 };
 
+/* RDM protocol version 2 */
+struct xnet_rts_size_hdr {
+	struct xnet_base_hdr	base_hdr;
+	uint64_t		size;
+};
+
 /* Maximum header is scatter RMA with CQ data */
 #define XNET_MAX_HDR (sizeof(struct xnet_cq_data_hdr) + \
 		     sizeof(struct ofi_rma_iov) * XNET_IOV_LIMIT)
@@ -34,9 +34,18 @@
 #include <errno.h>
 
 #include <ofi_prov.h>
+#include <ofi_iov.h>
 #include "xnet.h"
 
 
+/* Deferred work only completes to the CQ when the op asks for it */
+static inline uint64_t
+xnet_rdm_msg_flags(struct xnet_rdm *rdm, uint64_t flags)
+{
+	return (flags & OFI_TRIGGERED) ? flags :
+	       flags | rdm->util_ep.tx_msg_flags;
+}
+
 static ssize_t
 xnet_rdm_recv(struct fid_ep *ep_fid, void *buf, size_t len,
 	      void *desc, fi_addr_t src_addr, void *context)
@@ -63,6 +72,9 @@ xnet_rdm_recvmsg(struct fid_ep *ep_fid, const struct fi_msg *msg,
 {
 	struct xnet_rdm *rdm;
 
+	if (flags & FI_TRIGGER)
+		return ofi_trigger_msg(ep_fid, FI_OP_RECV, msg, flags);
+
 	rdm = container_of(ep_fid, struct xnet_rdm, util_ep.ep_fid);
 	return fi_recvmsg(&rdm->srx->rx_fid, msg, flags);
 }
@@ -73,6 +85,7 @@ xnet_rdm_send(struct fid_ep *ep_fid, const void *buf, size_t len,
 {
 	struct xnet_rdm *rdm;
 	struct xnet_conn *conn;
+	struct iovec iov;
 	ssize_t ret;
 
 	rdm = container_of(ep_fid, struct xnet_rdm, util_ep.ep_fid);
@@ -81,6 +94,15 @@ xnet_rdm_send(struct fid_ep *ep_fid, const void *buf, size_t len,
 	if (ret)
 		goto unlock;
 
+	if (conn->flags & XNET_CONN_SELF) {
+		iov.iov_base = (void *) buf;
+		iov.iov_len = len;
+		ret = xnet_self_send(rdm, xnet_op_msg, &iov, 1, dest_addr, 0, 0,
+				     rdm->util_ep.tx_op_flags & FI_COMPLETION,
+				     context);
+		goto unlock;
+	}
+
 	ret = fi_send(&conn->ep->util_ep.ep_fid, buf, len, desc, 0, context);
 unlock:
 	ofi_genlock_unlock(&xnet_rdm2_progress(rdm)->rdm_lock);
@@ -101,6 +123,14 @@ xnet_rdm_sendv(struct fid_ep *ep_fid, const struct iovec *iov,
 	if (ret)
 		goto unlock;
 
+	if (conn->flags & XNET_CONN_SELF) {
+		ret = xnet_self_send(rdm, xnet_op_msg, iov, count, dest_addr, 0,
+				     0,
+				     rdm->util_ep.tx_op_flags & FI_COMPLETION,
+				     context);
+		goto unlock;
+	}
+
 	ret = fi_sendv(&conn->ep->util_ep.ep_fid, iov, desc, count, 0, context);
 unlock:
 	ofi_genlock_unlock(&xnet_rdm2_progress(rdm)->rdm_lock);
@@ -115,12 +145,23 @@ xnet_rdm_sendmsg(struct fid_ep *ep_fid, const struct fi_msg *msg,
 	struct xnet_conn *conn;
 	ssize_t ret;
 
+	if (flags & FI_TRIGGER)
+		return ofi_trigger_msg(ep_fid, FI_OP_SEND, msg, flags);
+
 	rdm = container_of(ep_fid, struct xnet_rdm, util_ep.ep_fid);
 	ofi_genlock_lock(&xnet_rdm2_progress(rdm)->rdm_lock);
 	ret = xnet_get_conn(rdm, msg->addr, &conn);
 	if (ret)
 		goto unlock;
 
+	if (conn->flags & XNET_CONN_SELF) {
+		ret = xnet_self_send(rdm, xnet_op_msg, msg->msg_iov,
+				     msg->iov_count, msg->addr, 0, msg->data,
+				     xnet_rdm_msg_flags(rdm, flags),
+				     msg->context);
+		goto unlock;
+	}
+
 	ret = fi_sendmsg(&conn->ep->util_ep.ep_fid, msg, flags);
 unlock:
 	ofi_genlock_unlock(&xnet_rdm2_progress(rdm)->rdm_lock);
@@ -133,6 +174,7 @@ xnet_rdm_inject(struct fid_ep *ep_fid, const void *buf,
 {
 	struct xnet_rdm *rdm;
 	struct xnet_conn *conn;
+	struct iovec iov;
 	ssize_t ret;
 
 	rdm = container_of(ep_fid, struct xnet_rdm, util_ep.ep_fid);
@@ -141,6 +183,14 @@ xnet_rdm_inject(struct fid_ep *ep_fid, const void *buf,
 	if (ret)
 		goto unlock;
 
+	if (conn->flags & XNET_CONN_SELF) {
+		iov.iov_base = (void *) buf;
+		iov.iov_len = len;
+		ret = xnet_self_send(rdm, xnet_op_msg, &iov, 1, dest_addr, 0, 0,
+				     FI_INJECT, NULL);
+		goto unlock;
+	}
+
 	ret = fi_inject(&conn->ep->util_ep.ep_fid, buf, len, 0);
 unlock:
 	ofi_genlock_unlock(&xnet_rdm2_progress(rdm)->rdm_lock);
@@ -153,6 +203,7 @@ xnet_rdm_senddata(struct fid_ep *ep_fid, const void *buf, size_t len,
 {
 	struct xnet_rdm *rdm;
 	struct xnet_conn *conn;
+	struct iovec iov;
 	ssize_t ret;
 
 	rdm = container_of(ep_fid, struct xnet_rdm, util_ep.ep_fid);
@@ -161,6 +212,16 @@ xnet_rdm_senddata(struct fid_ep *ep_fid, const void *buf, size_t len,
 	if (ret)
 		goto unlock;
 
+	if (conn->flags & XNET_CONN_SELF) {
+		iov.iov_base = (void *) buf;
+		iov.iov_len = len;
+		ret = xnet_self_send(rdm, xnet_op_msg, &iov, 1, dest_addr, 0,
+				     data, FI_REMOTE_CQ_DATA |
+				     (rdm->util_ep.tx_op_flags & FI_COMPLETION),
+				     context);
+		goto unlock;
+	}
+
 	ret = fi_senddata(&conn->ep->util_ep.ep_fid, buf, len, desc, data, 0,
 			  context);
 unlock:
@@ -174,6 +235,7 @@ xnet_rdm_injectdata(struct fid_ep *ep_fid, const void *buf, size_t len,
 {
 	struct xnet_rdm *rdm;
 	struct xnet_conn *conn;
+	struct iovec iov;
 	ssize_t ret;
 
 	rdm = container_of(ep_fid, struct xnet_rdm, util_ep.ep_fid);
@@ -182,6 +244,14 @@ xnet_rdm_injectdata(struct fid_ep *ep_fid, const void *buf, size_t len,
 	if (ret)
 		goto unlock;
 
+	if (conn->flags & XNET_CONN_SELF) {
+		iov.iov_base = (void *) buf;
+		iov.iov_len = len;
+		ret = xnet_self_send(rdm, xnet_op_msg, &iov, 1, dest_addr, 0,
+				     data, FI_INJECT | FI_REMOTE_CQ_DATA, NULL);
+		goto unlock;
+	}
+
 	ret = fi_injectdata(&conn->ep->util_ep.ep_fid, buf, len, data, 0);
 unlock:
 	ofi_genlock_unlock(&xnet_rdm2_progress(rdm)->rdm_lock);
@@ -231,6 +301,9 @@ xnet_rdm_trecvmsg(struct fid_ep *ep_fid, const struct fi_msg_tagged *msg,
 {
 	struct xnet_rdm *rdm;
 
+	if (flags & FI_TRIGGER)
+		return ofi_trigger_tagged(ep_fid, FI_OP_TRECV, msg, flags);
+
 	rdm = container_of(ep_fid, struct xnet_rdm, util_ep.ep_fid);
 	return fi_trecvmsg(&rdm->srx->rx_fid, msg, flags);
 }
@@ -241,6 +314,7 @@ xnet_rdm_tsend(struct fid_ep *ep_fid, const void *buf, size_t len,
 {
 	struct xnet_rdm *rdm;
 	struct xnet_conn *conn;
+	struct iovec iov;
 	ssize_t ret;
 
 	rdm = container_of(ep_fid, struct xnet_rdm, util_ep.ep_fid);
@@ -249,6 +323,16 @@ xnet_rdm_tsend(struct fid_ep *ep_fid, const void *buf, size_t len,
 	if (ret)
 		goto unlock;
 
+	if (conn->flags & XNET_CONN_SELF) {
+		iov.iov_base = (void *) buf;
+		iov.iov_len = len;
+		ret = xnet_self_send(rdm, xnet_op_tag, &iov, 1, dest_addr, tag,
+				     0,
+				     rdm->util_ep.tx_op_flags & FI_COMPLETION,
+				     context);
+		goto unlock;
+	}
+
 	ret = fi_tsend(&conn->ep->util_ep.ep_fid, buf, len, desc, 0, tag,
 		       context);
 unlock:
@@ -271,6 +355,14 @@ xnet_rdm_tsendv(struct fid_ep *ep_fid, const struct iovec *iov,
 	if (ret)
 		goto unlock;
 
+	if (conn->flags & XNET_CONN_SELF) {
+		ret = xnet_self_send(rdm, xnet_op_tag, iov, count, dest_addr,
+				     tag, 0,
+				     rdm->util_ep.tx_op_flags & FI_COMPLETION,
+				     context);
+		goto unlock;
+	}
+
 	ret = fi_tsendv(&conn->ep->util_ep.ep_fid, iov, desc, count, 0, tag,
 			context);
 unlock:
@@ -286,12 +378,24 @@ xnet_rdm_tsendmsg(struct fid_ep *ep_fid, const struct fi_msg_tagged *msg,
 	struct xnet_conn *conn;
 	ssize_t ret;
 
+	if (flags & FI_TRIGGER)
+		return ofi_trigger_tagged(ep_fid, FI_OP_TSEND, msg, flags);
+
 	rdm = container_of(ep_fid, struct xnet_rdm, util_ep.ep_fid);
 	ofi_genlock_lock(&xnet_rdm2_progress(rdm)->rdm_lock);
 	ret = xnet_get_conn(rdm, msg->addr, &conn);
 	if (ret)
 		goto unlock;
 
+	if (conn->flags & XNET_CONN_SELF) {
+		ret = xnet_self_send(rdm, xnet_op_tag, msg->msg_iov,
+				     msg->iov_count, msg->addr, msg->tag,
+				     msg->data,
+				     xnet_rdm_msg_flags(rdm, flags),
+				     msg->context);
+		goto unlock;
+	}
+
 	ret = fi_tsendmsg(&conn->ep->util_ep.ep_fid, msg, flags);
 unlock:
 	ofi_genlock_unlock(&xnet_rdm2_progress(rdm)->rdm_lock);
@@ -304,6 +408,7 @@ xnet_rdm_tinject(struct fid_ep *ep_fid, const void *buf,
 {
 	struct xnet_rdm *rdm;
 	struct xnet_conn *conn;
+	struct iovec iov;
 	ssize_t ret;
 
 	rdm = container_of(ep_fid, struct xnet_rdm, util_ep.ep_fid);
@@ -312,6 +417,14 @@ xnet_rdm_tinject(struct fid_ep *ep_fid, const void *buf,
 	if (ret)
 		goto unlock;
 
+	if (conn->flags & XNET_CONN_SELF) {
+		iov.iov_base = (void *) buf;
+		iov.iov_len = len;
+		ret = xnet_self_send(rdm, xnet_op_tag, &iov, 1, dest_addr, tag,
+				     0, FI_INJECT, NULL);
+		goto unlock;
+	}
+
 	ret = fi_tinject(&conn->ep->util_ep.ep_fid, buf, len, 0, tag);
 unlock:
 	ofi_genlock_unlock(&xnet_rdm2_progress(rdm)->rdm_lock);
@@ -325,6 +438,7 @@ xnet_rdm_tsenddata(struct fid_ep *ep_fid, const void *buf, size_t len,
 {
 	struct xnet_rdm *rdm;
 	struct xnet_conn *conn;
+	struct iovec iov;
 	ssize_t ret;
 
 	rdm = container_of(ep_fid, struct xnet_rdm, util_ep.ep_fid);
@@ -333,6 +447,16 @@ xnet_rdm_tsenddata(struct fid_ep *ep_fid, const void *buf, size_t len,
 	if (ret)
 		goto unlock;
 
+	if (conn->flags & XNET_CONN_SELF) {
+		iov.iov_base = (void *) buf;
+		iov.iov_len = len;
+		ret = xnet_self_send(rdm, xnet_op_tag, &iov, 1, dest_addr, tag,
+				     data, FI_REMOTE_CQ_DATA |
+				     (rdm->util_ep.tx_op_flags & FI_COMPLETION),
+				     context);
+		goto unlock;
+	}
+
 	ret = fi_tsenddata(&conn->ep->util_ep.ep_fid, buf, len, desc, data, 0,
 			   tag, context);
 unlock:
@@ -346,6 +470,7 @@ xnet_rdm_tinjectdata(struct fid_ep *ep_fid, const void *buf, size_t len,
 {
 	struct xnet_rdm *rdm;
 	struct xnet_conn *conn;
+	struct iovec iov;
 	ssize_t ret;
 
 	rdm = container_of(ep_fid, struct xnet_rdm, util_ep.ep_fid);
@@ -354,6 +479,14 @@ xnet_rdm_tinjectdata(struct fid_ep *ep_fid, const void *buf, size_t len,
 	if (ret)
 		goto unlock;
 
+	if (conn->flags & XNET_CONN_SELF) {
+		iov.iov_base = (void *) buf;
+		iov.iov_len = len;
+		ret = xnet_self_send(rdm, xnet_op_tag, &iov, 1, dest_addr, tag,
+				     data, FI_INJECT | FI_REMOTE_CQ_DATA, NULL);
+		goto unlock;
+	}
+
 	ret = fi_tinjectdata(&conn->ep->util_ep.ep_fid, buf, len, data, 0, tag);
 unlock:
 	ofi_genlock_unlock(&xnet_rdm2_progress(rdm)->rdm_lock);
@@ -380,6 +513,8 @@ xnet_rdm_read(struct fid_ep *ep_fid, void *buf, size_t len,
 {
 	struct xnet_rdm *rdm;
 	struct xnet_conn *conn;
+	struct iovec iov;
+	struct fi_rma_iov rma_iov;
 	ssize_t ret;
 
 	rdm = container_of(ep_fid, struct xnet_rdm, util_ep.ep_fid);
@@ -388,6 +523,18 @@ xnet_rdm_read(struct fid_ep *ep_fid, void *buf, size_t len,
 	if (ret)
 		goto unlock;
 
+	if (conn->flags & XNET_CONN_SELF) {
+		iov.iov_base = (void *) buf;
+		iov.iov_len = len;
+		rma_iov.addr = addr;
+		rma_iov.len = len;
+		rma_iov.key = key;
+		ret = xnet_self_rma(rdm, false, &iov, 1, &rma_iov, 1, 0,
+				    rdm->util_ep.tx_op_flags & FI_COMPLETION,
+				    context);
+		goto unlock;
+	}
+
 	ret = fi_read(&conn->ep->util_ep.ep_fid, buf, len, desc, src_addr, addr,
 		      key, context);
 unlock:
@@ -402,6 +549,7 @@ xnet_rdm_readv(struct fid_ep *ep_fid, const struct iovec *iov,
 {
 	struct xnet_rdm *rdm;
 	struct xnet_conn *conn;
+	struct fi_rma_iov rma_iov;
 	ssize_t ret;
 
 	rdm = container_of(ep_fid, struct xnet_rdm, util_ep.ep_fid);
@@ -410,6 +558,16 @@ xnet_rdm_readv(struct fid_ep *ep_fid, const struct iovec *iov,
 	if (ret)
 		goto unlock;
 
+	if (conn->flags & XNET_CONN_SELF) {
+		rma_iov.addr = addr;
+		rma_iov.len = ofi_total_iov_len(iov, count);
+		rma_iov.key = key;
+		ret = xnet_self_rma(rdm, false, iov, count, &rma_iov, 1, 0,
+				    rdm->util_ep.tx_op_flags & FI_COMPLETION,
+				    context);
+		goto unlock;
+	}
+
 	ret = fi_readv(&conn->ep->util_ep.ep_fid, iov, desc, count, src_addr, addr,
 		       key, context);
 unlock:
@@ -425,12 +583,23 @@ xnet_rdm_readmsg(struct fid_ep *ep_fid, const struct fi_msg_rma *msg,
 	struct xnet_conn *conn;
 	ssize_t ret;
 
+	if (flags & FI_TRIGGER)
+		return ofi_trigger_rma(ep_fid, FI_OP_READ, msg, flags);
+
 	rdm = container_of(ep_fid, struct xnet_rdm, util_ep.ep_fid);
 	ofi_genlock_lock(&xnet_rdm2_progress(rdm)->rdm_lock);
 	ret = xnet_get_conn(rdm, msg->addr, &conn);
 	if (ret)
 		goto unlock;
 
+	if (conn->flags & XNET_CONN_SELF) {
+		ret = xnet_self_rma(rdm, false, msg->msg_iov, msg->iov_count,
+				    msg->rma_iov, msg->rma_iov_count, 0,
+				    xnet_rdm_msg_flags(rdm, flags),
+				    msg->context);
+		goto unlock;
+	}
+
 	ret = fi_readmsg(&conn->ep->util_ep.ep_fid, msg, flags);
 unlock:
 	ofi_genlock_unlock(&xnet_rdm2_progress(rdm)->rdm_lock);
@@ -444,6 +613,8 @@ xnet_rdm_write(struct fid_ep *ep_fid, const void *buf,
 {
 	struct xnet_rdm *rdm;
 	struct xnet_conn *conn;
+	struct iovec iov;
+	struct fi_rma_iov rma_iov;
 	ssize_t ret;
 
 	rdm = container_of(ep_fid, struct xnet_rdm, util_ep.ep_fid);
@@ -452,6 +623,18 @@ xnet_rdm_write(struct fid_ep *ep_fid, const void *buf,
 	if (ret)
 		goto unlock;
 
+	if (conn->flags & XNET_CONN_SELF) {
+		iov.iov_base = (void *) buf;
+		iov.iov_len = len;
+		rma_iov.addr = addr;
+		rma_iov.len = len;
+		rma_iov.key = key;
+		ret = xnet_self_rma(rdm, true, &iov, 1, &rma_iov, 1, 0,
+				    rdm->util_ep.tx_op_flags & FI_COMPLETION,
+				    context);
+		goto unlock;
+	}
+
 	ret = fi_write(&conn->ep->util_ep.ep_fid, buf, len, desc, dest_addr,
 		       addr, key, context);
 unlock:
@@ -466,6 +649,7 @@ xnet_rdm_writev(struct fid_ep *ep_fid, const struct iovec *iov,
 {
 	struct xnet_rdm *rdm;
 	struct xnet_conn *conn;
+	struct fi_rma_iov rma_iov;
 	ssize_t ret;
 
 	rdm = container_of(ep_fid, struct xnet_rdm, util_ep.ep_fid);
@@ -474,6 +658,16 @@ xnet_rdm_writev(struct fid_ep *ep_fid, const struct iovec *iov,
 	if (ret)
 		goto unlock;
 
+	if (conn->flags & XNET_CONN_SELF) {
+		rma_iov.addr = addr;
+		rma_iov.len = ofi_total_iov_len(iov, count);
+		rma_iov.key = key;
+		ret = xnet_self_rma(rdm, true, iov, count, &rma_iov, 1, 0,
+				    rdm->util_ep.tx_op_flags & FI_COMPLETION,
+				    context);
+		goto unlock;
+	}
+
 	ret = fi_writev(&conn->ep->util_ep.ep_fid, iov, desc, count, dest_addr,
 			addr, key, context);
 unlock:
@@ -489,12 +683,23 @@ xnet_rdm_writemsg(struct fid_ep *ep_fid, const struct fi_msg_rma *msg,
 	struct xnet_conn *conn;
 	ssize_t ret;
 
+	if (flags & FI_TRIGGER)
+		return ofi_trigger_rma(ep_fid, FI_OP_WRITE, msg, flags);
+
 	rdm = container_of(ep_fid, struct xnet_rdm, util_ep.ep_fid);
 	ofi_genlock_lock(&xnet_rdm2_progress(rdm)->rdm_lock);
 	ret = xnet_get_conn(rdm, msg->addr, &conn);
 	if (ret)
 		goto unlock;
 
+	if (conn->flags & XNET_CONN_SELF) {
+		ret = xnet_self_rma(rdm, true, msg->msg_iov, msg->iov_count,
+				    msg->rma_iov, msg->rma_iov_count, msg->data,
+				    xnet_rdm_msg_flags(rdm, flags),
+				    msg->context);
+		goto unlock;
+	}
+
 	ret = fi_writemsg(&conn->ep->util_ep.ep_fid, msg, flags);
 unlock:
 	ofi_genlock_unlock(&xnet_rdm2_progress(rdm)->rdm_lock);
@@ -508,6 +713,8 @@ xnet_rdm_inject_write(struct fid_ep *ep_fid, const void *buf,
 {
 	struct xnet_rdm *rdm;
 	struct xnet_conn *conn;
+	struct iovec iov;
+	struct fi_rma_iov rma_iov;
 	ssize_t ret;
 
 	rdm = container_of(ep_fid, struct xnet_rdm, util_ep.ep_fid);
@@ -516,6 +723,17 @@ xnet_rdm_inject_write(struct fid_ep *ep_fid, const void *buf,
 	if (ret)
 		goto unlock;
 
+	if (conn->flags & XNET_CONN_SELF) {
+		iov.iov_base = (void *) buf;
+		iov.iov_len = len;
+		rma_iov.addr = addr;
+		rma_iov.len = len;
+		rma_iov.key = key;
+		ret = xnet_self_rma(rdm, true, &iov, 1, &rma_iov, 1, 0,
+				    FI_INJECT, NULL);
+		goto unlock;
+	}
+
 	ret = fi_inject_write(&conn->ep->util_ep.ep_fid, buf, len, dest_addr,
 			      addr, key);
 unlock:
@@ -531,6 +749,8 @@ xnet_rdm_writedata(struct fid_ep *ep_fid, const void *buf,
 {
 	struct xnet_rdm *rdm;
 	struct xnet_conn *conn;
+	struct iovec iov;
+	struct fi_rma_iov rma_iov;
 	ssize_t ret;
 
 	rdm = container_of(ep_fid, struct xnet_rdm, util_ep.ep_fid);
@@ -539,6 +759,18 @@ xnet_rdm_writedata(struct fid_ep *ep_fid, const void *buf,
 	if (ret)
 		goto unlock;
 
+	if (conn->flags & XNET_CONN_SELF) {
+		iov.iov_base = (void *) buf;
+		iov.iov_len = len;
+		rma_iov.addr = addr;
+		rma_iov.len = len;
+		rma_iov.key = key;
+		ret = xnet_self_rma(rdm, true, &iov, 1, &rma_iov, 1, data,
+				    (rdm->util_ep.tx_op_flags & FI_COMPLETION) |
+				    FI_REMOTE_CQ_DATA, context);
+		goto unlock;
+	}
+
 	ret = fi_writedata(&conn->ep->util_ep.ep_fid, buf, len, desc, data,
 			   dest_addr, addr, key, context);
 unlock:
@@ -553,6 +785,8 @@ xnet_rdm_inject_writedata(struct fid_ep *ep_fid, const void *buf,
 {
 	struct xnet_rdm *rdm;
 	struct xnet_conn *conn;
+	struct iovec iov;
+	struct fi_rma_iov rma_iov;
 	ssize_t ret;
 
 	rdm = container_of(ep_fid, struct xnet_rdm, util_ep.ep_fid);
@@ -561,6 +795,17 @@ xnet_rdm_inject_writedata(struct fid_ep *ep_fid, const void *buf,
 	if (ret)
 		goto unlock;
 
+	if (conn->flags & XNET_CONN_SELF) {
+		iov.iov_base = (void *) buf;
+		iov.iov_len = len;
+		rma_iov.addr = addr;
+		rma_iov.len = len;
+		rma_iov.key = key;
+		ret = xnet_self_rma(rdm, true, &iov, 1, &rma_iov, 1, data,
+				    FI_INJECT | FI_REMOTE_CQ_DATA, NULL);
+		goto unlock;
+	}
+
 	ret = fi_inject_writedata(&conn->ep->util_ep.ep_fid, buf, len, data,
 				  dest_addr, addr, key);
 unlock:
@@ -686,6 +931,11 @@ static int xnet_rdm_setopt(struct fid *fid, int level, int optname,
 			"FI_OPT_MIN_MULTI_RECV set to %zu\n",
 			rdm->srx->min_multi_recv_size);
 		break;
+	case FI_OPT_TCP_PRECONNECT:
+		if (optlen != sizeof(struct fi_rxm_preconnect))
+			return -FI_EINVAL;
+
+		return xnet_preconnect(rdm, optval);
 	default:
 		return -ENOPROTOOPT;
 	}
@@ -772,17 +1022,21 @@ out:
 	return ret;
 }
 
-static int xnet_reg_subdomain_mr(struct ofi_rbmap *map, struct ofi_rbnode *node, void *context)
+static int xnet_reg_subdomain_mr(struct ofi_mr_map *map,
+				 struct fi_mr_attr *attr, void *context)
 {
 	int ret;
-	struct fi_mr_attr *attr = (struct fi_mr_attr *)node->data;
 	struct xnet_domain *subdomain = context;
 
-	ret = ofi_mr_map_insert(&subdomain->util_domain.mr_map, attr,
-				&attr->requested_key, attr->context,
-				((struct ofi_mr*)attr->context)->flags);
+	/* The stored attr already holds the iov of a dmabuf region.
+	 * -FI_ENOKEY means a racing registration got here first.
+	 */
+	ret = ofi_mr_map_insert_key(&subdomain->util_domain.mr_map, attr,
+				    attr->requested_key, attr->context, 0);
+	if (ret == -FI_ENOKEY)
+		return FI_SUCCESS;
 	if (ret) {
-		XNET_WARN_ERR(FI_LOG_MR, "ofi_mr_map_insert", ret);
+		XNET_WARN_ERR(FI_LOG_MR, "ofi_mr_map_insert_key", ret);
 		return ret;
 	}
 
@@ -882,9 +1136,8 @@ int xnet_rdm_resolve_domains(struct xnet_rdm *rdm)
 			goto out;
 		}
 
-		ret = ofi_rbmap_foreach(domain->util_domain.mr_map.rbtree,
-					domain->util_domain.mr_map.rbtree->root,
-					xnet_reg_subdomain_mr, subdomain);
+		ret = ofi_mr_map_foreach(&domain->util_domain.mr_map,
+					 xnet_reg_subdomain_mr, subdomain);
 		if (ret)
 			goto out;
 	}
@@ -992,6 +1245,8 @@ static int xnet_rdm_close(struct fid *fid)
 	int ret;
 
 	rdm = container_of(fid, struct xnet_rdm, util_ep.ep_fid.fid);
+	ofi_trigger_flush_ep(rdm->util_ep.domain, &rdm->util_ep.ep_fid);
+
 	ofi_genlock_lock(&xnet_rdm2_progress(rdm)->rdm_lock);
 	ret = fi_close(&rdm->pep->util_pep.pep_fid.fid);
 	if (ret) {
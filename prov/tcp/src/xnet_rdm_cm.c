@@ -70,6 +70,16 @@ static int xnet_match_event(struct slist_entry *item, const void *arg)
 	return event->cm_entry.fid == &ep->util_ep.ep_fid.fid;
 }
 
+static void xnet_preconnect_done(struct xnet_conn *conn)
+{
+	if (!(conn->flags & XNET_CONN_PRECONNECT))
+		return;
+
+	conn->flags &= ~XNET_CONN_PRECONNECT;
+	assert(conn->rdm->preconnect_cnt);
+	conn->rdm->preconnect_cnt--;
+}
+
 static void xnet_close_conn(struct xnet_conn *conn)
 {
 	struct xnet_event *event;
@@ -77,6 +87,7 @@ static void xnet_close_conn(struct xnet_conn *conn)
 
 	FI_DBG(&xnet_prov, FI_LOG_EP_CTRL, "closing conn %p\n", conn);
 	assert(xnet_progress_locked(xnet_rdm2_progress(conn->rdm)));
+	xnet_preconnect_done(conn);
 
 	if (conn->flags & XNET_CONN_RX_LOOPBACK) {
 		if (conn == conn->rdm->rx_loopback)
@@ -101,6 +112,16 @@ static void xnet_close_conn(struct xnet_conn *conn)
 	if (conn->ep->peer)
 		util_put_peer(conn->ep->peer);
 
+	/* Sends queued on a connection that never came up were not started.
+	 * Keep them for the next connection to this peer.
+	 */
+	if (conn->ep->state != XNET_CONNECTED) {
+		assert(!conn->ep->cur_tx.entry);
+		slist_splice_tail(&conn->tx_queue, &conn->ep->tx_queue);
+		slist_splice_tail(&conn->rma_read_queue,
+				  &conn->ep->rma_read_queue);
+	}
+
 	fi_close(&conn->ep->util_ep.ep_fid.fid);
 	conn->ep = NULL;
 }
@@ -207,6 +228,9 @@ static int xnet_open_conn(struct xnet_conn *conn, struct fi_info *info)
 		goto err;
 	}
 
+	conn->ep->util_ep.flags |= XNET_EP_KEEP_TX;
+	slist_splice_tail(&conn->ep->tx_queue, &conn->tx_queue);
+	slist_splice_tail(&conn->ep->rma_read_queue, &conn->rma_read_queue);
 	return 0;
 
 err:
@@ -258,12 +282,27 @@ err:
 	return ret;
 }
 
+static void xnet_fail_conn_tx(struct xnet_conn *conn, int err)
+{
+	struct xnet_progress *progress = xnet_rdm2_progress(conn->rdm);
+	struct xnet_xfer_entry *xfer;
+
+	slist_splice_tail(&conn->tx_queue, &conn->rma_read_queue);
+	while (!slist_empty(&conn->tx_queue)) {
+		xfer = container_of(slist_remove_head(&conn->tx_queue),
+				    struct xnet_xfer_entry, entry);
+		xnet_report_error(xfer, err);
+		xnet_free_xfer(progress, xfer);
+	}
+}
+
 static void xnet_free_conn(struct xnet_conn *conn)
 {
 	struct rxm_av *av;
 
 	FI_DBG(&xnet_prov, FI_LOG_EP_CTRL, "free conn %p\n", conn);
 	assert(xnet_progress_locked(xnet_rdm2_progress(conn->rdm)));
+	xnet_fail_conn_tx(conn, FI_ECANCELED);
 
 	if (conn->flags & XNET_CONN_INDEXED)
 		ofi_idm_clear(&conn->rdm->conn_idx_map, conn->peer->index);
@@ -322,7 +361,10 @@ static struct xnet_conn *xnet_alloc_conn(struct xnet_rdm *rdm,
 
 	conn->rdm = rdm;
 	conn->flags = 0;
+	conn->retries = 0;
 	conn->peer = peer;
+	slist_init(&conn->tx_queue);
+	slist_init(&conn->rma_read_queue);
 	rxm_ref_peer(peer);
 
 	FI_DBG(&xnet_prov, FI_LOG_EP_CTRL, "allocated conn %p\n", conn);
@@ -350,6 +392,10 @@ static struct xnet_conn *xnet_add_conn(struct xnet_rdm *rdm,
 	}
 
 	conn->flags |= XNET_CONN_INDEXED;
+	if (xnet_self_comm &&
+	    peer->addr.sa.sa_family == rdm->addr.sa.sa_family &&
+	    !ofi_addr_cmp(&xnet_prov, &peer->addr.sa, &rdm->addr.sa))
+		conn->flags |= XNET_CONN_SELF;
 	return conn;
 }
 
@@ -369,6 +415,10 @@ ssize_t xnet_get_conn(struct xnet_rdm *rdm, fi_addr_t addr,
 	if (!*conn)
 		return -FI_ENOMEM;
 
+	/* Transfers to ourself are handled without a connection. */
+	if ((*conn)->flags & XNET_CONN_SELF)
+		return 0;
+
 	if (!(*conn)->ep) {
 		if ((*peer)->firewall_addr) {
 			FI_WARN(&xnet_prov, FI_LOG_EP_CTRL,
@@ -383,6 +433,10 @@ ssize_t xnet_get_conn(struct xnet_rdm *rdm, fi_addr_t addr,
 			return ret;
 	}
 
+	/* The transfer is queued on the ep and sent once connected. */
+	if (xnet_ep_connecting((*conn)->ep))
+		return 0;
+
 	if ((*conn)->ep->state != XNET_CONNECTED) {
 		/* Force progress for apps that simply retry sending without
 		 * trying to drive progress in between.
@@ -420,6 +474,9 @@ static void xnet_set_protocol(struct xnet_ep *ep, struct xnet_rdm_cm *msg)
 		return;
 
 	switch (msg->version & ~XNET_RDM_VERSION_FLAG) {
+	case 2:
+		ep->util_ep.flags |= XNET_EP_RTS_SIZE;
+		/* fall through */
 	case 1:
 		ep->util_ep.flags |= XNET_EP_RENDEZVOUS;
 		/* fall through */
@@ -573,17 +630,94 @@ static void xnet_process_connected(struct fi_eq_cm_entry *cm_entry)
 	conn = cm_entry->fid->context;
 	msg = (struct xnet_rdm_cm *) cm_entry->data;
 	conn->remote_pid = ntohl(msg->pid);
+	conn->retries = 0;
 	xnet_set_protocol(conn->ep, msg);
+	xnet_preconnect_done(conn);
 
 	FI_INFO(&xnet_prov, FI_LOG_EP_CTRL, "peer %s feature supported: %x\n",
 		conn->peer->str_addr, msg->features);
 }
 
+/* A connection attempt failed before anything was sent on it, which may
+ * just mean the peer rejected it in favor of its own request to us.
+ * Retry a few times with the queued sends before failing them.
+ */
+static bool xnet_retry_conn(struct xnet_conn *conn)
+{
+	if (slist_empty(&conn->tx_queue))
+		return false;
+
+	if (conn->retries++ < XNET_CONN_RETRIES && !conn->peer->firewall_addr &&
+	    !xnet_rdm_connect(conn))
+		return true;
+
+	FI_WARN(&xnet_prov, FI_LOG_EP_CTRL, "unable to connect to %s\n",
+		conn->peer->str_addr);
+	xnet_fail_conn_tx(conn, FI_ENOTCONN);
+	return false;
+}
+
+static void xnet_preconnect_progress(struct xnet_rdm *rdm)
+{
+	struct util_peer_addr **peer;
+	struct xnet_conn *conn;
+	fi_addr_t addr;
+	int ret;
+
+	assert(xnet_progress_locked(xnet_rdm2_progress(rdm)));
+	while (rdm->preconnect_next < rdm->preconnect_end &&
+	       rdm->preconnect_cnt < xnet_conn_batch) {
+		addr = rdm->preconnect_next++;
+		if (!ofi_bufpool_ibuf_is_valid(rdm->util_ep.av->av_entry_pool,
+					       addr))
+			continue;
+
+		peer = ofi_av_addr_context(rdm->util_ep.av, addr);
+		if (!*peer || (*peer)->firewall_addr)
+			continue;
+
+		conn = xnet_add_conn(rdm, *peer);
+		if (!conn)
+			break;
+
+		if (conn->ep || (conn->flags & XNET_CONN_SELF))
+			continue;
+
+		ret = xnet_rdm_connect(conn);
+		if (ret) {
+			FI_WARN(&xnet_prov, FI_LOG_EP_CTRL,
+				"unable to pre-connect to fi_addr %" PRIu64
+				": %s\n", addr, fi_strerror(-ret));
+			continue;
+		}
+
+		conn->flags |= XNET_CONN_PRECONNECT;
+		rdm->preconnect_cnt++;
+	}
+}
+
+int xnet_preconnect(struct xnet_rdm *rdm,
+		    const struct fi_rxm_preconnect *range)
+{
+	struct xnet_progress *progress = xnet_rdm2_progress(rdm);
+
+	if (!rdm->util_ep.av || !rdm->pep)
+		return -FI_EOPBADSTATE;
+
+	ofi_genlock_lock(&progress->rdm_lock);
+	rdm->preconnect_next = range->addr;
+	rdm->preconnect_end = range->addr + range->count;
+	xnet_preconnect_progress(rdm);
+	ofi_genlock_unlock(&progress->rdm_lock);
+	return 0;
+}
+
 void xnet_handle_event_list(struct xnet_progress *progress)
 {
 	struct xnet_event *event;
 	struct slist_entry *item;
 	struct xnet_conn *conn;
+	struct xnet_rdm *rdm;
 
 	assert(ofi_genlock_held(&progress->rdm_lock));
 	while (!slist_empty(&progress->event_list)) {
@@ -603,12 +737,17 @@ void xnet_handle_event_list(struct xnet_progress *progress)
 		case FI_SHUTDOWN:
 			conn = event->cm_entry.fid->context;
 			xnet_close_conn(conn);
-			xnet_free_conn(conn);
+			if (!xnet_retry_conn(conn))
+				xnet_free_conn(conn);
 			break;
 		default:
 			assert(0);
 			break;
 		}
+
+		rdm = event->rdm;
 		free(event);
+		if (rdm->preconnect_next < rdm->preconnect_end)
+			xnet_preconnect_progress(rdm);
 	};
 }
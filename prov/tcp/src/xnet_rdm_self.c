@@ -0,0 +1,382 @@
+/*
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <ofi_iov.h>
+#include "xnet.h"
+
+/* Transfers from an rdm endpoint to its own address do not go through a
+ * loopback connection.  Messages are matched directly against the srx
+ * and copied into the posted buffer, or saved as unexpected the same way
+ * as a message read from a socket.  RMA operations copy to or from the
+ * registered region.  Completions are reported as if the transfer had
+ * gone through the socket.
+ */
+
+static struct xnet_xfer_entry *
+xnet_alloc_self_tx(struct xnet_rdm *rdm, uint64_t cq_flags, int cntr_id,
+		   void *context)
+{
+	struct xnet_xfer_entry *tx_entry;
+
+	tx_entry = xnet_alloc_xfer(xnet_rdm2_progress(rdm));
+	if (tx_entry) {
+		tx_entry->cq_flags = cq_flags;
+		tx_entry->cq = container_of(rdm->util_ep.tx_cq,
+					    struct xnet_cq, util_cq);
+		tx_entry->cntr = rdm->util_ep.cntrs[cntr_id];
+		tx_entry->context = context;
+	}
+	return tx_entry;
+}
+
+static void
+xnet_complete_self(struct xnet_rdm *rdm, struct xnet_xfer_entry *xfer,
+		   int err)
+{
+	if (err) {
+		xnet_cntr_incerr(xfer);
+		xnet_report_error(xfer, err);
+	} else {
+		xnet_report_success(xfer);
+	}
+	xnet_free_xfer(xnet_rdm2_progress(rdm), xfer);
+}
+
+static size_t
+xnet_copy_self(const struct iovec *dst, size_t dst_cnt,
+	       const struct iovec *src, size_t src_cnt)
+{
+	size_t i, len = 0;
+
+	for (i = 0; i < src_cnt; i++) {
+		len += ofi_copy_to_iov(dst, dst_cnt, len, src[i].iov_base,
+				       src[i].iov_len);
+	}
+	return len;
+}
+
+static void
+xnet_init_self_hdr(union xnet_hdrs *hdr, uint8_t op, size_t len,
+		   uint64_t tag, uint64_t data, uint64_t flags)
+{
+	size_t hdr_len;
+
+	memset(&hdr->base_hdr, 0, sizeof(hdr->base_hdr));
+	hdr->base_hdr.version = XNET_HDR_VERSION;
+	hdr->base_hdr.op = op;
+	if (flags & FI_REMOTE_CQ_DATA) {
+		hdr->base_hdr.flags = XNET_REMOTE_CQ_DATA;
+		if (op == xnet_op_tag) {
+			hdr->tag_data_hdr.cq_data = data;
+			hdr->tag_data_hdr.tag = tag;
+			hdr_len = sizeof(hdr->tag_data_hdr);
+		} else {
+			hdr->cq_data_hdr.cq_data = data;
+			hdr_len = sizeof(hdr->cq_data_hdr);
+		}
+	} else if (op == xnet_op_tag) {
+		hdr->tag_hdr.tag = tag;
+		hdr_len = sizeof(hdr->tag_hdr);
+	} else {
+		hdr_len = sizeof(hdr->base_hdr);
+	}
+	hdr->base_hdr.hdr_size = (uint8_t) hdr_len;
+	hdr->base_hdr.size = hdr_len + len;
+}
+
+static void
+xnet_recv_self(struct xnet_rdm *rdm, struct xnet_xfer_entry *rx_entry,
+	       union xnet_hdrs *hdr, const struct iovec *iov, size_t count,
+	       fi_addr_t addr)
+{
+	size_t msg_len;
+	int ret = 0;
+
+	assert(xnet_progress_locked(xnet_rdm2_progress(rdm)));
+	msg_len = xnet_msg_len(hdr);
+	memcpy(&rx_entry->hdr, hdr, (size_t) hdr->base_hdr.hdr_size);
+	rx_entry->src_addr = addr;
+	rx_entry->cq_flags |= rdm->util_ep.rx_op_flags & FI_COMPLETION;
+
+	if (rx_entry->ctrl_flags & XNET_MULTI_RECV)
+		ret = xnet_alter_mrecv(rdm->srx, rx_entry, msg_len);
+
+	if (!ret) {
+		(void) ofi_truncate_iov(rx_entry->iov, &rx_entry->iov_cnt,
+					msg_len);
+		if (xnet_copy_self(rx_entry->iov, rx_entry->iov_cnt,
+				   iov, count) != msg_len)
+			ret = -FI_ETRUNC;
+	}
+
+	if (ret)
+		FI_WARN(&xnet_prov, FI_LOG_EP_DATA, "self recv truncated\n");
+	xnet_complete_self(rdm, rx_entry, -ret);
+}
+
+/* Unexpected messages to ourself are bounded like those read from a
+ * socket, see xnet_save_and_cont(), but the sender gets -FI_EAGAIN
+ * instead of the connection being left unread.
+ */
+static bool
+xnet_self_save_avail(struct xnet_srx *srx, struct xnet_saved_msg *saved_msg,
+		     size_t msg_len)
+{
+	struct xnet_progress *progress = xnet_srx2_progress(srx);
+
+	if ((msg_len > xnet_max_saved_size) ||
+	    ((msg_len > xnet_buf_size) &&
+	     (progress->saved_mem + msg_len > xnet_max_saved_mem)))
+		return false;
+
+	return (saved_msg ? saved_msg->cnt : srx->self_cnt) < xnet_max_saved;
+}
+
+static int
+xnet_save_self(struct xnet_rdm *rdm, union xnet_hdrs *hdr,
+	       const struct iovec *iov, size_t count, fi_addr_t addr,
+	       uint64_t tag)
+{
+	struct xnet_progress *progress;
+	struct xnet_saved_msg *saved_msg;
+	struct xnet_xfer_entry *saved_entry;
+	size_t msg_len;
+
+	progress = xnet_rdm2_progress(rdm);
+	assert(xnet_progress_locked(progress));
+	if (hdr->base_hdr.op == xnet_op_tag) {
+		saved_msg = ofi_array_at(&rdm->srx->saved_msgs, addr);
+		if (!saved_msg)
+			return -FI_ENOMEM;
+	} else {
+		saved_msg = NULL;
+	}
+
+	msg_len = xnet_msg_len(hdr);
+	if (!xnet_self_save_avail(rdm->srx, saved_msg, msg_len))
+		return -FI_EAGAIN;
+
+	saved_entry = xnet_alloc_xfer(progress);
+	if (!saved_entry)
+		return -FI_EAGAIN;
+
+	if (!msg_len) {
+		saved_entry->iov_cnt = 0;
+	} else if (xnet_alloc_xfer_buf(progress, saved_entry, msg_len)) {
+		xnet_free_xfer(progress, saved_entry);
+		return -FI_EAGAIN;
+	} else {
+		(void) ofi_copy_from_iov(saved_entry->user_buf, msg_len,
+					 iov, count, 0);
+	}
+
+	memcpy(&saved_entry->hdr, hdr, (size_t) hdr->base_hdr.hdr_size);
+	saved_entry->src_addr = addr;
+	saved_entry->cq_flags = rdm->util_ep.rx_op_flags & FI_COMPLETION;
+	saved_entry->saving_ep = NULL;
+	if (msg_len) {
+		/* sizes the release in xnet_saved_mem_done() */
+		saved_entry->ctrl_flags |= XNET_SAVED_MEM;
+		progress->saved_mem += msg_len;
+	}
+
+	if (!saved_msg) {
+		slist_insert_tail(&saved_entry->entry, &rdm->srx->self_queue);
+		rdm->srx->self_cnt++;
+		return 0;
+	}
+
+	saved_entry->tag = tag;
+	saved_entry->ignore = 0;
+	saved_entry->ctrl_flags |= XNET_SAVED_XFER;
+	slist_insert_tail(&saved_entry->entry, &saved_msg->queue);
+	if (!saved_msg->cnt++) {
+		assert(dlist_empty(&saved_msg->entry));
+		dlist_insert_tail(&saved_msg->entry, &progress->saved_tag_list);
+	}
+	xnet_prof_unexp_msg(rdm->srx->profile, 1);
+	return 0;
+}
+
+/* Untagged messages sent to ourself are queued until a receive is posted,
+ * and must be received in order.
+ */
+void xnet_progress_self(struct xnet_srx *srx)
+{
+	struct xnet_xfer_entry *saved_entry, *rx_entry;
+
+	assert(xnet_progress_locked(xnet_srx2_progress(srx)));
+	while (!slist_empty(&srx->self_queue) && !slist_empty(&srx->rx_queue)) {
+		saved_entry = container_of(slist_remove_head(&srx->self_queue),
+					   struct xnet_xfer_entry, entry);
+		srx->self_cnt--;
+		rx_entry = container_of(slist_remove_head(&srx->rx_queue),
+					struct xnet_xfer_entry, entry);
+		xnet_recv_self(srx->rdm, rx_entry, &saved_entry->hdr,
+			       saved_entry->iov, saved_entry->iov_cnt,
+			       saved_entry->src_addr);
+		xnet_free_xfer(xnet_srx2_progress(srx), saved_entry);
+	}
+}
+
+ssize_t xnet_self_send(struct xnet_rdm *rdm, uint8_t op,
+		       const struct iovec *iov, size_t count, fi_addr_t addr,
+		       uint64_t tag, uint64_t data, uint64_t flags,
+		       void *context)
+{
+	struct xnet_xfer_entry *tx_entry, *rx_entry;
+	struct xnet_srx *srx = rdm->srx;
+	union xnet_hdrs hdr;
+	ssize_t ret;
+
+	assert(xnet_progress_locked(xnet_rdm2_progress(rdm)));
+	assert(count <= XNET_IOV_LIMIT);
+	tx_entry = xnet_alloc_self_tx(rdm, (flags & FI_COMPLETION) | FI_SEND |
+				      (op == xnet_op_tag ? FI_TAGGED : FI_MSG),
+				      CNTR_TX, context);
+	if (!tx_entry)
+		return -FI_EAGAIN;
+	xnet_init_trigger(tx_entry, flags);
+
+	xnet_init_self_hdr(&hdr, op, ofi_total_iov_len(iov, count),
+			   tag, data, flags);
+	if (op == xnet_op_tag) {
+		rx_entry = xnet_srx_match_src(srx, addr, tag);
+	} else if (slist_empty(&srx->self_queue) &&
+		   !slist_empty(&srx->rx_queue)) {
+		rx_entry = container_of(slist_remove_head(&srx->rx_queue),
+					struct xnet_xfer_entry, entry);
+	} else {
+		rx_entry = NULL;
+	}
+
+	if (rx_entry) {
+		xnet_recv_self(rdm, rx_entry, &hdr, iov, count, addr);
+	} else {
+		ret = xnet_save_self(rdm, &hdr, iov, count, addr, tag);
+		if (ret) {
+			xnet_free_xfer(xnet_rdm2_progress(rdm), tx_entry);
+			return ret;
+		}
+	}
+
+	xnet_complete_self(rdm, tx_entry, 0);
+	return 0;
+}
+
+/* Remote write completions match xnet_handle_write(). */
+static struct xnet_xfer_entry *
+xnet_alloc_self_write(struct xnet_rdm *rdm, size_t len, uint64_t data,
+		      uint64_t flags)
+{
+	struct xnet_xfer_entry *rx_entry;
+
+	rx_entry = xnet_alloc_xfer(xnet_rdm2_progress(rdm));
+	if (!rx_entry)
+		return NULL;
+
+	if (flags & FI_REMOTE_CQ_DATA) {
+		rx_entry->cq_flags = (FI_COMPLETION | FI_REMOTE_WRITE |
+				      FI_REMOTE_CQ_DATA);
+		rx_entry->hdr.base_hdr.flags = XNET_REMOTE_CQ_DATA;
+		rx_entry->hdr.cq_data_hdr.cq_data = data;
+		rx_entry->hdr.base_hdr.hdr_size =
+			(uint8_t) sizeof(rx_entry->hdr.cq_data_hdr);
+	} else {
+		rx_entry->ctrl_flags = XNET_INTERNAL_XFER;
+		rx_entry->hdr.base_hdr.hdr_size =
+			(uint8_t) sizeof(rx_entry->hdr.base_hdr);
+	}
+	rx_entry->hdr.base_hdr.op = xnet_op_write;
+	rx_entry->hdr.base_hdr.size = rx_entry->hdr.base_hdr.hdr_size + len;
+	rx_entry->cntr = rdm->util_ep.cntrs[CNTR_REM_WR];
+	rx_entry->cq = container_of(rdm->util_ep.rx_cq, struct xnet_cq,
+				    util_cq);
+	return rx_entry;
+}
+
+ssize_t xnet_self_rma(struct xnet_rdm *rdm, bool write,
+		      const struct iovec *iov, size_t count,
+		      const struct fi_rma_iov *rma_iov, size_t rma_count,
+		      uint64_t data, uint64_t flags, void *context)
+{
+	struct xnet_xfer_entry *tx_entry, *rx_entry = NULL;
+	struct iovec target[XNET_IOV_LIMIT];
+	uintptr_t addr;
+	size_t i, len;
+	int ret;
+
+	assert(xnet_progress_locked(xnet_rdm2_progress(rdm)));
+	assert(count <= XNET_IOV_LIMIT && rma_count <= XNET_IOV_LIMIT);
+	tx_entry = xnet_alloc_self_tx(rdm, (flags & FI_COMPLETION) | FI_RMA |
+				      (write ? FI_WRITE : FI_READ),
+				      write ? CNTR_WR : CNTR_RD, context);
+	if (!tx_entry)
+		return -FI_EAGAIN;
+	xnet_init_trigger(tx_entry, flags);
+
+	len = ofi_total_iov_len(iov, count);
+	if (write) {
+		rx_entry = xnet_alloc_self_write(rdm, len, data, flags);
+		if (!rx_entry) {
+			xnet_free_xfer(xnet_rdm2_progress(rdm), tx_entry);
+			return -FI_EAGAIN;
+		}
+	}
+
+	for (i = 0; i < rma_count; i++) {
+		addr = (uintptr_t) rma_iov[i].addr;
+		ret = ofi_mr_verify(&rdm->util_ep.domain->mr_map,
+				    rma_iov[i].len, &addr, rma_iov[i].key,
+				    write ? FI_REMOTE_WRITE : FI_REMOTE_READ);
+		if (ret) {
+			FI_WARN(&xnet_prov, FI_LOG_EP_DATA,
+				"invalid self rma iov\n");
+			goto err;
+		}
+		target[i].iov_base = (void *) addr;
+		target[i].iov_len = rma_iov[i].len;
+	}
+
+	if (write) {
+		(void) xnet_copy_self(target, rma_count, iov, count);
+		xnet_complete_self(rdm, rx_entry, 0);
+	} else {
+		(void) xnet_copy_self(iov, count, target, rma_count);
+	}
+	xnet_complete_self(rdm, tx_entry, 0);
+	return 0;
+
+err:
+	if (rx_entry)
+		xnet_free_xfer(xnet_rdm2_progress(rdm), rx_entry);
+	xnet_complete_self(rdm, tx_entry, -ret);
+	return 0;
+}
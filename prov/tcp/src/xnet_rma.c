@@ -135,6 +135,8 @@ xnet_rma_readmsg(struct fid_ep *ep_fid, const struct fi_msg_rma *msg,
 	}
 	xnet_rma_read_send_entry_fill(send_entry, recv_entry, ep, msg);
 	xnet_rma_read_recv_entry_fill(recv_entry, ep, msg, flags);
+	xnet_init_trigger(send_entry, flags);
+	xnet_init_trigger(recv_entry, flags);
 
 	slist_insert_tail(&recv_entry->entry, &ep->rma_read_queue);
 	xnet_tx_queue_insert(ep, send_entry);
@@ -266,7 +268,9 @@ xnet_rma_writemsg(struct fid_ep *ep_fid, const struct fi_msg_rma *msg,
 			       FI_RMA | FI_WRITE;
 	send_entry->cntr = ep->util_ep.cntrs[CNTR_WR];
 	xnet_set_commit_flags(send_entry, flags);
+	xnet_set_more_flag(send_entry, flags);
 	send_entry->context = msg->context;
+	xnet_init_trigger(send_entry, flags);
 
 	xnet_tx_queue_insert(ep, send_entry);
 unlock:
@@ -75,6 +75,8 @@ xnet_srx_msg(struct xnet_srx *srx, struct xnet_xfer_entry *recv_entry)
 	assert(xnet_progress_locked(progress));
 	/* See comment with xnet_srx_tag(). */
 	slist_insert_tail(&recv_entry->entry, &srx->rx_queue);
+	if (!slist_empty(&srx->self_queue))
+		xnet_progress_self(srx);
 
 	if (!dlist_empty(&progress->unexp_msg_list)) {
 		if (recv_entry->ctrl_flags & FI_MULTI_RECV) {
@@ -109,6 +111,7 @@ xnet_srx_recvmsg(struct fid_ep *ep_fid, const struct fi_msg *msg,
 	recv_entry->ctrl_flags = flags & FI_MULTI_RECV;
 	recv_entry->cq_flags = (flags & FI_COMPLETION) | FI_MSG | FI_RECV;
 	recv_entry->context = msg->context;
+	xnet_init_trigger(recv_entry, flags);
 	recv_entry->iov_cnt = msg->iov_count;
 	if (msg->iov_count) {
 		recv_entry->user_buf = msg->msg_iov[0].iov_base;
@@ -116,7 +119,11 @@ xnet_srx_recvmsg(struct fid_ep *ep_fid, const struct fi_msg *msg,
 		       msg->iov_count * sizeof(*msg->msg_iov));
 	}
 
-	xnet_srx_msg(srx, recv_entry);
+	/* More buffers follow, resume blocked receives after the last one */
+	if (flags & FI_MORE)
+		slist_insert_tail(&recv_entry->entry, &srx->rx_queue);
+	else
+		xnet_srx_msg(srx, recv_entry);
 unlock:
 	ofi_genlock_unlock(xnet_srx2_progress(srx)->active_lock);
 	return ret;
@@ -361,7 +368,8 @@ xnet_srx_claim(struct xnet_srx *srx, struct xnet_xfer_entry *recv_entry,
 		hdr = saved_entry ? &saved_entry->hdr : &ep->cur_rx.hdr;
 		msg_len = xnet_msg_len(hdr);
 		if (msg_len) {
-			ret = xnet_alloc_xfer_buf(recv_entry, msg_len);
+			ret = xnet_alloc_xfer_buf(xnet_srx2_progress(srx),
+						  recv_entry, msg_len);
 			if (ret)
 				return ret;
 		} else {
@@ -549,6 +557,7 @@ xnet_srx_trecvmsg(struct fid_ep *ep_fid, const struct fi_msg_tagged *msg,
 
 	/* Set counter after checking for FI_PEEK - peek does not update cntr */
 	recv_entry->cntr = srx->cntr;
+	xnet_init_trigger(recv_entry, flags);
 	ret = (flags & FI_CLAIM) ? xnet_srx_claim(srx, recv_entry, flags) :
 				   xnet_srx_tag(srx, recv_entry);
 	if (ret)
@@ -668,7 +677,7 @@ xnet_match_tag(struct xnet_srx *srx, struct xnet_ep *ep, uint64_t tag)
  * for this case.
  */
 static struct xnet_xfer_entry *
-xnet_match_tag_addr(struct xnet_srx *srx, struct xnet_ep *ep, uint64_t tag)
+xnet_match_tag_src(struct xnet_srx *srx, fi_addr_t addr, uint64_t tag)
 {
 	struct xnet_xfer_entry *rx_entry, *any_entry;
 	struct slist *queue;
@@ -677,10 +686,10 @@ xnet_match_tag_addr(struct xnet_srx *srx, struct xnet_ep *ep, uint64_t tag)
 
 	assert(xnet_progress_locked(xnet_srx2_progress(srx)));
 
-	queue = (ep->peer && ep->peer->fi_addr != FI_ADDR_NOTAVAIL) ?
-		ofi_array_at(&srx->src_tag_queues, ep->peer->fi_addr) : NULL;
+	queue = (addr != FI_ADDR_NOTAVAIL) ?
+		ofi_array_at(&srx->src_tag_queues, addr) : NULL;
 	if (!queue)
-		return xnet_match_tag(srx, ep, tag);
+		return xnet_match_tag(srx, NULL, tag);
 
 	slist_foreach(queue, item, prev) {
 		rx_entry = container_of(item, struct xnet_xfer_entry, entry);
@@ -688,7 +697,7 @@ xnet_match_tag_addr(struct xnet_srx *srx, struct xnet_ep *ep, uint64_t tag)
 			goto found;
 	}
 
-	return xnet_match_tag(srx, ep, tag);
+	return xnet_match_tag(srx, NULL, tag);
 
 found:
 	/* We select from the any source queue if it matches and was posted
@@ -712,6 +721,22 @@ found:
 	return rx_entry;
 }
 
+static struct xnet_xfer_entry *
+xnet_match_tag_addr(struct xnet_srx *srx, struct xnet_ep *ep, uint64_t tag)
+{
+	return xnet_match_tag_src(srx, ep->peer ? ep->peer->fi_addr :
+				  FI_ADDR_NOTAVAIL, tag);
+}
+
+/* Match a tagged message from addr that did not arrive over a socket. */
+struct xnet_xfer_entry *
+xnet_srx_match_src(struct xnet_srx *srx, fi_addr_t addr, uint64_t tag)
+{
+	if (srx->match_tag_rx == xnet_match_tag)
+		return xnet_match_tag(srx, NULL, tag);
+	return xnet_match_tag_src(srx, addr, tag);
+}
+
 static bool
 xnet_srx_cancel_rx(struct xnet_srx *srx, struct slist *queue, void *context)
 {
@@ -863,6 +888,7 @@ static int xnet_srx_close(struct fid *fid)
 	ofi_genlock_lock(xnet_srx2_progress(srx)->active_lock);
 	xnet_srx_cleanup(srx, &srx->rx_queue);
 	xnet_srx_cleanup(srx, &srx->tag_queue);
+	xnet_srx_cleanup(srx, &srx->self_queue);
 	ofi_array_iter(&srx->src_tag_queues, srx, xnet_srx_cleanup_queues);
 	ofi_array_iter(&srx->saved_msgs, srx, xnet_srx_cleanup_saved);
 	ofi_genlock_unlock(xnet_srx2_progress(srx)->active_lock);
@@ -905,6 +931,7 @@ int xnet_srx_context(struct fid_domain *domain, struct fi_rx_attr *attr,
 	srx->rx_fid.tagged = &xnet_srx_tag_ops;
 	slist_init(&srx->rx_queue);
 	slist_init(&srx->tag_queue);
+	slist_init(&srx->self_queue);
 	ofi_array_init(&srx->src_tag_queues, sizeof(struct slist), NULL);
 	ofi_array_init(&srx->saved_msgs, sizeof(struct xnet_saved_msg),
 		       xnet_init_saved_msg);
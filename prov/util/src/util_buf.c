@@ -318,3 +318,147 @@ int ofi_ibufpool_region_is_lower(struct dlist_entry *item, const void *arg)
 
 	return reg1->index < reg2->index;
 }
+
+/* Size class for a request no larger than the largest class.  Classes
+ * alternate between 2^n and 3 * 2^(n - 2), starting at 2^min_shift.
+ */
+static int ofi_slab_class(struct ofi_slab *slab, size_t size)
+{
+	uint8_t shift;
+	int index;
+
+	if (size <= slab->class_size[0])
+		return 0;
+
+	shift = ofi_msb(size - 1);
+	index = (shift - slab->min_shift) * 2;
+	if (size <= ((size_t) 3 << (shift - 2)))
+		index--;
+
+	assert(index < slab->class_cnt && size <= slab->class_size[index]);
+	return index;
+}
+
+static int ofi_slab_create_pool(struct ofi_slab *slab, int index)
+{
+	struct ofi_bufpool_attr attr = {
+		.size = sizeof(struct ofi_slab_hdr) + slab->class_size[index],
+		.alignment = 16,
+		.flags = slab->attr.flags,
+	};
+
+	attr.chunk_cnt = MAX(slab->attr.region_size / attr.size, 1);
+	return ofi_bufpool_create_attr(&attr, &slab->pool[index]);
+}
+
+int ofi_slab_create(const struct ofi_slab_attr *attr, struct ofi_slab **slab)
+{
+	struct ofi_slab *new_slab;
+	size_t size;
+	int i;
+
+	new_slab = calloc(1, sizeof(*new_slab));
+	if (!new_slab)
+		return -FI_ENOMEM;
+
+	new_slab->attr = *attr;
+	if (!new_slab->attr.region_size)
+		new_slab->attr.region_size = OFI_SLAB_REGION_SIZE;
+
+	size = roundup_power_of_two(MAX(attr->min_size, OFI_SLAB_MIN_SIZE));
+	new_slab->min_shift = ofi_lsb(size) - 1;
+	new_slab->attr.min_size = size;
+	if (new_slab->attr.max_size < size)
+		new_slab->attr.max_size = size;
+
+	for (i = 0; i < OFI_SLAB_MAX_CLASSES; i++) {
+		new_slab->class_size[i] = (i & 1) ?
+			(size_t) 3 << (new_slab->min_shift + i / 2 - 1) :
+			size << (i / 2);
+		new_slab->class_cnt = i + 1;
+		if (new_slab->class_size[i] >= new_slab->attr.max_size)
+			break;
+	}
+
+	FI_DBG(&core_prov, FI_LOG_CORE, "%s classes %d sizes %zu-%zu\n",
+	       __func__, new_slab->class_cnt, new_slab->class_size[0],
+	       new_slab->class_size[new_slab->class_cnt - 1]);
+
+	*slab = new_slab;
+	return FI_SUCCESS;
+}
+
+void ofi_slab_destroy(struct ofi_slab *slab)
+{
+	int i;
+
+	FI_DBG(&core_prov, FI_LOG_CORE, "%s allocs %zu large %zu "
+	       "peak bytes %zu in use %zu\n", __func__, slab->stats.alloc_cnt,
+	       slab->stats.large_cnt, slab->stats.peak_bytes,
+	       slab->stats.inuse_cnt);
+	assert(!slab->stats.inuse_cnt);
+
+	for (i = 0; i < slab->class_cnt; i++) {
+		if (slab->pool[i])
+			ofi_bufpool_destroy(slab->pool[i]);
+	}
+	free(slab);
+}
+
+void *ofi_slab_alloc(struct ofi_slab *slab, size_t size)
+{
+	struct ofi_slab_hdr *hdr;
+	int index;
+
+	if (size > slab->class_size[slab->class_cnt - 1]) {
+		hdr = malloc(sizeof(*hdr) + size);
+		if (!hdr)
+			return NULL;
+		slab->stats.large_cnt++;
+	} else {
+		index = ofi_slab_class(slab, size);
+		if (!slab->pool[index] && ofi_slab_create_pool(slab, index))
+			return NULL;
+
+		hdr = ofi_buf_alloc(slab->pool[index]);
+		if (!hdr)
+			return NULL;
+		size = slab->class_size[index];
+	}
+
+	hdr->slab = slab;
+	hdr->size = size;
+
+	slab->stats.alloc_cnt++;
+	slab->stats.inuse_cnt++;
+	slab->stats.inuse_bytes += size;
+	if (slab->stats.inuse_bytes > slab->stats.peak_bytes)
+		slab->stats.peak_bytes = slab->stats.inuse_bytes;
+
+	return hdr + 1;
+}
+
+void ofi_slab_free(void *buf)
+{
+	struct ofi_slab_hdr *hdr;
+	struct ofi_slab *slab;
+
+	if (!buf)
+		return;
+
+	hdr = (struct ofi_slab_hdr *) buf - 1;
+	slab = hdr->slab;
+	assert(slab->stats.inuse_cnt);
+	slab->stats.inuse_cnt--;
+	slab->stats.inuse_bytes -= hdr->size;
+
+	if (hdr->size > slab->class_size[slab->class_cnt - 1])
+		free(hdr);
+	else
+		ofi_buf_free(hdr);
+}
+
+size_t ofi_slab_buf_size(void *buf)
+{
+	return ((struct ofi_slab_hdr *) buf - 1)->size;
+}
@@ -250,6 +250,8 @@ int ofi_cntr_cleanup(struct util_cntr *cntr)
 	if (ofi_atomic_get32(&cntr->ref))
 		return -FI_EBUSY;
 
+	ofi_trigger_flush(cntr->domain, cntr);
+
 	if (!(cntr->flags & FI_PEER))
 		fi_close(&cntr->peer_cntr->fid);
 
@@ -291,6 +293,8 @@ void ofi_cntr_progress(struct util_cntr *cntr)
 		ep->progress(ep);
 	}
 	ofi_genlock_unlock(&cntr->ep_list_lock);
+
+	ofi_trigger_progress(cntr->domain);
 }
 
 static struct fi_ops util_cntr_fi_ops = {
@@ -349,6 +353,8 @@ int ofi_cntr_init(const struct fi_provider *prov, struct fid_domain *domain,
 	ofi_atomic_initialize64(&cntr->cnt, 0);
 	ofi_atomic_initialize64(&cntr->err, 0);
 	dlist_init(&cntr->ep_list);
+	dlist_init(&cntr->trigger_list);
+	dlist_init(&cntr->trigger_entry);
 
 	cntr->flags = attr->flags;
 	cntr->cntr_fid.fid.fclass = FI_CLASS_CNTR;
@@ -171,6 +171,7 @@ static void initialize_monitor_list()
 		rocr_monitor,
 		rocr_ipc_monitor,
 		xpmem_monitor,
+		memfd_monitor,
 		ze_monitor,
 		ze_ipc_monitor,
 		import_monitor,
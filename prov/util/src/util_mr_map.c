@@ -66,11 +66,37 @@ dup_mr_attr(const struct fi_mr_attr *attr, uint64_t flags)
 	return dup_attr;
 }
 
+/* Returns the table index of a key, or 0 if the key is in the rbtree. */
+static inline int ofi_mr_map_index(struct ofi_mr_map *map, uint64_t key)
+{
+	return (map->mode & FI_MR_PROV_KEY) ?
+	       (int) (key & OFI_MR_MAP_IDX_MASK) : 0;
+}
+
+static struct fi_mr_attr *ofi_mr_map_find(struct ofi_mr_map *map,
+					  uint64_t key)
+{
+	struct fi_mr_attr *attr;
+	struct ofi_rbnode *node;
+	int index;
+
+	index = ofi_mr_map_index(map, key);
+	if (index) {
+		attr = ofi_idx_lookup(&map->idx, index);
+		if (attr && attr->requested_key == key)
+			return attr;
+	}
+
+	/* Keys copied from another map by ofi_mr_map_insert_key */
+	node = ofi_rbmap_find(map->rbtree, &key);
+	return node ? node->data : NULL;
+}
+
 int ofi_mr_map_insert(struct ofi_mr_map *map, const struct fi_mr_attr *attr,
 		      uint64_t *key, void *context, uint64_t flags)
 {
 	struct fi_mr_attr *item;
-	int ret;
+	int index, ret;
 
 	item = dup_mr_attr(attr, flags);
 	if (!item)
@@ -79,8 +105,19 @@ int ofi_mr_map_insert(struct ofi_mr_map *map, const struct fi_mr_attr *attr,
 	if (!(map->mode & FI_MR_VIRT_ADDR))
 		item->offset = (uintptr_t) attr->mr_iov[0].iov_base;
 
-	if (map->mode & FI_MR_PROV_KEY)
-		item->requested_key = map->key++;
+	item->context = context;
+	if (map->mode & FI_MR_PROV_KEY) {
+		index = ofi_idx_insert(&map->idx, item);
+		if (index < 0)
+			index = 0;
+
+		item->requested_key = (map->key++ << OFI_MR_MAP_IDX_BITS) |
+				      index;
+		if (index) {
+			*key = item->requested_key;
+			return 0;
+		}
+	}
 
 	ret = ofi_rbmap_insert(map->rbtree, &item->requested_key, item, NULL);
 	if (ret) {
@@ -89,7 +126,6 @@ int ofi_mr_map_insert(struct ofi_mr_map *map, const struct fi_mr_attr *attr,
 		goto err;
 	}
 	*key = item->requested_key;
-	item->context = context;
 
 	return 0;
 err:
@@ -97,17 +133,80 @@ err:
 	return ret;
 }
 
-void *ofi_mr_map_get(struct ofi_mr_map *map, uint64_t key)
+/*
+ * Insert a region under a key generated by another map, such as when
+ * replicating the regions of a domain into its subdomains.  The key is
+ * kept as is, so the region goes in the rbtree whatever its index bits.
+ */
+int ofi_mr_map_insert_key(struct ofi_mr_map *map, const struct fi_mr_attr *attr,
+			  uint64_t key, void *context, uint64_t flags)
+{
+	struct fi_mr_attr *item;
+	int ret;
+
+	item = dup_mr_attr(attr, flags);
+	if (!item)
+		return -FI_ENOMEM;
+
+	if (!(map->mode & FI_MR_VIRT_ADDR))
+		item->offset = (uintptr_t) item->mr_iov[0].iov_base;
+
+	item->context = context;
+	item->requested_key = key;
+	ret = ofi_rbmap_insert(map->rbtree, &item->requested_key, item, NULL);
+	if (ret) {
+		free(item);
+		return (ret == -FI_EALREADY) ? -FI_ENOKEY : ret;
+	}
+	return 0;
+}
+
+struct ofi_mr_map_iter {
+	struct ofi_mr_map *map;
+	ofi_mr_map_func func;
+	void *context;
+};
+
+static int ofi_mr_map_node_func(struct ofi_rbmap *rbtree,
+				struct ofi_rbnode *node, void *context)
 {
+	struct ofi_mr_map_iter *iter = context;
+
+	return iter->func(iter->map, node->data, iter->context);
+}
+
+/* Calls func for every region in the map, indexed or not. */
+int ofi_mr_map_foreach(struct ofi_mr_map *map, ofi_mr_map_func func,
+		       void *context)
+{
+	struct ofi_mr_map_iter iter = {
+		.map = map,
+		.func = func,
+		.context = context,
+	};
 	struct fi_mr_attr *attr;
-	struct ofi_rbnode *node;
+	int index, ret;
 
-	node = ofi_rbmap_find(map->rbtree, &key);
-	if (!node)
-		return NULL;
+	for (index = 1; ofi_idx_is_valid(&map->idx, index); index++) {
+		attr = ofi_idx_at(&map->idx, index);
+		if (!attr)
+			continue;
 
-	attr = node->data;
-	return attr->context;
+		ret = func(map, attr, context);
+		if (ret)
+			return ret;
+	}
+
+	return ofi_rbmap_foreach(map->rbtree, map->rbtree->root,
+				 ofi_mr_map_node_func, &iter);
+}
+
+void *ofi_mr_map_get(struct ofi_mr_map *map, uint64_t key)
+{
+	struct fi_mr_attr *attr;
+
+	attr = ofi_mr_map_find(map, key);
+	return attr ? attr->context : NULL;
 }
 
 int ofi_mr_map_verify(struct ofi_mr_map *map, uintptr_t *io_addr,
@@ -115,19 +214,15 @@ int ofi_mr_map_verify(struct ofi_mr_map *map, uintptr_t *io_addr,
 		      void **context)
 {
 	struct fi_mr_attr *attr;
-	struct ofi_rbnode *node;
 	void *addr;
 
-	node = ofi_rbmap_find(map->rbtree, &key);
-	if (!node) {
+	attr = ofi_mr_map_find(map, key);
+	if (!attr) {
                 FI_WARN(map->prov, FI_LOG_MR,
                         "unknown key: %" PRIu64 "\n", key);
 	        return -FI_EINVAL;
         }
 
-	attr = node->data;
-	assert(attr);
-
 	if ((access & attr->access) != access) {
                 FI_WARN(map->prov, FI_LOG_MR,
                         "invalid access: permitted %s\n",
@@ -163,6 +258,17 @@ int ofi_mr_map_remove(struct ofi_mr_map *map, uint64_t key)
 {
 	struct ofi_rbnode *node;
 	struct fi_mr_attr *attr;
+	int index;
+
+	index = ofi_mr_map_index(map, key);
+	if (index) {
+		attr = ofi_idx_lookup(&map->idx, index);
+		if (attr && attr->requested_key == key) {
+			ofi_idx_remove(&map->idx, index);
+			free(attr);
+			return 0;
+		}
+	}
 
 	node = ofi_rbmap_find(map->rbtree, &key);
 	if (!node)
@@ -210,6 +316,7 @@ int ofi_mr_map_init(const struct fi_provider *prov, int mode,
 	}
 	map->prov = prov;
 	map->key = 1;
+	memset(&map->idx, 0, sizeof(map->idx));
 
 	return 0;
 }
@@ -217,6 +324,7 @@ int ofi_mr_map_init(const struct fi_provider *prov, int mode,
 void ofi_mr_map_close(struct ofi_mr_map *map)
 {
 	ofi_rbmap_destroy(map->rbtree);
+	ofi_idx_reset(&map->idx);
 }
 
 int ofi_mr_close(struct fid *fid)
@@ -0,0 +1,492 @@
+/*
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <ofi_util.h>
+
+static uint64_t util_trigger_count(struct util_trigger *trigger)
+{
+	uint64_t cnt;
+
+	cnt = ofi_atomic_get64(&trigger->cntr->cnt);
+	/* deferred work counts errors toward its threshold */
+	if (trigger->work)
+		cnt += ofi_atomic_get64(&trigger->cntr->err);
+	return cnt;
+}
+
+/*
+ * Queued work holds a reference on the other counters it updates, so they
+ * cannot be closed under it.  The triggering counter flushes its work when
+ * it is closed instead, and the endpoint when it is, see ofi_trigger_flush_ep.
+ */
+static struct util_cntr *util_trigger_ref_cntr(struct util_trigger *trigger,
+					       struct fid_cntr *cntr_fid)
+{
+	struct util_cntr *cntr;
+
+	if (!cntr_fid)
+		return NULL;
+
+	cntr = container_of(cntr_fid, struct util_cntr, cntr_fid);
+	if (cntr != trigger->cntr)
+		ofi_atomic_inc32(&cntr->ref);
+	return cntr;
+}
+
+static void util_trigger_unref_cntr(struct util_trigger *trigger,
+				    struct util_cntr *cntr)
+{
+	if (cntr && cntr != trigger->cntr)
+		ofi_atomic_dec32(&cntr->ref);
+}
+
+static void util_trigger_free(struct util_trigger *trigger)
+{
+	struct util_cntr *cntr = trigger->cntr;
+
+	assert(ofi_mutex_held(&cntr->domain->trigger_lock));
+	dlist_remove(&trigger->entry);
+	if (dlist_empty(&cntr->trigger_list))
+		dlist_remove_init(&cntr->trigger_entry);
+
+	util_trigger_unref_cntr(trigger, trigger->ctx.cntr);
+	if (trigger->op_type == FI_OP_CNTR_SET ||
+	    trigger->op_type == FI_OP_CNTR_ADD)
+		util_trigger_unref_cntr(trigger,
+					container_of(trigger->op.cntr.cntr,
+						     struct util_cntr,
+						     cntr_fid));
+	free(trigger);
+}
+
+static ssize_t util_trigger_post(struct util_trigger *trigger)
+{
+	switch (trigger->op_type) {
+	case FI_OP_RECV:
+		return fi_recvmsg(trigger->ep, &trigger->op.msg,
+				  trigger->flags);
+	case FI_OP_SEND:
+		return fi_sendmsg(trigger->ep, &trigger->op.msg,
+				  trigger->flags);
+	case FI_OP_TRECV:
+		return fi_trecvmsg(trigger->ep, &trigger->op.tagged,
+				   trigger->flags);
+	case FI_OP_TSEND:
+		return fi_tsendmsg(trigger->ep, &trigger->op.tagged,
+				   trigger->flags);
+	case FI_OP_READ:
+		return fi_readmsg(trigger->ep, &trigger->op.rma,
+				  trigger->flags);
+	case FI_OP_WRITE:
+		return fi_writemsg(trigger->ep, &trigger->op.rma,
+				   trigger->flags);
+	case FI_OP_CNTR_SET:
+		return fi_cntr_set(trigger->op.cntr.cntr,
+				   trigger->op.cntr.value);
+	case FI_OP_CNTR_ADD:
+		return fi_cntr_add(trigger->op.cntr.cntr,
+				   trigger->op.cntr.value);
+	default:
+		assert(0);
+		return -FI_ENOSYS;
+	}
+}
+
+/* Posts the work on the counter that has reached its threshold */
+static bool util_trigger_fire(struct util_cntr *cntr)
+{
+	struct util_trigger *trigger;
+	bool fired = false;
+	ssize_t ret;
+
+	while (!dlist_empty(&cntr->trigger_list)) {
+		trigger = container_of(cntr->trigger_list.next,
+				       struct util_trigger, entry);
+		if (util_trigger_count(trigger) < trigger->threshold)
+			break;
+
+		ret = util_trigger_post(trigger);
+		if (ret == -FI_EAGAIN)
+			break;
+
+		if (ret) {
+			FI_WARN(cntr->domain->prov, FI_LOG_CNTR,
+				"triggered %s failed: %s\n",
+				fi_tostr(&trigger->op_type, FI_TYPE_OP_TYPE),
+				fi_strerror((int) -ret));
+			if (trigger->ctx.cntr)
+				fi_cntr_adderr(&trigger->ctx.cntr->cntr_fid, 1);
+		}
+		util_trigger_free(trigger);
+		fired = true;
+	}
+	return fired;
+}
+
+void ofi_trigger_progress_locked(struct util_domain *domain)
+{
+	struct util_cntr *cntr;
+	struct dlist_entry *tmp;
+	bool fired;
+
+	assert(ofi_mutex_held(&domain->trigger_lock));
+	/* counter ops may release work queued on other counters */
+	do {
+		fired = false;
+		dlist_foreach_container_safe(&domain->trigger_cntrs,
+					     struct util_cntr, cntr,
+					     trigger_entry, tmp)
+			fired |= util_trigger_fire(cntr);
+	} while (fired);
+}
+
+static void util_trigger_queue(struct util_trigger *trigger)
+{
+	struct util_domain *domain = trigger->cntr->domain;
+	struct util_cntr *cntr = trigger->cntr;
+	struct dlist_entry *item;
+
+	ofi_mutex_lock(&domain->trigger_lock);
+	/* after all work with the same or a lower threshold */
+	dlist_foreach_reverse(&cntr->trigger_list, item) {
+		if (container_of(item, struct util_trigger, entry)->threshold <=
+		    trigger->threshold)
+			break;
+	}
+	dlist_insert_after(&trigger->entry, item);
+	if (dlist_empty(&cntr->trigger_entry))
+		dlist_insert_tail(&cntr->trigger_entry, &domain->trigger_cntrs);
+
+	/* work whose threshold has already been reached starts now */
+	ofi_trigger_progress_locked(domain);
+	ofi_mutex_unlock(&domain->trigger_lock);
+}
+
+static int util_trigger_copy_iov(struct util_trigger *trigger,
+				 const struct iovec *iov, void **desc,
+				 size_t count)
+{
+	if (count > OFI_TRIGGER_IOV_LIMIT)
+		return -FI_EINVAL;
+
+	memcpy(trigger->iov, iov, sizeof(*iov) * count);
+	if (desc)
+		memcpy(trigger->desc, desc, sizeof(*desc) * count);
+	return 0;
+}
+
+static int util_trigger_init_msg(struct util_trigger *trigger,
+				 const struct fi_msg *msg)
+{
+	trigger->op.msg = *msg;
+	trigger->op.msg.msg_iov = trigger->iov;
+	trigger->op.msg.desc = msg->desc ? trigger->desc : NULL;
+	return util_trigger_copy_iov(trigger, msg->msg_iov, msg->desc,
+				     msg->iov_count);
+}
+
+static int util_trigger_init_tagged(struct util_trigger *trigger,
+				    const struct fi_msg_tagged *msg)
+{
+	trigger->op.tagged = *msg;
+	trigger->op.tagged.msg_iov = trigger->iov;
+	trigger->op.tagged.desc = msg->desc ? trigger->desc : NULL;
+	return util_trigger_copy_iov(trigger, msg->msg_iov, msg->desc,
+				     msg->iov_count);
+}
+
+static int util_trigger_init_rma(struct util_trigger *trigger,
+				 const struct fi_msg_rma *msg)
+{
+	if (msg->rma_iov_count > OFI_TRIGGER_IOV_LIMIT)
+		return -FI_EINVAL;
+
+	trigger->op.rma = *msg;
+	trigger->op.rma.msg_iov = trigger->iov;
+	trigger->op.rma.desc = msg->desc ? trigger->desc : NULL;
+	trigger->op.rma.rma_iov = trigger->rma_iov;
+	memcpy(trigger->rma_iov, msg->rma_iov,
+	       sizeof(*msg->rma_iov) * msg->rma_iov_count);
+	return util_trigger_copy_iov(trigger, msg->msg_iov, msg->desc,
+				     msg->iov_count);
+}
+
+static int
+util_trigger_alloc(struct fid_ep *ep, enum fi_op_type op_type, void *context,
+		   uint64_t flags, struct util_trigger **trigger)
+{
+	struct fi_triggered_context *trig_ctx = context;
+
+	/* buffers are not read until the op fires */
+	if (!trig_ctx || (flags & FI_INJECT))
+		return -FI_EINVAL;
+
+	if (trig_ctx->event_type != FI_TRIGGER_THRESHOLD)
+		return -FI_ENOSYS;
+
+	*trigger = calloc(1, sizeof(**trigger));
+	if (!*trigger)
+		return -FI_ENOMEM;
+
+	(*trigger)->cntr = container_of(trig_ctx->trigger.threshold.cntr,
+					struct util_cntr, cntr_fid);
+	(*trigger)->threshold = trig_ctx->trigger.threshold.threshold;
+	(*trigger)->op_type = op_type;
+	(*trigger)->ep = ep;
+	(*trigger)->flags = flags & ~FI_TRIGGER;
+	return 0;
+}
+
+ssize_t ofi_trigger_msg(struct fid_ep *ep, enum fi_op_type op_type,
+			const struct fi_msg *msg, uint64_t flags)
+{
+	struct util_trigger *trigger;
+	int ret;
+
+	ret = util_trigger_alloc(ep, op_type, msg->context, flags, &trigger);
+	if (ret)
+		return ret;
+
+	ret = util_trigger_init_msg(trigger, msg);
+	if (ret) {
+		free(trigger);
+		return ret;
+	}
+
+	util_trigger_queue(trigger);
+	return 0;
+}
+
+ssize_t ofi_trigger_tagged(struct fid_ep *ep, enum fi_op_type op_type,
+			   const struct fi_msg_tagged *msg, uint64_t flags)
+{
+	struct util_trigger *trigger;
+	int ret;
+
+	ret = util_trigger_alloc(ep, op_type, msg->context, flags, &trigger);
+	if (ret)
+		return ret;
+
+	ret = util_trigger_init_tagged(trigger, msg);
+	if (ret) {
+		free(trigger);
+		return ret;
+	}
+
+	util_trigger_queue(trigger);
+	return 0;
+}
+
+ssize_t ofi_trigger_rma(struct fid_ep *ep, enum fi_op_type op_type,
+			const struct fi_msg_rma *msg, uint64_t flags)
+{
+	struct util_trigger *trigger;
+	int ret;
+
+	ret = util_trigger_alloc(ep, op_type, msg->context, flags, &trigger);
+	if (ret)
+		return ret;
+
+	ret = util_trigger_init_rma(trigger, msg);
+	if (ret) {
+		free(trigger);
+		return ret;
+	}
+
+	util_trigger_queue(trigger);
+	return 0;
+}
+
+static int util_queue_work(struct util_domain *domain,
+			   struct fi_deferred_work *work)
+{
+	struct util_trigger *trigger;
+	int ret;
+
+	if (!work->triggering_cntr)
+		return -FI_EINVAL;
+
+	trigger = calloc(1, sizeof(*trigger));
+	if (!trigger)
+		return -FI_ENOMEM;
+
+	trigger->cntr = container_of(work->triggering_cntr, struct util_cntr,
+				     cntr_fid);
+	trigger->threshold = work->threshold;
+	trigger->work = work;
+	trigger->op_type = work->op_type;
+
+	/* FI_TRIGGER would queue the op again when it is posted */
+	switch (work->op_type) {
+	case FI_OP_RECV:
+	case FI_OP_SEND:
+		trigger->ep = work->op.msg->ep;
+		trigger->flags = (work->op.msg->flags & ~FI_TRIGGER) |
+				 OFI_TRIGGERED;
+		trigger->ctx.context = work->op.msg->msg.context;
+		ret = util_trigger_init_msg(trigger, &work->op.msg->msg);
+		trigger->op.msg.context = &trigger->ctx;
+		break;
+	case FI_OP_TRECV:
+	case FI_OP_TSEND:
+		trigger->ep = work->op.tagged->ep;
+		trigger->flags = (work->op.tagged->flags & ~FI_TRIGGER) |
+				 OFI_TRIGGERED;
+		trigger->ctx.context = work->op.tagged->msg.context;
+		ret = util_trigger_init_tagged(trigger, &work->op.tagged->msg);
+		trigger->op.tagged.context = &trigger->ctx;
+		break;
+	case FI_OP_READ:
+	case FI_OP_WRITE:
+		trigger->ep = work->op.rma->ep;
+		trigger->flags = (work->op.rma->flags & ~FI_TRIGGER) |
+				 OFI_TRIGGERED;
+		trigger->ctx.context = work->op.rma->msg.context;
+		ret = util_trigger_init_rma(trigger, &work->op.rma->msg);
+		trigger->op.rma.context = &trigger->ctx;
+		break;
+	case FI_OP_CNTR_SET:
+	case FI_OP_CNTR_ADD:
+		/* only the target counter is updated */
+		ret = (work->completion_cntr || !work->op.cntr->cntr) ?
+		      -FI_EINVAL : 0;
+		trigger->op.cntr = *work->op.cntr;
+		break;
+	default:
+		ret = -FI_ENOSYS;
+		break;
+	}
+
+	if (!ret && trigger->cntr->domain != domain)
+		ret = -FI_EINVAL;
+
+	if (ret) {
+		FI_WARN(domain->prov, FI_LOG_DOMAIN,
+			"unable to queue deferred %s: %s\n",
+			fi_tostr(&work->op_type, FI_TYPE_OP_TYPE),
+			fi_strerror(-ret));
+		free(trigger);
+		return ret;
+	}
+
+	trigger->ctx.cntr = util_trigger_ref_cntr(trigger,
+						  work->completion_cntr);
+	if (work->op_type == FI_OP_CNTR_SET || work->op_type == FI_OP_CNTR_ADD)
+		(void) util_trigger_ref_cntr(trigger, trigger->op.cntr.cntr);
+
+	util_trigger_queue(trigger);
+	return 0;
+}
+
+static int util_cancel_work(struct util_domain *domain,
+			    struct fi_deferred_work *work)
+{
+	struct util_trigger *trigger;
+	struct util_cntr *cntr;
+	int ret = -FI_ENOENT;
+
+	if (!work->triggering_cntr)
+		return -FI_EINVAL;
+
+	cntr = container_of(work->triggering_cntr, struct util_cntr, cntr_fid);
+	ofi_mutex_lock(&domain->trigger_lock);
+	dlist_foreach_container(&cntr->trigger_list, struct util_trigger,
+				trigger, entry) {
+		if (trigger->work == work) {
+			util_trigger_free(trigger);
+			ret = 0;
+			break;
+		}
+	}
+	ofi_mutex_unlock(&domain->trigger_lock);
+	return ret;
+}
+
+static void util_trigger_flush_cntr(struct util_cntr *cntr)
+{
+	while (!dlist_empty(&cntr->trigger_list))
+		util_trigger_free(container_of(cntr->trigger_list.next,
+					       struct util_trigger, entry));
+}
+
+/* Drops the work waiting on cntr, or all of the domain's if it is NULL */
+void ofi_trigger_flush(struct util_domain *domain, struct util_cntr *cntr)
+{
+	struct dlist_entry *tmp;
+
+	ofi_mutex_lock(&domain->trigger_lock);
+	if (cntr) {
+		util_trigger_flush_cntr(cntr);
+	} else {
+		dlist_foreach_container_safe(&domain->trigger_cntrs,
+					     struct util_cntr, cntr,
+					     trigger_entry, tmp)
+			util_trigger_flush_cntr(cntr);
+	}
+	ofi_mutex_unlock(&domain->trigger_lock);
+}
+
+/* Drops the work that would post to ep, called as the endpoint closes */
+void ofi_trigger_flush_ep(struct util_domain *domain, struct fid_ep *ep)
+{
+	struct util_trigger *trigger;
+	struct dlist_entry *tmp, *cntr_tmp;
+	struct util_cntr *cntr;
+
+	ofi_mutex_lock(&domain->trigger_lock);
+	dlist_foreach_container_safe(&domain->trigger_cntrs, struct util_cntr,
+				     cntr, trigger_entry, cntr_tmp) {
+		dlist_foreach_container_safe(&cntr->trigger_list,
+					     struct util_trigger, trigger,
+					     entry, tmp) {
+			if (trigger->ep == ep)
+				util_trigger_free(trigger);
+		}
+	}
+	ofi_mutex_unlock(&domain->trigger_lock);
+}
+
+int ofi_trigger_control(struct util_domain *domain, int command, void *arg)
+{
+	switch (command) {
+	case FI_QUEUE_WORK:
+		return arg ? util_queue_work(domain, arg) : -FI_EINVAL;
+	case FI_CANCEL_WORK:
+		return arg ? util_cancel_work(domain, arg) : -FI_EINVAL;
+	case FI_FLUSH_WORK:
+		ofi_trigger_flush(domain, NULL);
+		return 0;
+	default:
+		return -FI_ENOSYS;
+	}
+}
@@ -589,24 +589,29 @@ static void util_wait_yield_signal(struct util_wait *util_wait)
 	ofi_mutex_unlock(&wait_yield->signal_lock);
 }
 
+static int util_wait_yield_signaled(struct util_wait_yield *wait)
+{
+	int signaled;
+
+	ofi_mutex_lock(&wait->signal_lock);
+	signaled = wait->signal;
+	ofi_mutex_unlock(&wait->signal_lock);
+	return signaled;
+}
+
 static int util_wait_yield_run(struct fid_wait *wait_fid, int timeout)
 {
 	struct util_wait_yield *wait;
 	struct ofi_wait_fid_entry *fid_entry;
 	uint64_t endtime;
+	int idle = 0;
 	int ret = 0;
 
 	wait = container_of(wait_fid, struct util_wait_yield, util_wait.wait_fid);
 	endtime = ofi_timeout_time(timeout);
 
 	while (1) {
-		int signaled;
-
-		ofi_mutex_lock(&wait->signal_lock);
-		signaled = wait->signal;
-		ofi_mutex_unlock(&wait->signal_lock);
-
-		if (signaled)
+		if (util_wait_yield_signaled(wait))
 			break;
 
 		if (ofi_adjust_timeout(endtime, &timeout))
@@ -621,8 +626,27 @@ static int util_wait_yield_run(struct fid_wait *wait_fid, int timeout)
 				return ret;
 			}
 		}
+
+		ret = -FI_EAGAIN;
+		if (!dlist_empty(&wait->util_wait.fid_list) &&
+		    wait->util_wait.fid_list.next ==
+		    wait->util_wait.fid_list.prev) {
+			fid_entry = container_of(wait->util_wait.fid_list.next,
+						 struct ofi_wait_fid_entry,
+						 entry);
+			/* progress above may have just completed something */
+			if (fid_entry->block && !util_wait_yield_signaled(wait)) {
+				fid_entry->blocked++;
+				ofi_mutex_unlock(&wait->util_wait.lock);
+				ret = fid_entry->block(fid_entry->fid, idle++,
+						       timeout);
+				ofi_mutex_lock(&wait->util_wait.lock);
+				fid_entry->blocked--;
+			}
+		}
 		ofi_mutex_unlock(&wait->util_wait.lock);
-		sched_yield();
+		if (ret)
+			sched_yield();
 	}
 
 	ofi_mutex_lock(&wait->signal_lock);
@@ -749,6 +773,16 @@ int ofi_wait_del_fid(struct util_wait *wait, fid_t fid)
 	if (ofi_atomic_dec32(&fid_entry->ref))
 		goto out;
 
+	/* The fid goes away once we return; wait out threads sleeping in
+	 * its block hook, which sleeps for a bounded time.
+	 */
+	dlist_remove(&fid_entry->entry);
+	while (fid_entry->blocked) {
+		ofi_mutex_unlock(&wait->lock);
+		sched_yield();
+		ofi_mutex_lock(&wait->lock);
+	}
+
 	wait_fd = container_of(wait, struct util_wait_fd, util_wait);
 	fds = fid_entry->pollfds.fd;
 	for (i = 0; i < fid_entry->pollfds.nfds; i++) {
@@ -760,7 +794,6 @@ int ofi_wait_del_fid(struct util_wait *wait, fid_t fid)
 		}
 	}
 
-	dlist_remove(&fid_entry->entry);
 	free(fid_entry->pollfds.fd);
 	free(fid_entry);
 out:
@@ -838,6 +871,16 @@ static int ofi_wait_get_fid_fds(struct util_wait *wait,
 
 int ofi_wait_add_fid(struct util_wait *wait, fid_t fid, uint32_t events,
 		     ofi_wait_try_func wait_try)
+{
+	return ofi_wait_add_fid_block(wait, fid, events, wait_try, NULL);
+}
+
+/* As ofi_wait_add_fid(), but a yield wait set whose only fid is this one
+ * calls 'block' instead of sched_yield() while nothing completes.
+ */
+int ofi_wait_add_fid_block(struct util_wait *wait, fid_t fid, uint32_t events,
+			   ofi_wait_try_func wait_try,
+			   ofi_wait_block_func block)
 {
 	struct ofi_wait_fid_entry *fid_entry;
 	struct dlist_entry *entry;
@@ -863,6 +906,7 @@ int ofi_wait_add_fid(struct util_wait *wait, fid_t fid, uint32_t events,
 
 	fid_entry->fid = fid;
 	fid_entry->wait_try = wait_try;
+	fid_entry->block = block;
 	fid_entry->events = events;
 	ofi_atomic_initialize32(&fid_entry->ref, 1);
 
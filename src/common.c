@@ -1279,8 +1279,74 @@ int ofi_bsock_sendv(struct ofi_bsock *bsock, const struct iovec *iov,
 	return 0;
 }
 
+int ofi_bsock_queuev(struct ofi_bsock *bsock, const struct iovec *iov,
+		     size_t cnt, size_t *len)
+{
+	*len = ofi_total_iov_len(iov, cnt);
+	if (*len >= ofi_byteq_writeable(&bsock->sq) ||
+	    *len > bsock->zerocopy_size) {
+		*len = 0;
+		return -FI_EAGAIN;
+	}
+
+	ofi_byteq_writev(&bsock->sq, iov, cnt);
+	return 0;
+}
+
+/* The largest iov that is read together with the prefetch buffer */
+#define OFI_BSOCK_SPLIT_IOV_LIMIT 8
+
+/*
+ * Payloads that would otherwise be staged through the prefetch buffer are
+ * read straight into the caller's buffers, with the prefetch buffer
+ * appended to take whatever follows them in the stream, usually the next
+ * header.  io_uring completes prefetches into the prefetch buffer only, so
+ * it keeps the staged reads.
+ */
+static bool ofi_bsock_can_split(struct ofi_bsock *bsock, size_t cnt)
+{
+	return !bsock->sockapi->rx_uring.io_uring &&
+	       cnt <= OFI_BSOCK_SPLIT_IOV_LIMIT;
+}
+
+static ssize_t
+ofi_bsock_split_recv(struct ofi_bsock *bsock, const struct iovec *iov,
+		     size_t cnt, size_t offset, size_t len)
+{
+	struct iovec split_iov[OFI_BSOCK_SPLIT_IOV_LIMIT + 1];
+	size_t i, split_cnt = 0;
+	ssize_t ret;
+
+	assert(ofi_bsock_can_split(bsock, cnt));
+	for (i = 0; i < cnt; i++) {
+		if (offset >= iov[i].iov_len) {
+			offset -= iov[i].iov_len;
+			continue;
+		}
+
+		split_iov[split_cnt].iov_base = (char *) iov[i].iov_base + offset;
+		split_iov[split_cnt++].iov_len = iov[i].iov_len - offset;
+		offset = 0;
+	}
+
+	split_iov[split_cnt].iov_base = &bsock->rq.data[bsock->rq.tail];
+	split_iov[split_cnt++].iov_len = ofi_byteq_writeable(&bsock->rq);
+	assert(split_iov[split_cnt - 1].iov_len);
+
+	ret = bsock->sockapi->recvv(bsock->sockapi, bsock->sock, split_iov,
+				    split_cnt, MSG_NOSIGNAL, &bsock->rx_sockctx);
+	bsock->rx_drained = ret < (ssize_t) (len +
+					     split_iov[split_cnt - 1].iov_len);
+	if (ret > (ssize_t) len) {
+		ofi_byteq_add(&bsock->rq, (size_t) ret - len);
+		ret = len;
+	}
+	return ret;
+}
+
 int ofi_bsock_recv(struct ofi_bsock *bsock, void *buf, size_t *len)
 {
+	struct iovec iov;
 	size_t bytes, avail = 0;
 	ssize_t ret;
 
@@ -1296,11 +1362,23 @@ int ofi_bsock_recv(struct ofi_bsock *bsock, void *buf, size_t *len)
 
 	assert(!ofi_bsock_readable(bsock));
 	if (*len < (bsock->rq.size >> 1)) {
+		if (ofi_bsock_can_split(bsock, 1)) {
+			iov.iov_base = buf;
+			iov.iov_len = *len;
+			ret = ofi_bsock_split_recv(bsock, &iov, 1, 0, *len);
+			if (ret <= 0)
+				goto out;
+
+			*len = bytes + ret;
+			return 0;
+		}
+
 		avail = ofi_byteq_writeable(&bsock->rq);
 		assert(avail);
 		ret = bsock->sockapi->recv(bsock->sockapi, bsock->sock,
 					   &bsock->rq.data[bsock->rq.tail],
 					   avail, MSG_NOSIGNAL, &bsock->rx_sockctx);
+		bsock->rx_drained = ret < (ssize_t) avail;
 		if (ret <= 0)
 			goto out;
 
@@ -1313,6 +1391,7 @@ int ofi_bsock_recv(struct ofi_bsock *bsock, void *buf, size_t *len)
 
 	ret = bsock->sockapi->recv(bsock->sockapi, bsock->sock, buf, *len,
 				   MSG_NOSIGNAL, &bsock->rx_sockctx);
+	bsock->rx_drained = ret < (ssize_t) *len;
 	if (ret > 0) {
 		*len = bytes + ret;
 		return 0;
@@ -1355,11 +1434,21 @@ int ofi_bsock_recvv(struct ofi_bsock *bsock, struct iovec *iov, size_t cnt,
 
 	assert(!ofi_bsock_readable(bsock));
 	if (*len < (bsock->rq.size >> 1)) {
+		if (ofi_bsock_can_split(bsock, cnt)) {
+			ret = ofi_bsock_split_recv(bsock, iov, cnt, bytes, *len);
+			if (ret <= 0)
+				goto out;
+
+			*len = bytes + ret;
+			return 0;
+		}
+
 		avail = ofi_byteq_writeable(&bsock->rq);
 		assert(avail);
 		ret = bsock->sockapi->recv(bsock->sockapi, bsock->sock,
 					   &bsock->rq.data[bsock->rq.tail],
 					   avail, MSG_NOSIGNAL, &bsock->rx_sockctx);
+		bsock->rx_drained = ret < (ssize_t) avail;
 		if (ret <= 0)
 			goto out;
 
@@ -1380,6 +1469,7 @@ int ofi_bsock_recvv(struct ofi_bsock *bsock, struct iovec *iov, size_t cnt,
 
 	ret = bsock->sockapi->recvv(bsock->sockapi, bsock->sock, iov, cnt,
 				    MSG_NOSIGNAL, &bsock->rx_sockctx);
+	bsock->rx_drained = ret < (ssize_t) *len;
 	if (ret > 0) {
 		*len = ret;
 		return 0;
@@ -151,6 +151,24 @@ int ofi_truncate_iov(struct iovec *iov, size_t *iov_count, size_t new_size)
 	return new_size ? -FI_ETRUNC : FI_SUCCESS;
 }
 
+size_t ofi_coalesce_iov(struct iovec *dst, const struct iovec *src,
+			size_t count)
+{
+	size_t i, n = 0;
+
+	for (i = 0; i < count; i++) {
+		if (!src[i].iov_len)
+			continue;
+		if (n && (char *) dst[n - 1].iov_base + dst[n - 1].iov_len ==
+			 src[i].iov_base) {
+			dst[n - 1].iov_len += src[i].iov_len;
+			continue;
+		}
+		dst[n++] = src[i];
+	}
+	return n;
+}
+
 /* Copy 'len' bytes worth of src iovec to dst */
 int ofi_copy_iov_desc(struct iovec *dst_iov, void **dst_desc, size_t *dst_count,
 		      struct iovec *src_iov, void **src_desc, size_t src_count,
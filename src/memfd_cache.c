@@ -0,0 +1,248 @@
+/*
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif /* HAVE_CONFIG_H */
+
+#include <ofi_mr.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * @brief Describe the file behind a dmabuf-style registration of host
+ * memory so that a peer can map it.  The fd is duplicated, so the
+ * application may close its own copy once the region is registered.
+ *
+ * @param[in] dmabuf the registration attributes (fd and base_addr)
+ * @param[out] handle the handle to pass to peers
+ * @return int 0 on success, negative value otherwise.
+ */
+int ofi_memfd_get_handle(const struct fi_mr_dmabuf *dmabuf,
+			 struct ofi_memfd_handle *handle)
+{
+	struct stat st;
+	int fd;
+
+	if (!dmabuf->base_addr)
+		return -FI_EINVAL;
+
+	fd = fcntl(dmabuf->fd, F_DUPFD_CLOEXEC, 0);
+	if (fd < 0)
+		return -errno;
+
+	if (fstat(fd, &st)) {
+		close(fd);
+		return -errno;
+	}
+
+	handle->pid = getpid();
+	handle->fd = fd;
+	handle->ino = st.st_ino;
+	handle->base = (uintptr_t) dmabuf->base_addr;
+	return FI_SUCCESS;
+}
+
+void ofi_memfd_put_handle(struct ofi_memfd_handle *handle)
+{
+	close(handle->fd);
+}
+
+/* Import the peer's fd: pidfd_getfd() first, then /proc/<pid>/fd.  The
+ * latter only needs ptrace read access, so it keeps working where Yama
+ * (or a container profile) blocks pidfd_getfd() and CMA.
+ */
+static int memfd_import(const struct ofi_memfd_handle *handle)
+{
+	char path[64];
+	int pidfd, fd;
+
+	pidfd = ofi_pidfd_open(handle->pid, 0);
+	if (pidfd >= 0) {
+		fd = ofi_pidfd_getfd(pidfd, handle->fd, 0);
+		close(pidfd);
+		if (fd >= 0)
+			return fd;
+	}
+
+	snprintf(path, sizeof(path), "/proc/%d/fd/%d", handle->pid,
+		 handle->fd);
+	fd = open(path, O_RDWR | O_CLOEXEC);
+	return fd < 0 ? -errno : fd;
+}
+
+static int memfd_cache_add_region(struct ofi_mr_cache *cache,
+				  struct ofi_mr_entry *entry)
+{
+	struct ofi_memfd_handle *handle =
+		(struct ofi_memfd_handle *) entry->info.handle;
+	struct stat st;
+	void *addr;
+	int fd, ret = FI_SUCCESS;
+
+	fd = memfd_import(handle);
+	if (fd < 0) {
+		FI_WARN(&core_prov, FI_LOG_CORE,
+			"unable to import fd %d from pid %d: %s\n",
+			handle->fd, handle->pid, strerror(-fd));
+		return fd;
+	}
+
+	/* the fd number may have been reused since the handle was sent */
+	if (fstat(fd, &st) || st.st_ino != handle->ino) {
+		ret = -FI_ENOENT;
+		goto out;
+	}
+
+	addr = mmap(NULL, entry->info.iov.iov_len, PROT_READ | PROT_WRITE,
+		    MAP_SHARED, fd,
+		    (uintptr_t) entry->info.iov.iov_base - handle->base);
+	if (addr == MAP_FAILED) {
+		ret = -errno;
+		goto out;
+	}
+	entry->info.mapped_addr = addr;
+out:
+	close(fd);
+	return ret;
+}
+
+static void memfd_cache_delete_region(struct ofi_mr_cache *cache,
+				      struct ofi_mr_entry *entry)
+{
+	munmap(entry->info.mapped_addr, entry->info.iov.iov_len);
+}
+
+/**
+ * @brief Open a memfd cache
+ *
+ * @param cache[in] the memfd cache
+ * @param domain[in] the domain that the cache is attached to.
+ * @return int 0 on success, negative value otherwise.
+ */
+int ofi_memfd_cache_open(struct ofi_mr_cache **cache,
+			 struct util_domain *domain)
+{
+	struct ofi_mem_monitor *memory_monitors[OFI_HMEM_MAX] = {0};
+	int ret;
+
+	memory_monitors[FI_HMEM_SYSTEM] = memfd_monitor;
+
+	*cache = calloc(1, sizeof(*(*cache)));
+	if (!*cache)
+		return -FI_ENOMEM;
+
+	(*cache)->add_region = memfd_cache_add_region;
+	(*cache)->delete_region = memfd_cache_delete_region;
+	ret = ofi_mr_cache_init(domain, memory_monitors, *cache);
+	if (ret) {
+		free(*cache);
+		*cache = NULL;
+		return ret;
+	}
+
+	FI_INFO(&core_prov, FI_LOG_CORE,
+		"memfd cache enabled, max_cnt: %zu max_size: %zu\n",
+		cache_params.max_cnt, cache_params.max_size);
+	return FI_SUCCESS;
+}
+
+/**
+ * @brief Destroy the memfd cache
+ *
+ * @param cache the memfd cache
+ */
+void ofi_memfd_cache_destroy(struct ofi_mr_cache *cache)
+{
+	ofi_mr_cache_cleanup(cache);
+	free(cache);
+}
+
+/**
+ * @brief Given the peer's memfd handle and the page aligned range of the
+ * peer's address space it covers, return a cache entry whose mapped_addr
+ * maps iov->iov_base.  The file is imported and mapped on a miss.
+ *
+ * @param[in] cache the memfd cache
+ * @param[in] peer_id ID of the peer
+ * @param[in] iov the peer's address range to be mapped
+ * @param[in] handle the peer's memfd handle
+ * @param[out] mr_entry the matched mr_entry
+ * @return int 0 on success, negative value otherwise.
+ */
+int ofi_memfd_cache_search(struct ofi_mr_cache *cache, uint64_t peer_id,
+			   struct iovec *iov, struct ofi_memfd_handle *handle,
+			   struct ofi_mr_entry **mr_entry)
+{
+	struct ofi_mr_info info = {0};
+
+	info.iov = *iov;
+	info.iface = FI_HMEM_SYSTEM;
+	info.peer_id = peer_id;
+	memcpy(&info.handle, handle, sizeof(*handle));
+
+	return ofi_mr_cache_search(cache, &info, mr_entry);
+}
+
+#else
+
+int ofi_memfd_get_handle(const struct fi_mr_dmabuf *dmabuf,
+			 struct ofi_memfd_handle *handle)
+{
+	return -FI_ENOSYS;
+}
+
+void ofi_memfd_put_handle(struct ofi_memfd_handle *handle)
+{
+}
+
+int ofi_memfd_cache_open(struct ofi_mr_cache **cache,
+			 struct util_domain *domain)
+{
+	*cache = NULL;
+	return -FI_ENOSYS;
+}
+
+void ofi_memfd_cache_destroy(struct ofi_mr_cache *cache)
+{
+}
+
+int ofi_memfd_cache_search(struct ofi_mr_cache *cache, uint64_t peer_id,
+			   struct iovec *iov, struct ofi_memfd_handle *handle,
+			   struct ofi_mr_entry **mr_entry)
+{
+	return -FI_ENOSYS;
+}
+
+#endif /* __linux__ */